@@ -0,0 +1,63 @@
+/**
+ * @file bench_pico.cpp
+ * @brief pico-raycaster-bench firmware: the kernel suite on the device, with cycle counts.
+ *
+ * Cycles come from the M33's DWT cycle counter, times from the microsecond
+ * timer. The ST7735 kernels drive the real SPI at the firmware's wiring, a
+ * panel does not have to be attached. The suite runs once the USB serial port
+ * is opened and again on every key, a key other than Enter is taken as the
+ * first letter of a kernel name prefix ('d' runs the dda kernels).
+ */
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/m33.h"
+
+#include "hot_path.hpp"
+#include "kernel_suite.hpp"
+#include "st7735.hpp"
+
+namespace {
+    uint64_t nowNs() {
+        return time_us_64() * 1000;
+    }
+
+    uint32_t cycles() {
+        return m33_hw->dwt_cyccnt;
+    }
+}
+
+int main() {
+    stdio_init_all();
+
+    // the cycle counter needs the trace block enabled first
+    hw_set_bits(&m33_hw->demcr, M33_DEMCR_TRCENA_BITS);
+    m33_hw->dwt_cyccnt = 0;
+    hw_set_bits(&m33_hw->dwt_ctrl, M33_DWT_CTRL_CYCCNTENA_BITS);
+
+    ST7735 tft(1, spi0, 18, 19, 17, 21, 20, 255);
+    tft.initialize(ST7735::TFT_Type::GREEN_TAB);
+
+    const BenchPlatform platform{"rp2350", nowNs, cycles, &tft};
+
+    while (!stdio_usb_connected()) {
+        sleep_ms(100);
+    }
+
+    char filter[2] = {0, 0};
+
+    while (true) {
+        printf("KERNELS begin target=%s hot_path=%s clock_hz=%u\n", platform.target, RAYCASTER_SRAM_HOT_PATH ? "sram" : "xip",
+               static_cast<unsigned>(clock_get_hz(clk_sys)));
+        const uint16_t count = runKernelSuite(platform, filter);
+        printf("KERNELS end count=%u\n", count);
+
+        int key;
+        while ((key = getchar_timeout_us(100000)) == PICO_ERROR_TIMEOUT) {
+        }
+
+        filter[0] = (key == '\r' || key == '\n') ? 0 : static_cast<char>(key);
+    }
+}
@@ -0,0 +1,300 @@
+/**
+ * @file kernel_suite.cpp
+ */
+
+#include "kernel_suite.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include "column_fill.hpp"
+#include "fixed_point.hpp"
+#include "fp_math.hpp"
+#include "map_data.hpp"
+#include "raycast.hpp"
+#include "render_config.hpp"
+#include "st7735.hpp"
+#include "vec2.hpp"
+
+namespace {
+    using Config = DefaultRenderConfig;
+
+    constexpr uint16_t VALUE_COUNT = 1024;      // operands per arithmetic kernel run
+    constexpr uint16_t RAY_COUNT = 1024;        // rays per DDA kernel run, 8 headings of 128 columns
+    constexpr uint16_t FILL_COLUMNS = 256;      // columns per fill kernel run
+    constexpr uint16_t DISPLAY_OPS = 256;       // pixels or commands per display kernel run
+
+    // the result of every kernel ends up here so none of them can be optimised away
+    volatile uint32_t sink;
+
+    /// @brief xorshift32, the same operands on every platform
+    uint32_t nextRandom(uint32_t& state) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    /**
+     * @brief Time one kernel and print its KERNEL line
+     * @param ops Operations per call, the reported times are per operation
+     * @param kernel Does the work once, returns something derived from the results
+     */
+    template <typename Kernel>
+    void measure(const BenchPlatform& platform, const char* name, const char* unit, uint32_t ops, Kernel&& kernel) {
+        sink = kernel();
+
+        uint64_t best_ns = UINT64_MAX;
+        uint32_t best_cycles = UINT32_MAX;
+
+        for (uint8_t run = 0; run < KERNEL_RUNS; run++) {
+            const uint32_t start_cycles = platform.cycles ? platform.cycles() : 0;
+            const uint64_t start_ns = platform.now_ns();
+
+            sink = kernel();
+
+            const uint64_t ns = platform.now_ns() - start_ns;
+            const uint32_t cycles = platform.cycles ? platform.cycles() - start_cycles : 0;
+
+            if (ns < best_ns) best_ns = ns;
+            if (cycles < best_cycles) best_cycles = cycles;
+        }
+
+        printf("KERNEL target=%s name=%s unit=%s ops=%u ns_per_op=%.2f", platform.target, name, unit, static_cast<unsigned>(ops),
+               static_cast<double>(best_ns) / ops);
+        if (platform.cycles) printf(" cycles_per_op=%.2f", static_cast<double>(best_cycles) / ops);
+        printf("\n");
+    }
+
+    /**
+     * @class Suite
+     * @brief The kernels and their inputs, built once before anything is timed
+     */
+    class Suite {
+        public:
+            Suite(const BenchPlatform& platform, const char* filter) : platform_(platform), filter_(filter) {}
+
+            uint16_t run() {
+                fixedPoint();
+                trig();
+                dda();
+                columnFill();
+                if (platform_.display != nullptr) display();
+
+                return count_;
+            }
+
+        private:
+            const BenchPlatform& platform_;
+            const char* filter_;
+            uint16_t count_ = 0;
+
+            bool selected(const char* name) const {
+                return filter_ == nullptr || strncmp(name, filter_, strlen(filter_)) == 0;
+            }
+
+            template <typename Kernel>
+            void kernel(const char* name, const char* unit, uint32_t ops, Kernel&& fn) {
+                if (!selected(name)) return;
+
+                measure(platform_, name, unit, ops, fn);
+                count_++;
+            }
+
+            // ---- Fixed15_16 arithmetic ----
+
+            inline static Fixed15_16 a_[VALUE_COUNT], b_[VALUE_COUNT], out_[VALUE_COUNT];
+
+            void fixedPoint() {
+                uint32_t state = 0x1234567u;
+                for (uint16_t i = 0; i < VALUE_COUNT; i++) {
+                    // magnitudes the renderer sees, divisors kept away from 0 like its distances
+                    a_[i] = Fixed15_16::fromRaw(static_cast<int32_t>(nextRandom(state) % (64 << 16)) - (32 << 16));
+                    b_[i] = Fixed15_16::fromRaw(static_cast<int32_t>(nextRandom(state) % (16 << 16)) + (1 << 12));
+                }
+
+                auto reduce = []() {
+                    uint32_t sum = 0;
+                    for (const Fixed15_16& v : out_) sum += static_cast<uint32_t>(v.toRaw());
+                    return sum;
+                };
+
+                kernel("fixed_add", "op", VALUE_COUNT, [&]() {
+                    for (uint16_t i = 0; i < VALUE_COUNT; i++) out_[i] = a_[i] + b_[i];
+                    return reduce();
+                });
+                kernel("fixed_mul", "op", VALUE_COUNT, [&]() {
+                    for (uint16_t i = 0; i < VALUE_COUNT; i++) out_[i] = a_[i] * b_[i];
+                    return reduce();
+                });
+                kernel("fixed_div", "op", VALUE_COUNT, [&]() {
+                    for (uint16_t i = 0; i < VALUE_COUNT; i++) out_[i] = a_[i] / b_[i];
+                    return reduce();
+                });
+                kernel("fixed_mul_add", "op", VALUE_COUNT / 2, [&]() {
+                    for (uint16_t i = 0; i < VALUE_COUNT; i += 2) out_[i] = mulAdd(a_[i], b_[i], a_[i + 1], b_[i + 1]);
+                    return reduce();
+                });
+            }
+
+            // ---- Trig lookups ----
+
+            inline static int16_t degrees_[VALUE_COUNT];
+            inline static angle16_t angles_[VALUE_COUNT];
+
+            void trig() {
+                uint32_t state = 0x89ABCDEu;
+                for (uint16_t i = 0; i < VALUE_COUNT; i++) {
+                    degrees_[i] = static_cast<int16_t>(nextRandom(state) % 720) - 360;
+                    angles_[i] = static_cast<angle16_t>(nextRandom(state));
+                }
+
+                kernel("sinfp", "op", VALUE_COUNT, [&]() {
+                    uint32_t sum = 0;
+                    for (int16_t d : degrees_) sum += static_cast<uint32_t>(sinfp(d).toRaw());
+                    return sum;
+                });
+                kernel("sin_bam", "op", VALUE_COUNT, [&]() {
+                    uint32_t sum = 0;
+                    for (angle16_t a : angles_) sum += static_cast<uint32_t>(sinBam(a).toRaw());
+                    return sum;
+                });
+            }
+
+            // ---- DDA traversal on synthetic maps ----
+
+            static constexpr uint8_t ROOM_SIZE = 32;
+            static constexpr uint8_t CORRIDOR_LENGTH = 128, CORRIDOR_WIDTH = 5;
+
+            inline static uint8_t room_tiles_[ROOM_SIZE * ROOM_SIZE];
+            inline static uint8_t maze_tiles_[ROOM_SIZE * ROOM_SIZE];
+            inline static uint8_t corridor_tiles_[CORRIDOR_LENGTH * CORRIDOR_WIDTH];
+            inline static Ray rays_[RAY_COUNT];
+            inline static RayHit hits_[RAY_COUNT];
+
+            /// @brief Walls around the edge only, tiles are column major like the map format
+            static void border(uint8_t* tiles, uint8_t width, uint8_t height) {
+                for (uint8_t x = 0; x < width; x++) {
+                    for (uint8_t y = 0; y < height; y++) {
+                        tiles[y + height * x] = (x == 0 || y == 0 || x + 1 == width || y + 1 == height) ? 1 : 0;
+                    }
+                }
+            }
+
+            /// @brief 8 headings of one screen width of camera rays from a point
+            static void cameraFan(Fixed15_16 x, Fixed15_16 y) {
+                for (uint16_t i = 0; i < RAY_COUNT; i++) {
+                    const angle16_t heading = static_cast<angle16_t>((i / 128) * (0x10000 / 8) + 0x0400);
+                    const Vec2fp dir{cosBam(heading), sinBam(heading)};
+                    const Fixed15_16 camera_x = Fixed15_16::fromRaw(((i % 128) << 10) - Fixed15_16::ONE);
+
+                    const Vec2fp ray = dir.scaledAdd(dir.perpendicular() * Config::FOV_SCALE, camera_x);
+                    rays_[i] = Ray{x, y, ray.x, ray.y};
+                }
+            }
+
+            void castAll(const char* name, const MapView& map) {
+                kernel(name, "ray", RAY_COUNT, [&]() {
+                    castRays(map, rays_, hits_, RAY_COUNT);
+
+                    uint32_t sum = 0;
+                    for (const RayHit& hit : hits_) sum += hit.tile + hit.tex_x;
+                    return sum;
+                });
+            }
+
+            void dda() {
+                const Fixed15_16 centre = Fixed15_16::fromRaw((ROOM_SIZE / 2) * Fixed15_16::ONE + (Fixed15_16::ONE >> 1));
+
+                // an empty room, every ray crosses about half the map
+                border(room_tiles_, ROOM_SIZE, ROOM_SIZE);
+                const MapView room(ROOM_SIZE, ROOM_SIZE, room_tiles_);
+                cameraFan(centre, centre);
+                castAll("dda_room", room);
+
+                // a third of the tiles solid, short rays with a hit within a few cells
+                border(maze_tiles_, ROOM_SIZE, ROOM_SIZE);
+                uint32_t state = 0x2468ACEu;
+                for (uint8_t x = 1; x + 1 < ROOM_SIZE; x++) {
+                    for (uint8_t y = 1; y + 1 < ROOM_SIZE; y++) {
+                        const bool near_start = x + 1 >= ROOM_SIZE / 2 && x <= ROOM_SIZE / 2 + 1 && y + 1 >= ROOM_SIZE / 2 && y <= ROOM_SIZE / 2 + 1;
+                        maze_tiles_[y + ROOM_SIZE * x] = (!near_start && nextRandom(state) % 3 == 0) ? 1 : 0;
+                    }
+                }
+                const MapView maze(ROOM_SIZE, ROOM_SIZE, maze_tiles_);
+                castAll("dda_maze", maze);
+
+                // down a long corridor at shallow angles, the longest traversals
+                border(corridor_tiles_, CORRIDOR_LENGTH, CORRIDOR_WIDTH);
+                const MapView corridor(CORRIDOR_LENGTH, CORRIDOR_WIDTH, corridor_tiles_);
+                for (uint16_t i = 0; i < RAY_COUNT; i++) {
+                    const Fixed15_16 slope = Fixed15_16::fromRaw((static_cast<int32_t>(i) - RAY_COUNT / 2) << 1);
+                    rays_[i] = Ray{1.5_fp, 2.5_fp, Fixed15_16(1), slope};
+                }
+                castAll("dda_corridor", corridor);
+            }
+
+            // ---- Column texture fill ----
+
+            inline static uint16_t tex_[Config::TEX_SIZE];
+            inline static Config::pixel_t column_[Config::HEIGHT];
+
+            void fillAt(const char* name, int16_t line_height) {
+                // the setup drawWallColumn does for this height
+                int16_t draw_start = (-line_height >> 1) + (Config::HEIGHT >> 1);
+                if (draw_start < 0) draw_start = 0;
+                int16_t draw_end = (line_height >> 1) + (Config::HEIGHT >> 1);
+                if (draw_end >= Config::HEIGHT) draw_end = Config::HEIGHT - 1;
+
+                const Fixed15_16 step = Fixed15_16(static_cast<int16_t>(Config::TEX_SIZE)) / Fixed15_16(line_height);
+                const Fixed15_16 tex_pos = (draw_start - ((Config::HEIGHT - line_height) >> 1)) * step;
+
+                kernel(name, "column", FILL_COLUMNS, [&]() {
+                    for (uint16_t i = 0; i < FILL_COLUMNS; i++) {
+                        fillTexturedColumn<Config>(column_, tex_, draw_start, draw_end, tex_pos, step);
+                    }
+                    return static_cast<uint32_t>(column_[Config::HEIGHT / 2]);
+                });
+            }
+
+            void columnFill() {
+                uint32_t state = 0x13579BDu;
+                for (uint16_t i = 0; i < Config::TEX_SIZE; i++) {
+                    tex_[i] = static_cast<uint16_t>(nextRandom(state));
+                }
+
+                fillAt("column_fill_h16", 16);
+                fillAt("column_fill_h64", 64);
+                fillAt("column_fill_h128", 128);
+                fillAt("column_fill_h512", 512);
+            }
+
+            // ---- ST7735 command and pixel paths ----
+
+            void display() {
+                ST7735& tft = *platform_.display;
+
+                for (uint16_t y = 0; y < Config::HEIGHT; y++) column_[y] = static_cast<uint16_t>(y * 0x0841);
+
+                kernel("st7735_command", "command", DISPLAY_OPS, [&]() {
+                    for (uint16_t i = 0; i < DISPLAY_OPS; i++) tft.invertDisplay(false);
+                    return 0u;
+                });
+                kernel("st7735_pixel", "pixel", DISPLAY_OPS, [&]() {
+                    for (uint16_t i = 0; i < DISPLAY_OPS; i++) tft.drawPixel(static_cast<uint8_t>(i % Config::WIDTH), static_cast<uint8_t>(i % Config::HEIGHT), 0xFFFF);
+                    return 0u;
+                });
+                kernel("st7735_column", "column", Config::WIDTH, [&]() {
+                    for (uint16_t x = 0; x < Config::WIDTH; x++) tft.drawRayColumnn(static_cast<uint8_t>(x), column_, Config::HEIGHT);
+                    return 0u;
+                });
+            }
+    };
+}
+
+uint16_t runKernelSuite(const BenchPlatform& platform, const char* filter) {
+    if (filter != nullptr && filter[0] == '\0') filter = nullptr;
+
+    Suite suite(platform, filter);
+    return suite.run();
+}
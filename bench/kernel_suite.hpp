@@ -0,0 +1,48 @@
+/**
+ * @file kernel_suite.hpp
+ * @brief Per kernel microbenchmarks, shared by the host "bench" tool and the pico-raycaster-bench firmware.
+ *
+ * Every kernel does a fixed amount of work, the same on the host and the
+ * device, runs it once to warm the caches and then KERNEL_RUNS more times,
+ * keeping the fastest. Each kernel prints one line:
+ *
+ *   KERNEL target=rp2350 name=dda_maze unit=ray ops=1024 ns_per_op=812.40 cycles_per_op=121.86
+ *
+ * cycles_per_op is only printed where the platform has a cycle counter (the
+ * M33's DWT on the device). Names and units are stable so logs of two commits
+ * can be compared with tools/hot_path_report kernels.
+ */
+
+#ifndef KERNEL_SUITE_H
+#define KERNEL_SUITE_H
+
+#include <cstdint>
+
+class ST7735;
+
+/// @brief Timed runs per kernel after the warm up, the fastest is reported
+inline constexpr uint8_t KERNEL_RUNS = 5;
+
+/// @brief What a platform provides to run the suite on
+struct BenchPlatform {
+    /// @brief Printed as target= on every line, eg. "host" or "rp2350"
+    const char* target;
+
+    /// @brief Monotonic time in nanoseconds
+    uint64_t (*now_ns)();
+
+    /// @brief Free running 32 bit cycle counter, nullptr if there is none
+    uint32_t (*cycles)();
+
+    /// @brief Initialised display driver for the st7735 kernels, nullptr skips them
+    ST7735* display;
+};
+
+/**
+ * @brief Run the kernels and print a KERNEL line for each
+ * @param filter Only kernels whose name starts with this, nullptr or "" for all
+ * @return Number of kernels run
+ */
+uint16_t runKernelSuite(const BenchPlatform& platform, const char* filter);
+
+#endif // KERNEL_SUITE_H
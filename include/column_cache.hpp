@@ -0,0 +1,107 @@
+/**
+ * @file column_cache.hpp
+ * @brief LRU cache of textured wall columns, keyed on what decides their pixels.
+ */
+
+#ifndef COLUMN_CACHE_H
+#define COLUMN_CACHE_H
+
+#include <cstdint>
+
+#include "fixed_point.hpp"
+#include "raycast.hpp"
+#include "renderer.hpp"
+
+/**
+ * @class ColumnCache
+ * @brief Scaled wall columns kept in SRAM and copied into the column buffer instead of sampled again.
+ *
+ * What drawWallColumn() writes only depends on the texture (tile and side),
+ * the face's shade, the texture column and the projected wall height, so a
+ * column seen before, in this frame or an earlier one, is one copy of its
+ * rows. Entries hold one screen column each, the least recently used one
+ * makes room for a new column once the budget is used up.
+ *
+ * @note Pixels come from the bound texture blob, clear() after binding another one
+ * @note Only unit high walls, the layered walls of maps with wall heights are clipped per column
+ */
+class ColumnCache {
+    public:
+        /// @brief Entries the storage holds, one per screen column of a frame
+        inline static constexpr uint16_t MAX_ENTRIES = SCREEN_WIDTH;
+
+        struct Stats {
+            uint32_t lookups;
+            uint32_t hits;
+            uint32_t evictions;
+            uint32_t pixels_copied; // rows served from the cache instead of sampled
+
+            [[nodiscard]] Fixed15_16 hitRate() const {
+                // counts can pass the integer range of a Fixed15_16 over many frames
+                return (lookups == 0) ? Fixed15_16(0) : Fixed15_16::fromRaw(static_cast<int32_t>((static_cast<uint64_t>(hits) << 16) / lookups));
+            }
+
+            /// @brief Texel reads saved, one per pixel, 2 bytes each
+            [[nodiscard]] uint32_t bytesSaved() const { return pixels_copied * sizeof(uint16_t); }
+        };
+
+        ColumnCache();
+
+        /**
+         * @brief Limit the entries in use, eg. to trade SRAM for hit rate
+         * @param entries Clamped to 1..MAX_ENTRIES
+         * @note Drops every cached column
+         */
+        void setBudget(uint16_t entries);
+        [[nodiscard]] uint16_t budget() const { return budget_; }
+
+        /// @brief Bytes of SRAM the budget's entries take
+        [[nodiscard]] uint32_t budgetBytes() const { return budget_ * static_cast<uint32_t>(sizeof(Entry)); }
+
+        /// @brief Drop every cached column
+        void clear();
+
+        /**
+         * @brief drawWallColumn() served from the cache where the column was drawn before
+         * @param column Output buffer of SCREEN_HEIGHT pixels, rows outside the wall are left untouched
+         */
+        void drawWallColumn(const RayHit& hit, uint16_t* column);
+
+        [[nodiscard]] const Stats& stats() const { return stats_; }
+        void resetStats() { stats_ = Stats{}; }
+
+    private:
+        inline static constexpr uint16_t NONE = UINT16_MAX;
+        inline static constexpr uint8_t BUCKET_BITS = 8;
+
+        struct Entry {
+            uint64_t key;
+            int16_t draw_start;
+            int16_t draw_end;
+            uint16_t bucket_next; // chain of the entry's hash bucket
+            uint16_t older;       // LRU list, towards the eviction end
+            uint16_t newer;
+            uint16_t pixels[SCREEN_HEIGHT]; // rows draw_start.. of the column
+        };
+
+        uint16_t budget_ = MAX_ENTRIES;
+        uint16_t used_ = 0;
+        uint16_t newest_ = NONE;
+        uint16_t oldest_ = NONE;
+        Stats stats_{};
+
+        uint16_t buckets_[1 << BUCKET_BITS];
+        Entry entries_[MAX_ENTRIES];
+
+        [[nodiscard]] static uint16_t bucketOf(uint64_t key) {
+            return static_cast<uint16_t>((key * 0x9E3779B97F4A7C15ULL) >> (64 - BUCKET_BITS));
+        }
+
+        void unlinkLru(uint16_t e);
+        void pushNewest(uint16_t e);
+
+        /// @brief A free entry, or the least recently used one taken out of its bucket
+        uint16_t takeEntry();
+};
+
+#endif // COLUMN_CACHE_H
@@ -0,0 +1,224 @@
+/**
+ * @file column_fill.hpp
+ * @brief Texture column fill kernels, specialised on scale.
+ *
+ * Once a wall is taller on screen than its texture, each texel covers one or
+ * more screen pixels, so the magnified kernel reads each texel once and writes
+ * it as a run. Otherwise every pixel (or every other pixel) samples a new
+ * texel and the minified kernel does a plain strided gather. Both produce
+ * exactly the same pixels as stepping tex_pos one pixel at a time.
+ */
+
+#ifndef COLUMN_FILL_H
+#define COLUMN_FILL_H
+
+#include <cstdint>
+
+#include "fixed_point.hpp"
+#include "render_config.hpp"
+
+/**
+ * @brief Steps below this use the run kernel, every texel covers at least one pixel there
+ * @note The run ends come from one add per texel, so even runs of one or two pixels read half the texels
+ */
+inline constexpr Fixed15_16 MAGNIFIED_STEP_MAX = 1.0_fp;
+
+/**
+ * @brief Write a run of identical pixels
+ * @note Unrolled by 4, run lengths are at most a few dozen pixels
+ */
+template <typename Pixel>
+inline void fillRun(Pixel* dst, Pixel color, int16_t count) {
+    while (count >= 4) {
+        dst[0] = color;
+        dst[1] = color;
+        dst[2] = color;
+        dst[3] = color;
+        dst += 4;
+        count -= 4;
+    }
+
+    switch (count) {
+        case 3: dst[2] = color; [[fallthrough]];
+        case 2: dst[1] = color; [[fallthrough]];
+        case 1: dst[0] = color; [[fallthrough]];
+        default: break;
+    }
+}
+
+/// @brief Texel as a lit face shows it, Shaded false leaves the texel and the shade unread
+template <bool Shaded>
+[[gnu::always_inline]] inline uint16_t litTexel(uint16_t texel, [[maybe_unused]] uint8_t shade) {
+    if constexpr (Shaded) {
+        return shadeTexel(texel, shade);
+    } else {
+        return texel;
+    }
+}
+
+/**
+ * @brief Runs of texels at most Width pixels tall, each writes Width pixels and the next run overwrites the spill
+ * @param boundary Row where the next texel starts in Q32.32, rounded up by its bias, advanced past the runs written
+ * @return Row the exact runs go on from, the last Width rows are left to them so nothing spills past the column
+ * @note No branch on the run length, short runs are the ones a branch would mispredict
+ */
+template <class Config, int16_t Width, bool Shaded>
+inline int16_t fillSpilledRuns(typename Config::pixel_t* dst, const uint16_t* src, int16_t count,
+                               uint32_t& texel, uint64_t& boundary, uint64_t texel_len, uint8_t shade) {
+    int16_t y = 0;
+
+    while (y + Width <= count) {
+        const typename Config::pixel_t color = fromRgb565<typename Config::pixel_t>(litTexel<Shaded>(src[texel & Config::TEX_MASK], shade));
+        for (int16_t i = 0; i < Width; i++) {
+            dst[y + i] = color;
+        }
+
+        y = static_cast<int16_t>(boundary >> 32);
+        texel++;
+        boundary += texel_len;
+    }
+
+    return y;
+}
+
+/**
+ * @brief Texture rows the fill kernels read for rows [draw_start, draw_end), so a generated column can skip the rest
+ * @param first_row Set to the first texture row read
+ * @param last_row Set to the last texture row read, the whole column if the rows wrap around
+ */
+template <class Config = DefaultRenderConfig>
+inline void sampledRows(int16_t draw_start, int16_t draw_end, Fixed15_16 tex_pos, Fixed15_16 step, uint8_t& first_row, uint8_t& last_row) {
+    const int32_t first = tex_pos.toRaw() >> 16;
+    const int32_t last = (tex_pos.toRaw() + step.toRaw() * (draw_end - draw_start - 1)) >> 16;
+
+    // tall walls repeat the texture, the kernels mask every row
+    if (draw_end <= draw_start || (first & ~Config::TEX_MASK) != (last & ~Config::TEX_MASK)) {
+        first_row = 0;
+        last_row = Config::TEX_MASK;
+        return;
+    }
+
+    first_row = static_cast<uint8_t>(first & Config::TEX_MASK);
+    last_row = static_cast<uint8_t>(last & Config::TEX_MASK);
+}
+
+/**
+ * @brief Darken rows [first_row, last_row] of a masked texture column for a baked shade, see shadeTexel()
+ * @param dst Column of TEX_SIZE texels, may be src
+ * @note Key texels stay as they are, darkened texels that come out as the key are nudged off it
+ */
+inline void shadeMaskedRows(const uint16_t* src, uint16_t* dst, uint8_t first_row, uint8_t last_row, uint8_t shade, uint16_t color_key) {
+    for (uint16_t y = first_row; y <= last_row; y++) {
+        const uint16_t texel = src[y];
+        const uint16_t shaded = shadeTexel(texel, shade);
+
+        dst[y] = (texel == color_key) ? texel : (shaded == color_key) ? static_cast<uint16_t>(shaded ^ 1) : shaded;
+    }
+}
+
+/**
+ * @brief Fill rows [draw_start, draw_end) of a column from a texture column
+ * @tparam Config Render configuration, gives the texture size and column pixel type
+ * @tparam Magnified true if every texel covers at least one pixel, steps below MAGNIFIED_STEP_MAX
+ * @tparam Shaded Darken every texel read by shade, see shadeTexel()
+ * @param column Output column buffer
+ * @param src Texture column of the wall's side
+ * @param tex_pos Texture y coordinate at draw_start
+ * @param step Texture y increment per screen pixel
+ * @param shade Baked shade of the face, only read if Shaded
+ */
+template <class Config, bool Magnified, bool Shaded = false>
+inline void fillColumn(typename Config::pixel_t* column, const uint16_t* src,
+                       int16_t draw_start, int16_t draw_end, Fixed15_16 tex_pos, Fixed15_16 step, uint8_t shade = 0) {
+    int32_t pos = tex_pos.toRaw();
+    const int32_t step_raw = step.toRaw();
+
+    using Pixel = typename Config::pixel_t;
+
+    if constexpr (Magnified) {
+        Pixel* dst = &column[draw_start];
+        const int16_t count = draw_end - draw_start;
+        if (count <= 0) return;
+
+        // pixels per texel in Q32.32, truncated so every texel boundary below comes out a hair early, never late:
+        // over a column the error stays far below 1 / step_raw, the least a boundary can sit above a whole row
+        const uint64_t texel_len = (1ULL << 48) / static_cast<uint32_t>(step_raw);
+
+        // row where the next texel starts, biased so >> 32 rounds up to the first row at or past it
+        const uint32_t to_boundary = 0x10000u - (static_cast<uint32_t>(pos) & 0xFFFF);
+        uint64_t boundary = ((static_cast<uint64_t>(to_boundary) * texel_len) >> 16) + 0xFFFFFFFFULL;
+        uint32_t texel = static_cast<uint32_t>(pos) >> 16;
+
+        int16_t y = 0;
+        if (texel_len < (2ULL << 32)) {
+            y = fillSpilledRuns<Config, 2, Shaded>(dst, src, count, texel, boundary, texel_len, shade);
+        } else if (texel_len < (4ULL << 32)) {
+            y = fillSpilledRuns<Config, 4, Shaded>(dst, src, count, texel, boundary, texel_len, shade);
+        }
+
+        while (true) {
+            const int16_t end = static_cast<int16_t>(boundary >> 32);
+            const Pixel color = fromRgb565<Pixel>(litTexel<Shaded>(src[texel & Config::TEX_MASK], shade));
+
+            if (end >= count) {
+                fillRun(dst + y, color, static_cast<int16_t>(count - y));
+                return;
+            }
+            fillRun(dst + y, color, static_cast<int16_t>(end - y));
+
+            y = end;
+            texel++;
+            boundary += texel_len;
+        }
+    } else {
+        // the loop it replaced, written the same way so it compiles to the same gather
+        for (int16_t y = draw_start; y < draw_end; y++) {
+            column[y] = fromRgb565<Pixel>(litTexel<Shaded>(src[(pos >> 16) & Config::TEX_MASK], shade));
+            pos += step_raw;
+        }
+    }
+}
+
+/**
+ * @brief Dispatch to the fillColumn specialisation for this step and shade
+ * @param shade Baked shade of the face, 0 reads the texels as they are
+ * @note Lit faces darken each texel as it is read, once per texel on tall walls and once per pixel on short ones
+ */
+template <class Config = DefaultRenderConfig>
+inline void fillTexturedColumn(typename Config::pixel_t* column, const uint16_t* tex_column,
+                               int16_t draw_start, int16_t draw_end, Fixed15_16 tex_pos, Fixed15_16 step, uint8_t shade = 0) {
+    // a step of one raw unit would overflow the run arithmetic, no wall with an int16_t line height gets one
+    const bool magnified = step < MAGNIFIED_STEP_MAX && step.toRaw() > 1;
+
+    if (shade != 0) {
+        if (magnified) fillColumn<Config, true, true>(column, tex_column, draw_start, draw_end, tex_pos, step, shade);
+        else           fillColumn<Config, false, true>(column, tex_column, draw_start, draw_end, tex_pos, step, shade);
+        return;
+    }
+
+    if (magnified) fillColumn<Config, true>(column, tex_column, draw_start, draw_end, tex_pos, step);
+    else           fillColumn<Config, false>(column, tex_column, draw_start, draw_end, tex_pos, step);
+}
+
+/**
+ * @brief Fill rows [draw_start, draw_end) of a column from a texture column, leaving rows whose texel is the colour key
+ * @param src Texture column of the wall's side
+ * @param color_key Texel value of transparent texels, see TextureFileHeader::color_key
+ * @note One compare per pixel and no runs, only masked texture columns come here
+ */
+template <class Config = DefaultRenderConfig>
+inline void fillMaskedColumn(typename Config::pixel_t* column, const uint16_t* src, uint16_t color_key,
+                             int16_t draw_start, int16_t draw_end, Fixed15_16 tex_pos, Fixed15_16 step) {
+    using Pixel = typename Config::pixel_t;
+
+    int32_t pos = tex_pos.toRaw();
+    const int32_t step_raw = step.toRaw();
+
+    for (int16_t y = draw_start; y < draw_end; y++) {
+        const uint16_t texel = src[(pos >> 16) & Config::TEX_MASK];
+        if (texel != color_key) column[y] = fromRgb565<Pixel>(texel);
+        pos += step_raw;
+    }
+}
+
+#endif // COLUMN_FILL_H
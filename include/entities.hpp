@@ -0,0 +1,356 @@
+/**
+ * @file entities.hpp
+ * @brief Structure of arrays entity store with a per-tile spatial hash.
+ */
+
+#ifndef ENTITIES_H
+#define ENTITIES_H
+
+#include <cstdint>
+
+#include "fixed_point.hpp"
+#include "fp_math.hpp"
+#include "map_data.hpp"
+#include "pvs.hpp"
+#include "raycast.hpp"
+#include "renderer.hpp"
+#include "vec2.hpp"
+
+/**
+ * @class EntityStore
+ * @brief Actors stored as parallel arrays, bucketed by the map tile they stand on.
+ *
+ * Positions, velocities, radii and sprite ids each live in their own array so
+ * per-frame passes (integration, culling) stream through exactly the fields
+ * they touch. Entities are kept dense: removing one moves the last entity
+ * into its slot, so indices are only stable until the next remove().
+ *
+ * Every map tile heads a doubly linked list of the entities on it. An entity
+ * is only relinked when it crosses into another tile, so a frame where most
+ * actors stay inside their tile costs no hash maintenance. Radii are at most
+ * half a tile, so colliding entities always share a tile or are neighbours.
+ *
+ * @tparam Capacity Maximum number of entities
+ * @tparam MaxTiles Largest map (width * height) the store can be bound to
+ */
+template <uint16_t Capacity, uint16_t MaxTiles = 64 * 64>
+class EntityStore {
+    public:
+        static_assert(Capacity > 0 && Capacity < UINT16_MAX, "entity indices are uint16_t, UINT16_MAX marks the end of a list");
+
+        using Index = uint16_t;
+
+        inline static constexpr Index NONE = UINT16_MAX;
+        inline static constexpr Fixed15_16 MAX_RADIUS = 0.5_fp;
+
+        /**
+         * @brief Construct an empty store over a map
+         * @note Keeps a reference like the renderers, call mapChanged() after the view is rebound
+         */
+        explicit EntityStore(const MapView& map) : map_(map) {
+            clear();
+        }
+
+        /// @brief Remove every entity
+        void clear() {
+            count_ = 0;
+            for (uint32_t t = 0; t < MaxTiles; t++) heads_[t] = NONE;
+        }
+
+        /**
+         * @brief Rebuild the spatial hash for new map dimensions
+         * @note Entities left outside the new map or inside a wall are removed, all of them if the map is bigger than MaxTiles
+         */
+        void mapChanged() {
+            // the hash has no list for tiles past MaxTiles, spawn() refuses such a map the same way
+            if (!fitsMap()) {
+                clear();
+                return;
+            }
+
+            for (uint32_t t = 0; t < MaxTiles; t++) heads_[t] = NONE;
+
+            for (Index i = 0; i < count_;) {
+                if (!isOpen(pos_x_[i], pos_y_[i])) {
+                    copy(i, --count_);
+                    continue;
+                }
+                link(i, tileOf(pos_x_[i], pos_y_[i]));
+                i++;
+            }
+        }
+
+        [[nodiscard]] uint16_t size() const { return count_; }
+
+        /**
+         * @brief Add an entity
+         * @param radius Collision radius, clamped to MAX_RADIUS
+         * @return Its index, NONE if the store is full, the map too big or the position not on an open tile
+         */
+        Index spawn(Fixed15_16 x, Fixed15_16 y, uint8_t sprite, Fixed15_16 radius = 0.25_fp) {
+            if (count_ >= Capacity || !fitsMap() || !isOpen(x, y)) {
+                return NONE;
+            }
+
+            const Index i = count_++;
+            pos_x_[i] = x;
+            pos_y_[i] = y;
+            vel_x_[i] = Fixed15_16::fromRaw(0);
+            vel_y_[i] = Fixed15_16::fromRaw(0);
+            radius_[i] = (radius > MAX_RADIUS) ? MAX_RADIUS : radius;
+            sprite_[i] = sprite;
+
+            link(i, tileOf(x, y));
+            return i;
+        }
+
+        /// @brief Remove entity i, the last entity takes over index i
+        void remove(Index i) {
+            unlink(i);
+            moveLast(i);
+        }
+
+        /**
+         * @brief Teleport entity i
+         * @return false if the position is not on an open tile, the entity stays put
+         */
+        bool setPosition(Index i, Fixed15_16 x, Fixed15_16 y) {
+            if (!isOpen(x, y)) return false;
+
+            pos_x_[i] = x;
+            pos_y_[i] = y;
+            retile(i);
+            return true;
+        }
+
+        void setVelocity(Index i, Fixed15_16 vx, Fixed15_16 vy) {
+            vel_x_[i] = vx;
+            vel_y_[i] = vy;
+        }
+
+        // read-only views of the arrays, valid for [0, size())
+        [[nodiscard]] const Fixed15_16* posX() const { return pos_x_; }
+        [[nodiscard]] const Fixed15_16* posY() const { return pos_y_; }
+        [[nodiscard]] const Fixed15_16* velX() const { return vel_x_; }
+        [[nodiscard]] const Fixed15_16* velY() const { return vel_y_; }
+        [[nodiscard]] const Fixed15_16* radius() const { return radius_; }
+        [[nodiscard]] const uint8_t* sprite() const { return sprite_; }
+
+        /// @brief Entities relinked to another tile since the counter was last reset
+        [[nodiscard]] uint32_t retiles() const { return retiles_; }
+        void resetRetiles() { retiles_ = 0; }
+
+        /**
+         * @brief Move every entity by its velocity
+         * @param dt Time step, velocities are in tiles per unit of dt
+         * @note Centres bounce off walls one axis at a time, like the player movement
+         */
+        void integrate(Fixed15_16 dt) {
+            for (Index i = 0; i < count_; i++) {
+                const Fixed15_16 nx = pos_x_[i] + vel_x_[i] * dt;
+                if (isOpen(nx, pos_y_[i])) {
+                    pos_x_[i] = nx;
+                } else {
+                    vel_x_[i] = -vel_x_[i];
+                }
+
+                const Fixed15_16 ny = pos_y_[i] + vel_y_[i] * dt;
+                if (isOpen(pos_x_[i], ny)) {
+                    pos_y_[i] = ny;
+                } else {
+                    vel_y_[i] = -vel_y_[i];
+                }
+
+                retile(i);
+            }
+        }
+
+        /**
+         * @brief Call fn(index) for every entity whose centre is within radius of (x, y)
+         * @note Only the tiles overlapping the query circle are visited
+         */
+        template <typename Fn>
+        void forEachNear(Fixed15_16 x, Fixed15_16 y, Fixed15_16 radius, Fn&& fn) const {
+            const int16_t x0 = clampX((x - radius).toInt());
+            const int16_t x1 = clampX((x + radius).toInt());
+            const int16_t y0 = clampY((y - radius).toInt());
+            const int16_t y1 = clampY((y + radius).toInt());
+
+            const int64_t r2 = static_cast<int64_t>(radius.toRaw()) * radius.toRaw();
+
+            for (int16_t tx = x0; tx <= x1; tx++) {
+                for (int16_t ty = y0; ty <= y1; ty++) {
+                    for (Index j = heads_[ty + map_.height * tx]; j != NONE; j = next_[j]) {
+                        if (distanceSquared(pos_x_[j] - x, pos_y_[j] - y) <= r2) fn(j);
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Call fn(a, b) once for every pair of overlapping entities, a < b
+         * @note Walks the tiles, pairing each entity with the rest of its tile and
+         *       the tiles after it (half the neighbourhood, so each pair is tested once)
+         */
+        template <typename Fn>
+        void forEachCollision(Fn&& fn) const {
+            for (int16_t tx = 0; tx < map_.width; tx++) {
+                for (int16_t ty = 0; ty < map_.height; ty++) {
+                    for (Index a = heads_[ty + map_.height * tx]; a != NONE; a = next_[a]) {
+                        collideList(a, next_[a], fn);
+
+                        if (ty + 1 < map_.height) collideList(a, heads_[ty + 1 + map_.height * tx], fn);
+                        if (tx + 1 >= map_.width) continue;
+
+                        const uint16_t right = ty + map_.height * (tx + 1);
+                        if (ty > 0) collideList(a, heads_[right - 1], fn);
+                        collideList(a, heads_[right], fn);
+                        if (ty + 1 < map_.height) collideList(a, heads_[right + 1], fn);
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Collect the entities a camera can see
+         * @param out Visible indices, nearest first is not guaranteed
+         * @param max_count Size of out
+         * @param max_distance Entities further along the view direction are skipped
+         * @param pvs Visible set of the camera's tile, entities on tiles outside it are skipped before anything else
+         * @return Number of indices written
+         * @note Culls against the visible set and the view frustum first, then checks line of sight through the map
+         */
+        uint16_t collectVisible(const Camera& camera, Index* out, uint16_t max_count, Fixed15_16 max_distance = Fixed15_16(64),
+                                const PotentiallyVisibleSet* pvs = nullptr) const {
+            // inverse of the camera matrix [plane dir], same transform as sprite projection
+            const Fixed15_16 det = camera.plane().cross(camera.dir());
+            if (det.toRaw() == 0) return 0;
+            const Fixed15_16 inv_det = 1 / det;
+
+            uint16_t found = 0;
+
+            for (Index i = 0; i < count_ && found < max_count; i++) {
+                if (pvs != nullptr && !pvs->isTileVisible(tile_[i])) continue;
+
+                const Vec2fp offset = Vec2fp{pos_x_[i], pos_y_[i]} - camera.pos();
+
+                // depth along the view direction and offset across it, in camera plane units
+                const Fixed15_16 depth = inv_det * camera.plane().cross(offset);
+                if (depth + radius_[i] <= 0 || depth > max_distance) continue;
+
+                const Fixed15_16 across = inv_det * offset.cross(camera.dir());
+                if (abs(across) > depth + radius_[i]) continue;
+
+                if (hasLineOfSight(map_, camera.pos_x, camera.pos_y, pos_x_[i], pos_y_[i])) {
+                    out[found++] = i;
+                }
+            }
+
+            return found;
+        }
+
+    private:
+        const MapView& map_;
+
+        uint16_t count_ = 0;
+        uint32_t retiles_ = 0;
+
+        Fixed15_16 pos_x_[Capacity];
+        Fixed15_16 pos_y_[Capacity];
+        Fixed15_16 vel_x_[Capacity];
+        Fixed15_16 vel_y_[Capacity];
+        Fixed15_16 radius_[Capacity];
+        uint8_t sprite_[Capacity];
+
+        // spatial hash: per entity tile and links, per tile list head
+        uint16_t tile_[Capacity];
+        Index next_[Capacity];
+        Index prev_[Capacity];
+        Index heads_[MaxTiles];
+
+        [[nodiscard]] static int64_t distanceSquared(Fixed15_16 dx, Fixed15_16 dy) {
+            return static_cast<int64_t>(dx.toRaw()) * dx.toRaw() + static_cast<int64_t>(dy.toRaw()) * dy.toRaw();
+        }
+
+        [[nodiscard]] int16_t clampX(int16_t x) const { return (x < 0) ? 0 : (x >= map_.width) ? map_.width - 1 : x; }
+        [[nodiscard]] int16_t clampY(int16_t y) const { return (y < 0) ? 0 : (y >= map_.height) ? map_.height - 1 : y; }
+
+        /// @brief Column major like the tile data
+        [[nodiscard]] uint16_t tileOf(Fixed15_16 x, Fixed15_16 y) const {
+            return static_cast<uint16_t>(y.toInt() + map_.height * x.toInt());
+        }
+
+        [[nodiscard]] bool fitsMap() const {
+            return static_cast<uint32_t>(map_.width) * map_.height <= MaxTiles;
+        }
+
+        [[nodiscard]] bool isOpen(Fixed15_16 x, Fixed15_16 y) const {
+            if (x < 0 || y < 0 || x.toInt() >= map_.width || y.toInt() >= map_.height) return false;
+            return map_.getEffectiveTile(x.toInt(), y.toInt()) == 0;
+        }
+
+        void link(Index i, uint16_t tile) {
+            tile_[i] = tile;
+            prev_[i] = NONE;
+            next_[i] = heads_[tile];
+            if (next_[i] != NONE) prev_[next_[i]] = i;
+            heads_[tile] = i;
+        }
+
+        void unlink(Index i) {
+            if (prev_[i] != NONE) next_[prev_[i]] = next_[i];
+            else heads_[tile_[i]] = next_[i];
+
+            if (next_[i] != NONE) prev_[next_[i]] = prev_[i];
+        }
+
+        /// @brief Relink entity i if it crossed into another tile
+        void retile(Index i) {
+            const uint16_t tile = tileOf(pos_x_[i], pos_y_[i]);
+            if (tile == tile_[i]) return;
+
+            unlink(i);
+            link(i, tile);
+            retiles_++;
+        }
+
+        /// @brief Copy the per entity fields, links excluded
+        void copy(Index to, Index from) {
+            pos_x_[to] = pos_x_[from];
+            pos_y_[to] = pos_y_[from];
+            vel_x_[to] = vel_x_[from];
+            vel_y_[to] = vel_y_[from];
+            radius_[to] = radius_[from];
+            sprite_[to] = sprite_[from];
+        }
+
+        /// @brief Test a against every entity of the list starting at b
+        template <typename Fn>
+        void collideList(Index a, Index b, Fn& fn) const {
+            for (; b != NONE; b = next_[b]) {
+                const int32_t reach = radius_[a].toRaw() + radius_[b].toRaw();
+                if (distanceSquared(pos_x_[b] - pos_x_[a], pos_y_[b] - pos_y_[a]) < static_cast<int64_t>(reach) * reach) {
+                    if (a < b) fn(a, b);
+                    else fn(b, a);
+                }
+            }
+        }
+
+        /// @brief Move the last entity into slot i (already unlinked), fixing up its neighbours' links
+        void moveLast(Index i) {
+            const Index last = --count_;
+            if (i == last) return;
+
+            copy(i, last);
+            tile_[i] = tile_[last];
+            next_[i] = next_[last];
+            prev_[i] = prev_[last];
+
+            if (prev_[i] != NONE) next_[prev_[i]] = i;
+            else if (heads_[tile_[i]] == last) heads_[tile_[i]] = i;
+
+            if (next_[i] != NONE) prev_[next_[i]] = i;
+        }
+};
+
+#endif // ENTITIES_H
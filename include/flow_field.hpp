@@ -0,0 +1,238 @@
+/**
+ * @file flow_field.hpp
+ * @brief Grid of distances and directions towards a target tile, built a bit per frame.
+ */
+
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <cstdint>
+
+#include "map_data.hpp"
+
+/**
+ * @class FlowField
+ * @brief Breadth first search from a target tile over the open tiles of a map
+ *
+ * Every reachable tile stores its step count to the target and the direction of
+ * the next tile on a shortest path, so any number of agents can steer with one
+ * lookup each instead of searching themselves. Moves are 8 way, diagonals only
+ * when both orthogonal tiles are open so agents never cut wall corners.
+ *
+ * The search is spread over frames: update() clears the back grid and then
+ * expands tiles into it, at most a fixed amount of work per call, while agents
+ * keep reading the last complete grid, and the grids swap once the search runs
+ * out of tiles. A target that moves while a search is running starts it over,
+ * so a finished grid always leads to where the target was last seen; agents
+ * steer by the previous grid until then and no frame ever stalls.
+ *
+ * @tparam MaxTiles Largest map (width * height) the field can be bound to
+ */
+template <uint32_t MaxTiles = 64 * 64>
+class FlowField {
+    public:
+        static_assert(MaxTiles <= UINT16_MAX, "tile indices are uint16_t, UINT16_MAX marks an unreachable tile");
+
+        inline static constexpr uint16_t UNREACHABLE = UINT16_MAX;
+
+        /// @brief Direction codes, clockwise from +x. Opposite directions are 4 apart, diagonals are odd
+        inline static constexpr uint8_t NONE = 8;
+        inline static constexpr int8_t DIR_X[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+        inline static constexpr int8_t DIR_Y[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+        /// @brief Tiles expanded per update() when no budget is given, about 0.1 ms on the Pico
+        inline static constexpr uint16_t DEFAULT_BUDGET = 256;
+
+        /// @brief Tiles of the back grid cleared for one unit of budget, a store each against eight neighbour tests
+        inline static constexpr uint16_t CLEAR_PER_WORK = 16;
+
+        /**
+         * @brief Construct a field with nothing reachable
+         * @note Keeps a reference like the renderers, call mapChanged() after the view is rebound
+         */
+        explicit FlowField(const MapView& map) : map_(map) {
+            clearGrid(grids_[0]);
+            clearGrid(grids_[1]);
+        }
+
+        /**
+         * @brief Throw away both grids, for a new level
+         * @note Nothing is reachable until the next search completes
+         */
+        void mapChanged() {
+            clearGrid(grids_[front_]);
+            restart_ = true;
+            searching_ = false;
+        }
+
+        /**
+         * @brief Search again without dropping the current grid, for doors and destroyed walls
+         * @note Agents keep steering by the old grid until the new one is complete
+         */
+        void passabilityChanged() {
+            restart_ = true;
+        }
+
+        /**
+         * @brief Advance the search towards the target tile, starting it over if the target moved
+         * @param budget Most tiles to expand in this call, clearing counts CLEAR_PER_WORK tiles as one
+         * @return true if a new grid became current
+         */
+        bool update(uint8_t target_x, uint8_t target_y, uint16_t budget = DEFAULT_BUDGET) {
+            if (target_x != want_x_ || target_y != want_y_) {
+                want_x_ = target_x;
+                want_y_ = target_y;
+                restart_ = true;
+                searching_ = false;
+            }
+
+            if (!searching_) {
+                if (!restart_) return false;
+                if (!begin()) return false;
+            }
+
+            last_work_ = 0;
+            if (!clear(budget)) return false;
+            return expand(budget - last_work_);
+        }
+
+        /// @brief Steps to the target from tile (x, y), UNREACHABLE for walls, unreached and out of bounds tiles
+        [[nodiscard]] uint16_t distance(uint8_t x, uint8_t y) const {
+            if (x >= map_.width || y >= map_.height) return UNREACHABLE;
+            return grids_[front_].dist[y + map_.height * x];
+        }
+
+        /// @brief Direction code of the next tile towards the target, NONE at the target and where unreachable
+        [[nodiscard]] uint8_t direction(uint8_t x, uint8_t y) const {
+            if (x >= map_.width || y >= map_.height) return NONE;
+            return grids_[front_].dir[y + map_.height * x];
+        }
+
+        /// @brief Tile the current grid leads to
+        [[nodiscard]] uint8_t targetX() const { return grids_[front_].target_x; }
+        [[nodiscard]] uint8_t targetY() const { return grids_[front_].target_y; }
+
+        /// @brief true while a search is spread over update() calls
+        [[nodiscard]] bool searching() const { return searching_; }
+
+        /// @brief Budget used by the last update(), tiles expanded plus tiles cleared / CLEAR_PER_WORK
+        [[nodiscard]] uint16_t lastWork() const { return last_work_; }
+
+    private:
+        struct Grid {
+            uint16_t dist[MaxTiles];
+            uint8_t dir[MaxTiles];
+            uint8_t target_x = 0;
+            uint8_t target_y = 0;
+        };
+
+        const MapView& map_;
+
+        Grid grids_[2];
+        uint8_t front_ = 0;
+
+        // search state, the queue holds every reachable tile once so it never wraps
+        uint16_t queue_[MaxTiles];
+        uint16_t head_ = 0;
+        uint16_t tail_ = 0;
+
+        // tiles of the back grid cleared so far, the target is seeded once all of them are
+        uint32_t cleared_ = 0;
+
+        uint8_t want_x_ = 0;
+        uint8_t want_y_ = 0;
+        bool restart_ = true;
+        bool searching_ = false;
+        uint16_t last_work_ = 0;
+
+        void clearGrid(Grid& grid, uint32_t first = 0, uint32_t end = MaxTiles) {
+            for (uint32_t t = first; t < end; t++) {
+                grid.dist[t] = UNREACHABLE;
+                grid.dir[t] = NONE;
+            }
+        }
+
+        [[nodiscard]] bool isOpen(int16_t x, int16_t y) const {
+            if (x < 0 || y < 0 || x >= map_.width || y >= map_.height) return false;
+            return map_.getEffectiveTile(x, y) == 0;
+        }
+
+        /// @brief Start a search for the wanted target, false if the target is not an open tile
+        bool begin() {
+            restart_ = false;
+            last_work_ = 0;
+
+            if (static_cast<uint32_t>(map_.width) * map_.height > MaxTiles || !isOpen(want_x_, want_y_)) return false;
+
+            cleared_ = 0;
+            head_ = 0;
+            tail_ = 0;
+            searching_ = true;
+            return true;
+        }
+
+        /**
+         * @brief Clear the back grid's map tiles within budget, then seed the target
+         * @return true once the grid is clear and the search can expand, last_work_ holds the budget used
+         */
+        bool clear(uint16_t budget) {
+            const uint32_t tiles = static_cast<uint32_t>(map_.width) * map_.height;
+            if (cleared_ == tiles) return true;
+
+            Grid& back = grids_[front_ ^ 1];
+            uint32_t end = cleared_ + static_cast<uint32_t>(budget) * CLEAR_PER_WORK;
+            if (end > tiles) end = tiles;
+            clearGrid(back, cleared_, end);
+            last_work_ = static_cast<uint16_t>((end - cleared_ + CLEAR_PER_WORK - 1) / CLEAR_PER_WORK);
+            cleared_ = end;
+
+            if (cleared_ != tiles) return false;
+
+            back.target_x = want_x_;
+            back.target_y = want_y_;
+
+            const uint16_t target = want_y_ + map_.height * want_x_;
+            back.dist[target] = 0;
+            queue_[tail_++] = target;
+            return true;
+        }
+
+        /// @brief Expand up to budget tiles of the back grid, swap when the queue empties
+        bool expand(uint16_t budget) {
+            Grid& back = grids_[front_ ^ 1];
+            uint16_t work = 0;
+
+            while (head_ != tail_ && work < budget) {
+                const uint16_t tile = queue_[head_++];
+                const int16_t x = tile / map_.height;
+                const int16_t y = tile % map_.height;
+                const uint16_t next_dist = back.dist[tile] + 1;
+                work++;
+
+                for (uint8_t d = 0; d < 8; d++) {
+                    const int16_t nx = x + DIR_X[d];
+                    const int16_t ny = y + DIR_Y[d];
+                    if (!isOpen(nx, ny)) continue;
+
+                    // no squeezing diagonally between two walls or around a corner
+                    if ((d & 1) && (!isOpen(nx, y) || !isOpen(x, ny))) continue;
+
+                    const uint16_t neighbour = ny + map_.height * nx;
+                    if (back.dist[neighbour] != UNREACHABLE) continue;
+
+                    back.dist[neighbour] = next_dist;
+                    back.dir[neighbour] = (d + 4) & 7; // back towards the tile it was reached from
+                    queue_[tail_++] = neighbour;
+                }
+            }
+
+            last_work_ += work;
+            if (head_ != tail_) return false;
+
+            front_ ^= 1;
+            searching_ = false;
+            return true;
+        }
+};
+
+#endif // FLOW_FIELD_H
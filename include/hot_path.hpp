@@ -0,0 +1,29 @@
+/**
+ * @file hot_path.hpp
+ * @brief Placement of the per-column render path, see the PICO_RAYCASTER_SRAM_HOT_PATH build option.
+ */
+
+#ifndef HOT_PATH_H
+#define HOT_PATH_H
+
+/**
+ * With RAYCASTER_SRAM_HOT_PATH the render kernels are linked into SRAM
+ * (.time_critical.raycaster, copied out of flash by the SDK crt0) so they stop
+ * competing with texture and map reads for the XIP cache. Otherwise they stay
+ * in flash like everything else. The host tools never set it.
+ *
+ * Put RAYCASTER_HOT in front of the definition, it works on member functions too:
+ *   RAYCASTER_HOT RayHit castRay(...) { ... }
+ */
+#ifndef RAYCASTER_SRAM_HOT_PATH
+#define RAYCASTER_SRAM_HOT_PATH 0
+#endif
+
+#if RAYCASTER_SRAM_HOT_PATH
+#include "pico.h"
+#define RAYCASTER_HOT __not_in_flash("raycaster")
+#else
+#define RAYCASTER_HOT
+#endif
+
+#endif // HOT_PATH_H
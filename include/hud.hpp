@@ -0,0 +1,124 @@
+/**
+ * @file hud.hpp
+ * @brief Minimap and stat overlay composited on top of the raycaster columns.
+ */
+
+#ifndef HUD_H
+#define HUD_H
+
+#include <cstdint>
+
+#include "map_data.hpp"
+#include "textures.hpp"
+
+/// @brief Inclusive screen space rectangle
+struct HudRect {
+    uint8_t x0, y0;
+    uint8_t x1, y1;
+
+    [[nodiscard]] constexpr bool intersects(const HudRect& other) const {
+        return x0 <= other.x1 && other.x0 <= x1 && y0 <= other.y1 && other.y0 <= y1;
+    }
+
+    /// @note only valid if the rects intersect
+    [[nodiscard]] constexpr HudRect clip(const HudRect& other) const {
+        return HudRect{
+            x0 > other.x0 ? x0 : other.x0, y0 > other.y0 ? y0 : other.y0,
+            x1 < other.x1 ? x1 : other.x1, y1 < other.y1 ? y1 : other.y1
+        };
+    }
+
+    [[nodiscard]] constexpr HudRect merge(const HudRect& other) const {
+        return HudRect{
+            x0 < other.x0 ? x0 : other.x0, y0 < other.y0 ? y0 : other.y0,
+            x1 > other.x1 ? x1 : other.x1, y1 > other.y1 ? y1 : other.y1
+        };
+    }
+};
+
+/**
+ * @class HudOverlay
+ * @brief Opaque overlay with a top-down minimap and numeric stat readouts.
+ *
+ * Each widget keeps its own column major pixel buffer so compositing into an
+ * outgoing ray column is a single copy per widget. Widget buffers are only
+ * re-rasterised inside dirty rectangles, and the minimap background is built
+ * once per map and cached.
+ */
+class HudOverlay {
+    public:
+        inline static constexpr uint8_t MINIMAP_SIZE = 32; // square, in pixels
+        inline static constexpr uint8_t MARGIN = 2;
+
+        inline static constexpr uint8_t GLYPH_WIDTH = 3;
+        inline static constexpr uint8_t GLYPH_HEIGHT = 5;
+        inline static constexpr uint8_t STAT_DIGITS = 4;
+        inline static constexpr uint8_t STAT_COUNT = 2; // fps, frame time in ms
+        inline static constexpr uint8_t STATS_WIDTH = STAT_DIGITS * (GLYPH_WIDTH + 1) + 1;
+        inline static constexpr uint8_t STATS_HEIGHT = STAT_COUNT * (GLYPH_HEIGHT + 1) + 1;
+
+        /**
+         * @brief Construct the overlay and cache the minimap background
+         * @param map Map to draw, the background is rasterised from it once
+         * @param screen_width Width of the screen, used to right align the stats
+         */
+        HudOverlay(const MapView& map, uint8_t screen_width);
+
+        /**
+         * @brief Update the overlay state, marking changed regions dirty
+         * @param player Current player pose
+         * @param fps Frames per second readout
+         * @param frame_ms Frame time readout in milliseconds
+         */
+        void update(const PlayerData& player, uint16_t fps, uint16_t frame_ms);
+
+        /// @brief Re-rasterise the dirty regions of the widget buffers and clear the dirty list
+        void flush();
+
+        /// @brief Rebuild the cached minimap background after the map, its overlay or its textures changed
+        void mapChanged();
+
+        /**
+         * @brief Copy the overlay pixels that cover screen column x into the column buffer
+         * @param x Screen column
+         * @param column Column buffer, at least as tall as the lowest widget
+         */
+        void composite(uint8_t x, uint16_t* column) const;
+
+    private:
+        inline static constexpr uint8_t MAX_DIRTY_RECTS = 8;
+        // panel byte order, like the column buffers the widgets are composited into
+        inline static constexpr uint16_t MINIMAP_FLOOR_COLOR = 0x0000;
+        inline static constexpr uint16_t MINIMAP_PLAYER_COLOR = panelColor(0xFFE0); // yellow
+        inline static constexpr uint16_t STATS_BG_COLOR = 0x0000;
+        inline static constexpr uint16_t STATS_FG_COLOR = panelColor(0x07E0);       // green
+
+        const MapView& map_;
+
+        HudRect minimap_rect_;
+        HudRect stats_rect_;
+
+        HudRect dirty_rects_[MAX_DIRTY_RECTS];
+        uint8_t dirty_count_ = 0;
+
+        // player marker state, in minimap pixels
+        uint8_t marker_x_ = 0, marker_y_ = 0;
+        int8_t marker_dx_ = 0, marker_dy_ = 0;
+
+        uint16_t stat_values_[STAT_COUNT] = {0};
+
+        // column major widget buffers
+        uint16_t minimap_bg_[MINIMAP_SIZE * MINIMAP_SIZE];
+        uint16_t minimap_[MINIMAP_SIZE * MINIMAP_SIZE];
+        uint16_t stats_[STATS_WIDTH * STATS_HEIGHT];
+
+        void buildMinimapBackground();
+
+        void markDirty(const HudRect& rect);
+        HudRect markerRect() const;
+
+        void redrawMinimap(const HudRect& rect);
+        void redrawStats(const HudRect& rect);
+};
+
+#endif // HUD_H
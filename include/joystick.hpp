@@ -0,0 +1,193 @@
+/**
+ * @file joystick.hpp
+ * @brief Analog joystick input: free running ADC samples filtered in the background.
+ */
+
+#ifndef JOYSTICK_H
+#define JOYSTICK_H
+
+#include <cstdint>
+
+#include "fixed_point.hpp"
+
+/// @brief Filtered stick position, each axis -1..1 with 0 inside the deadzone
+struct JoystickState {
+    Fixed15_16 x;
+    Fixed15_16 y;
+};
+
+/**
+ * @class JoystickSampler
+ * @brief Turns raw round robin ADC samples of the two stick axes into a JoystickState.
+ *
+ * Samples arrive in the order the ADC converts them, alternating between the
+ * axes starting with first_axis. Each axis is low pass filtered, measured
+ * against the rest position taken from the first samples after reset(), and
+ * given a deadzone with the rest of the travel rescaled to 0..1, reaching 1
+ * a little before the rail.
+ *
+ * pushSample() runs in the ADC interrupt on the device, latest() in the render
+ * loop. The state is published as one 32 bit word (both axes in Q1.14), so a
+ * read never waits and never sees one axis from an older sample than the other.
+ * No pico-sdk dependency, the host tools feed it recorded or synthetic samples.
+ */
+class JoystickSampler {
+    public:
+        enum Axis : uint8_t { X = 0, Y = 1 };
+
+        inline static constexpr uint16_t ADC_MAX = 4095;                   // 12 bit conversions
+        inline static constexpr uint16_t ERROR_BIT = 0x8000;               // set in FIFO words of failed conversions
+        inline static constexpr uint8_t FILTER_SHIFT = 2;                  // moving average over about 4 samples
+        inline static constexpr uint16_t CALIBRATION_SAMPLES = 64;         // per axis, taken as the rest position
+        inline static constexpr uint16_t DEADZONE = 200;                   // in ADC counts around the rest position
+        inline static constexpr uint16_t EDGE_ZONE = 100;                  // counts short of either rail that already read full scale
+        inline static constexpr int16_t FULL_SCALE = 1 << 14;              // Q1.14 of the published axes
+
+        explicit JoystickSampler(Axis first_axis = X) : first_axis_(first_axis) { reset(); }
+
+        /// @brief Forget the filters and the rest position, the next CALIBRATION_SAMPLES per axis recalibrate
+        void reset() {
+            for (AxisFilter& filter : axes_) filter = AxisFilter{};
+            next_axis_ = first_axis_;
+            published_ = 0;
+            samples_ = 0;
+            errors_ = 0;
+        }
+
+        /**
+         * @brief Start the round robin again at first_axis, eg. after the ADC FIFO overflowed
+         * @note Filters and calibration are kept
+         */
+        void resync() {
+            next_axis_ = first_axis_;
+        }
+
+        /**
+         * @brief Feed one ADC FIFO word, the conversion of whichever axis is next in the round robin
+         * @note Failed conversions (ERROR_BIT) are dropped but still take their axis' turn
+         */
+        void pushSample(uint16_t word) {
+            const uint8_t axis = next_axis_;
+            next_axis_ ^= 1;
+
+            if ((word & ERROR_BIT) != 0) {
+                errors_++;
+                return;
+            }
+
+            samples_++;
+            axes_[axis].push(word & ADC_MAX);
+            publish();
+        }
+
+        /// @brief The most recent filtered position, all 0 until both axes are calibrated
+        [[nodiscard]] JoystickState latest() const {
+            const uint32_t packed = published_;
+
+            // Q1.14 to Q15.16
+            return JoystickState{
+                Fixed15_16::fromRaw(static_cast<int16_t>(packed & 0xFFFF) * 4),
+                Fixed15_16::fromRaw(static_cast<int16_t>(packed >> 16) * 4)
+            };
+        }
+
+        [[nodiscard]] bool calibrated() const { return axes_[X].calibrated() && axes_[Y].calibrated(); }
+
+        /// @brief Samples accepted and dropped since reset()
+        [[nodiscard]] uint32_t sampleCount() const { return samples_; }
+        [[nodiscard]] uint32_t errorCount() const { return errors_; }
+
+    private:
+        struct AxisFilter {
+            int32_t filtered = 0;   // Q4 ADC counts
+            int32_t center = 0;     // Q4 ADC counts, summed raw counts while calibrating
+            uint16_t seen = 0;
+
+            [[nodiscard]] bool calibrated() const { return seen >= CALIBRATION_SAMPLES; }
+
+            void push(uint16_t raw) {
+                const int32_t sample = static_cast<int32_t>(raw) << 4;
+
+                if (!calibrated()) {
+                    center += raw;
+                    filtered = sample;
+                    if (++seen == CALIBRATION_SAMPLES) center = (center << 4) / CALIBRATION_SAMPLES;
+                    return;
+                }
+
+                filtered += (sample - filtered) >> FILTER_SHIFT;
+            }
+
+            /// @brief Deflection in Q1.14, the travel past the deadzone on either side maps to 0..1
+            [[nodiscard]] int16_t value() const {
+                if (!calibrated()) return 0;
+
+                const int32_t deflection = filtered - center;
+                const int32_t magnitude = (deflection < 0) ? -deflection : deflection;
+                const int32_t dead = DEADZONE << 4;
+                if (magnitude <= dead) return 0;
+
+                // the rest position is rarely mid scale, each side gets its own span
+                // noisy sticks never sit on the rails, full scale comes a little before them
+                const int32_t span = ((deflection < 0) ? center : (ADC_MAX << 4) - center) - dead - (EDGE_ZONE << 4);
+                if (span <= 0) return 0;
+
+                int32_t scaled = (magnitude - dead) * FULL_SCALE / span;
+                if (scaled > FULL_SCALE) scaled = FULL_SCALE;
+
+                return static_cast<int16_t>((deflection < 0) ? -scaled : scaled);
+            }
+        };
+
+        AxisFilter axes_[2];
+        Axis first_axis_;
+        uint8_t next_axis_ = X;
+
+        // x in the low half, y in the high half, a single aligned store so readers never see half an update
+        volatile uint32_t published_ = 0;
+        uint32_t samples_ = 0;
+        uint32_t errors_ = 0;
+
+        void publish() {
+            published_ = static_cast<uint16_t>(axes_[X].value()) | (static_cast<uint32_t>(static_cast<uint16_t>(axes_[Y].value())) << 16);
+        }
+};
+
+/**
+ * @class AdcJoystick
+ * @brief The stick on two ADC inputs, converted continuously in round robin mode.
+ *
+ * The ADC free runs at SAMPLE_RATE_HZ conversions per second into its FIFO and
+ * raises an interrupt every two words, one per axis. The handler drains the FIFO
+ * into a JoystickSampler, so the render loop reads the latest position without
+ * touching the ADC. Only one instance can exist, it owns the ADC and its IRQ.
+ */
+class AdcJoystick {
+    public:
+        inline static constexpr uint32_t SAMPLE_RATE_HZ = 2000; // both axes, 1 kHz each
+
+        /**
+         * @param x_input ADC input of the x axis (GPIO 26 + input)
+         * @param y_input ADC input of the y axis
+         */
+        AdcJoystick(uint8_t x_input, uint8_t y_input);
+
+        /// @brief Set up the pins, the FIFO and the interrupt and start converting
+        void begin();
+
+        /// @brief Latest filtered position, O(1) and safe to call at any time
+        [[nodiscard]] JoystickState read() const { return sampler_.latest(); }
+
+        [[nodiscard]] const JoystickSampler& sampler() const { return sampler_; }
+
+    private:
+        uint8_t x_input_;
+        uint8_t y_input_;
+        JoystickSampler sampler_;
+
+        inline static AdcJoystick* instance_ = nullptr;
+
+        static void onFifoIrq();
+};
+
+#endif // JOYSTICK_H
@@ -0,0 +1,113 @@
+/**
+ * @file level_archive.hpp
+ * @brief Archive of several levels and the texture sets they use, linked or mapped as one blob.
+ */
+
+#ifndef LEVEL_ARCHIVE_H
+#define LEVEL_ARCHIVE_H
+
+#include <cstdint>
+
+#include "map_data.hpp"
+
+/**
+ * Layout, all offsets from the start of the archive:
+ *   LevelArchiveHeader
+ *   LevelEntry[level_count]             at levels_offset
+ *   TextureSetEntry[texture_set_count]  at texture_sets_offset
+ *   texture sets and maps, each a complete textures.xip / mapdata.xip blob
+ *
+ * Levels are handed out as pointers into the archive, nothing is copied, so
+ * switching level only rebinds views (see Level).
+ */
+struct LevelArchiveHeader {
+    inline static constexpr uint32_t VALID_MAGIC = 0x304C564C; // 'LVL0' reversed for little endian
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t level_count;
+    uint32_t texture_set_count;
+    uint32_t levels_offset;
+    uint32_t texture_sets_offset;
+    uint32_t reserved[2];
+};
+
+struct LevelEntry {
+    inline static constexpr uint8_t NAME_LENGTH = 20;
+
+    char name[NAME_LENGTH]; // zero terminated
+    uint32_t map_offset;
+    uint32_t map_size;
+    uint32_t texture_set;
+};
+
+struct TextureSetEntry {
+    uint32_t offset;
+    uint32_t size;
+};
+
+extern "C" {
+    // defined in assets_bin/levels.S
+    // kept as byte array for pointer math
+    extern const uint8_t levels_xip_blob[];
+    extern const uint8_t levels_xip_blob_end[];
+}
+
+/// @brief One level of an archive, both blobs point into the archive
+struct Level {
+    const char* name;
+    const uint8_t* map_blob;     // mapdata.xip layout
+    const uint8_t* texture_blob; // textures.xip layout
+    uint32_t texture_size;       // bytes of texture_blob
+
+    /// @brief Both blobs passed validation, see LevelArchive::getLevel()
+    [[nodiscard]] bool isValid() const {
+        return map_blob != nullptr && texture_blob != nullptr;
+    }
+};
+
+/**
+ * @class LevelArchive
+ * @brief Read-only view on a level archive in XIP flash or a host memory mapping
+ */
+class LevelArchive {
+    private:
+        const uint8_t* blob_;
+
+    public:
+        explicit LevelArchive(const uint8_t* blob = levels_xip_blob) : blob_(blob) {}
+
+        /// @brief Checks the archive magic, check BEFORE reading any level
+        [[nodiscard]] bool isValid() const;
+
+        [[nodiscard]] const LevelArchiveHeader* getHeader() const {
+            return reinterpret_cast<const LevelArchiveHeader*>(blob_);
+        }
+
+        [[nodiscard]] uint32_t levelCount() const {
+            return getHeader()->level_count;
+        }
+
+        /**
+         * @brief Views on the map and texture set of a level
+         * @note assumes the archive is valid, a blob that fails its header check is nullptr,
+         *       as are both blobs of an out of range level (see Level::isValid())
+         */
+        [[nodiscard]] Level getLevel(uint32_t index) const;
+};
+
+/**
+ * @brief Make a level the one being rendered
+ *
+ * Binds the level's texture set to the TextureManager and rebuilds its
+ * pointer cache, the only per-level SRAM state of the renderer. Caller owned
+ * state built from the map (HUD minimap, temporal history, SRAM tile copy)
+ * has to be refreshed by the caller.
+ *
+ * @param map Set to a view on the level's tiles in the archive
+ * @return false if the level failed validation, nothing is bound and map is left as it was
+ * @note assumes the archive is valid
+ */
+bool bindLevel(const Level& level, MapView& map);
+
+#endif // LEVEL_ARCHIVE_H
@@ -5,6 +5,7 @@
 #ifndef MAP_DATA_H
 #define MAP_DATA_H
 
+#include <cstddef>
 #include <cstdint>
 
 #include "fixed_point.hpp"
@@ -12,13 +13,59 @@
 struct MapFileHeader {
     inline static constexpr uint32_t VALID_MAGIC = 0x3050414D; // 'MAP0' reversed for little endian
 
+    /// @brief Layout with every field below, isMapDataValid() refuses any newer version
+    inline static constexpr uint32_t VERSION = 100002;
+
+    /// @brief Visible sets list the textures of their wall faces from this version on, older sets are not read (see getPvs())
+    inline static constexpr uint32_t PVS_FACES_VERSION = 100002;
+
+    /// @brief Maps packed before the layout was versioned, their headers end before some fields (see hasField())
+    inline static constexpr uint32_t FIRST_VERSION = 100000;
+
     uint32_t magic;
     uint32_t version;
     uint32_t playerdata_offset;
     uint32_t mapdata_offset;
-    uint32_t reserved;
+    uint32_t doors_offset; // 0 if the map has no doors
+
+    /**
+     * @brief Baked light of the wall faces, 0 if the map is unlit
+     * @note Added after the first maps were packed, only FIRST_VERSION headers can end before it
+     */
+    uint32_t lightmap_offset;
+
+    /**
+     * @brief Wall height per tile, 0 if every wall is one unit high
+     * @note Added after lightmaps, only FIRST_VERSION headers can end before it
+     */
+    uint32_t heights_offset;
+
+    /**
+     * @brief Potentially visible set of every open tile (see pvs.hpp), 0 if the map has none
+     * @note Added after wall heights, only FIRST_VERSION headers can end before it
+     */
+    uint32_t pvs_offset;
+
+    /**
+     * @brief The header has the field at this offset
+     * @note The version decides, a VERSION header has every field. FIRST_VERSION headers were written as the
+     *       fields were added and end wherever their player data starts
+     */
+    inline bool hasField(size_t field_offset) const {
+        if (version >= VERSION) return true;
+        return playerdata_offset >= field_offset + sizeof(uint32_t);
+    }
 };
 
+/// @brief Wall heights are stored in 1/16 units, one byte per tile in tile order (column major)
+inline constexpr uint8_t WALL_HEIGHT_ONE = 16;
+
+/**
+ * @brief Faces of a tile in the lightmap, 4 shade bytes per tile in tile order (column major)
+ * @note A ray running towards +x sees the tile's X_MIN face, so face = 2 * side + (ray runs towards -x / -y)
+ */
+enum class TileFace : uint8_t { X_MIN, X_MAX, Y_MIN, Y_MAX };
+
 extern "C" {
     // defined in assets_bin/map_data.S
     // kept as byte array for pointer math
@@ -33,11 +80,40 @@ struct PlayerData {
     Fixed15_16 dir_y;
 };
 
+/**
+ * @brief Door placed in the map file, the tile grid holds the door's tile at (x, y)
+ * @note Door sections are a uint32_t count followed by the doors
+ */
+struct DoorData {
+    uint8_t x;
+    uint8_t y;
+    uint8_t axis; // 0 if the door is passed along x (its plane is x = const), 1 along y
+    uint8_t reserved;
+};
+
+class TileOverlay;
+
+/// @note Not const members so a view can be rebound when the level changes, the tiles themselves stay read-only
 struct MapView {
-    const uint8_t width;
-    const uint8_t height;
+    uint8_t width;
+    uint8_t height;
+
+    const uint8_t* tile_data;
+
+    /// @brief Runtime changes to the tiles (doors, destroyed walls), nullptr for a static map
+    const TileOverlay* overlay = nullptr;
+
+    /// @brief Baked shade per tile face (see TileFace), nullptr for an unlit map
+    const uint8_t* lightmap = nullptr;
 
-    const uint8_t* const tile_data;
+    /// @brief Wall height per tile in WALL_HEIGHT_ONE units, nullptr if every wall is one unit high
+    const uint8_t* heights = nullptr;
+
+    /// @brief Highest wall of the map, bounds how far a column has to look past nearer walls
+    uint8_t max_height = WALL_HEIGHT_ONE;
+
+    /// @brief Potentially visible sets section (see pvs.hpp), nullptr if the map has none
+    const uint8_t* pvs = nullptr;
 
     /**
      * @brief Construct a MapView
@@ -55,20 +131,81 @@ struct MapView {
         return getTileUnchecked(x, y); // column major
     }
 
+    /**
+     * @brief Get the tile at (x, y) after the overlay, with bounds checking
+     * @note For collision and the minimap, doors count as solid until fully open. castRay reads the overlay itself
+     */
+    uint8_t getEffectiveTile(uint8_t x, uint8_t y) const;
+
+    /**
+     * @brief Baked shade of one face of the tile at (x, y), WITHOUT bounds checking
+     * @return 0 (full brightness) for an unlit map, otherwise below SHADE_COUNT
+     */
+    inline uint8_t getShade(uint8_t x, uint8_t y, TileFace face) const {
+        if (lightmap == nullptr) return 0;
+        return lightmap[((y + height * x) << 2) + static_cast<uint8_t>(face)];
+    }
+
+    /// @brief Wall height of the tile at (x, y) in WALL_HEIGHT_ONE units, WITHOUT bounds checking
+    inline uint8_t getWallHeight(uint8_t x, uint8_t y) const {
+        if (heights == nullptr) return WALL_HEIGHT_ONE;
+        return heights[y + height * x];
+    }
+
     /// @brief Get the tile at (x, y) WITHOUT bounds checking
     inline uint8_t getTileUnchecked(uint8_t x, uint8_t y) const {
         return tile_data[y + height * x]; // column major
     }
 };
 
-bool isMapDataValid();
+// all of these read the linked map_data_xip_blob unless given another blob
 
-const MapFileHeader* getMapFileHeader();
+bool isMapDataValid(const uint8_t* blob = map_data_xip_blob);
+
+const MapFileHeader* getMapFileHeader(const uint8_t* blob = map_data_xip_blob);
 
 /// @note assumes map file data is valid
-const PlayerData* getPlayerData();
+const PlayerData* getPlayerData(const uint8_t* blob = map_data_xip_blob);
 
 /// @note assumes map file data is valid
-MapView createMapView();
+MapView createMapView(const uint8_t* blob = map_data_xip_blob);
+
+/**
+ * @brief Doors of the map
+ * @param[out] count Number of doors, 0 if the map has none
+ * @note assumes map file data is valid
+ */
+const DoorData* getDoors(uint32_t& count, const uint8_t* blob = map_data_xip_blob);
+
+/**
+ * @brief Baked shades of the map, 4 per tile (see TileFace)
+ * @return nullptr if the map is unlit or was packed before lightmaps
+ * @note assumes map file data is valid, createMapView() already binds it
+ */
+const uint8_t* getLightmap(const uint8_t* blob = map_data_xip_blob);
+
+/**
+ * @brief Wall heights of the map, one per tile in WALL_HEIGHT_ONE units
+ * @return nullptr if every wall is one unit high or the map was packed before wall heights
+ * @note assumes map file data is valid, createMapView() already binds it
+ */
+const uint8_t* getWallHeights(const uint8_t* blob = map_data_xip_blob);
+
+/**
+ * @brief Potentially visible sets of the map, see pvs.hpp for the layout
+ * @return nullptr if the map has none or was packed before them, or before their face texture lists
+ * @note assumes map file data is valid, createMapView() already binds it
+ */
+const uint8_t* getPvs(const uint8_t* blob = map_data_xip_blob);
+
+/**
+ * @brief Copy the tiles of a map into a buffer, eg. to keep them in SRAM instead of XIP flash
+ * @param map Map to copy
+ * @param tiles Destination buffer
+ * @param capacity Size of the destination buffer in tiles
+ * @return View on the copy, or the original map if it does not fit
+ * @note The overlay, lightmap, wall heights and visible sets stay where they are
+ */
+MapView copyMapView(const MapView& map, uint8_t* tiles, size_t capacity);
 
 #endif // MAP_DATA_H
\ No newline at end of file
@@ -0,0 +1,121 @@
+/**
+ * @file pvs.hpp
+ * @brief Potentially visible sets baked into the map: the tiles and wall textures that can be seen from each open tile.
+ *
+ * Section layout at MapFileHeader::pvs_offset, offsets relative to the section:
+ *
+ *   uint32_t entries[width * height]   offset of each tile's set, 0 for tiles without one (walls)
+ *
+ * and at each entry:
+ *
+ *   uint32_t base                      offset of the bitset this one is stored against, 0 if it is stored whole
+ *   uint8_t texture_count
+ *   uint8_t tiles[texture_count]       wall tiles visible from the tile, the most seen first
+ *   uint8_t face_count
+ *   uint8_t faces[face_count]          textures of the faces of those walls, see faceTextures()
+ *   visibility bitset                  bit y + height * x for every tile, run length encoded
+ *
+ * The bitset is (width * height + 7) / 8 bytes once decoded. A non-zero byte
+ * stands for itself, a zero byte is followed by the number of zero bytes it
+ * stands for (1..255). Neighbouring tiles see nearly the same tiles, so one
+ * tile of every PVS_BLOCK x PVS_BLOCK block is stored whole and the others
+ * only as their difference (XOR) to it, which is mostly zero runs.
+ *
+ * Sets are built from the packed walls with doors open, so they stay
+ * conservative while doors move. The face textures are listed per set rather
+ * than found at runtime, which would scan every tile of the map on each tile
+ * crossing. Destroyed walls can reveal more than the set
+ * holds, call disable() once one is.
+ */
+
+#ifndef PVS_H
+#define PVS_H
+
+#include <cstdint>
+
+#include "map_data.hpp"
+
+/// @brief Tiles per side of the blocks that share a base set
+inline constexpr uint8_t PVS_BLOCK = 4;
+
+/**
+ * @class PotentiallyVisibleSet
+ * @brief The decoded set of the tile the camera stands on.
+ * @note Keeps a reference to the map like the renderers, call invalidate() after the view is rebound
+ */
+class PotentiallyVisibleSet {
+    public:
+        /// @brief Largest map (width * height) a set can be decoded for, bigger maps see every tile
+        inline static constexpr uint16_t MAX_TILES = 64 * 64;
+
+        explicit PotentiallyVisibleSet(const MapView& map) : map_(map) {}
+
+        /**
+         * @brief Decode the set of the tile at (x, y) if it is not the current one
+         * @return true if the set changed, eg. to prefetch its textures
+         * @note Tiles without a set (walls, maps without a PVS section) see every tile and have no texture list
+         */
+        bool update(int16_t x, int16_t y);
+
+        /// @brief Drop the decoded set, the next update() decodes again
+        void invalidate();
+
+        /// @brief Stop culling for the rest of the level, eg. after a wall was destroyed
+        void disable();
+
+        /// @brief A set is decoded, culling with isVisible() can skip tiles
+        [[nodiscard]] bool active() const { return active_; }
+
+        /// @brief The tile at (x, y) can be seen from the current tile, always true without an active set
+        [[nodiscard]] bool isVisible(int16_t x, int16_t y) const {
+            if (!active_) return true;
+            if (static_cast<uint16_t>(x) >= map_.width || static_cast<uint16_t>(y) >= map_.height) return false;
+            return isTileVisible(static_cast<uint16_t>(y + map_.height * x));
+        }
+
+        /// @brief isVisible() by column major tile index, which must lie inside the map
+        [[nodiscard]] bool isTileVisible(uint16_t tile) const {
+            if (!active_) return true;
+            return (bits_[tile >> 3] >> (tile & 7)) & 1;
+        }
+
+        /// @brief Wall tiles visible from the current tile, the most seen first
+        [[nodiscard]] const uint8_t* textures() const { return textures_; }
+        [[nodiscard]] uint8_t textureCount() const { return texture_count_; }
+
+        /**
+         * @brief Textures of the faces of visible walls, in textures() order, the ones with more faces first among a wall's
+         * @param textures Set to up to max texture indices of the bound texture set (see ColumnRenderer::wallTexture())
+         * @return Textures written, 0 without an active set
+         * @note A face counts if it borders an open tile, a lower wall or a door, whether or not a ray reaches it.
+         *       The list is baked into the set, this only copies it
+         */
+        uint8_t faceTextures(uint16_t* textures, uint8_t max) const;
+
+    private:
+        const MapView& map_;
+
+        int32_t tile_ = -1;     // tile the set was decoded for, -1 if none
+        bool active_ = false;
+        bool disabled_ = false;
+
+        uint8_t texture_count_ = 0;
+        uint8_t textures_[UINT8_MAX];
+
+        // face textures of the decoded set, read from the section where they are needed
+        uint8_t face_count_ = 0;
+        const uint8_t* faces_ = nullptr;
+        uint8_t bits_[MAX_TILES / 8];
+};
+
+/**
+ * @brief Decode one run length encoded bitset
+ * @param src Encoded bytes, see pvs.hpp
+ * @param dst Decoded bytes, or the base set to apply a difference to
+ * @param size Number of decoded bytes
+ * @param difference Apply src to dst as a difference (XOR) instead of overwriting it
+ * @return Bytes of src read
+ */
+uint32_t decodePvsBits(const uint8_t* src, uint8_t* dst, uint32_t size, bool difference = false);
+
+#endif // PVS_H
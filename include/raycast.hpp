@@ -0,0 +1,124 @@
+/**
+ * @file raycast.hpp
+ * @brief DDA ray traversal over a MapView, shared by the renderer and gameplay queries.
+ */
+
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "fixed_point.hpp"
+#include "map_data.hpp"
+#include "textures.hpp"
+
+struct Ray {
+    Fixed15_16 origin_x;
+    Fixed15_16 origin_y;
+
+    /// @note does not need to be normalised, distances are in multiples of its length
+    Fixed15_16 dir_x;
+    Fixed15_16 dir_y;
+};
+
+struct RayHit {
+    uint8_t tile;   // tile value that was hit, 0 if the ray missed
+    uint8_t side;   // 0 for x-sides, 1 for y-sides
+    uint8_t tex_x;  // texture column, 0 unless RayQueryOptions::compute_tex, door hits included
+    uint8_t shade;  // baked shade of the face that was hit, 0 unless RayQueryOptions::compute_tex, door hits included
+    int16_t map_x;
+    int16_t map_y;
+
+    /**
+     * @brief Distance along the ray to the hit, in multiples of the ray direction
+     * @note For camera rays (dir + plane * camera_x) this is the perpendicular
+     * wall distance, for unit length directions it is the euclidean distance.
+     */
+    Fixed15_16 distance;
+};
+
+struct RayQueryOptions {
+    /// @brief Rays that reach this distance without hitting anything report a miss
+    Fixed15_16 max_distance = Fixed15_16::fromRaw(INT32_MAX);
+
+    /// @brief Work out the texture column of the hit (not needed for line of sight)
+    bool compute_tex = true;
+
+    /// @brief log2 of the texture size the texture column is for
+    uint8_t tex_log2_size = TEX_LOG2_SIZE;
+
+    /// @brief Stop the batch at the first ray that hits something
+    bool stop_on_first_hit = false;
+};
+
+/**
+ * @brief Trace a single ray through the map until it hits a non-zero tile
+ * @param map Map to traverse
+ * @param ray Ray to trace
+ * @param options Query options
+ * @return The hit, tile is 0 if the ray left the map or passed max_distance
+ */
+RayHit castRay(const MapView& map, const Ray& ray, const RayQueryOptions& options = RayQueryOptions{});
+
+/**
+ * @brief Where a DDA walk stands: the tile it is in and the distances to the next grid lines
+ * @note Distances are in multiples of the ray direction like RayHit::distance
+ */
+struct DdaState {
+    int16_t map_x;
+    int16_t map_y;
+    Fixed15_16 side_dist_x;
+    Fixed15_16 side_dist_y;
+    Fixed15_16 delta_dist_x;
+    Fixed15_16 delta_dist_y;
+    int8_t step_x;
+    int8_t step_y;
+
+    /// @brief Set up the walk from the ray's origin, false if the ray has no direction
+    bool start(const Ray& ray);
+};
+
+/**
+ * @class RayWalk
+ * @brief A ray traced wall after wall, for walls that do not hide everything behind them (see MapView::heights)
+ * @note castRay() is the first step of a walk, kept apart so the common single hit keeps its state in registers
+ */
+class RayWalk {
+    public:
+        /// @note map is referenced, it has to outlive the walk
+        RayWalk(const MapView& map, const Ray& ray, const RayQueryOptions& options = RayQueryOptions{});
+
+        /**
+         * @brief Go on to the next wall along the ray
+         * @return The hit, tile is 0 once the ray left the map or passed max_distance, and for every call after that
+         */
+        RayHit next();
+
+    private:
+        const MapView& map_;
+        Ray ray_;
+        RayQueryOptions options_;
+        DdaState state_;
+        bool overlay_;
+        bool done_;
+};
+
+/**
+ * @brief Trace a batch of rays
+ * @param map Map to traverse
+ * @param rays Rays to trace
+ * @param hits Output, one per ray
+ * @param count Number of rays
+ * @param options Query options, applied to every ray
+ * @return Number of rays traced, less than count if stop_on_first_hit ended the batch early
+ */
+size_t castRays(const MapView& map, const Ray* rays, RayHit* hits, size_t count, const RayQueryOptions& options = RayQueryOptions{});
+
+/**
+ * @brief Check that nothing solid lies between two points
+ * @return true if the segment from (x0, y0) to (x1, y1) does not cross a wall
+ */
+bool hasLineOfSight(const MapView& map, Fixed15_16 x0, Fixed15_16 y0, Fixed15_16 x1, Fixed15_16 y1);
+
+#endif // RAYCAST_H
@@ -0,0 +1,75 @@
+/**
+ * @file render_config.hpp
+ * @brief Compile-time renderer configuration: resolution, texture size and column pixel type.
+ */
+
+#ifndef RENDER_CONFIG_H
+#define RENDER_CONFIG_H
+
+#include <cstdint>
+#include <type_traits>
+
+#include "fixed_point.hpp"
+#include "textures.hpp"
+
+/**
+ * @brief Convert a texel to the pixel type of a column buffer
+ * @note RGB565 in panel byte order is what the panels take, 0x00RRGGBB is for host sinks
+ */
+template <typename Pixel>
+[[nodiscard]] constexpr Pixel fromRgb565(uint16_t c) {
+    if constexpr (std::is_same_v<Pixel, uint16_t>) {
+        return c;
+    } else {
+        static_assert(std::is_same_v<Pixel, uint32_t>, "column pixels are RGB565 (uint16_t) or 0x00RRGGBB (uint32_t)");
+
+        const TexelRgb rgb = texelToRgb(c);
+        return (static_cast<uint32_t>(rgb.r) << 16) | (static_cast<uint32_t>(rgb.g) << 8) | rgb.b;
+    }
+}
+
+/**
+ * @struct RenderConfig
+ * @brief Everything the column renderer needs to know about its target at compile time.
+ *
+ * The renderer is instantiated per configuration so the screen and texture
+ * sizes fold into the inner loops as constants, and column buffers get their
+ * exact size and pixel type.
+ *
+ * @tparam Width Screen width in columns
+ * @tparam Height Screen height in rows, projected wall heights are int16_t so this stays well below that
+ * @tparam TexLog2Size log2 of the texture size, the bound texture blob has to match
+ * @tparam Pixel Column buffer pixel, see fromRgb565()
+ */
+template <uint16_t Width, uint16_t Height, uint8_t TexLog2Size = TEX_LOG2_SIZE, typename Pixel = uint16_t>
+struct RenderConfig {
+    static_assert(Width >= 2 && Width <= 1024, "screen width out of range");
+    static_assert(Height >= 2 && Height <= 1024, "screen height out of range");
+    static_assert(TexLog2Size >= 1 && TexLog2Size <= 7, "texture columns are addressed with a uint8_t tex_x");
+
+    inline static constexpr uint16_t WIDTH = Width;
+    inline static constexpr uint16_t HEIGHT = Height;
+
+    inline static constexpr uint8_t TEX_LOG2_SIZE = TexLog2Size;
+    inline static constexpr uint16_t TEX_SIZE = 1 << TexLog2Size;
+    inline static constexpr uint16_t TEX_MASK = TEX_SIZE - 1;
+    inline static constexpr Fixed15_16 TEX_SIZE_FP = Fixed15_16(TEX_SIZE);
+
+    /// @brief Camera plane length, the horizontal field of view is the same at every resolution
+    inline static constexpr Fixed15_16 FOV_SCALE = 0.66667_fp;
+
+    /// @brief Closest wall distance whose projected height still fits in an int16_t
+    inline static constexpr Fixed15_16 MIN_WALL_DIST = Fixed15_16::fromRaw((Height * Fixed15_16::ONE) / INT16_MAX + 1);
+
+    using pixel_t = Pixel;
+
+    /// @brief Smallest type that holds a screen column index
+    using column_index_t = std::conditional_t<(Width <= 256), uint8_t, uint16_t>;
+};
+
+/// @brief The ST7735 panel in landscape, what the firmware renders
+using St7735Config = RenderConfig<160, 128>;
+
+using DefaultRenderConfig = St7735Config;
+
+#endif // RENDER_CONFIG_H
@@ -0,0 +1,409 @@
+/**
+ * @file renderer.hpp
+ * @brief Fixed-point column renderer shared by the firmware and host tools.
+ */
+
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <cstdint>
+
+#include "column_fill.hpp"
+#include "fixed_point.hpp"
+#include "map_data.hpp"
+#include "raycast.hpp"
+#include "render_config.hpp"
+#include "textures.hpp"
+#include "vec2.hpp"
+
+// the firmware's screen, see DefaultRenderConfig
+inline constexpr uint16_t SCREEN_WIDTH = DefaultRenderConfig::WIDTH;
+inline constexpr uint16_t SCREEN_HEIGHT = DefaultRenderConfig::HEIGHT;
+
+inline constexpr Fixed15_16 FOV_SCALE = DefaultRenderConfig::FOV_SCALE;
+
+/// @brief Camera pose that a column is rendered from
+struct Camera {
+    Fixed15_16 pos_x;
+    Fixed15_16 pos_y;
+    Fixed15_16 dir_x;
+    Fixed15_16 dir_y;
+    Fixed15_16 plane_x;
+    Fixed15_16 plane_y;
+
+    [[nodiscard]] constexpr Vec2fp pos() const { return Vec2fp{pos_x, pos_y}; }
+    [[nodiscard]] constexpr Vec2fp dir() const { return Vec2fp{dir_x, dir_y}; }
+    [[nodiscard]] constexpr Vec2fp plane() const { return Vec2fp{plane_x, plane_y}; }
+
+    /// @brief Camera looking along the player direction, plane perpendicular to it
+    template <class Config = DefaultRenderConfig>
+    static constexpr Camera fromPlayer(const PlayerData& player) {
+        const Vec2fp plane = Vec2fp{player.dir_x, player.dir_y}.perpendicular() * Config::FOV_SCALE;
+
+        return Camera{
+            player.pos_x, player.pos_y,
+            player.dir_x, player.dir_y,
+            plane.x, plane.y
+        };
+    }
+};
+
+/// @brief Closest wall distance whose projected height still fits in an int16_t
+inline constexpr Fixed15_16 MIN_WALL_DIST = DefaultRenderConfig::MIN_WALL_DIST;
+
+/**
+ * @brief Rows [top, bottom) of a screen column that walls farther away can still show through
+ * @note Walls stand on the floor and are drawn front to back, each one closes the span from below
+ */
+struct ColumnSpan {
+    int16_t top;
+    int16_t bottom;
+
+    [[nodiscard]] bool closed() const { return top >= bottom; }
+};
+
+/**
+ * @brief Most walls one column composites, the nearest masked ones first
+ * @note A ray through more grates than this draws the farthest one it reached over whatever the column held
+ */
+inline constexpr uint8_t MAX_MASKED_LAYERS = 4;
+
+/**
+ * @class ColumnRenderer
+ * @brief The column renderer instantiated for one RenderConfig.
+ * @note The free functions below are the DefaultRenderConfig instance the firmware uses
+ * @note Always inlined, GCC ignores section attributes on template instances so the
+ * RAYCASTER_HOT wrappers are what puts the default instance into SRAM
+ */
+template <class Config>
+class ColumnRenderer {
+    public:
+        using pixel_t = typename Config::pixel_t;
+        using column_index_t = typename Config::column_index_t;
+
+        /// @brief Column buffer of exactly one screen column
+        using Column = pixel_t[Config::HEIGHT];
+
+        /**
+         * @brief Projected wall height for a perpendicular wall distance
+         * @note Larger than the screen for close walls so textures still scale properly
+         */
+        [[nodiscard]] static int16_t lineHeight(Fixed15_16 wall_dist) {
+            if (wall_dist < Config::MIN_WALL_DIST) wall_dist = Config::MIN_WALL_DIST;
+            return (Config::HEIGHT / wall_dist).toInt();
+        }
+
+        /// @brief Camera space ray for screen column x
+        [[nodiscard, gnu::always_inline]] static inline Ray cameraRay(const Camera& camera, column_index_t x);
+
+        /**
+         * @brief Texture a wall hit is drawn with
+         * @note y-sides use the shaded texture after the x-side one, baked light is applied when the column is filled
+         */
+        [[nodiscard, gnu::always_inline]] static inline uint16_t wallTexture(const RayHit& hit) {
+            return hit.tile - 1 + hit.side;
+        }
+
+        /**
+         * @brief The hit's texture column has transparent texels, see TextureManager::isColumnMasked()
+         * @note Opaque columns of a masked texture are false, they keep the single hit path
+         */
+        [[nodiscard, gnu::always_inline]] static inline bool isMasked(const RayHit& hit) {
+            return hit.tile != 0 && TextureManager::isColumnMasked(wallTexture(hit), hit.tex_x);
+        }
+
+        /// @brief Rows [draw_start, draw_end) drawWallColumn() draws for a projected wall height
+        [[gnu::always_inline]] static inline void wallRows(int16_t line_height, int16_t& draw_start, int16_t& draw_end) {
+            draw_start = (-line_height >> 1) + (Config::HEIGHT >> 1);
+            if (draw_start < 0) draw_start = 0;
+
+            draw_end = (line_height >> 1) + (Config::HEIGHT >> 1);
+            if (draw_end >= Config::HEIGHT) draw_end = Config::HEIGHT - 1;
+        }
+
+        /**
+         * @brief Texture a screen column for an already traced wall hit
+         * @param hit Wall hit, nothing is drawn for a miss
+         * @param column Output buffer of Config::HEIGHT pixels, rows outside the wall are left untouched
+         * @note Transparent texels of masked columns leave their rows untouched too
+         */
+        [[gnu::always_inline]] static inline void drawWallColumn(const RayHit& hit, pixel_t* column);
+
+        /// @brief Span of a column before any wall is drawn, the rows drawWallColumn() can draw to
+        [[nodiscard]] static constexpr ColumnSpan openSpan() { return ColumnSpan{0, Config::HEIGHT - 1}; }
+
+        /**
+         * @brief Texture the part of a wall of any height that is still open in a column, and close it off
+         * @param wall_height Height of the wall in WALL_HEIGHT_ONE units
+         * @param span Open rows of the column, shrunk by the wall
+         * @return true if any row was drawn
+         * @note A unit high wall on an open span draws the same pixels as drawWallColumn()
+         */
+        [[gnu::always_inline]] static inline bool drawWallSpan(const RayHit& hit, uint8_t wall_height, pixel_t* column, ColumnSpan& span);
+
+        /**
+         * @brief No wall of the map at or past this distance can show in the span
+         * @param max_height Highest wall of the map, see MapView::max_height
+         */
+        [[nodiscard]] static bool hidesAllBehind(Fixed15_16 distance, uint8_t max_height, const ColumnSpan& span);
+
+        /**
+         * @brief Texture every wall of a column that shows past the nearer ones, for maps with wall heights
+         * @param[out] layers Number of walls drawn
+         * @return The nearest wall hit
+         * @note The walk stops once the column is covered or no wall of the map could rise above what is drawn
+         */
+        [[gnu::always_inline]] static inline RayHit renderWallLayers(const MapView& map, const Ray& ray, pixel_t* column, uint8_t& layers);
+
+        /**
+         * @brief Texture the walls a column sees through masked texture columns, composited back to front
+         * @param[out] layers Number of walls drawn, at most MAX_MASKED_LAYERS
+         * @return The nearest wall hit
+         * @note The walk stops at the first opaque column, every wall is drawn with drawWallColumn() from the farthest one on
+         * @note Maps with wall heights composite in renderWallLayers() instead, which clips walls front to back, their masked
+         * columns show what the column held behind the transparent texels
+         */
+        [[gnu::always_inline]] static inline RayHit renderMaskedLayers(const MapView& map, const Ray& ray, pixel_t* column, uint8_t& layers);
+
+        /**
+         * @brief Raycast and texture a single screen column
+         * @return The wall hit for this column, the nearest one if the map has wall heights or the wall is masked
+         */
+        [[gnu::always_inline]] static inline RayHit renderColumn(const MapView& map, const Camera& camera, column_index_t x, pixel_t* column);
+
+    private:
+        /// @brief Texture rows [draw_start, draw_end) of the hit's wall, tex_pos is the texture row at draw_start
+        [[gnu::always_inline]] static inline void fillWall(const RayHit& hit, pixel_t* column, int16_t draw_start, int16_t draw_end,
+                                                           Fixed15_16 tex_pos, Fixed15_16 step);
+};
+
+template <class Config>
+Ray ColumnRenderer<Config>::cameraRay(const Camera& camera, column_index_t x) {
+    Fixed15_16 camera_x = (2 * Fixed15_16(x) / Fixed15_16(Config::WIDTH)) - 1;
+
+    const Vec2fp ray_dir = camera.dir().scaledAdd(camera.plane(), camera_x);
+
+    return Ray{camera.pos_x, camera.pos_y, ray_dir.x, ray_dir.y};
+}
+
+template <class Config>
+void ColumnRenderer<Config>::drawWallColumn(const RayHit& hit, pixel_t* column) {
+    // rays only miss if the map is not closed off by walls, leave the column empty then
+    if (hit.tile == 0) {
+        return;
+    }
+
+    int16_t line_height = lineHeight(hit.distance);
+
+    int16_t draw_start, draw_end;
+    wallRows(line_height, draw_start, draw_end);
+
+    // step through texture for each screen pixel
+    Fixed15_16 step = Config::TEX_SIZE_FP / Fixed15_16(line_height);
+
+    int16_t wall_top_coord = (Config::HEIGHT - line_height) >> 1;
+
+    // starting texture coordinate
+    Fixed15_16 tex_pos = (draw_start - wall_top_coord) * step;
+
+    fillWall(hit, column, draw_start, draw_end, tex_pos, step);
+}
+
+template <class Config>
+void ColumnRenderer<Config>::fillWall(const RayHit& hit, pixel_t* column, int16_t draw_start, int16_t draw_end, Fixed15_16 tex_pos, Fixed15_16 step) {
+    // pointer to the column of the texture we are sampling from
+    // since textures are stored column major for cache efficiency
+    const uint16_t texture = wallTexture(hit);
+#if RAYCASTER_PROCEDURAL_TEXTURES
+    // procedural textures generate the rows this column samples into scratch, still one read per texel after that
+    uint16_t scratch[Config::TEX_SIZE];
+    uint8_t first_row, last_row;
+    sampledRows<Config>(draw_start, draw_end, tex_pos, step, first_row, last_row);
+
+    const uint16_t* tex_column = TextureManager::getTextureColumn(texture, hit.tex_x, Config::TEX_LOG2_SIZE, scratch, first_row, last_row);
+#else
+    const uint16_t* tex_column = TextureManager::getTextureColumn(texture, hit.tex_x, Config::TEX_LOG2_SIZE);
+#endif
+
+    if (TextureManager::isColumnMasked(texture, hit.tex_x)) {
+        // the key is compared before darkening, so lit masked columns shade the rows they sample up front
+        uint16_t shaded[Config::TEX_SIZE];
+        if (hit.shade != 0) {
+            uint8_t shaded_first, shaded_last;
+            sampledRows<Config>(draw_start, draw_end, tex_pos, step, shaded_first, shaded_last);
+            shadeMaskedRows(tex_column, shaded, shaded_first, shaded_last, hit.shade, TextureManager::colorKey());
+            tex_column = shaded;
+        }
+
+        fillMaskedColumn<Config>(column, tex_column, TextureManager::colorKey(), draw_start, draw_end, tex_pos, step);
+        return;
+    }
+
+    fillTexturedColumn<Config>(column, tex_column, draw_start, draw_end, tex_pos, step, hit.shade);
+}
+
+template <class Config>
+bool ColumnRenderer<Config>::drawWallSpan(const RayHit& hit, uint8_t wall_height, pixel_t* column, ColumnSpan& span) {
+    const int16_t line_height = lineHeight(hit.distance);
+
+    // the foot of the wall is where a unit high wall's bottom is, it grows up from there
+    const int32_t bottom = (line_height >> 1) + (Config::HEIGHT >> 1);
+    const int32_t top = bottom - ((static_cast<int32_t>(line_height) * wall_height) >> 4);
+
+    const int16_t draw_start = static_cast<int16_t>(top > span.top ? top : span.top);
+    const int16_t draw_end = static_cast<int16_t>(bottom < span.bottom ? bottom : span.bottom);
+
+    // walls behind this one have their foot higher up the screen, nothing of them shows below its top
+    if (top < span.bottom) span.bottom = draw_start;
+
+    if (draw_start >= draw_end) {
+        return false;
+    }
+
+    const Fixed15_16 step = Config::TEX_SIZE_FP / Fixed15_16(line_height);
+    const int16_t wall_top_coord = (Config::HEIGHT - line_height) >> 1;
+
+    // the texture repeats every unit up from the foot, whole textures ahead keep tex_pos positive above the first one
+    Fixed15_16 tex_pos = (draw_start - wall_top_coord) * step;
+    if (wall_height > WALL_HEIGHT_ONE) tex_pos += Config::TEX_SIZE_FP * static_cast<int16_t>(wall_height / WALL_HEIGHT_ONE + 1);
+
+    fillWall(hit, column, draw_start, draw_end, tex_pos, step);
+
+    return true;
+}
+
+template <class Config>
+bool ColumnRenderer<Config>::hidesAllBehind(Fixed15_16 distance, uint8_t max_height, const ColumnSpan& span) {
+    if (span.closed()) return true;
+
+    // farther walls are smaller, the highest top one could reach is the tallest wall right here
+    // walls up to half a unit never reach above the horizon, however close
+    const int32_t line_height = lineHeight(distance);
+    const int32_t reach = (max_height > WALL_HEIGHT_ONE / 2) ? (line_height * (max_height - WALL_HEIGHT_ONE / 2)) >> 4 : 0;
+
+    // one row of slack for the rounding of drawWallSpan
+    return (Config::HEIGHT >> 1) - reach - 1 >= span.bottom;
+}
+
+template <class Config>
+RayHit ColumnRenderer<Config>::renderWallLayers(const MapView& map, const Ray& ray, pixel_t* column, uint8_t& layers) {
+    RayQueryOptions options;
+    options.tex_log2_size = Config::TEX_LOG2_SIZE;
+
+    RayWalk walk(map, ray, options);
+    ColumnSpan span = openSpan();
+
+    const RayHit nearest = walk.next();
+    RayHit hit = nearest;
+    layers = 0;
+
+    while (hit.tile != 0) {
+        layers += drawWallSpan(hit, map.getWallHeight(hit.map_x, hit.map_y), column, span);
+
+        if (hidesAllBehind(hit.distance, map.max_height, span)) break;
+
+        hit = walk.next();
+    }
+
+    return nearest;
+}
+
+template <class Config>
+RayHit ColumnRenderer<Config>::renderMaskedLayers(const MapView& map, const Ray& ray, pixel_t* column, uint8_t& layers) {
+    RayQueryOptions options;
+    options.tex_log2_size = Config::TEX_LOG2_SIZE;
+
+    RayWalk walk(map, ray, options);
+    RayHit hits[MAX_MASKED_LAYERS];
+
+    layers = 0;
+    RayHit hit = walk.next();
+
+    while (hit.tile != 0 && layers < MAX_MASKED_LAYERS) {
+        hits[layers++] = hit;
+        if (!isMasked(hit)) break;
+
+        hit = walk.next();
+    }
+
+    // farthest first, nearer walls only cover the rows their opaque texels reach
+    for (uint8_t i = layers; i-- > 0;) drawWallColumn(hits[i], column);
+
+    return (layers > 0) ? hits[0] : hit;
+}
+
+template <class Config>
+RayHit ColumnRenderer<Config>::renderColumn(const MapView& map, const Camera& camera, column_index_t x, pixel_t* column) {
+    if (map.heights != nullptr) {
+        uint8_t layers;
+        return renderWallLayers(map, cameraRay(camera, x), column, layers);
+    }
+
+    RayQueryOptions options;
+    options.tex_log2_size = Config::TEX_LOG2_SIZE;
+
+    const Ray ray = cameraRay(camera, x);
+    const RayHit hit = castRay(map, ray, options);
+
+    // only walls with a transparent column look past the first hit
+    if (isMasked(hit)) {
+        uint8_t layers;
+        return renderMaskedLayers(map, ray, column, layers);
+    }
+
+    drawWallColumn(hit, column);
+
+    return hit;
+}
+
+using DefaultColumnRenderer = ColumnRenderer<DefaultRenderConfig>;
+
+// the firmware renderer, DefaultColumnRenderer
+
+/**
+ * @brief Projected wall height for a perpendicular wall distance
+ * @note Larger than the screen for close walls so textures still scale properly
+ */
+[[nodiscard]] inline int16_t lineHeight(Fixed15_16 wall_dist) {
+    return DefaultColumnRenderer::lineHeight(wall_dist);
+}
+
+/**
+ * @brief Camera space ray for screen column x
+ */
+[[nodiscard]] Ray cameraRay(const Camera& camera, uint8_t x);
+
+/**
+ * @brief Texture a screen column for an already traced wall hit
+ * @param hit Wall hit, nothing is drawn for a miss
+ * @param column Output buffer of SCREEN_HEIGHT pixels, rows outside the wall are left untouched
+ */
+void drawWallColumn(const RayHit& hit, uint16_t* column);
+
+/**
+ * @brief Texture every wall of a column that shows past the nearer ones, for maps with wall heights
+ * @param column Output buffer of SCREEN_HEIGHT pixels, rows outside the walls are left untouched
+ * @param[out] layers Number of walls drawn
+ * @return The nearest wall hit
+ */
+RayHit renderWallLayers(const MapView& map, const Ray& ray, uint16_t* column, uint8_t& layers);
+
+/**
+ * @brief Texture the walls a column sees through masked texture columns, composited back to front
+ * @param column Output buffer of SCREEN_HEIGHT pixels, rows no wall covers are left untouched
+ * @param[out] layers Number of walls drawn, at most MAX_MASKED_LAYERS
+ * @return The nearest wall hit
+ */
+RayHit renderMaskedLayers(const MapView& map, const Ray& ray, uint16_t* column, uint8_t& layers);
+
+/**
+ * @brief Raycast and texture a single screen column
+ * @param map Map to render
+ * @param camera Camera pose
+ * @param x Screen column
+ * @param column Output buffer of SCREEN_HEIGHT pixels, rows outside the wall are left untouched
+ * @return The wall hit for this column, the nearest one if the map has wall heights
+ */
+RayHit renderColumn(const MapView& map, const Camera& camera, uint8_t x, uint16_t* column);
+
+#endif // RENDERER_H
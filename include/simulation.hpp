@@ -0,0 +1,123 @@
+/**
+ * @file simulation.hpp
+ * @brief Fixed timestep player simulation, decoupled from the frame rate.
+ */
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+
+#include "fixed_point.hpp"
+#include "fp_math.hpp"
+#include "joystick.hpp"
+#include "map_data.hpp"
+#include "renderer.hpp"
+
+/// @brief Simulation tick, the rate the old per column INPUT_DELAY gate moved the player at
+inline constexpr uint32_t SIM_TICK_US = 15000;
+
+/// @brief Most ticks run for one frame, a stalled frame drops the rest instead of falling further behind
+inline constexpr uint8_t SIM_MAX_TICKS = 8;
+
+/**
+ * @class FixedTimestep
+ * @brief Accumulates frame time and runs the simulation in whole ticks.
+ *
+ * The simulation always advances by the same step however long frames take, so
+ * movement speed does not depend on render speed. What is left over below one
+ * tick is carried to the next frame and gives the interpolation factor between
+ * the last two simulated states.
+ */
+class FixedTimestep {
+    public:
+        explicit FixedTimestep(uint32_t tick_us = SIM_TICK_US, uint8_t max_ticks = SIM_MAX_TICKS)
+            : tick_us_(tick_us), max_ticks_(max_ticks) {}
+
+        /// @brief Drop the carried time, eg. after a level switch
+        void reset() {
+            accumulator_us_ = 0;
+        }
+
+        /**
+         * @brief Add elapsed time and run every whole tick it completes
+         * @param tick Called once per tick, no arguments
+         * @return Ticks run, at most max_ticks
+         */
+        template <typename Tick>
+        uint8_t advance(uint32_t elapsed_us, Tick&& tick) {
+            accumulator_us_ += elapsed_us;
+
+            uint8_t ticks = 0;
+            while (accumulator_us_ >= tick_us_) {
+                if (ticks == max_ticks_) {
+                    // keep the phase, lose the backlog
+                    dropped_us_ += accumulator_us_ - accumulator_us_ % tick_us_;
+                    accumulator_us_ %= tick_us_;
+                    break;
+                }
+
+                tick();
+                accumulator_us_ -= tick_us_;
+                ticks++;
+            }
+
+            return ticks;
+        }
+
+        /// @brief How far the carried time is into the next tick, 0 up to (not including) 1
+        [[nodiscard]] Fixed15_16 alpha() const {
+            return Fixed15_16::fromRaw(static_cast<int32_t>((static_cast<uint64_t>(accumulator_us_) << 16) / tick_us_));
+        }
+
+        [[nodiscard]] uint32_t tickUs() const { return tick_us_; }
+
+        /// @brief Simulation time thrown away by the max_ticks limit
+        [[nodiscard]] uint32_t droppedUs() const { return dropped_us_; }
+
+    private:
+        uint32_t tick_us_;
+        uint8_t max_ticks_;
+        uint32_t accumulator_us_ = 0;
+        uint32_t dropped_us_ = 0;
+};
+
+/// @brief Turn per tick with the stick pushed all the way, 200 degrees a second
+inline constexpr angle16_t SIM_MAX_TURN = degreesToBam(3);
+
+/**
+ * @brief Simulated player, the view direction is kept as an angle
+ * @note The direction vector is derived from the heading whenever it is needed, so
+ * turning never accumulates rounding and the vector always has unit length.
+ */
+struct PlayerState {
+    Fixed15_16 pos_x;
+    Fixed15_16 pos_y;
+    angle16_t heading;
+
+    /// @brief State for a pose from the map file, the heading is the angle of its direction
+    [[nodiscard]] static PlayerState fromPose(const PlayerData& pose) {
+        return PlayerState{pose.pos_x, pose.pos_y, atan2Bam(pose.dir_y, pose.dir_x)};
+    }
+
+    /// @brief Pose with the unit direction of the heading
+    [[nodiscard]] constexpr PlayerData pose() const {
+        return PlayerData{pos_x, pos_y, cosBam(heading), sinBam(heading)};
+    }
+};
+
+/**
+ * @brief Advance the player by one simulation tick
+ * @param stick Filtered stick position, pushed past half way on y it moves a step,
+ *              x turns at a rate proportional to its deflection
+ */
+void stepPlayer(PlayerState& player, const MapView& map, const JoystickState& stick);
+
+/**
+ * @brief Camera for a frame, between the last two simulated states
+ * @param alpha 0 for previous, towards 1 for current, see FixedTimestep::alpha()
+ * @note The heading is blended the short way round the circle and the direction and plane derived from it
+ */
+[[nodiscard]] Camera interpolateCamera(const PlayerState& previous, const PlayerState& current, Fixed15_16 alpha);
+
+#endif // SIMULATION_H
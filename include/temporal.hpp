@@ -0,0 +1,108 @@
+/**
+ * @file temporal.hpp
+ * @brief Interlaced column rendering with reprojection of the previous frame's hits.
+ */
+
+#ifndef TEMPORAL_H
+#define TEMPORAL_H
+
+#include <cstdint>
+
+#include "column_cache.hpp"
+#include "map_data.hpp"
+#include "raycast.hpp"
+#include "renderer.hpp"
+
+static_assert(SCREEN_WIDTH <= 256, "TemporalRenderer indexes screen columns with uint8_t");
+
+/**
+ * @class TemporalRenderer
+ * @brief Raycasts only even or odd columns on alternate frames.
+ *
+ * Columns of the active parity are rendered first with fresh rays. The other
+ * columns reuse the wall line their previous frame hit: the new camera ray is
+ * intersected with that line analytically, which costs one divide instead of
+ * a DDA traversal. The reprojection is only trusted if the fresh neighbouring
+ * columns hit the same wall line with no gap between them, otherwise a fresh
+ * ray is cast. Hits near tiles changed by the map's overlay (doors, destroyed
+ * walls) are never reprojected. Maps with wall heights draw several walls per
+ * column, a single remembered hit cannot stand in for them, so every column is
+ * walked fresh there. Columns whose wall is masked are walked fresh as well.
+ */
+class TemporalRenderer {
+    public:
+        struct FrameStats {
+            uint16_t rays_cast;
+            uint16_t reprojected;
+            uint16_t layers; // walls drawn, more than one per column where short walls let farther ones show
+
+            /// @brief Average walls drawn per rendered column
+            [[nodiscard]] Fixed15_16 layersPerColumn() const {
+                const uint16_t columns = rays_cast + reprojected;
+                return (columns == 0) ? Fixed15_16(0) : Fixed15_16(layers) / Fixed15_16(columns);
+            }
+        };
+
+        explicit TemporalRenderer(const MapView& map);
+
+        /// @brief Toggle interlacing, when off every column casts a fresh ray
+        void setEnabled(bool enabled);
+        [[nodiscard]] bool isEnabled() const { return enabled_; }
+
+        /// @brief Drop all history, eg. after the map changes or the player teleports
+        void invalidate();
+
+        /**
+         * @brief Draw unit high walls through a column cache, nullptr to sample every column
+         * @note The cache outlives the renderer and is cleared by its owner when the texture blob changes
+         */
+        void setColumnCache(ColumnCache* cache) { column_cache_ = cache; }
+        [[nodiscard]] ColumnCache* columnCache() const { return column_cache_; }
+
+        /**
+         * @brief Start a new frame, every column of it is rendered from this camera
+         */
+        void beginFrame(const Camera& camera);
+
+        /**
+         * @brief Screen column to render i-th in the current frame
+         * @note Fresh columns come first so their neighbours are known when reprojecting
+         */
+        [[nodiscard]] uint8_t columnAt(uint8_t i) const;
+
+        /**
+         * @brief Render screen column x of the current frame
+         * @param column Output buffer of SCREEN_HEIGHT pixels, rows outside the wall are left untouched
+         */
+        RayHit renderColumn(uint8_t x, uint16_t* column);
+
+        /**
+         * @brief Hit of screen column x, this frame's once renderColumn() drew it, the previous frame's before
+         * @note The nearest wall of the column, what later stages read like a depth buffer, eg. sprites clip against distance
+         */
+        [[nodiscard]] const RayHit& hit(uint8_t x) const { return hits_[x]; }
+
+        /// @brief Stats of the current (or just finished) frame
+        [[nodiscard]] const FrameStats& frameStats() const { return stats_; }
+
+    private:
+        const MapView& map_;
+
+        bool enabled_ = false;
+        bool history_valid_ = false;   // hits_ holds a complete previous frame
+        bool discard_history_ = false;
+        uint8_t parity_ = 0;
+
+        Camera camera_{};
+        FrameStats stats_{};
+        ColumnCache* column_cache_ = nullptr;
+
+        // hit of every column, last frame's until the column is rendered this frame
+        RayHit hits_[SCREEN_WIDTH];
+        bool fresh_[SCREEN_WIDTH];
+
+        bool isReprojectable(uint8_t x, int16_t& across_min, int16_t& across_max) const;
+        bool reproject(const RayHit& previous, const Ray& ray, int16_t across_min, int16_t across_max, RayHit& out) const;
+};
+
+#endif // TEMPORAL_H
@@ -5,9 +5,12 @@
 #ifndef TEXTURES_H
 #define TEXTURES_H
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "fixed_point.hpp"
+#include "hot_path.hpp"
 
 // texture based constants
 
@@ -17,62 +20,560 @@ inline constexpr uint8_t TEX_SIZE = (1 << TEX_LOG2_SIZE);
 inline constexpr Fixed15_16 TEX_SIZE_FP = Fixed15_16(TEX_SIZE);
 inline constexpr uint8_t TEX_MASK = TEX_SIZE - 1; // for wrapping
 
+// baked lighting, shade s scales colours by (SHADE_COUNT - s) / SHADE_COUNT, 0 is full brightness
+inline constexpr uint8_t SHADE_COUNT = 16;
+
+// texel colours, texels and column buffers hold big endian RGB565 (the panel's byte order) so columns go out over SPI as they are
+
+/// @brief Swap a texel between panel byte order and native RGB565, split channels only after this
+[[nodiscard]] constexpr uint16_t swapTexelBytes(uint16_t c) {
+    return static_cast<uint16_t>(c << 8 | c >> 8);
+}
+
+/// @brief Panel byte order colour from a native RGB565 value, eg. 0xF800 for red
+[[nodiscard]] constexpr uint16_t panelColor(uint16_t rgb565) {
+    return swapTexelBytes(rgb565);
+}
+
+/// @brief 8 bit channels of a texel
+struct TexelRgb {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+};
+
+/// @brief Channels of a panel byte order texel, top bits replicated into the low ones so 0x1F maps to 0xFF
+[[nodiscard]] constexpr TexelRgb texelToRgb(uint16_t texel) {
+    const uint16_t c = swapTexelBytes(texel);
+    const uint8_t r = c >> 11;
+    const uint8_t g = (c >> 5) & 0x3F;
+    const uint8_t b = c & 0x1F;
+    return TexelRgb{static_cast<uint8_t>((r << 3) | (r >> 2)), static_cast<uint8_t>((g << 2) | (g >> 4)), static_cast<uint8_t>((b << 3) | (b >> 2))};
+}
+
+/// @brief Panel byte order texel from 8 bit channels, rounded to the nearest RGB565 step
+[[nodiscard]] constexpr uint16_t rgbToTexel(uint8_t r, uint8_t g, uint8_t b) {
+    return panelColor(static_cast<uint16_t>(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255)));
+}
+
+/**
+ * @brief Panel byte order texel darkened by a baked shade, every channel scaled to (SHADE_COUNT - shade) / SHADE_COUNT
+ * @note One multiply for all three channels, they are spread apart so each has room for its product
+ */
+[[nodiscard]] constexpr uint16_t shadeTexel(uint16_t texel, uint8_t shade) {
+    constexpr uint32_t CHANNELS = 0x07E0F81F; // green in the top half, red and blue in the bottom one
+
+    const uint32_t c = swapTexelBytes(texel);
+    const uint32_t spread = (c | c << 16) & CHANNELS;
+    const uint32_t scaled = ((spread * static_cast<uint32_t>(SHADE_COUNT - shade)) >> 4) & CHANNELS;
+
+    return swapTexelBytes(static_cast<uint16_t>(scaled | scaled >> 16));
+}
+static_assert(SHADE_COUNT == 16, "shadeTexel() divides by SHADE_COUNT with a shift");
+
 struct TextureFileHeader {
     inline static constexpr uint32_t VALID_MAGIC = 0x30504958; // 'XIP0' reversed for little endian
+    inline static constexpr uint32_t VERSION = 100002;         // the layout below, with column masks
 
     uint32_t magic;
     uint32_t version;
     uint32_t tex_count;
-    uint32_t reserved;
+
+    /**
+     * @brief Brightness levels packed, 0 or 1, the offset table holds tex_count entries
+     * @note Baked light darkens the texels a column samples when it is filled (see shadeTexel()),
+     * isValid() refuses sets packed with darker copies of every texture
+     */
+    uint32_t shade_levels;
+
+    /// @brief Texel value of transparent texels, compared as stored. Only used if mask_offset is set
+    uint16_t color_key;
+    uint16_t reserved;
+
+    /**
+     * @brief Offset of the column masks, 0 if every texture is opaque
+     * @note One uint64_t per offset table entry, bit x is set if column x of that texture has color_key
+     * texels. Columns with a clear bit are drawn like any opaque wall
+     */
+    uint32_t mask_offset;
+
+    /// @brief Offset table entries with this bit set point at a ProceduralTexture instead of texels
+    inline static constexpr uint32_t PROCEDURAL_OFFSET = 0x80000000;
 };
 
+/**
+ * @struct ProceduralTexture
+ * @brief Texture described by a small table and an integer kernel instead of TEX_SIZE * TEX_SIZE texels
+ *
+ * The packer only emits one when the kernel reproduces every texel of the
+ * source image, so a procedural texture renders exactly like the stored one.
+ * The table of table_size texels follows the 4 byte header.
+ */
+struct ProceduralTexture {
+    enum Kind : uint8_t {
+        CHECKERS = 0, // table[((x >> shift) ^ (y >> shift)) & 1]
+        XOR = 1,      // table[(x ^ y) >> shift]
+        RAMPS = 2,    // table[x] | table[TEX_SIZE + y], every bit follows only x or only y
+    };
+
+    inline static constexpr uint8_t KIND_COUNT = 3;
+
+    uint8_t kind;
+    uint8_t shift;
+    uint16_t table_size;
+
+    /// @brief Table texels a kind needs, 0 if the kind or shift is invalid
+    [[nodiscard]] static constexpr uint16_t tableSize(uint8_t kind, uint8_t shift) {
+        if (shift >= TEX_LOG2_SIZE) return 0;
+
+        switch (kind) {
+            case CHECKERS: return 2;
+            case XOR: return TEX_SIZE >> shift;
+            case RAMPS: return (shift == 0) ? 2 * TEX_SIZE : 0;
+            default: return 0;
+        }
+    }
+
+    [[nodiscard]] const uint16_t* table() const {
+        return reinterpret_cast<const uint16_t*>(this + 1);
+    }
+
+    /// @brief Texel (x, y) of the full size texture
+    [[nodiscard]] uint16_t texel(uint8_t x, uint8_t y) const {
+        const uint16_t* t = table();
+
+        switch (kind) {
+            case CHECKERS: return t[((x >> shift) ^ (y >> shift)) & 1];
+            case XOR: return t[(x ^ y) >> shift];
+            default: return t[x] | t[TEX_SIZE + y];
+        }
+    }
+
+    /**
+     * @brief Write one texture column, column major like a stored texture
+     * @param tex_x Column at the render texture size
+     * @param tex_log2_size log2 of the render texture size, at most TEX_LOG2_SIZE. Smaller
+     * sizes take every n-th texel, like a downsampled copy of the stored texture
+     * @param out (1 << tex_log2_size) texels
+     * @param first_row First row to write, rows outside [first_row, last_row] are left as they are
+     * @param last_row Last row to write, clamped to the column
+     */
+    [[gnu::always_inline]] inline void generateColumn(uint8_t tex_x, uint8_t tex_log2_size, uint16_t* out,
+                                                      uint8_t first_row = 0, uint8_t last_row = UINT8_MAX) const {
+        const uint8_t down = TEX_LOG2_SIZE - tex_log2_size;
+        const uint8_t size = 1 << tex_log2_size;
+        const uint8_t end = (last_row < size) ? last_row + 1 : size;
+        const uint8_t x = tex_x << down;
+        const uint16_t* t = table();
+
+        // x is fixed along a column
+        switch (kind) {
+            case CHECKERS:
+            case XOR: {
+                // (x ^ y) >> shift is (x >> shift) ^ (y >> shift), checkers keep the low bit of it
+                const uint8_t mask = (kind == CHECKERS) ? 1 : UINT8_MAX;
+                const uint8_t cell_x = x >> shift;
+
+                for (uint8_t y = first_row; y < end; y++) out[y] = t[(cell_x ^ ((y << down) >> shift)) & mask];
+                break;
+            }
+            default: {
+                const uint16_t column_bits = t[x];
+                const uint16_t* rows = t + TEX_SIZE;
+                for (uint8_t y = first_row; y < end; y++) out[y] = column_bits | rows[y << down];
+                break;
+            }
+        }
+    }
+};
+
+// blobs with procedural textures only bind with this, otherwise a wall column is always a stored one and
+// the per column sampler has no generator branch or scratch buffer
+#ifndef RAYCASTER_PROCEDURAL_TEXTURES
+#define RAYCASTER_PROCEDURAL_TEXTURES 0
+#endif
+
+// the firmware takes every texture set from the level archive and does not link textures.xip on its own
+#ifndef RAYCASTER_LINKED_TEXTURES
+#define RAYCASTER_LINKED_TEXTURES 1
+#endif
+
+#if RAYCASTER_LINKED_TEXTURES
 extern "C" {
     // defined in assets_bin/textures.S
     // kept as byte array for pointer math
     extern const uint8_t textures_xip_blob[]; 
     extern const uint8_t textures_xip_blob_end[];
 }
+#endif
 
 /**
  * @class TextureManager
  * @brief Manages access to textures stored in XIP memory.
+ * @note Reads the linked textures_xip_blob unless another blob is bound with setBlob(),
+ *       without RAYCASTER_LINKED_TEXTURES nothing is bound until then
  */
 class TextureManager {
     public:
-        /// @brief Retrieves the header of the textures data.
-        static const TextureFileHeader* getHeader() {
-            return reinterpret_cast<const TextureFileHeader*>(textures_xip_blob);
-        }
-        
-        /**
-         * @brief Retrieves pointer to texture data by index.
-         * @param texIndex Index of the texture to retrieve.
-         * @return Pointer to the texture data, or nullptr if index is out of bounds.
-         */
-        static const uint16_t* getTextureData(uint8_t texIndex) {
+        /// @brief Textures prefetch() keeps in SRAM, 8 KB each at the full texture size
+        inline static constexpr uint8_t SRAM_TEXTURE_SLOTS = 8;
+
+        /// @brief Bytes prefetchStep() copies per call by default, one column of a full size texture
+        inline static constexpr uint32_t PREFETCH_STEP_BYTES = TEX_SIZE * sizeof(uint16_t);
+
+    private:
+#if RAYCASTER_LINKED_TEXTURES
+        inline static const uint8_t* blob_ = textures_xip_blob;
+        inline static size_t blob_size_ = static_cast<size_t>(textures_xip_blob_end - textures_xip_blob);
+#else
+        inline static const uint8_t* blob_ = nullptr;
+        inline static size_t blob_size_ = 0;
+#endif
+
+#if RAYCASTER_SRAM_HOT_PATH
+        // one pointer per possible tile index, resolved once by cachePointers()
+        inline static constexpr uint16_t MAX_CACHED = 256;
+
+        inline static const uint8_t* cached_blob_ = nullptr;
+        inline static uint32_t cached_count_ = 0;
+        inline static const uint16_t* pointers_[MAX_CACHED] = {};
+#if RAYCASTER_PROCEDURAL_TEXTURES
+        inline static const ProceduralTexture* procedurals_[MAX_CACHED] = {};
+#endif
+
+        // textures copied out of flash by prefetchStep(), pointers_ points at them once they are complete
+        inline static constexpr uint16_t FREE_SLOT = UINT16_MAX;
+
+        inline static uint16_t slots_[SRAM_TEXTURE_SLOTS][TEX_SIZE * TEX_SIZE];
+        inline static uint16_t slot_texture_[SRAM_TEXTURE_SLOTS] = {FREE_SLOT, FREE_SLOT, FREE_SLOT, FREE_SLOT,
+                                                                    FREE_SLOT, FREE_SLOT, FREE_SLOT, FREE_SLOT};
+        static_assert(SRAM_TEXTURE_SLOTS == sizeof(slot_texture_) / sizeof(slot_texture_[0]), "every slot starts free");
+
+        // texels copied into each slot so far, a slot is resident at slot_texels_
+        inline static uint32_t slot_copied_[SRAM_TEXTURE_SLOTS] = {};
+        inline static uint32_t slot_texels_ = TEX_SIZE * TEX_SIZE;
+#endif
+
+        // column masks of the bound blob, nullptr if it has no masked textures
+        inline static const uint64_t* masks_ = nullptr;
+        inline static uint32_t mask_count_ = 0;
+        inline static uint16_t color_key_ = 0;
+
+        /// @brief Offset table entry of a texture, 0 (the header) if the index is out of bounds
+        static uint32_t tableEntry(uint16_t texIndex) {
             const TextureFileHeader* const header = getHeader();
             
             // bounds check 
             if (texIndex >= header->tex_count) {
-                return nullptr; 
+                return 0; 
             }
             
             // pointer to the location of the start of the offset array (after header ends)
-            const uint32_t* offset_array_addr = reinterpret_cast<const uint32_t*>(textures_xip_blob + sizeof(TextureFileHeader));
+            const uint32_t* offset_array_addr = reinterpret_cast<const uint32_t*>(blob_ + sizeof(TextureFileHeader));
     
-            uint32_t offset = offset_array_addr[texIndex];
+            return offset_array_addr[texIndex];
+        }
+
+        /// @brief Texels of a stored texture in the blob, nullptr if index is out of bounds or the texture is procedural
+        static const uint16_t* blobTextureData(uint16_t texIndex) {
+            const uint32_t offset = tableEntry(texIndex);
+
+            if (offset == 0 || (offset & TextureFileHeader::PROCEDURAL_OFFSET) != 0) {
+                return nullptr;
+            }
 
             // uint8 here because we want to move offset in bytes, not wider type
-            const uint8_t* texture_start_addr = textures_xip_blob + offset;
+            const uint8_t* texture_start_addr = blob_ + offset;
             
             // we are at the correct position and can cast back to uint16 (color)
             return reinterpret_cast<const uint16_t*>(texture_start_addr);
         }
 
+        static void buildMaskTable() {
+            const bool valid = isValid();
+            const bool masked = valid && getHeader()->mask_offset != 0;
+
+            masks_ = masked ? reinterpret_cast<const uint64_t*>(blob_ + getHeader()->mask_offset) : nullptr;
+            mask_count_ = masked ? getHeader()->tex_count : 0;
+            color_key_ = masked ? getHeader()->color_key : 0;
+        }
+
+    public:
+        /**
+         * @brief Bind a different texture blob (eg. memory mapped on the host)
+         * @note Not thread safe, bind before rendering starts
+         * @note Masked textures draw opaque until their blob is bound here
+         * @param size Bytes of the blob, isValid() checks the column masks end inside it
+         */
+        static void setBlob(const uint8_t* blob, size_t size) {
+            blob_ = blob;
+            blob_size_ = size;
+            buildMaskTable();
+        }
+
+        /// @brief Retrieves the header of the textures data.
+        static const TextureFileHeader* getHeader() {
+            return reinterpret_cast<const TextureFileHeader*>(blob_);
+        }
+        
+        /// @brief The bound blob has textures with transparent texels
+        static bool hasMasks() {
+            return masks_ != nullptr;
+        }
+
+        /// @brief Texel value of transparent texels, see hasMasks()
+        static uint16_t colorKey() {
+            return color_key_;
+        }
+
+        /**
+         * @brief A texture column has transparent texels, walls behind it can show through
+         * @note One null check for blobs without masked textures
+         */
+        [[gnu::always_inline]] static inline bool isColumnMasked(uint16_t texIndex, uint8_t tex_x) {
+            return masks_ != nullptr && texIndex < mask_count_ && ((masks_[texIndex] >> tex_x) & 1) != 0;
+        }
+
+        /**
+         * @brief Retrieves pointer to texture data by index.
+         * @param texIndex Index of the texture to retrieve
+         * @return Pointer to the texture data, or nullptr if index is out of bounds or the texture is procedural.
+         */
+        static const uint16_t* getTextureData(uint16_t texIndex) {
+#if RAYCASTER_SRAM_HOT_PATH
+            if (cached_blob_ == blob_ && texIndex < cached_count_) {
+                return pointers_[texIndex];
+            }
+#endif
+            return blobTextureData(texIndex);
+        }
+
+        /**
+         * @brief Retrieves the kernel of a procedural texture by index.
+         * @return Pointer to the descriptor, or nullptr if index is out of bounds or the texture is stored.
+         * @note Always nullptr without RAYCASTER_PROCEDURAL_TEXTURES, isValid() refuses blobs that have any
+         */
+        static const ProceduralTexture* getProcedural([[maybe_unused]] uint16_t texIndex) {
+#if !RAYCASTER_PROCEDURAL_TEXTURES
+            return nullptr;
+#else
+#if RAYCASTER_SRAM_HOT_PATH
+            if (cached_blob_ == blob_ && texIndex < cached_count_) {
+                return procedurals_[texIndex];
+            }
+#endif
+            const uint32_t offset = tableEntry(texIndex);
+
+            if ((offset & TextureFileHeader::PROCEDURAL_OFFSET) == 0) {
+                return nullptr;
+            }
+
+            return reinterpret_cast<const ProceduralTexture*>(blob_ + (offset & ~TextureFileHeader::PROCEDURAL_OFFSET));
+#endif
+        }
+
+        /**
+         * @brief Pointer to one column of a texture, stored or procedural
+         * @param tex_x Texture column
+         * @param tex_log2_size log2 of the texture size the caller samples at, the bound blob's stored textures have to match
+         * @param scratch (1 << tex_log2_size) texels, procedural columns are generated into it, unused without RAYCASTER_PROCEDURAL_TEXTURES
+         * @param first_row First row the caller samples, a procedural column only generates [first_row, last_row] into scratch
+         * @param last_row Last row the caller samples
+         * @return The stored column, scratch, or nullptr if index is out of bounds
+         */
+        [[gnu::always_inline]] static inline const uint16_t* getTextureColumn(uint16_t texIndex, uint8_t tex_x, uint8_t tex_log2_size,
+                                                                              [[maybe_unused]] uint16_t* scratch = nullptr,
+                                                                              [[maybe_unused]] uint8_t first_row = 0,
+                                                                              [[maybe_unused]] uint8_t last_row = UINT8_MAX) {
+            const uint16_t* texels = getTextureData(texIndex);
+#if !RAYCASTER_PROCEDURAL_TEXTURES
+            return (texels != nullptr) ? &texels[tex_x << tex_log2_size] : nullptr;
+#else
+            if (texels != nullptr) {
+                return &texels[tex_x << tex_log2_size];
+            }
+
+            const ProceduralTexture* procedural = getProcedural(texIndex);
+            if (procedural == nullptr) {
+                return nullptr;
+            }
+
+            procedural->generateColumn(tex_x, tex_log2_size, scratch, first_row, last_row);
+            return scratch;
+#endif
+        }
+
+        /**
+         * @brief Resolve every texture pointer of the bound blob into an SRAM table
+         * @note Only with the SRAM hot path build option, getTextureData() and getProcedural() then skip the header and offset reads from flash
+         * @note Call after isValid(), binding another blob falls back to the uncached lookup
+         * @note Textures past MAX_CACHED keep the uncached lookup
+         */
+        static void cachePointers() {
+#if RAYCASTER_SRAM_HOT_PATH
+            cached_blob_ = nullptr; // uncached lookups while filling
+
+            const uint32_t count = getHeader()->tex_count;
+            cached_count_ = (count < MAX_CACHED) ? count : MAX_CACHED;
+
+            for (uint32_t i = 0; i < cached_count_; i++) {
+                pointers_[i] = getTextureData(static_cast<uint16_t>(i));
+#if RAYCASTER_PROCEDURAL_TEXTURES
+                procedurals_[i] = getProcedural(static_cast<uint16_t>(i));
+#endif
+            }
+
+            // the pointers lead back to flash, so nothing is resident any more
+            for (uint16_t& texture : slot_texture_) texture = FREE_SLOT;
+
+            cached_blob_ = blob_;
+#endif
+        }
+
+        /**
+         * @brief Queue the listed textures for SRAM, the first ones first, prefetchStep() copies them
+         * @param textures Texture indices, eg. PotentiallyVisibleSet::faceTextures()
+         * @param tex_log2_size log2 of the texture size the bound blob stores
+         * @return Textures queued, those already resident or queued are kept and not counted
+         * @note Only with the SRAM hot path build option and after cachePointers(), otherwise a no-op
+         * @note Up to SRAM_TEXTURE_SLOTS stored textures. Textures no longer listed go back to being read
+         *       from flash right away, queued ones are read from flash until their copy completes
+         */
+        static uint8_t prefetch(const uint16_t* textures, uint8_t count, uint8_t tex_log2_size = TEX_LOG2_SIZE) {
+#if RAYCASTER_SRAM_HOT_PATH
+            if (cached_blob_ != blob_) return 0;
+
+            // keep the stored ones that fit
+            uint16_t wanted[SRAM_TEXTURE_SLOTS];
+            uint8_t wanted_count = 0;
+
+            auto slotOf = [](uint16_t texture) {
+                for (uint8_t s = 0; s < SRAM_TEXTURE_SLOTS; s++) {
+                    if (slot_texture_[s] == texture) return s;
+                }
+                return SRAM_TEXTURE_SLOTS;
+            };
+            auto isWanted = [&](uint16_t texture) {
+                for (uint8_t w = 0; w < wanted_count; w++) {
+                    if (wanted[w] == texture) return true;
+                }
+                return false;
+            };
+
+            for (uint8_t i = 0; i < count && wanted_count < SRAM_TEXTURE_SLOTS; i++) {
+                if (textures[i] >= cached_count_ || isWanted(textures[i]) || blobTextureData(textures[i]) == nullptr) continue;
+                wanted[wanted_count++] = textures[i];
+            }
+
+            // copies of another texture size are stale
+            const uint32_t texels = 1u << (2 * tex_log2_size);
+            const bool resized = texels != slot_texels_;
+            slot_texels_ = texels;
+
+            // evict first so the new textures find free slots
+            for (uint8_t s = 0; s < SRAM_TEXTURE_SLOTS; s++) {
+                if (slot_texture_[s] == FREE_SLOT || (!resized && isWanted(slot_texture_[s]))) continue;
+                pointers_[slot_texture_[s]] = blobTextureData(slot_texture_[s]);
+                slot_texture_[s] = FREE_SLOT;
+            }
+
+            uint8_t queued = 0;
+
+            for (uint8_t w = 0; w < wanted_count; w++) {
+                if (slotOf(wanted[w]) != SRAM_TEXTURE_SLOTS) continue; // resident or queued already
+
+                const uint8_t s = slotOf(FREE_SLOT);
+                slot_texture_[s] = wanted[w];
+                slot_copied_[s] = 0;
+                queued++;
+            }
+
+            return queued;
+#else
+            (void)textures;
+            (void)count;
+            (void)tex_log2_size;
+            return 0;
+#endif
+        }
+
+        /**
+         * @brief Copy the next part of the textures prefetch() queued, eg. once per screen column
+         * @param max_bytes Bytes to copy at most, the copy out of flash is spread over calls instead of stalling one frame
+         * @return Bytes copied, 0 once every queued texture is resident
+         * @note A texture is drawn from SRAM once all of it is copied, in queue order
+         */
+        static uint32_t prefetchStep(uint32_t max_bytes = PREFETCH_STEP_BYTES) {
+#if RAYCASTER_SRAM_HOT_PATH
+            if (cached_blob_ != blob_) return 0;
+
+            uint32_t budget = max_bytes / sizeof(uint16_t);
+            uint32_t copied = 0;
+
+            for (uint8_t s = 0; s < SRAM_TEXTURE_SLOTS && budget > 0; s++) {
+                const uint16_t texture = slot_texture_[s];
+                if (texture == FREE_SLOT || slot_copied_[s] == slot_texels_) continue;
+
+                const uint32_t remaining = slot_texels_ - slot_copied_[s];
+                const uint32_t texels = (remaining < budget) ? remaining : budget;
+                memcpy(slots_[s] + slot_copied_[s], blobTextureData(texture) + slot_copied_[s], texels * sizeof(uint16_t));
+
+                slot_copied_[s] += texels;
+                budget -= texels;
+                copied += texels;
+
+                if (slot_copied_[s] == slot_texels_) pointers_[texture] = slots_[s];
+            }
+
+            return copied * sizeof(uint16_t);
+#else
+            (void)max_bytes;
+            return 0;
+#endif
+        }
+
+        /**
+         * @brief Checks the magic and format version of a texture blob, that it has no shade levels and that its column masks end inside it
+         * @note nullptr is not valid. The offset table and the textures are trusted, the packer checks those,
+         *       except that without RAYCASTER_PROCEDURAL_TEXTURES no entry may be procedural
+         */
+        static bool isValid(const uint8_t* blob, size_t size) {
+            if (blob == nullptr || size < sizeof(TextureFileHeader)) {
+                return false;
+            }
+
+            const TextureFileHeader* header = reinterpret_cast<const TextureFileHeader*>(blob);
+            if (header->magic != TextureFileHeader::VALID_MAGIC || header->version != TextureFileHeader::VERSION || header->shade_levels > 1) {
+                return false;
+            }
+
+            const size_t count = header->tex_count;
+
+#if !RAYCASTER_PROCEDURAL_TEXTURES
+            // the sampler has no generator, so every texture has to be stored
+            const size_t table_size = count * sizeof(uint32_t);
+            if (table_size > size - sizeof(TextureFileHeader)) {
+                return false;
+            }
+            for (size_t i = 0; i < count; i++) {
+                uint32_t offset;
+                memcpy(&offset, blob + sizeof(TextureFileHeader) + i * sizeof(uint32_t), sizeof(offset));
+                if ((offset & TextureFileHeader::PROCEDURAL_OFFSET) != 0) {
+                    return false;
+                }
+            }
+#endif
+
+            // one column mask per offset table entry
+            const size_t masks_size = count * sizeof(uint64_t);
+            return header->mask_offset == 0 ||
+                   (header->mask_offset % alignof(uint64_t) == 0 && header->mask_offset <= size && masks_size <= size - header->mask_offset);
+        }
+
         /// @brief Checks if the texture data in XIP memory is valid.
         /// @note Check BEFORE attempting to access any textures! 
         static bool isValid() {
-            return getHeader()->magic == TextureFileHeader::VALID_MAGIC;
+            return isValid(blob_, blob_size_);
         }
 };
 
@@ -0,0 +1,111 @@
+/**
+ * @file tile_overlay.hpp
+ * @brief Sparse runtime changes on top of the read-only map tiles: doors and destroyed walls.
+ */
+
+#ifndef TILE_OVERLAY_H
+#define TILE_OVERLAY_H
+
+#include <cstdint>
+
+#include "fixed_point.hpp"
+#include "map_data.hpp"
+
+/**
+ * @class TileOverlay
+ * @brief Small open addressing table of modified tiles, consulted by the DDA.
+ *
+ * The map tiles stay in flash (or their SRAM copy) untouched. Only walls of
+ * the map can be changed (a door's tile is its texture), so the DDA looks at
+ * the overlay only where it would otherwise stop. A coarse bitmap with one
+ * bit per 4x4 tile block then decides whether the table is probed at all.
+ */
+class TileOverlay {
+    public:
+        inline static constexpr uint8_t CAPACITY = 64;              // power of two
+        inline static constexpr uint8_t MAX_ENTRIES = CAPACITY * 3 / 4; // keeps probe chains short
+        inline static constexpr uint8_t MAX_DOORS = MAX_ENTRIES / 2;     // the rest is left for destroyed walls
+        inline static constexpr uint8_t BLOCK_LOG2 = 2;             // 4x4 tiles per bitmap bit
+        inline static constexpr uint32_t DOOR_OPEN_US = 1000000;    // time for a door to slide fully open
+
+        enum class Kind : uint8_t { TILE, DOOR };
+
+        struct Entry {
+            uint8_t x;
+            uint8_t y;
+            uint8_t tile;   // replacement tile, or the door's texture tile
+            Kind kind;
+            uint8_t axis;   // doors only, see DoorData::axis
+            int8_t motion;  // doors only, 1 opening, -1 closing, 0 still
+            bool used;
+
+            /// @brief Doors only, how far the panel has slid out of the way, 0 closed to 1 open
+            Fixed15_16 open;
+        };
+
+        TileOverlay() { reset(); }
+
+        /// @brief Drop every modification, eg. when a level is bound
+        void reset();
+
+        [[nodiscard]] bool empty() const { return count_ == 0; }
+        [[nodiscard]] uint8_t count() const { return count_; }
+
+        /**
+         * @brief Replace the wall at (x, y), 0 destroys it
+         * @note Empty map tiles can not be changed, the DDA does not look at the overlay there
+         * @return false if the overlay is full
+         */
+        bool setTile(uint8_t x, uint8_t y, uint8_t tile);
+
+        /**
+         * @brief Place a closed door at (x, y)
+         * @param tile Texture tile of the door panel, the map tile at (x, y) must not be empty
+         * @return false if the overlay is full
+         */
+        bool addDoor(uint8_t x, uint8_t y, uint8_t axis, uint8_t tile);
+
+        /**
+         * @brief Add the doors of a map file, their texture is the tile under them
+         * @return Number of doors added
+         */
+        uint8_t loadDoors(const uint8_t* blob, const MapView& map);
+
+        /**
+         * @brief Start opening a closed (or closing) door at (x, y), or closing an open one
+         * @return false if there is no door at (x, y)
+         */
+        bool toggleDoor(uint8_t x, uint8_t y);
+
+        /**
+         * @brief Advance the door animations
+         * @return true if a door became passable or solid, the minimap needs rebuilding
+         */
+        bool update(uint32_t elapsed_us);
+
+        /// @brief Coarse test, false means (x, y) certainly has no entry
+        [[nodiscard]] inline bool mayBeModified(uint8_t x, uint8_t y) const {
+            const uint16_t bit = ((y >> BLOCK_LOG2) << (8 - BLOCK_LOG2)) | (x >> BLOCK_LOG2);
+            return (blocks_[bit >> 5] >> (bit & 31)) & 1;
+        }
+
+        /// @brief Entry at (x, y), nullptr if the tile is unmodified
+        [[nodiscard]] const Entry* find(uint8_t x, uint8_t y) const;
+
+    private:
+        Entry entries_[CAPACITY];
+        uint8_t count_ = 0;
+
+        // one bit per block of a 256x256 map
+        uint32_t blocks_[(256 >> BLOCK_LOG2) * (256 >> BLOCK_LOG2) / 32];
+
+        static uint8_t slot(uint8_t x, uint8_t y) { return (x * 31 + y) & (CAPACITY - 1); }
+
+        /// @brief Slot of (x, y), CAPACITY if it has none
+        uint8_t indexOf(uint8_t x, uint8_t y) const;
+
+        /// @brief Entry at (x, y), a fresh one if missing, nullptr if the table is full
+        Entry* insert(uint8_t x, uint8_t y);
+};
+
+#endif // TILE_OVERLAY_H
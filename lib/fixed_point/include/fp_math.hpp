@@ -104,6 +104,82 @@ static constexpr auto FP_SIN_TABLE = generateSinTable();
 [[nodiscard]] constexpr Fixed15_16 sinfp(Fixed15_16 angleDeg) { return sinfp(angleDeg.toInt()); }
 [[nodiscard]] constexpr Fixed15_16 cosfp(Fixed15_16 angleDeg) { return cosfp(angleDeg.toInt()); }
 
+/**
+ * @brief Binary angle (BAM), the full circle in 16 bits
+ * @note Adding and subtracting wraps around the circle for free, 0x4000 is 90 degrees
+ */
+using angle16_t = uint16_t;
+
+inline constexpr angle16_t BAM_QUARTER = 0x4000;
+inline constexpr angle16_t BAM_HALF = 0x8000;
+
+namespace {
+
+    inline constexpr uint8_t BAM_SEGMENT_SHIFT = 6;                                   // 64 angles per table segment
+    inline constexpr uint16_t BAM_LUT_SEGMENTS = BAM_QUARTER >> BAM_SEGMENT_SHIFT;    // 256 over the quarter wave
+
+    /**
+     * @brief Generate the quarter wave sine table for binary angles, raw Q16.16
+     * @return BAM_LUT_SEGMENTS + 1 entries, the last is sin(90 degrees) so every segment has both ends
+     * @note compile-time evaluation, the linear interpolation between entries stays below one Q16 step
+     */
+    consteval std::array<int32_t, BAM_LUT_SEGMENTS + 1> generateBamSinTable() {
+        std::array<int32_t, BAM_LUT_SEGMENTS + 1> table{};
+
+        for (size_t i = 0; i <= BAM_LUT_SEGMENTS; i++) {
+            double rad = i * (std::numbers::pi / 2.0) / BAM_LUT_SEGMENTS;
+
+            table[i] = static_cast<int32_t>(cxprTaylorSin(rad) * Fixed15_16::ONE + 0.5);
+        }
+
+        return table;
+    }
+
+} // consteval namespace
+
+static constexpr auto FP_BAM_SIN_TABLE = generateBamSinTable();
+
+/**
+ * @brief Sine of a binary angle, quarter wave lookup with linear interpolation
+ * @param a Angle, 0x10000 per turn
+ * @return Sine in Fixed15_16, within 2 raw steps of the exact value, exactly 0 and 1 on the axes
+ */
+[[nodiscard]] constexpr Fixed15_16 sinBam(angle16_t a) {
+    // the falling half of each lobe reads the quarter wave backwards, the lower half circle negates it
+    uint16_t offset = a & (BAM_QUARTER - 1);
+    if ((a & BAM_QUARTER) != 0) offset = BAM_QUARTER - offset;
+
+    const uint16_t index = offset >> BAM_SEGMENT_SHIFT;
+    const int32_t frac = offset & ((1 << BAM_SEGMENT_SHIFT) - 1);
+
+    int32_t value = FP_BAM_SIN_TABLE[index];
+    if (frac != 0) {
+        // frac is 0 at the top entry, so index + 1 is always in the table here
+        value += ((FP_BAM_SIN_TABLE[index + 1] - value) * frac + (1 << (BAM_SEGMENT_SHIFT - 1))) >> BAM_SEGMENT_SHIFT;
+    }
+
+    return Fixed15_16::fromRaw((a & BAM_HALF) != 0 ? -value : value);
+}
+
+[[nodiscard]] constexpr Fixed15_16 cosBam(angle16_t a) {
+    return sinBam(static_cast<angle16_t>(a + BAM_QUARTER));
+}
+
+/// @brief Whole degrees to a binary angle, rounded to the nearest step
+[[nodiscard]] constexpr angle16_t degreesToBam(int16_t degrees) {
+    const int32_t scaled = (static_cast<int32_t>(degrees) * 0x10000 + (degrees < 0 ? -180 : 180)) / 360;
+    return static_cast<angle16_t>(scaled);
+}
+
+/**
+ * @brief Angle of a direction vector, the inverse of (cosBam, sinBam)
+ * @note Uses the FPU, meant for loading a pose rather than per frame work
+ */
+[[nodiscard]] inline angle16_t atan2Bam(Fixed15_16 y, Fixed15_16 x) {
+    const float turns = std::atan2(y.toFloat(), x.toFloat()) / (2.0f * std::numbers::pi_v<float>);
+    return static_cast<angle16_t>(static_cast<int32_t>(std::lround(turns * 0x10000)));
+}
+
 /// @brief Floor function for Fixed15_16
 [[nodiscard]] constexpr Fixed15_16 floor(Fixed15_16 val) noexcept {
     return Fixed15_16::fromRaw(val.toRaw() & 0xFFFF0000);
@@ -0,0 +1,109 @@
+/**
+ * @file vec2.hpp
+ * @brief 2D vectors with fused multiply-accumulate kernels for Fixed15_16.
+ *
+ * Sums of products like a dot product or a rotation keep the full 64 bit
+ * products and round once at the end, instead of truncating every product
+ * on its own. On the M33 that is SMLAL per term onto an accumulator preloaded
+ * with the rounding half, so rounding costs nothing over truncating.
+ * Everything is constexpr so the kernels also work in consteval table generation.
+ */
+
+#ifndef VEC2_H
+#define VEC2_H
+
+#include <cstdint>
+
+#include "fixed_point.hpp"
+
+// =====================================================================
+// Fused kernels
+// =====================================================================
+
+/// @brief a * b + c * d, generic types multiply and add as usual
+template <typename T>
+[[nodiscard]] constexpr T mulAdd(const T a, const T b, const T c, const T d) noexcept { return a * b + c * d; }
+
+/// @brief a * b - c * d
+template <typename T>
+[[nodiscard]] constexpr T mulSub(const T a, const T b, const T c, const T d) noexcept { return a * b - c * d; }
+
+/// @brief acc + a * b
+template <typename T>
+[[nodiscard]] constexpr T mulAcc(const T acc, const T a, const T b) noexcept { return acc + a * b; }
+
+namespace {
+    inline constexpr int64_t FUSED_ROUND = int64_t{1} << 15; // half a step below the shift
+}
+
+/**
+ * @brief a * b + c * d accumulated in 64 bits and rounded once
+ * @note Within half a step of the exact sum, truncating each product on its own can be almost two steps low
+ */
+[[nodiscard]] constexpr Fixed15_16 mulAdd(const Fixed15_16 a, const Fixed15_16 b, const Fixed15_16 c, const Fixed15_16 d) noexcept {
+    const int64_t acc = FUSED_ROUND + static_cast<int64_t>(a.toRaw()) * b.toRaw() + static_cast<int64_t>(c.toRaw()) * d.toRaw();
+    return Fixed15_16::fromRaw(static_cast<int32_t>(acc >> 16));
+}
+
+/// @brief a * b - c * d accumulated in 64 bits and rounded once
+[[nodiscard]] constexpr Fixed15_16 mulSub(const Fixed15_16 a, const Fixed15_16 b, const Fixed15_16 c, const Fixed15_16 d) noexcept {
+    const int64_t acc = FUSED_ROUND + static_cast<int64_t>(a.toRaw()) * b.toRaw() - static_cast<int64_t>(c.toRaw()) * d.toRaw();
+    return Fixed15_16::fromRaw(static_cast<int32_t>(acc >> 16));
+}
+
+/**
+ * @brief acc + a * b with acc added to the full product
+ * @note Truncates like the plain operators, so this is bit for bit acc + a * b and
+ * camera rays come out exactly as before
+ */
+[[nodiscard]] constexpr Fixed15_16 mulAcc(const Fixed15_16 acc, const Fixed15_16 a, const Fixed15_16 b) noexcept {
+    const int64_t sum = (static_cast<int64_t>(acc.toRaw()) << 16) + static_cast<int64_t>(a.toRaw()) * b.toRaw();
+    return Fixed15_16::fromRaw(static_cast<int32_t>(sum >> 16));
+}
+
+// =====================================================================
+// Vec2
+// =====================================================================
+
+/**
+ * @class Vec2
+ * @brief A 2D vector, x and y of any number type.
+ * @note Products of pairs go through mulAdd / mulSub / mulAcc, fused for Fixed15_16
+ */
+template <typename T>
+struct Vec2 {
+    T x;
+    T y;
+
+    friend constexpr bool operator==(const Vec2& lhs, const Vec2& rhs) noexcept = default;
+
+    [[nodiscard]] constexpr Vec2 operator+(const Vec2 other) const noexcept { return Vec2{x + other.x, y + other.y}; }
+    [[nodiscard]] constexpr Vec2 operator-(const Vec2 other) const noexcept { return Vec2{x - other.x, y - other.y}; }
+    [[nodiscard]] constexpr Vec2 operator-() const noexcept { return Vec2{-x, -y}; }
+    [[nodiscard]] constexpr Vec2 operator*(const T scale) const noexcept { return Vec2{x * scale, y * scale}; }
+
+    [[nodiscard]] constexpr T dot(const Vec2 other) const noexcept { return mulAdd(x, other.x, y, other.y); }
+
+    /// @brief z of the 3D cross product, positive if other is counter clockwise from this
+    [[nodiscard]] constexpr T cross(const Vec2 other) const noexcept { return mulSub(x, other.y, y, other.x); }
+
+    /// @brief Rotated counter clockwise by the angle with the given cosine and sine
+    [[nodiscard]] constexpr Vec2 rotated(const T cos, const T sin) const noexcept {
+        return Vec2{mulSub(x, cos, y, sin), mulAdd(x, sin, y, cos)};
+    }
+
+    /// @brief Rotated by 90 degrees counter clockwise, exact
+    [[nodiscard]] constexpr Vec2 perpendicular() const noexcept { return Vec2{-y, x}; }
+
+    /// @brief this + other * scale
+    [[nodiscard]] constexpr Vec2 scaledAdd(const Vec2 other, const T scale) const noexcept {
+        return Vec2{mulAcc(x, other.x, scale), mulAcc(y, other.y, scale)};
+    }
+
+    /// @brief this at t = 0 towards to at t = 1
+    [[nodiscard]] constexpr Vec2 lerp(const Vec2 to, const T t) const noexcept { return scaledAdd(to - *this, t); }
+};
+
+using Vec2fp = Vec2<Fixed15_16>;
+
+#endif // VEC2_H
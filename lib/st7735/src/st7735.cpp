@@ -1,5 +1,12 @@
 #include "st7735.hpp"
 
+// the column transfer runs once per screen column, ST7735_IN_RAM links it into SRAM
+// (spi_write_blocking already lives there) so it does not evict render data from the XIP cache
+#if ST7735_IN_RAM
+#define ST7735_HOT __not_in_flash("st7735")
+#else
+#define ST7735_HOT
+#endif
 
 namespace {
     constexpr uint8_t SWRESET    = 0x01;
@@ -189,7 +196,7 @@ void ST7735::Rcmd3() {
  * @brief Write a command to the display
  * @note MUST be called between select() and deselect()
  */
-void ST7735::writeCommand(uint8_t cmd) {
+ST7735_HOT void ST7735::writeCommand(uint8_t cmd) {
     gpio_put(dc_pin_, 0); // Command mode
     spi_write_blocking(spi_, &cmd, 1);
 }
@@ -198,7 +205,7 @@ void ST7735::writeCommand(uint8_t cmd) {
  * @brief Write a byte to the display
  * @note MUST be called between select() and deselect()
  */
-void ST7735::writeByte(uint8_t data) {
+ST7735_HOT void ST7735::writeByte(uint8_t data) {
     gpio_put(dc_pin_, 1); // Data mode
     spi_write_blocking(spi_, &data, 1);
 }
@@ -229,7 +236,7 @@ void ST7735::writeByteBuffer(const uint8_t* buffer, size_t length) {
  * @param y1 Bottom right y coordinate
  * @note MUST be called between select() and deselect()
  */
-void ST7735::setAddrWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+ST7735_HOT void ST7735::setAddrWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
     writeCommand(CASET);
     writeByte(0);
     writeByte(x0 + x_start_);
@@ -525,7 +532,7 @@ void ST7735::drawRaySolidColumn(uint8_t x, uint8_t wallStart, uint8_t wallHeight
     deselect();
 }
 
-void ST7735::drawRayColumnn(uint8_t x, const uint16_t* colors, size_t len) {
+ST7735_HOT void ST7735::drawRayColumnn(uint8_t x, const uint16_t* colors, size_t len) {
     if (x >= tft_width_) return;
     if (len == 0) return;
     
@@ -0,0 +1,107 @@
+/**
+ * @file column_cache.cpp
+ */
+
+#include "column_cache.hpp"
+
+#include <cstring>
+
+#include "hot_path.hpp"
+
+ColumnCache::ColumnCache() {
+    clear();
+}
+
+void ColumnCache::setBudget(uint16_t entries) {
+    budget_ = (entries < 1) ? 1 : (entries > MAX_ENTRIES) ? MAX_ENTRIES : entries;
+    clear();
+}
+
+void ColumnCache::clear() {
+    for (uint16_t& bucket : buckets_) bucket = NONE;
+
+    used_ = 0;
+    newest_ = NONE;
+    oldest_ = NONE;
+}
+
+void ColumnCache::unlinkLru(uint16_t e) {
+    Entry& entry = entries_[e];
+
+    if (entry.newer != NONE) entries_[entry.newer].older = entry.older;
+    else newest_ = entry.older;
+
+    if (entry.older != NONE) entries_[entry.older].newer = entry.newer;
+    else oldest_ = entry.newer;
+}
+
+void ColumnCache::pushNewest(uint16_t e) {
+    entries_[e].older = newest_;
+    entries_[e].newer = NONE;
+
+    if (newest_ != NONE) entries_[newest_].newer = e;
+    else oldest_ = e;
+
+    newest_ = e;
+}
+
+uint16_t ColumnCache::takeEntry() {
+    if (used_ < budget_) {
+        return used_++;
+    }
+
+    const uint16_t e = oldest_;
+    unlinkLru(e);
+
+    // out of its bucket chain, which is short with a bucket per screen column or more
+    uint16_t* link = &buckets_[bucketOf(entries_[e].key)];
+    while (*link != e) link = &entries_[*link].bucket_next;
+    *link = entries_[e].bucket_next;
+
+    stats_.evictions++;
+    return e;
+}
+
+RAYCASTER_HOT void ColumnCache::drawWallColumn(const RayHit& hit, uint16_t* column) {
+    if (hit.tile == 0) {
+        return;
+    }
+
+    const int16_t line_height = lineHeight(hit.distance);
+    const uint64_t key = DefaultColumnRenderer::wallTexture(hit) | (static_cast<uint64_t>(hit.tex_x) << 16) |
+                         (static_cast<uint64_t>(static_cast<uint16_t>(line_height)) << 24) | (static_cast<uint64_t>(hit.shade) << 40);
+
+    stats_.lookups++;
+
+    uint16_t& bucket = buckets_[bucketOf(key)];
+    for (uint16_t e = bucket; e != NONE; e = entries_[e].bucket_next) {
+        Entry& entry = entries_[e];
+        if (entry.key != key) continue;
+
+        const int16_t rows = entry.draw_end - entry.draw_start;
+        memcpy(column + entry.draw_start, entry.pixels, rows * sizeof(uint16_t));
+
+        if (e != newest_) {
+            unlinkLru(e);
+            pushNewest(e);
+        }
+
+        stats_.hits++;
+        stats_.pixels_copied += rows;
+        return;
+    }
+
+    ::drawWallColumn(hit, column);
+
+    const uint16_t e = takeEntry();
+    Entry& entry = entries_[e];
+
+    entry.key = key;
+    DefaultColumnRenderer::wallRows(line_height, entry.draw_start, entry.draw_end);
+    memcpy(entry.pixels, column + entry.draw_start, (entry.draw_end - entry.draw_start) * sizeof(uint16_t));
+
+    entry.bucket_next = bucket;
+    bucket = e;
+
+    pushNewest(e);
+}
@@ -0,0 +1,261 @@
+/**
+ * @file hud.cpp
+ */
+
+#include "hud.hpp"
+
+#include <cstring>
+
+#include "fp_math.hpp"
+#include "hot_path.hpp"
+#include "textures.hpp"
+
+namespace {
+    /// @brief 3x5 digit glyphs, row major with the top row in bits 14..12
+    constexpr uint16_t DIGIT_GLYPHS[10] = {
+        0b111'101'101'101'111, // 0
+        0b010'110'010'010'111, // 1
+        0b111'001'111'100'111, // 2
+        0b111'001'111'001'111, // 3
+        0b101'101'111'001'001, // 4
+        0b111'100'111'001'111, // 5
+        0b111'100'111'101'111, // 6
+        0b111'001'001'001'001, // 7
+        0b111'101'111'101'111, // 8
+        0b111'101'111'001'111, // 9
+    };
+
+    constexpr uint16_t MAX_STAT_VALUE = 9999;
+
+    /// @brief Average colour of an 8x8 grid of texels, used as the minimap colour for a wall
+    /// @note Channels are averaged in native RGB565, the result is in panel byte order like the texels
+    uint16_t averageTextureColor(uint16_t tex_index) {
+        uint32_t r = 0, g = 0, b = 0;
+        uint16_t scratch[TEX_SIZE];
+
+        for (uint8_t tx = 0; tx < TEX_SIZE; tx += TEX_SIZE / 8) {
+            const uint16_t* tex_column = TextureManager::getTextureColumn(tex_index, tx, TEX_LOG2_SIZE, scratch);
+            if (tex_column == nullptr) return 0xFFFF;
+
+            for (uint8_t ty = 0; ty < TEX_SIZE; ty += TEX_SIZE / 8) {
+                const uint16_t c = swapTexelBytes(tex_column[ty]);
+                r += c >> 11;
+                g += (c >> 5) & 0x3F;
+                b += c & 0x1F;
+            }
+        }
+
+        return panelColor(static_cast<uint16_t>(((r / 64) << 11) | ((g / 64) << 5) | (b / 64)));
+    }
+
+    inline bool contains(const HudRect& r, int16_t x, int16_t y) {
+        return x >= r.x0 && x <= r.x1 && y >= r.y0 && y <= r.y1;
+    }
+}
+
+HudOverlay::HudOverlay(const MapView& map, uint8_t screen_width) : map_(map) {
+    minimap_rect_ = HudRect{
+        MARGIN, MARGIN,
+        MARGIN + MINIMAP_SIZE - 1, MARGIN + MINIMAP_SIZE - 1
+    };
+
+    const uint8_t stats_x0 = screen_width - MARGIN - STATS_WIDTH;
+    stats_rect_ = HudRect{
+        stats_x0, MARGIN,
+        static_cast<uint8_t>(stats_x0 + STATS_WIDTH - 1), MARGIN + STATS_HEIGHT - 1
+    };
+
+    buildMinimapBackground();
+
+    // everything needs rasterising on the first flush
+    markDirty(minimap_rect_);
+    markDirty(stats_rect_);
+}
+
+/**
+ * @brief Rasterise the whole map into the cached minimap background
+ * @note Each wall takes the average colour of its texture,
+ * large maps are point sampled down to MINIMAP_SIZE.
+ */
+void HudOverlay::buildMinimapBackground() {
+    const uint16_t span = (map_.width > map_.height) ? map_.width : map_.height;
+
+    // each texture is averaged once, this runs again on every level switch
+    uint16_t tile_colors[256];
+    bool tile_color_known[256] = {false};
+
+    for (uint8_t px = 0; px < MINIMAP_SIZE; px++) {
+        uint8_t tile_x = static_cast<uint8_t>((px * span) / MINIMAP_SIZE);
+
+        for (uint8_t py = 0; py < MINIMAP_SIZE; py++) {
+            uint8_t tile_y = static_cast<uint8_t>((py * span) / MINIMAP_SIZE);
+
+            uint8_t tile = map_.getEffectiveTile(tile_x, tile_y);
+            uint16_t color = MINIMAP_FLOOR_COLOR;
+
+            if (tile > 0) {
+                if (!tile_color_known[tile]) {
+                    tile_colors[tile] = averageTextureColor(tile - 1);
+                    tile_color_known[tile] = true;
+                }
+                color = tile_colors[tile];
+            }
+
+            minimap_bg_[px * MINIMAP_SIZE + py] = color;
+        }
+    }
+}
+
+void HudOverlay::mapChanged() {
+    buildMinimapBackground();
+    markDirty(minimap_rect_);
+}
+
+void HudOverlay::markDirty(const HudRect& rect) {
+    // out of slots, grow the last rect to cover the new one instead
+    if (dirty_count_ == MAX_DIRTY_RECTS) {
+        dirty_rects_[MAX_DIRTY_RECTS - 1] = dirty_rects_[MAX_DIRTY_RECTS - 1].merge(rect);
+        return;
+    }
+
+    dirty_rects_[dirty_count_++] = rect;
+}
+
+/// @brief Screen space bounds of the player marker (centre dot and direction tip)
+HudRect HudOverlay::markerRect() const {
+    const uint8_t x = minimap_rect_.x0 + marker_x_;
+    const uint8_t y = minimap_rect_.y0 + marker_y_;
+
+    return HudRect{
+        static_cast<uint8_t>(x > minimap_rect_.x0 ? x - 1 : x), static_cast<uint8_t>(y > minimap_rect_.y0 ? y - 1 : y),
+        static_cast<uint8_t>(x < minimap_rect_.x1 ? x + 1 : x), static_cast<uint8_t>(y < minimap_rect_.y1 ? y + 1 : y)
+    };
+}
+
+void HudOverlay::update(const PlayerData& player, uint16_t fps, uint16_t frame_ms) {
+    const int16_t span = (map_.width > map_.height) ? map_.width : map_.height;
+
+    int16_t mx = (player.pos_x * static_cast<int16_t>(MINIMAP_SIZE) / span).toInt();
+    int16_t my = (player.pos_y * static_cast<int16_t>(MINIMAP_SIZE) / span).toInt();
+    mx = (mx < 0) ? 0 : (mx >= MINIMAP_SIZE ? MINIMAP_SIZE - 1 : mx);
+    my = (my < 0) ? 0 : (my >= MINIMAP_SIZE ? MINIMAP_SIZE - 1 : my);
+
+    // round the direction to one of 8 neighbouring pixels
+    int8_t dx = static_cast<int8_t>(floor(player.dir_x + 0.5_fp).toInt());
+    int8_t dy = static_cast<int8_t>(floor(player.dir_y + 0.5_fp).toInt());
+
+    if (mx != marker_x_ || my != marker_y_ || dx != marker_dx_ || dy != marker_dy_) {
+        markDirty(markerRect()); // erase old marker
+
+        marker_x_ = static_cast<uint8_t>(mx);
+        marker_y_ = static_cast<uint8_t>(my);
+        marker_dx_ = dx;
+        marker_dy_ = dy;
+
+        markDirty(markerRect());
+    }
+
+    const uint16_t values[STAT_COUNT] = {fps, frame_ms};
+
+    for (uint8_t i = 0; i < STAT_COUNT; i++) {
+        uint16_t value = (values[i] > MAX_STAT_VALUE) ? MAX_STAT_VALUE : values[i];
+        if (value == stat_values_[i]) continue;
+
+        stat_values_[i] = value;
+
+        const uint8_t line_y0 = stats_rect_.y0 + 1 + i * (GLYPH_HEIGHT + 1);
+        markDirty(HudRect{stats_rect_.x0, line_y0, stats_rect_.x1, static_cast<uint8_t>(line_y0 + GLYPH_HEIGHT - 1)});
+    }
+}
+
+void HudOverlay::flush() {
+    for (uint8_t i = 0; i < dirty_count_; i++) {
+        const HudRect& rect = dirty_rects_[i];
+
+        if (rect.intersects(minimap_rect_)) {
+            redrawMinimap(rect.clip(minimap_rect_));
+        }
+        if (rect.intersects(stats_rect_)) {
+            redrawStats(rect.clip(stats_rect_));
+        }
+    }
+
+    dirty_count_ = 0;
+}
+
+/// @param rect Region to redraw, already clipped to the minimap
+void HudOverlay::redrawMinimap(const HudRect& rect) {
+    const uint8_t local_y0 = rect.y0 - minimap_rect_.y0;
+    const size_t run_bytes = (rect.y1 - rect.y0 + 1) * sizeof(uint16_t);
+
+    // restore the cached background
+    for (uint8_t x = rect.x0; x <= rect.x1; x++) {
+        size_t offset = (x - minimap_rect_.x0) * MINIMAP_SIZE + local_y0;
+        memcpy(&minimap_[offset], &minimap_bg_[offset], run_bytes);
+    }
+
+    // player marker on top, clipped to the rect
+    const int16_t mx = minimap_rect_.x0 + marker_x_;
+    const int16_t my = minimap_rect_.y0 + marker_y_;
+
+    const int16_t points[2][2] = {
+        {mx, my},
+        {static_cast<int16_t>(mx + marker_dx_), static_cast<int16_t>(my + marker_dy_)}
+    };
+
+    for (const auto& p : points) {
+        if (contains(rect, p[0], p[1])) {
+            minimap_[(p[0] - minimap_rect_.x0) * MINIMAP_SIZE + (p[1] - minimap_rect_.y0)] = MINIMAP_PLAYER_COLOR;
+        }
+    }
+}
+
+/// @param rect Region to redraw, already clipped to the stats panel
+void HudOverlay::redrawStats(const HudRect& rect) {
+    for (uint8_t x = rect.x0; x <= rect.x1; x++) {
+        uint16_t* col = &stats_[(x - stats_rect_.x0) * STATS_HEIGHT];
+
+        for (uint8_t y = rect.y0; y <= rect.y1; y++) {
+            col[y - stats_rect_.y0] = STATS_BG_COLOR;
+        }
+    }
+
+    for (uint8_t line = 0; line < STAT_COUNT; line++) {
+        const int16_t glyph_y0 = stats_rect_.y0 + 1 + line * (GLYPH_HEIGHT + 1);
+        if (glyph_y0 > rect.y1 || glyph_y0 + GLYPH_HEIGHT - 1 < rect.y0) continue;
+
+        // right aligned, no leading zeros
+        uint16_t value = stat_values_[line];
+
+        for (int8_t d = STAT_DIGITS - 1; d >= 0; d--) {
+            const int16_t glyph_x0 = stats_rect_.x0 + 1 + d * (GLYPH_WIDTH + 1);
+            const uint16_t glyph = DIGIT_GLYPHS[value % 10];
+
+            for (uint8_t gy = 0; gy < GLYPH_HEIGHT; gy++) {
+                for (uint8_t gx = 0; gx < GLYPH_WIDTH; gx++) {
+                    const uint8_t bit = (GLYPH_HEIGHT - 1 - gy) * GLYPH_WIDTH + (GLYPH_WIDTH - 1 - gx);
+                    if (!((glyph >> bit) & 1)) continue;
+
+                    const int16_t sx = glyph_x0 + gx;
+                    const int16_t sy = glyph_y0 + gy;
+                    if (!contains(rect, sx, sy)) continue;
+
+                    stats_[(sx - stats_rect_.x0) * STATS_HEIGHT + (sy - stats_rect_.y0)] = STATS_FG_COLOR;
+                }
+            }
+
+            value /= 10;
+            if (value == 0) break;
+        }
+    }
+}
+
+RAYCASTER_HOT void HudOverlay::composite(uint8_t x, uint16_t* column) const {
+    if (x >= minimap_rect_.x0 && x <= minimap_rect_.x1) {
+        memcpy(&column[minimap_rect_.y0], &minimap_[(x - minimap_rect_.x0) * MINIMAP_SIZE], MINIMAP_SIZE * sizeof(uint16_t));
+    }
+
+    if (x >= stats_rect_.x0 && x <= stats_rect_.x1) {
+        memcpy(&column[stats_rect_.y0], &stats_[(x - stats_rect_.x0) * STATS_HEIGHT], STATS_HEIGHT * sizeof(uint16_t));
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file joystick.cpp
+ */
+
+#include "joystick.hpp"
+
+#include "hardware/adc.h"
+#include "hardware/irq.h"
+
+namespace {
+    // the ADC clock is 48 MHz, a conversion starts every (div + 1) cycles
+    constexpr float ADC_CLOCK_HZ = 48000000.0f;
+
+    // an interrupt per pair of words, the 4 deep FIFO then has room for a late handler
+    constexpr uint8_t FIFO_IRQ_THRESHOLD = 2;
+}
+
+// the round robin walks the enabled inputs upwards, so it starts on the lower one
+AdcJoystick::AdcJoystick(uint8_t x_input, uint8_t y_input)
+    : x_input_(x_input), y_input_(y_input),
+      sampler_(x_input < y_input ? JoystickSampler::X : JoystickSampler::Y) {}
+
+void AdcJoystick::begin() {
+    instance_ = this;
+
+    adc_init();
+    adc_gpio_init(26 + x_input_);
+    adc_gpio_init(26 + y_input_);
+
+    adc_select_input(x_input_ < y_input_ ? x_input_ : y_input_);
+    adc_set_round_robin((1u << x_input_) | (1u << y_input_));
+
+    // FIFO on, no DMA request, IRQ at the threshold, error bit kept in the words, 12 bit samples
+    adc_fifo_setup(true, false, FIFO_IRQ_THRESHOLD, true, false);
+    adc_set_clkdiv(ADC_CLOCK_HZ / SAMPLE_RATE_HZ - 1.0f);
+
+    sampler_.reset();
+
+    irq_set_exclusive_handler(ADC_IRQ_FIFO, onFifoIrq);
+    adc_irq_set_enabled(true);
+    irq_set_enabled(ADC_IRQ_FIFO, true);
+
+    adc_run(true);
+}
+
+void AdcJoystick::onFifoIrq() {
+    JoystickSampler& sampler = instance_->sampler_;
+
+    // a lost word would swap the axes from then on, start the round robin over
+    if (adc_hw->fcs & ADC_FCS_OVER_BITS) {
+        adc_run(false);
+        while (!(adc_hw->cs & ADC_CS_READY_BITS)) {}
+
+        adc_fifo_drain();
+        hw_set_bits(&adc_hw->fcs, ADC_FCS_OVER_BITS); // write one to clear
+
+        adc_select_input(instance_->x_input_ < instance_->y_input_ ? instance_->x_input_ : instance_->y_input_);
+        sampler.resync();
+        adc_run(true);
+        return;
+    }
+
+    while (!adc_fifo_is_empty()) {
+        sampler.pushSample(adc_fifo_get());
+    }
+}
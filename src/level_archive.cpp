@@ -0,0 +1,55 @@
+/**
+ * @file level_archive.cpp
+ */
+
+#include "level_archive.hpp"
+
+#include "textures.hpp"
+
+bool LevelArchive::isValid() const {
+    return getHeader()->magic == LevelArchiveHeader::VALID_MAGIC;
+}
+
+Level LevelArchive::getLevel(uint32_t index) const {
+    const LevelArchiveHeader* header = getHeader();
+
+    if (index >= header->level_count) {
+        return Level{"", nullptr, nullptr, 0};
+    }
+
+    const LevelEntry* levels = reinterpret_cast<const LevelEntry*>(blob_ + header->levels_offset);
+    const TextureSetEntry* texture_sets = reinterpret_cast<const TextureSetEntry*>(blob_ + header->texture_sets_offset);
+
+    const LevelEntry& level = levels[index];
+
+    const uint8_t* map_blob = blob_ + level.map_offset;
+    if (!isMapDataValid(map_blob)) {
+        map_blob = nullptr;
+    }
+
+    const uint8_t* texture_blob = nullptr;
+    uint32_t texture_size = 0;
+    if (level.texture_set < header->texture_set_count) {
+        texture_blob = blob_ + texture_sets[level.texture_set].offset;
+        texture_size = texture_sets[level.texture_set].size;
+    }
+    if (!TextureManager::isValid(texture_blob, texture_size)) {
+        texture_blob = nullptr;
+        texture_size = 0;
+    }
+
+    return Level{level.name, map_blob, texture_blob, texture_size};
+}
+
+bool bindLevel(const Level& level, MapView& map) {
+    // refuse before touching the bound textures, the current level stays renderable
+    if (!level.isValid()) {
+        return false;
+    }
+
+    TextureManager::setBlob(level.texture_blob, level.texture_size);
+    TextureManager::cachePointers();
+
+    map = createMapView(level.map_blob);
+    return true;
+}
@@ -4,26 +4,34 @@
 
 #include "map_data.hpp"
 
-const MapFileHeader* getMapFileHeader() {
-    return reinterpret_cast<const MapFileHeader*>(map_data_xip_blob);
+#include <cstring>
+
+const MapFileHeader* getMapFileHeader(const uint8_t* blob) {
+    return reinterpret_cast<const MapFileHeader*>(blob);
 }
 
-bool isMapDataValid() {
-    const MapFileHeader* header = getMapFileHeader();
+bool isMapDataValid(const uint8_t* blob) {
+    if (blob == nullptr) {
+        return false;
+    }
+
+    const MapFileHeader* header = getMapFileHeader(blob);
     
-    return (header->magic == MapFileHeader::VALID_MAGIC);
+    // a newer layout may move fields this build reads
+    return header->magic == MapFileHeader::VALID_MAGIC && header->version >= MapFileHeader::FIRST_VERSION &&
+           header->version <= MapFileHeader::VERSION;
 }
 
-const PlayerData* getPlayerData() {
-    const MapFileHeader* header = getMapFileHeader();
+const PlayerData* getPlayerData(const uint8_t* blob) {
+    const MapFileHeader* header = getMapFileHeader(blob);
 
-    return reinterpret_cast<const PlayerData*>(map_data_xip_blob + header->playerdata_offset);
+    return reinterpret_cast<const PlayerData*>(blob + header->playerdata_offset);
 }
 
-MapView createMapView() {
-    const MapFileHeader* header = getMapFileHeader();
+MapView createMapView(const uint8_t* blob) {
+    const MapFileHeader* header = getMapFileHeader(blob);
     
-    const uint8_t* map_data_ptr = map_data_xip_blob + header->mapdata_offset;
+    const uint8_t* map_data_ptr = blob + header->mapdata_offset;
 
     // first two bytes are width and height
     uint8_t width = map_data_ptr[0];
@@ -32,5 +40,78 @@ MapView createMapView() {
     // tile data starts after width and height bytes
     const uint8_t* tile_data = &map_data_ptr[2];
 
-    return MapView(width, height, tile_data);
+    MapView map(width, height, tile_data);
+    map.lightmap = getLightmap(blob);
+    map.heights = getWallHeights(blob);
+    map.pvs = getPvs(blob);
+
+    // read once per level so columns do not have to
+    if (map.heights != nullptr) {
+        map.max_height = 0;
+        for (size_t i = 0; i < static_cast<size_t>(width) * height; i++) {
+            if (tile_data[i] != 0 && map.heights[i] > map.max_height) map.max_height = map.heights[i];
+        }
+    }
+
+    return map;
+}
+
+const DoorData* getDoors(uint32_t& count, const uint8_t* blob) {
+    const MapFileHeader* header = getMapFileHeader(blob);
+
+    if (header->doors_offset == 0) {
+        count = 0;
+        return nullptr;
+    }
+
+    const uint8_t* doors_ptr = blob + header->doors_offset;
+    memcpy(&count, doors_ptr, sizeof(count));
+
+    return reinterpret_cast<const DoorData*>(doors_ptr + sizeof(uint32_t));
+}
+
+const uint8_t* getLightmap(const uint8_t* blob) {
+    const MapFileHeader* header = getMapFileHeader(blob);
+
+    if (!header->hasField(offsetof(MapFileHeader, lightmap_offset)) || header->lightmap_offset == 0) {
+        return nullptr;
+    }
+
+    return blob + header->lightmap_offset;
+}
+
+const uint8_t* getWallHeights(const uint8_t* blob) {
+    const MapFileHeader* header = getMapFileHeader(blob);
+
+    if (!header->hasField(offsetof(MapFileHeader, heights_offset)) || header->heights_offset == 0) {
+        return nullptr;
+    }
+
+    return blob + header->heights_offset;
+}
+
+const uint8_t* getPvs(const uint8_t* blob) {
+    const MapFileHeader* header = getMapFileHeader(blob);
+
+    if (!header->hasField(offsetof(MapFileHeader, pvs_offset)) || header->pvs_offset == 0 ||
+        header->version < MapFileHeader::PVS_FACES_VERSION) {
+        return nullptr;
+    }
+
+    return blob + header->pvs_offset;
+}
+
+MapView copyMapView(const MapView& map, uint8_t* tiles, size_t capacity) {
+    const size_t tile_count = static_cast<size_t>(map.width) * map.height;
+
+    if (tile_count > capacity) {
+        return map;
+    }
+
+    memcpy(tiles, map.tile_data, tile_count);
+
+    MapView copy = map;
+    copy.tile_data = tiles;
+
+    return copy;
 }
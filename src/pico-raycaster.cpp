@@ -4,219 +4,203 @@
 #include "pico/stdlib.h"
 #include "pico/time.h"
 #include "hardware/gpio.h"
-#include "hardware/adc.h"
 
 #include "fixed_point.hpp"
 #include "fp_math.hpp"
 #include "st7735.hpp"
 
 #include "textures.hpp"
+#include "column_cache.hpp"
 #include "map_data.hpp"
-
-inline constexpr uint8_t SCREEN_WIDTH = 160;
-inline constexpr uint8_t SCREEN_HEIGHT = 128;
-inline constexpr uint8_t J_VRX_PIN = 28, J_VRY_PIN = 27;
-
-inline constexpr Fixed15_16 MOVE_STEP = 0.05_fp;
-inline constexpr uint32_t INPUT_DELAY = 15000;
-
-inline constexpr Fixed15_16 rosin = sinfp(2); // sin(2 degrees)
-inline constexpr Fixed15_16 rocos = cosfp(2); // cos(2 degrees)
-inline constexpr Fixed15_16 FOV_SCALE = 0.66667_fp;
+#include "hot_path.hpp"
+#include "hud.hpp"
+#include "joystick.hpp"
+#include "level_archive.hpp"
+#include "pvs.hpp"
+#include "renderer.hpp"
+#include "simulation.hpp"
+#include "temporal.hpp"
+#include "tile_overlay.hpp"
+
+// ST7735::drawRayColumnn takes a uint8_t column and the panel is driven in 160x128 landscape
+static_assert(DefaultRenderConfig::WIDTH == 160 && DefaultRenderConfig::HEIGHT == 128, "render config does not match the ST7735 panel");
+
+// ADC inputs of the stick, GPIO 28 and 27
+inline constexpr uint8_t J_VRX_INPUT = 2, J_VRY_INPUT = 1;
+
+#if RAYCASTER_SRAM_HOT_PATH
+// largest map whose tiles are copied into SRAM, bigger maps are read from flash
+inline constexpr size_t MAP_SRAM_CAPACITY = 64 * 64;
+#endif
+
+#if RAYCASTER_BENCHMARK
+// one full turn in 2 degree steps from the map's start pose, the same camera path every lap
+inline constexpr uint16_t BENCH_FRAMES = 180;
+inline constexpr angle16_t BENCH_TURN = degreesToBam(2);
+#endif
 
 
 int main()
 {
     stdio_init_all();
-    adc_init();
-
-
-    adc_gpio_init(J_VRX_PIN);
-    adc_gpio_init(J_VRY_PIN);
 
+#if !RAYCASTER_BENCHMARK
+    // sampled in the background from here on, the stick has to be at rest while it calibrates
+    static AdcJoystick joystick(J_VRX_INPUT, J_VRY_INPUT);
+    joystick.begin();
+#endif
 
     ST7735 tft(1, spi0, 18, 19, 17, 21, 20, 255);
     tft.initialize(ST7735::TFT_Type::GREEN_TAB);
 
-    // validate texture data
-    if (!TextureManager::isValid()) {
+    // validate level archive
+    const LevelArchive levels;
+    if (!levels.isValid() || levels.levelCount() == 0) {
         tft.drawFillScreen(0xF800); // red screen
 
         while (true) {
-            const TextureFileHeader* header = TextureManager::getHeader();
-            printf("ERROR Texture data invalid!\n");
-            printf("Magic read: 0x%08X\n", header->magic);
-            printf("Expected:   0x%08X\n", TextureFileHeader::VALID_MAGIC);
-        } 
+            printf("ERROR Level archive invalid!\n");
+            printf("Magic read: 0x%08X\n", levels.getHeader()->magic);
+            printf("Expected:   0x%08X\n", LevelArchiveHeader::VALID_MAGIC);
+        }
     }
 
-    // load map data
-    if (!isMapDataValid()) {
-        tft.drawFillScreen(0xFB00); // red screen
+    // validate and bind the first level, getLevel() drops a map or texture blob that fails its check
+    uint32_t level_index = 0;
+    Level level = levels.getLevel(level_index);
+    MapView map_data(0, 0, nullptr);
+    if (!bindLevel(level, map_data)) {
+        tft.drawFillScreen(0xF800); // red screen
 
         while (true) {
-            const MapFileHeader* header = getMapFileHeader();
-            printf("ERROR Map data invalid!\n");
-            printf("Magic read: 0x%08X\n", header->magic);
-            printf("Expected:   0x%08X\n", MapFileHeader::VALID_MAGIC);
+            printf("ERROR Level %s invalid!\n", level.name);
+            printf("Map data:     %s\n", level.map_blob != nullptr ? "ok" : "invalid");
+            printf("Texture data: %s\n", level.texture_blob != nullptr ? "ok" : "invalid");
         }
     }
 
-    const MapView map_data = createMapView();
-    PlayerData player_data = *getPlayerData();
-    
-    // movement & rotation
+#if RAYCASTER_SRAM_HOT_PATH
+    // every DDA step reads a tile, keep them next to the kernels
+    static uint8_t map_tiles_sram[MAP_SRAM_CAPACITY];
+    map_data = copyMapView(map_data, map_tiles_sram, MAP_SRAM_CAPACITY);
+#endif
 
-    absolute_time_t last_move_time = 0;
-    
-    Fixed15_16 plane_x = -player_data.dir_y * FOV_SCALE;
-    Fixed15_16 plane_y = player_data.dir_x * FOV_SCALE;
+    // doors and destroyed walls, the tiles themselves stay read-only
+    static TileOverlay overlay;
+    map_data.overlay = &overlay;
+    overlay.loadDoors(level.map_blob, map_data);
 
-    // current raycast screen coordinate
-    uint8_t current_screen_x = 0;
+    PlayerState player = PlayerState::fromPose(*getPlayerData(level.map_blob));
 
-    while (true) {
-        uint64_t math_start, math_end;
-        math_start = time_us_64();
+    printf("Render hot path in %s\n", RAYCASTER_SRAM_HOT_PATH ? "SRAM" : "XIP flash");
 
-        Fixed15_16 camera_x = (2 * Fixed15_16(current_screen_x) / Fixed15_16(SCREEN_WIDTH)) - 1;
+    HudOverlay hud(map_data, SCREEN_WIDTH);
+    hud.update(player.pose(), 0, 0);
+    hud.flush();
 
-        Fixed15_16 ray_dir_x = player_data.dir_x + (plane_x * camera_x);
-        Fixed15_16 ray_dir_y = player_data.dir_y + (plane_y * camera_x);
+    // interlaced rendering, toggled with 't' over stdio, 'n' switches to the next level,
+    // 'e' opens or closes the door in front of the player and 'x' knocks out the wall in front,
+    // 'i' toggles interpolating the camera between simulation ticks, 'c' the column cache
+    TemporalRenderer temporal(map_data);
 
-        int16_t map_x = player_data.pos_x.toInt();
-        int16_t map_y = player_data.pos_y.toInt();
+    // wall columns drawn before are copied instead of sampled again, off until 'c' turns it on:
+    // keyed on the exact line height it hits on 3-11% of columns, too few to pay for the lookups
+    static ColumnCache column_cache;
 
-        // DDA setup
-        
-        Fixed15_16 delta_dist_x = (ray_dir_x == 0) ? Fixed15_16::fromRaw(INT32_MAX) : abs(1 / ray_dir_x);
-        Fixed15_16 delta_dist_y = (ray_dir_y == 0) ? Fixed15_16::fromRaw(INT32_MAX) : abs(1 / ray_dir_y);
+    // what can be seen from the player's tile, its wall textures are copied into SRAM when the tile changes
+    PotentiallyVisibleSet pvs(map_data);
 
+    uint64_t frame_start = time_us_64();
 
-        Fixed15_16 side_dist_x;
-        Fixed15_16 side_dist_y;
-        
-        // dda step direction
-        int8_t step_x;
-        int8_t step_y;
+    // every column of a frame renders from this camera, taken once before the first column
+    Camera frame_camera = Camera::fromPlayer(player.pose());
 
-        uint8_t hit = 0;
-        uint8_t side;
+#if !RAYCASTER_BENCHMARK
+    // movement runs in fixed ticks, caught up once per frame, so its speed does not depend on the frame rate
+    FixedTimestep sim;
+    PlayerState previous_player = player;
+    bool interpolate = true;
+    uint64_t last_sim_time = time_us_64();
+#endif
 
-        // sidedist is the distance to get to an int coordinate on the map after which we will start DDA with deltadist in step direction
-        if (ray_dir_x < 0) {
-            step_x = -1;
-            side_dist_x = (player_data.pos_x - map_x) * delta_dist_x;
-        } else {
-            step_x = 1;
-            side_dist_x = (map_x + 1 - player_data.pos_x) * delta_dist_x;
-        }
-        if (ray_dir_y < 0) {
-            step_y = -1;
-            side_dist_y = (player_data.pos_y - map_y) * delta_dist_y;
-        } else {
-            step_y = 1;
-            side_dist_y = (map_y + 1 - player_data.pos_y) * delta_dist_y;
-        }
+    // index of the column within the current frame, the renderer decides which screen column it is
+    uint8_t column_index = 0;
 
-        // finally start DDA loop
-        while (hit == 0) {
-            if (side_dist_x < side_dist_y) {
-                side_dist_x += delta_dist_x;
-                map_x += step_x;
-                side = 0;
-            } else {
-                side_dist_y += delta_dist_y;
-                map_y += step_y;
-                side = 1;
-            }
+    // time spent simulating, raycasting and drawing in the current frame
+    uint32_t frame_sim_us = 0;
+    uint8_t frame_ticks = 0;
+    uint32_t frame_render_us = 0;
+    uint32_t frame_gfx_us = 0;
 
-            // if (worldMap[map_x][map_y] > 0) {
-            //     hit = 1;
-            // }
-            if (map_data.getTileUnchecked(map_x, map_y) > 0) {
-                hit = 1;
-            }
-        }
+#if RAYCASTER_BENCHMARK
+    PlayerState bench_start_pose = player;
 
-        Fixed15_16 wall_dist; // perpendicular distance to wall
+    uint16_t bench_frame = 0;
+    uint64_t bench_total_us = 0, bench_render_us = 0, bench_gfx_us = 0;
+    uint32_t bench_min_us = UINT32_MAX, bench_max_us = 0;
+#endif
+
+    while (true) {
+        if (column_index == 0) {
+            const uint64_t sim_start = time_us_64();
+
+#if !RAYCASTER_BENCHMARK
+            // one stick reading for all ticks of the frame, it only changes at 1 kHz anyway
+            const JoystickState stick = joystick.read();
+
+            frame_ticks = sim.advance((uint32_t)(sim_start - last_sim_time), [&]() {
+                previous_player = player;
+                stepPlayer(player, map_data, stick);
+            });
+            last_sim_time = sim_start;
+
+            frame_camera = interpolate ? interpolateCamera(previous_player, player, sim.alpha()) : Camera::fromPlayer(player.pose());
+#else
+            frame_camera = Camera::fromPlayer(player.pose());
+#endif
+
+            const PlayerData pose = player.pose();
+            if (pvs.update(pose.pos_x.toInt(), pose.pos_y.toInt())) {
+                // the textures the visible faces are drawn with
+                uint16_t face_textures[TextureManager::SRAM_TEXTURE_SLOTS];
+                const uint8_t face_count = pvs.faceTextures(face_textures, TextureManager::SRAM_TEXTURE_SLOTS);
+                const uint8_t queued = TextureManager::prefetch(face_textures, face_count, DefaultRenderConfig::TEX_LOG2_SIZE);
+#if !RAYCASTER_BENCHMARK
+                printf("PVS tile (%d, %d): %d wall textures visible, %d queued for SRAM\n", pose.pos_x.toInt(), pose.pos_y.toInt(),
+                       pvs.textureCount(), queued);
+#else
+                (void)queued;
+#endif
+            }
 
-        // this is same as calculating ((map_x - pos_x + (1 - step_x) / 2) / ray_dir_x) but can be simplified due to scaling of sidedist and deltadist by raydir magnitude
-        if (side == 0) {
-            wall_dist = side_dist_x - delta_dist_x;
-        } else {
-            wall_dist = side_dist_y - delta_dist_y;
+            frame_sim_us = (uint32_t)(time_us_64() - sim_start);
         }
 
-        // ---- drawing the actual raycaster line ----
+        uint64_t math_start, math_end;
+        math_start = time_us_64();
 
-        // this is larger than the actual line drawn so that textures close up to walls can be scaled properly.
-        int16_t line_height = (SCREEN_HEIGHT / wall_dist).toInt();
+        // every column of a frame renders from the same camera so the previous frame can be reprojected
+        if (column_index == 0) {
+            temporal.beginFrame(frame_camera);
+        }
 
-        int16_t draw_start = (-line_height >> 1) + (SCREEN_HEIGHT >> 1);
-        if (draw_start < 0) draw_start = 0; 
+        const uint8_t current_screen_x = temporal.columnAt(column_index);
 
-        int16_t draw_end = (line_height >> 1) + (SCREEN_HEIGHT >> 1);
-        if (draw_end >= SCREEN_HEIGHT) draw_end = SCREEN_HEIGHT - 1;
-        
-        // exact position where wall was hit
-        Fixed15_16 wall_x; 
-        if (side == 0) {
-            wall_x = player_data.pos_y + wall_dist * ray_dir_y;
-        } else {
-            wall_x = player_data.pos_x + wall_dist * ray_dir_x;
-        }
-        // normalize this position to [0,1]
-        wall_x = fractional(wall_x);
-        
-
-        int16_t tex_x_coord = (wall_x << TEX_LOG2_SIZE).toInt();
-        
-        // mirror texture coordinate if needed
-        if ((side == 0 && ray_dir_x > 0) || (side == 1 && ray_dir_y < 0)) {
-            tex_x_coord = TEX_SIZE - tex_x_coord - 1;
-        } 
-        
-        // step through texture for each screen pixel
-        Fixed15_16 step = TEX_SIZE_FP / Fixed15_16(line_height);
-        
-        int16_t wall_top_coord = (SCREEN_HEIGHT - line_height) >> 1;
-        
-        // starting texture coordinate
-        Fixed15_16 tex_pos = (draw_start - wall_top_coord) * step;
-        
-        // texture number, -1 to account for 0 indexing
-        // uint8_t tex_index = worldMap[map_x][map_y] - 1; 
-        uint8_t tex_index = map_data.getTileUnchecked(map_x, map_y) - 1; 
+        // the textures prefetch() queued are copied a texture column per screen column, not all at once on a tile crossing
+        TextureManager::prefetchStep();
 
         // buffer for the texture from this ray column -- init to the color that we want the background to be.
         uint16_t ray_column[SCREEN_HEIGHT] = {0};
 
-        // pointer to the column of the texture we are sampling from
-        // since textures are stored column major for cache efficiency
-        const uint16_t* tex_data_start = TextureManager::getTextureData(tex_index);
-        const uint16_t* tex_data_start_shaded = TextureManager::getTextureData(tex_index + 1);
-
-        const uint16_t* tex_column = &tex_data_start[tex_x_coord * TEX_SIZE];
-        const uint16_t* tex_column_shaded = &tex_data_start_shaded[tex_x_coord * TEX_SIZE];
+        temporal.renderColumn(current_screen_x, ray_column);
 
-        for (size_t y = draw_start; y < draw_end; y++) {
-            int16_t tex_y_coord = tex_pos.toInt() & TEX_MASK;
-            
-            tex_pos += step;
-
-            uint16_t color = tex_column[tex_y_coord];
-            
-            // make y-sides darker 
-            if (side == 1) {
-                color = tex_column_shaded[tex_y_coord];
-            }
-
-            ray_column[y] = color;
-        }
+        hud.composite(current_screen_x, ray_column);
 
         math_end = time_us_64();
+        frame_render_us += (uint32_t)(math_end - math_start);
+#if !RAYCASTER_BENCHMARK
         printf("Math calc time: %dus\n", (uint32_t)(math_end - math_start));
+#endif
 
         uint64_t gfx_start, gfx_end;
         gfx_start = time_us_64();
@@ -224,65 +208,145 @@ int main()
         tft.drawRayColumnn(current_screen_x, ray_column, SCREEN_HEIGHT);
 
         gfx_end = time_us_64();
+        frame_gfx_us += (uint32_t)(gfx_end - gfx_start);
+#if !RAYCASTER_BENCHMARK
         printf("GFX draw time: %dus\n", (uint32_t)(gfx_end - gfx_start));
+#endif
 
 
 
-        current_screen_x++;
-        if (current_screen_x >= SCREEN_WIDTH) {
-            current_screen_x = 0;
-        }
-    
-        adc_select_input(2); // VRX
-        uint16_t vrx_reading = adc_read();
-        adc_select_input(1); // VRY
-        uint16_t vry_reading = adc_read();
-        
-
-        // clean up this mess of a movement code at some point :D
-
-        if (get_absolute_time() - last_move_time > INPUT_DELAY) {
-            last_move_time = get_absolute_time();
-    
-            if (vry_reading < 1000) {
-                if (map_data.getTileUnchecked((player_data.pos_x + player_data.dir_x * 10 * MOVE_STEP).toInt(), player_data.pos_y.toInt()) == 0) {
-                    player_data.pos_x += player_data.dir_x * MOVE_STEP;
-                }
-                if (map_data.getTileUnchecked(player_data.pos_x.toInt(), (player_data.pos_y + player_data.dir_y * 10 * MOVE_STEP).toInt()) == 0) {
-                    player_data.pos_y += player_data.dir_y * MOVE_STEP;
-                }
-    
-            } else if (vry_reading > 3000) {
-                if (map_data.getTileUnchecked((player_data.pos_x - player_data.dir_x * 10 * MOVE_STEP).toInt(), player_data.pos_y.toInt()) == 0) {
-                    player_data.pos_x -= player_data.dir_x * MOVE_STEP;
+        column_index++;
+        if (column_index >= SCREEN_WIDTH) {
+            column_index = 0;
+
+            // frame finished, refresh the overlay for the next one
+            uint64_t frame_end = time_us_64();
+            uint32_t frame_us = (uint32_t)(frame_end - frame_start);
+            frame_start = frame_end;
+
+            if (overlay.update(frame_us)) {
+                hud.mapChanged();
+            }
+
+            uint16_t fps = (frame_us > 0) ? (uint16_t)(1000000 / frame_us) : 0;
+            hud.update(player.pose(), fps, (uint16_t)(frame_us / 1000));
+            hud.flush();
+
+            const TemporalRenderer::FrameStats& stats = temporal.frameStats();
+            const ColumnCache::Stats& cache_stats = column_cache.stats();
+            printf("Frame time: %dus (sim %dus for %d ticks, render %dus, gfx %dus), rays cast: %d, reprojected: %d, layers/column: %.2f, "
+                   "column cache: %d%% hits, %d bytes saved\n",
+                   frame_us, frame_sim_us, frame_ticks, frame_render_us, frame_gfx_us, stats.rays_cast, stats.reprojected,
+                   static_cast<double>(stats.layersPerColumn().toFloat()), (cache_stats.hitRate() * 100).toInt(), cache_stats.bytesSaved());
+            column_cache.resetStats();
+
+            const int key = getchar_timeout_us(0);
+
+            if (key == 't') {
+                temporal.setEnabled(!temporal.isEnabled());
+                printf("Temporal rendering %s\n", temporal.isEnabled() ? "on" : "off");
+            }
+
+            if (key == 'c') {
+                column_cache.clear();
+                temporal.setColumnCache(temporal.columnCache() ? nullptr : &column_cache);
+                printf("Column cache %s (%d bytes)\n", temporal.columnCache() ? "on" : "off", column_cache.budgetBytes());
+            }
+
+#if !RAYCASTER_BENCHMARK
+            if (key == 'i') {
+                interpolate = !interpolate;
+                printf("Camera interpolation %s\n", interpolate ? "on" : "off");
+            }
+#endif
+
+            if (key == 'n') {
+                uint64_t switch_start = time_us_64();
+
+                // the map and textures stay in flash, only the SRAM state built from them is redone
+                const uint32_t next_index = (level_index + 1) % levels.levelCount();
+                const Level next = levels.getLevel(next_index);
+
+                if (!bindLevel(next, map_data)) {
+                    // nothing was bound, keep playing the current level
+                    printf("Level %s invalid, staying on %s\n", next.name, level.name);
+                } else {
+                    level_index = next_index;
+                    level = next;
+#if RAYCASTER_SRAM_HOT_PATH
+                    map_data = copyMapView(map_data, map_tiles_sram, MAP_SRAM_CAPACITY);
+#endif
+                    map_data.overlay = &overlay;
+                    column_cache.clear(); // the level may bring another texture set
+                    overlay.reset();
+                    overlay.loadDoors(level.map_blob, map_data);
+
+                    player = PlayerState::fromPose(*getPlayerData(level.map_blob));
+
+                    hud.mapChanged();
+                    temporal.invalidate();
+                    pvs.invalidate();
+#if RAYCASTER_BENCHMARK
+                    bench_start_pose = player;
+#else
+                    previous_player = player;
+                    sim.reset();
+#endif
+
+                    printf("Level switch to %s: %dus\n", level.name, (uint32_t)(time_us_64() - switch_start));
                 }
-                if (map_data.getTileUnchecked(player_data.pos_x.toInt(), (player_data.pos_y - player_data.dir_y * 10 * MOVE_STEP).toInt()) == 0) {
-                    player_data.pos_y -= player_data.dir_y * MOVE_STEP;
+            }
+
+            if (key == 'e' || key == 'x') {
+                // the tile one unit in front of the player
+                const PlayerData pose = player.pose();
+                const uint8_t target_x = (uint8_t)(pose.pos_x + pose.dir_x).toInt();
+                const uint8_t target_y = (uint8_t)(pose.pos_y + pose.dir_y).toInt();
+
+                if (key == 'e') {
+                    overlay.toggleDoor(target_x, target_y);
+                } else if (target_x > 0 && target_y > 0 && target_x + 1 < map_data.width && target_y + 1 < map_data.height &&
+                           map_data.getEffectiveTile(target_x, target_y) != 0) {
+                    // the border stays so rays always hit something
+                    if (overlay.setTile(target_x, target_y, 0)) {
+                        hud.mapChanged();
+                        // the baked sets did not see through this wall
+                        pvs.disable();
+                    } else {
+                        printf("Tile overlay full\n");
+                    }
                 }
             }
-            
-            if (vrx_reading > 3000) {
-                Fixed15_16 oldDirX = player_data.dir_x;
-                Fixed15_16 oldDirY = player_data.dir_y;
-    
-                player_data.dir_x = oldDirX * rocos - oldDirY * rosin;
-                player_data.dir_y = oldDirX * rosin + oldDirY * rocos;
-    
-                // recalibrate camera plane to account for drift (there shouldnt be a significant drift but just in case)
-                plane_x = -player_data.dir_y * FOV_SCALE;
-                plane_y = player_data.dir_x * FOV_SCALE;
-    
-            } else if (vrx_reading < 1000) {
-                Fixed15_16 oldDirX = player_data.dir_x;
-                Fixed15_16 oldDirY = player_data.dir_y;
-    
-                player_data.dir_x = oldDirX * rocos + oldDirY * rosin;
-                player_data.dir_y = -oldDirX * rosin + oldDirY * rocos;
-    
-                // recalibrate camera plane to account for drift (there shouldnt be a significant drift but just in case)
-                plane_x = -player_data.dir_y * FOV_SCALE;
-                plane_y = player_data.dir_x * FOV_SCALE;
+
+#if RAYCASTER_BENCHMARK
+            bench_total_us += frame_us;
+            bench_render_us += frame_render_us;
+            bench_gfx_us += frame_gfx_us;
+            if (frame_us < bench_min_us) bench_min_us = frame_us;
+            if (frame_us > bench_max_us) bench_max_us = frame_us;
+
+            // scripted turn instead of joystick input
+            player.heading += BENCH_TURN;
+
+            bench_frame++;
+            if (bench_frame == BENCH_FRAMES) {
+                // parsed by tools/hot_path_report, keep the format stable
+                printf("BENCH hot_path=%s temporal=%d frames=%d mean_us=%d min_us=%d max_us=%d render_us=%d gfx_us=%d\n",
+                       RAYCASTER_SRAM_HOT_PATH ? "sram" : "xip", temporal.isEnabled(), BENCH_FRAMES,
+                       (uint32_t)(bench_total_us / BENCH_FRAMES), bench_min_us, bench_max_us,
+                       (uint32_t)(bench_render_us / BENCH_FRAMES), (uint32_t)(bench_gfx_us / BENCH_FRAMES));
+
+                bench_frame = 0;
+                bench_total_us = bench_render_us = bench_gfx_us = 0;
+                bench_min_us = UINT32_MAX;
+                bench_max_us = 0;
+
+                player = bench_start_pose;
             }
+#endif
+
+            frame_render_us = 0;
+            frame_gfx_us = 0;
         }
     }
 }
@@ -0,0 +1,108 @@
+/**
+ * @file pvs.cpp
+ */
+
+#include "pvs.hpp"
+
+#include <cstring>
+
+uint32_t decodePvsBits(const uint8_t* src, uint8_t* dst, uint32_t size, bool difference) {
+    const uint8_t* const start = src;
+    uint32_t out = 0;
+
+    while (out < size) {
+        const uint8_t byte = *src++;
+
+        if (byte != 0) {
+            dst[out] = difference ? (dst[out] ^ byte) : byte;
+            out++;
+            continue;
+        }
+
+        // a run never goes past the end of a valid set, clamp anyway so a bad one cannot write past dst
+        uint32_t run = *src++;
+        if (run > size - out) run = size - out;
+
+        // zero bytes leave a base set as it is
+        if (!difference) memset(dst + out, 0, run);
+        out += run;
+    }
+
+    return static_cast<uint32_t>(src - start);
+}
+
+bool PotentiallyVisibleSet::update(int16_t x, int16_t y) {
+    if (disabled_ || static_cast<uint16_t>(x) >= map_.width || static_cast<uint16_t>(y) >= map_.height) {
+        return false;
+    }
+
+    const int32_t tile = y + map_.height * x;
+    if (tile == tile_) {
+        return false;
+    }
+    tile_ = tile;
+
+    active_ = false;
+    texture_count_ = 0;
+    face_count_ = 0;
+
+    const uint32_t tile_count = static_cast<uint32_t>(map_.width) * map_.height;
+    if (map_.pvs == nullptr || tile_count > MAX_TILES) {
+        return true;
+    }
+
+    uint32_t entry;
+    memcpy(&entry, map_.pvs + tile * sizeof(uint32_t), sizeof(entry));
+    if (entry == 0) {
+        return true;
+    }
+
+    const uint8_t* src = map_.pvs + entry;
+    const uint32_t bit_bytes = (tile_count + 7) / 8;
+
+    uint32_t base;
+    memcpy(&base, src, sizeof(base));
+    src += sizeof(base);
+
+    texture_count_ = *src++;
+    memcpy(textures_, src, texture_count_);
+    src += texture_count_;
+
+    face_count_ = *src++;
+    faces_ = src;
+    src += face_count_;
+
+    if (base != 0) {
+        decodePvsBits(map_.pvs + base, bits_, bit_bytes);
+        decodePvsBits(src, bits_, bit_bytes, true);
+    } else {
+        decodePvsBits(src, bits_, bit_bytes);
+    }
+    active_ = true;
+
+    return true;
+}
+
+void PotentiallyVisibleSet::invalidate() {
+    tile_ = -1;
+    active_ = false;
+    disabled_ = false;
+    texture_count_ = 0;
+    face_count_ = 0;
+}
+
+void PotentiallyVisibleSet::disable() {
+    disabled_ = true;
+    active_ = false;
+}
+
+uint8_t PotentiallyVisibleSet::faceTextures(uint16_t* textures, uint8_t max) const {
+    if (!active_) {
+        return 0;
+    }
+
+    const uint8_t count = (face_count_ < max) ? face_count_ : max;
+    for (uint8_t i = 0; i < count; i++) textures[i] = faces_[i];
+
+    return count;
+}
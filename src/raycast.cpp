@@ -0,0 +1,325 @@
+/**
+ * @file raycast.cpp
+ */
+
+#include "raycast.hpp"
+
+#include "fp_math.hpp"
+#include "hot_path.hpp"
+#include "textures.hpp"
+#include "tile_overlay.hpp"
+
+namespace {
+    /**
+     * @brief Distance along the ray between two grid lines, 1 / |d|
+     * @note Components below 3 raw units would overflow the reciprocal, they are treated as parallel
+     */
+    inline Fixed15_16 deltaDist(Fixed15_16 d) {
+        if (d.toRaw() > -3 && d.toRaw() < 3) {
+            return Fixed15_16::fromRaw(INT32_MAX);
+        }
+        return abs(1 / d);
+    }
+
+    /**
+     * @brief Texture column of a hit at fractional position wall_x along the wall
+     * @note Mirrored so textures read the same way from both sides of a wall
+     */
+    inline uint8_t texColumn(Fixed15_16 wall_x, uint8_t side, const Ray& ray, uint8_t tex_log2_size) {
+        int16_t tex_x_coord = (wall_x << tex_log2_size).toInt();
+
+        if ((side == 0 && ray.dir_x > 0) || (side == 1 && ray.dir_y < 0)) {
+            tex_x_coord = (1 << tex_log2_size) - tex_x_coord - 1;
+        }
+
+        return static_cast<uint8_t>(tex_x_coord);
+    }
+
+    /// @brief Lightmap face seen by a ray hitting a wall on this side
+    inline TileFace hitFace(uint8_t side, const Ray& ray) {
+        if (side == 0) return (ray.dir_x < 0) ? TileFace::X_MAX : TileFace::X_MIN;
+        return (ray.dir_y < 0) ? TileFace::Y_MAX : TileFace::Y_MIN;
+    }
+
+    /**
+     * @brief Intersect the ray with the door panel of the cell it is crossing
+     * @param side_dist_x Distance to the x grid line the ray leaves the cell through
+     * @param side_dist_y Distance to the y grid line the ray leaves the cell through
+     * @param dist Distance at which the cell was entered
+     * @return false if the ray misses the panel: it leaves the cell first or passes the open part
+     * @note The panel sits halfway into the cell and slides sideways, so a closed door looks recessed
+     */
+    inline bool hitDoor(const TileOverlay::Entry& door, const Ray& ray, Fixed15_16 side_dist_x, Fixed15_16 side_dist_y,
+                        Fixed15_16 delta_dist_x, Fixed15_16 delta_dist_y, Fixed15_16 dist, const RayQueryOptions& options, RayHit& out) {
+        const bool along_x = door.axis == 0;
+        const Fixed15_16 delta = along_x ? delta_dist_x : delta_dist_y;
+
+        // running parallel to the panel
+        if (delta.toRaw() == INT32_MAX) return false;
+
+        // the middle line of the cell is half a step before the exit line
+        const Fixed15_16 t = (along_x ? side_dist_x : side_dist_y) - (delta >> 1);
+        const Fixed15_16 exit = along_x ? side_dist_y : side_dist_x;
+        if (t < dist || t >= exit) return false;
+
+        const Fixed15_16 wall_x = fractional(along_x ? ray.origin_y + t * ray.dir_y : ray.origin_x + t * ray.dir_x);
+        if (wall_x < door.open) return false;
+
+        out.tile = door.tile;
+        out.side = along_x ? 0 : 1;
+        out.distance = t;
+        if (options.compute_tex) {
+            out.tex_x = texColumn(wall_x - door.open, out.side, ray, options.tex_log2_size);
+        }
+        return true;
+    }
+
+    /// @brief What the overlay makes of a wall tile the walk reached, small enough to come back in a register
+    struct OverlayStep {
+        enum Kind : uint8_t { WALL, PASS, DOOR } kind;
+        uint8_t tile; // tile to draw for WALL
+    };
+
+    /**
+     * @brief Look the walk's tile up in the overlay, once its block bit says it may be modified
+     * @param at Walk state in the tile, side distances to the lines it leaves through
+     * @param tile The map's tile, kept for WALL unless the overlay replaces it
+     * @param out The door hit for DOOR, with map position and shade
+     * @note Out of line so the DDA loop keeps only the bitmap test and stays in registers
+     */
+    [[gnu::noinline]] RAYCASTER_HOT OverlayStep overlayStep(const MapView& map, const Ray& ray, const RayQueryOptions& options,
+                                                           const DdaState& at, Fixed15_16 dist, uint8_t tile, RayHit& out) {
+        const TileOverlay::Entry* entry = map.overlay->find(at.map_x, at.map_y);
+        if (entry == nullptr) {
+            return {OverlayStep::WALL, tile};
+        }
+
+        if (entry->kind == TileOverlay::Kind::DOOR) {
+            if (!hitDoor(*entry, ray, at.side_dist_x, at.side_dist_y, at.delta_dist_x, at.delta_dist_y, dist, options, out)) {
+                return {OverlayStep::PASS, 0};
+            }
+            if (out.distance > options.max_distance) {
+                out = RayHit{};
+                return {OverlayStep::DOOR, 0};
+            }
+            out.map_x = at.map_x;
+            out.map_y = at.map_y;
+            if (options.compute_tex) {
+                out.shade = map.getShade(at.map_x, at.map_y, hitFace(out.side, ray));
+            }
+            return {OverlayStep::DOOR, 0};
+        }
+
+        if (entry->tile == 0) {
+            return {OverlayStep::PASS, 0};
+        }
+        return {OverlayStep::WALL, entry->tile};
+    }
+
+    /// @brief DdaState::start(), always inlined so castRay() keeps the state in registers
+    [[gnu::always_inline]] inline bool startDda(const Ray& ray, DdaState& state) {
+        state.map_x = ray.origin_x.toInt();
+        state.map_y = ray.origin_y.toInt();
+
+        if (ray.dir_x == 0 && ray.dir_y == 0) {
+            return false;
+        }
+
+        state.delta_dist_x = deltaDist(ray.dir_x);
+        state.delta_dist_y = deltaDist(ray.dir_y);
+
+        // sidedist is the distance to get to an int coordinate on the map after which we will start DDA with deltadist in step direction
+        if (ray.dir_x < 0) {
+            state.step_x = -1;
+            state.side_dist_x = (ray.origin_x - state.map_x) * state.delta_dist_x;
+        } else {
+            state.step_x = 1;
+            state.side_dist_x = (state.map_x + 1 - ray.origin_x) * state.delta_dist_x;
+        }
+        if (ray.dir_y < 0) {
+            state.step_y = -1;
+            state.side_dist_y = (ray.origin_y - state.map_y) * state.delta_dist_y;
+        } else {
+            state.step_y = 1;
+            state.side_dist_y = (state.map_y + 1 - ray.origin_y) * state.delta_dist_y;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief DDA traversal from state to the next wall, Overlay = false is the plain walk over the map tiles
+     * @param state Where the walk stands, left in the tile that was hit so the walk can go on past it
+     * @note Split at compile time so maps without doors or destroyed walls pay nothing for them
+     */
+    template <bool Overlay>
+    inline RayHit traverse(const MapView& map, const Ray& ray, const RayQueryOptions& options, DdaState& state) {
+        RayHit result{};
+
+        int16_t map_x = state.map_x;
+        int16_t map_y = state.map_y;
+        Fixed15_16 side_dist_x = state.side_dist_x;
+        Fixed15_16 side_dist_y = state.side_dist_y;
+        const Fixed15_16 delta_dist_x = state.delta_dist_x;
+        const Fixed15_16 delta_dist_y = state.delta_dist_y;
+        const int8_t step_x = state.step_x;
+        const int8_t step_y = state.step_y;
+
+        uint8_t side;
+        uint8_t tile;
+
+        // loaded once for the walk, the bitmap test is the only overlay work left inline
+        const TileOverlay* overlay = map.overlay;
+
+        // distance at which the current tile was entered
+        Fixed15_16 dist;
+
+        while (true) {
+            if (side_dist_x < side_dist_y) {
+                dist = side_dist_x;
+                side_dist_x += delta_dist_x;
+                map_x += step_x;
+                side = 0;
+            } else {
+                dist = side_dist_y;
+                side_dist_y += delta_dist_y;
+                map_y += step_y;
+                side = 1;
+            }
+
+            // a walk ends with its first miss, the state is not needed after it
+            if (dist > options.max_distance) {
+                return result;
+            }
+
+            // unsigned compare also catches negative coordinates
+            if (static_cast<uint16_t>(map_x) >= map.width || static_cast<uint16_t>(map_y) >= map.height) {
+                return result;
+            }
+
+            tile = map.getTileUnchecked(map_x, map_y);
+
+            if (tile > 0) {
+                // the overlay only changes walls, so empty tiles never probe it, and only its bitmap is tested inline
+                if constexpr (Overlay) {
+                    if (overlay->mayBeModified(map_x, map_y)) {
+                        const DdaState at{map_x, map_y, side_dist_x, side_dist_y, delta_dist_x, delta_dist_y, step_x, step_y};
+                        RayHit door{};
+                        const OverlayStep step = overlayStep(map, ray, options, at, dist, tile, door);
+
+                        if (step.kind == OverlayStep::PASS) {
+                            continue;
+                        }
+                        if (step.kind == OverlayStep::DOOR) {
+                            state.map_x = map_x;
+                            state.map_y = map_y;
+                            state.side_dist_x = side_dist_x;
+                            state.side_dist_y = side_dist_y;
+                            return door;
+                        }
+                        tile = step.tile;
+                    }
+                }
+
+                break;
+            }
+        }
+
+        state.map_x = map_x;
+        state.map_y = map_y;
+        state.side_dist_x = side_dist_x;
+        state.side_dist_y = side_dist_y;
+
+        result.tile = tile;
+        result.side = side;
+        result.map_x = map_x;
+        result.map_y = map_y;
+
+        // this is same as calculating ((map_x - pos_x + (1 - step_x) / 2) / ray_dir_x) but can be simplified due to scaling of sidedist and deltadist by raydir magnitude
+        result.distance = dist;
+
+        if (!options.compute_tex) {
+            return result;
+        }
+
+        // exact position where wall was hit
+        Fixed15_16 wall_x;
+        if (side == 0) {
+            wall_x = ray.origin_y + dist * ray.dir_y;
+        } else {
+            wall_x = ray.origin_x + dist * ray.dir_x;
+        }
+        // normalize this position to [0,1]
+        wall_x = fractional(wall_x);
+
+        result.tex_x = texColumn(wall_x, side, ray, options.tex_log2_size);
+        result.shade = map.getShade(map_x, map_y, hitFace(side, ray));
+
+        return result;
+    }
+
+    /// @brief Walk to the first wall, with the state a local each instance can keep in registers
+    template <bool Overlay>
+    RAYCASTER_HOT RayHit castFirst(const MapView& map, const Ray& ray, const RayQueryOptions& options) {
+        DdaState state;
+        if (!startDda(ray, state)) {
+            return RayHit{};
+        }
+        return traverse<Overlay>(map, ray, options, state);
+    }
+
+    /// @brief castFirst<true>() kept out of line, so the callers of castRay() inline only the plain walk
+    [[gnu::noinline]] RAYCASTER_HOT RayHit castOverlay(const MapView& map, const Ray& ray, const RayQueryOptions& options) {
+        return castFirst<true>(map, ray, options);
+    }
+}
+
+bool DdaState::start(const Ray& ray) {
+    return startDda(ray, *this);
+}
+
+RAYCASTER_HOT RayHit castRay(const MapView& map, const Ray& ray, const RayQueryOptions& options) {
+    if (map.overlay != nullptr && !map.overlay->empty()) {
+        return castOverlay(map, ray, options);
+    }
+    return castFirst<false>(map, ray, options);
+}
+
+RayWalk::RayWalk(const MapView& map, const Ray& ray, const RayQueryOptions& options)
+    : map_(map), ray_(ray), options_(options), overlay_(map.overlay != nullptr && !map.overlay->empty()) {
+    done_ = !startDda(ray, state_);
+}
+
+RAYCASTER_HOT RayHit RayWalk::next() {
+    if (done_) {
+        return RayHit{};
+    }
+
+    const RayHit hit = overlay_ ? traverse<true>(map_, ray_, options_, state_) : traverse<false>(map_, ray_, options_, state_);
+    done_ = hit.tile == 0;
+
+    return hit;
+}
+
+size_t castRays(const MapView& map, const Ray* rays, RayHit* hits, size_t count, const RayQueryOptions& options) {
+    for (size_t i = 0; i < count; i++) {
+        hits[i] = castRay(map, rays[i], options);
+
+        if (options.stop_on_first_hit && hits[i].tile != 0) {
+            return i + 1;
+        }
+    }
+
+    return count;
+}
+
+bool hasLineOfSight(const MapView& map, Fixed15_16 x0, Fixed15_16 y0, Fixed15_16 x1, Fixed15_16 y1) {
+    // with an unnormalised direction the target sits at distance 1
+    const Ray ray{x0, y0, x1 - x0, y1 - y0};
+
+    RayQueryOptions options;
+    options.max_distance = Fixed15_16(1);
+    options.compute_tex = false;
+
+    return castRay(map, ray, options).tile == 0;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file renderer.cpp
+ */
+
+#include "renderer.hpp"
+
+#include "hot_path.hpp"
+
+RAYCASTER_HOT Ray cameraRay(const Camera& camera, uint8_t x) {
+    return DefaultColumnRenderer::cameraRay(camera, x);
+}
+
+RAYCASTER_HOT void drawWallColumn(const RayHit& hit, uint16_t* column) {
+    DefaultColumnRenderer::drawWallColumn(hit, column);
+}
+
+RAYCASTER_HOT RayHit renderWallLayers(const MapView& map, const Ray& ray, uint16_t* column, uint8_t& layers) {
+    return DefaultColumnRenderer::renderWallLayers(map, ray, column, layers);
+}
+
+RAYCASTER_HOT RayHit renderMaskedLayers(const MapView& map, const Ray& ray, uint16_t* column, uint8_t& layers) {
+    return DefaultColumnRenderer::renderMaskedLayers(map, ray, column, layers);
+}
+
+// same as DefaultColumnRenderer::renderColumn, through the wrappers so the column fill is only emitted once
+RAYCASTER_HOT RayHit renderColumn(const MapView& map, const Camera& camera, uint8_t x, uint16_t* column) {
+    if (map.heights != nullptr) {
+        uint8_t layers;
+        return renderWallLayers(map, cameraRay(camera, x), column, layers);
+    }
+
+    const Ray ray = cameraRay(camera, x);
+    const RayHit hit = castRay(map, ray);
+
+    if (DefaultColumnRenderer::isMasked(hit)) {
+        uint8_t layers;
+        return renderMaskedLayers(map, ray, column, layers);
+    }
+
+    drawWallColumn(hit, column);
+
+    return hit;
+}
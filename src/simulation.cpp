@@ -0,0 +1,54 @@
+/**
+ * @file simulation.cpp
+ */
+
+#include "simulation.hpp"
+
+#include "fp_math.hpp"
+#include "vec2.hpp"
+
+namespace {
+    // stick travel past the deadzone that counts as pushed, about where the raw 1000 / 3000 thresholds were
+    constexpr Fixed15_16 STICK_THRESHOLD = 0.45_fp;
+
+    constexpr Fixed15_16 MOVE_STEP = 0.05_fp;
+
+    /// @brief Move along the view direction by sign * MOVE_STEP, each axis only if it stays clear of walls
+    void moveAlongView(PlayerState& player, const MapView& map, int8_t sign) {
+        const Fixed15_16 step_x = cosBam(player.heading) * MOVE_STEP * sign;
+        const Fixed15_16 step_y = sinBam(player.heading) * MOVE_STEP * sign;
+
+        // look 10 steps ahead so the camera never gets close enough to a wall to clip it
+        if (map.getEffectiveTile((player.pos_x + step_x * 10).toInt(), player.pos_y.toInt()) == 0) {
+            player.pos_x += step_x;
+        }
+        if (map.getEffectiveTile(player.pos_x.toInt(), (player.pos_y + step_y * 10).toInt()) == 0) {
+            player.pos_y += step_y;
+        }
+    }
+}
+
+void stepPlayer(PlayerState& player, const MapView& map, const JoystickState& stick) {
+    if (stick.y < -STICK_THRESHOLD) {
+        moveAlongView(player, map, 1);
+    } else if (stick.y > STICK_THRESHOLD) {
+        moveAlongView(player, map, -1);
+    }
+
+    // the stick's deadzone already gives 0 at rest, any deflection past it turns
+    // the magnitude is rounded so left and right turn equally fast
+    const int32_t deflection = stick.x.toRaw();
+    const int32_t turn = ((deflection < 0 ? -deflection : deflection) * SIM_MAX_TURN + (Fixed15_16::ONE >> 1)) >> 16;
+    player.heading = static_cast<angle16_t>(deflection < 0 ? player.heading - turn : player.heading + turn);
+}
+
+Camera interpolateCamera(const PlayerState& previous, const PlayerState& current, Fixed15_16 alpha) {
+    // the signed difference is the short way round, also across the wrap at 0
+    const int32_t turn = static_cast<int16_t>(current.heading - previous.heading);
+
+    const Vec2fp pos = Vec2fp{previous.pos_x, previous.pos_y}.lerp(Vec2fp{current.pos_x, current.pos_y}, alpha);
+
+    const PlayerState blended{pos.x, pos.y, static_cast<angle16_t>(previous.heading + ((turn * alpha.toRaw()) >> 16))};
+
+    return Camera::fromPlayer(blended.pose());
+}
@@ -0,0 +1,213 @@
+/**
+ * @file temporal.cpp
+ */
+
+#include "temporal.hpp"
+
+#include "fp_math.hpp"
+#include "hot_path.hpp"
+#include "textures.hpp"
+#include "tile_overlay.hpp"
+
+namespace {
+    /// @brief Both hits lie on the same grid line, eg. two tiles of one flat wall
+    inline bool samePlane(const RayHit& a, const RayHit& b) {
+        if (a.tile == 0 || b.tile == 0 || a.side != b.side) return false;
+        return (a.side == 0) ? a.map_x == b.map_x : a.map_y == b.map_y;
+    }
+
+    /// @brief Cell coordinate of a hit along its wall line
+    inline int16_t acrossCell(const RayHit& hit) {
+        return (hit.side == 0) ? hit.map_y : hit.map_x;
+    }
+
+    /// @brief The overlay may have changed the cell, eg. a door panel that is not on a grid line
+    inline bool overlayMayCover(const MapView& map, int16_t x, int16_t y) {
+        return map.overlay != nullptr && !map.overlay->empty() && map.overlay->mayBeModified(x, y);
+    }
+}
+
+TemporalRenderer::TemporalRenderer(const MapView& map) : map_(map) {
+    for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+        hits_[x] = RayHit{};
+        fresh_[x] = false;
+    }
+}
+
+void TemporalRenderer::setEnabled(bool enabled) {
+    if (enabled && !enabled_) {
+        invalidate();
+    }
+    enabled_ = enabled;
+}
+
+void TemporalRenderer::invalidate() {
+    discard_history_ = true;
+}
+
+void TemporalRenderer::beginFrame(const Camera& camera) {
+    // the frame that just finished rendered every column, so it is usable history
+    bool previous_complete = true;
+    for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+        previous_complete &= fresh_[x];
+        fresh_[x] = false;
+    }
+
+    history_valid_ = previous_complete && !discard_history_;
+    discard_history_ = false;
+
+    camera_ = camera;
+    stats_ = FrameStats{};
+    parity_ ^= 1;
+}
+
+RAYCASTER_HOT uint8_t TemporalRenderer::columnAt(uint8_t i) const {
+    if (!enabled_) {
+        return i;
+    }
+
+    // columns of the active parity first, then the rest
+    const uint8_t first_count = (SCREEN_WIDTH + 1 - parity_) >> 1;
+
+    if (i < first_count) {
+        return parity_ + (i << 1);
+    }
+    return (parity_ ^ 1) + ((i - first_count) << 1);
+}
+
+/**
+ * @brief Check that the fresh neighbours of column x hit the wall line column x hit last frame
+ * @param[out] across_min Lowest cell along the wall line hit by a neighbour
+ * @param[out] across_max Highest cell along the wall line hit by a neighbour
+ * @note Neighbours at most one cell apart leave no gap for column x to see through
+ */
+RAYCASTER_HOT bool TemporalRenderer::isReprojectable(uint8_t x, int16_t& across_min, int16_t& across_max) const {
+    const RayHit& previous = hits_[x];
+    bool any_neighbour = false;
+
+    if (overlayMayCover(map_, previous.map_x, previous.map_y)) return false;
+
+    across_min = INT16_MAX;
+    across_max = INT16_MIN;
+
+    for (int16_t n = x - 1; n <= x + 1; n += 2) {
+        if (n < 0 || n >= SCREEN_WIDTH) continue;
+        if (!fresh_[n] || !samePlane(hits_[n], previous)) return false;
+        if (overlayMayCover(map_, hits_[n].map_x, hits_[n].map_y)) return false;
+
+        const int16_t cell = acrossCell(hits_[n]);
+        if (cell < across_min) across_min = cell;
+        if (cell > across_max) across_max = cell;
+        any_neighbour = true;
+    }
+
+    return any_neighbour && across_max - across_min <= 1;
+}
+
+/**
+ * @brief Intersect a camera ray with the wall line of a previous hit
+ * @return false if the ray does not hit that line within [across_min, across_max], or faces away from it
+ */
+RAYCASTER_HOT bool TemporalRenderer::reproject(const RayHit& previous, const Ray& ray, int16_t across_min, int16_t across_max, RayHit& out) const {
+    // coordinate along and across the wall line
+    const Fixed15_16 pos_along = (previous.side == 0) ? ray.origin_x : ray.origin_y;
+    const Fixed15_16 pos_across = (previous.side == 0) ? ray.origin_y : ray.origin_x;
+    const Fixed15_16 dir_along = (previous.side == 0) ? ray.dir_x : ray.dir_y;
+    const Fixed15_16 dir_across = (previous.side == 0) ? ray.dir_y : ray.dir_x;
+    const int16_t cell_along = (previous.side == 0) ? previous.map_x : previous.map_y;
+
+    // the visible face is the one on the camera's side of the tile
+    Fixed15_16 face;
+    if (pos_along < cell_along) {
+        if (dir_along.toRaw() <= 0) return false;
+        face = Fixed15_16(cell_along);
+    } else if (pos_along >= cell_along + 1) {
+        if (dir_along.toRaw() >= 0) return false;
+        face = Fixed15_16(cell_along + 1);
+    } else {
+        return false;
+    }
+
+    // near parallel rays would overflow the divide, leave those to the DDA
+    if (abs(dir_along).toRaw() < 0x100) return false;
+
+    const Fixed15_16 dist = (face - pos_along) / dir_along;
+    const Fixed15_16 wall = pos_across + dist * dir_across;
+
+    const int16_t cell_across = wall.toInt();
+    if (cell_across < across_min || cell_across > across_max) return false;
+
+    int16_t tex_x_coord = (fractional(wall) << TEX_LOG2_SIZE).toInt();
+
+    // mirror texture coordinate like castRay does
+    if ((previous.side == 0 && ray.dir_x > 0) || (previous.side == 1 && ray.dir_y < 0)) {
+        tex_x_coord = TEX_SIZE - tex_x_coord - 1;
+    }
+
+    out.side = previous.side;
+    out.map_x = (previous.side == 0) ? cell_along : cell_across;
+    out.map_y = (previous.side == 0) ? cell_across : cell_along;
+    if (overlayMayCover(map_, out.map_x, out.map_y)) return false;
+
+    out.tile = map_.getTileUnchecked(out.map_x, out.map_y);
+    out.distance = dist;
+    out.tex_x = static_cast<uint8_t>(tex_x_coord);
+
+    // the face towards the camera, as castRay would have seen it
+    const uint8_t far_face = dir_along.toRaw() < 0;
+    out.shade = map_.getShade(out.map_x, out.map_y, static_cast<TileFace>((previous.side << 1) | far_face));
+
+    return out.tile != 0;
+}
+
+RAYCASTER_HOT RayHit TemporalRenderer::renderColumn(uint8_t x, uint16_t* column) {
+    const Ray ray = cameraRay(camera_, x);
+
+    RayHit hit;
+    bool reused = false;
+
+    if (map_.heights != nullptr) {
+        uint8_t layers;
+        hit = renderWallLayers(map_, ray, column, layers);
+
+        stats_.rays_cast++;
+        stats_.layers += layers;
+        hits_[x] = hit;
+        fresh_[x] = true;
+
+        return hit;
+    }
+
+    int16_t across_min, across_max;
+    if (enabled_ && history_valid_ && (x & 1) != parity_ && isReprojectable(x, across_min, across_max)) {
+        reused = reproject(hits_[x], ray, across_min, across_max, hit);
+    }
+
+    if (reused) {
+        stats_.reprojected++;
+    } else {
+        hit = castRay(map_, ray);
+        stats_.rays_cast++;
+    }
+
+    hits_[x] = hit;
+    fresh_[x] = true;
+
+    // walls seen through masked columns are walked fresh, the cache only holds opaque columns
+    if (DefaultColumnRenderer::isMasked(hit)) {
+        uint8_t layers;
+        renderMaskedLayers(map_, ray, column, layers);
+        stats_.layers += layers;
+        return hit;
+    }
+
+    stats_.layers += hit.tile != 0;
+
+    if (column_cache_ != nullptr) {
+        column_cache_->drawWallColumn(hit, column);
+    } else {
+        drawWallColumn(hit, column);
+    }
+
+    return hit;
+}
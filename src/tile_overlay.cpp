@@ -0,0 +1,154 @@
+/**
+ * @file tile_overlay.cpp
+ */
+
+#include "tile_overlay.hpp"
+
+#include <cstring>
+
+void TileOverlay::reset() {
+    for (Entry& entry : entries_) {
+        entry = Entry{};
+    }
+    memset(blocks_, 0, sizeof(blocks_));
+    count_ = 0;
+}
+
+uint8_t TileOverlay::indexOf(uint8_t x, uint8_t y) const {
+    for (uint8_t i = slot(x, y);; i = (i + 1) & (CAPACITY - 1)) {
+        const Entry& entry = entries_[i];
+
+        // never full, so every probe chain ends at an unused slot
+        if (!entry.used) return CAPACITY;
+        if (entry.x == x && entry.y == y) return i;
+    }
+}
+
+const TileOverlay::Entry* TileOverlay::find(uint8_t x, uint8_t y) const {
+    const uint8_t i = indexOf(x, y);
+    return (i < CAPACITY) ? &entries_[i] : nullptr;
+}
+
+TileOverlay::Entry* TileOverlay::insert(uint8_t x, uint8_t y) {
+    const uint8_t existing = indexOf(x, y);
+    if (existing < CAPACITY) return &entries_[existing];
+
+    if (count_ >= MAX_ENTRIES) return nullptr;
+
+    uint8_t i = slot(x, y);
+    while (entries_[i].used) i = (i + 1) & (CAPACITY - 1);
+
+    Entry& entry = entries_[i];
+    entry = Entry{};
+    entry.x = x;
+    entry.y = y;
+    entry.used = true;
+    count_++;
+
+    const uint16_t bit = ((y >> BLOCK_LOG2) << (8 - BLOCK_LOG2)) | (x >> BLOCK_LOG2);
+    blocks_[bit >> 5] |= 1u << (bit & 31);
+
+    return &entry;
+}
+
+bool TileOverlay::setTile(uint8_t x, uint8_t y, uint8_t tile) {
+    Entry* entry = insert(x, y);
+    if (entry == nullptr) return false;
+
+    entry->kind = Kind::TILE;
+    entry->tile = tile;
+    entry->motion = 0;
+    return true;
+}
+
+bool TileOverlay::addDoor(uint8_t x, uint8_t y, uint8_t axis, uint8_t tile) {
+    Entry* entry = insert(x, y);
+    if (entry == nullptr) return false;
+
+    entry->kind = Kind::DOOR;
+    entry->tile = tile;
+    entry->axis = axis;
+    entry->motion = 0;
+    entry->open = Fixed15_16::fromRaw(0);
+    return true;
+}
+
+uint8_t TileOverlay::loadDoors(const uint8_t* blob, const MapView& map) {
+    uint32_t door_count;
+    const DoorData* doors = getDoors(door_count, blob);
+
+    uint8_t added = 0;
+    for (uint32_t i = 0; i < door_count; i++) {
+        const DoorData& door = doors[i];
+        const uint8_t tile = map.getTile(door.x, door.y);
+
+        // a door needs a texture, the packer guarantees one but a bad blob should not crash the DDA
+        if (tile != 0 && addDoor(door.x, door.y, door.axis, tile)) {
+            added++;
+        }
+    }
+
+    return added;
+}
+
+bool TileOverlay::toggleDoor(uint8_t x, uint8_t y) {
+    const uint8_t i = indexOf(x, y);
+    if (i == CAPACITY || entries_[i].kind != Kind::DOOR) return false;
+
+    Entry* entry = &entries_[i];
+
+    // a moving door reverses, a still one heads for the other end
+    if (entry->motion != 0) {
+        entry->motion = -entry->motion;
+    } else {
+        entry->motion = (entry->open.toRaw() >= Fixed15_16::ONE) ? -1 : 1;
+    }
+    return true;
+}
+
+bool TileOverlay::update(uint32_t elapsed_us) {
+    if (count_ == 0) return false;
+
+    // fraction of the slide covered this frame, capped so a long stall does not overflow
+    if (elapsed_us > DOOR_OPEN_US) elapsed_us = DOOR_OPEN_US;
+    const int32_t step = static_cast<int32_t>(static_cast<uint64_t>(elapsed_us) * Fixed15_16::ONE / DOOR_OPEN_US);
+
+    bool passability_changed = false;
+
+    for (Entry& entry : entries_) {
+        if (!entry.used || entry.motion == 0) continue;
+
+        const bool was_open = entry.open.toRaw() >= Fixed15_16::ONE;
+
+        int32_t open = entry.open.toRaw() + entry.motion * step;
+        if (open >= Fixed15_16::ONE) {
+            open = Fixed15_16::ONE;
+            entry.motion = 0;
+        } else if (open <= 0) {
+            open = 0;
+            entry.motion = 0;
+        }
+        entry.open = Fixed15_16::fromRaw(open);
+
+        passability_changed |= was_open != (open >= Fixed15_16::ONE);
+    }
+
+    return passability_changed;
+}
+
+uint8_t MapView::getEffectiveTile(uint8_t x, uint8_t y) const {
+    const uint8_t tile = getTile(x, y);
+
+    if (overlay == nullptr || x >= width || y >= height || !overlay->mayBeModified(x, y)) {
+        return tile;
+    }
+
+    const TileOverlay::Entry* entry = overlay->find(x, y);
+    if (entry == nullptr) {
+        return tile;
+    }
+    if (entry->kind == TileOverlay::Kind::DOOR) {
+        return (entry->open.toRaw() >= Fixed15_16::ONE) ? 0 : entry->tile;
+    }
+    return entry->tile;
+}
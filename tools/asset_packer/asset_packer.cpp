@@ -0,0 +1,1333 @@
+/**
+ * @file asset_packer.cpp
+ * @brief Builds textures.xip and mapdata.xip from editable sources.
+ *
+ * Usage:
+ *   asset_packer textures MANIFEST.json PNG_DIR OUT.xip [--usage MAP] [--align N] [--procedural 0|1]
+ *     Packs <PNG_DIR>/<name>.png for every texture of the manifest. Texture
+ *     data starts on an N byte boundary (default: one XIP cache line) so every
+ *     64 texel column fills whole cache lines. With --usage the textures are
+ *     laid out by how many wall faces of MAP use them, most used first, so the
+ *     hot ones share flash pages. Texture ids are unchanged. Lit maps need
+ *     no darker copies, the renderer shades the texels a column samples.
+ *     With --procedural 1, textures that one of the
+ *     ProceduralTexture kernels reproduces exactly are packed as its table
+ *     instead of their texels. That saves flash but generating a column costs
+ *     more than reading a stored one (tools/bench/texture_sample_bench), so
+ *     textures are stored by default.
+ *     A manifest "color_key" (RGB565, eg. "0xF81F" for magenta) makes texels of that
+ *     colour, and PNG pixels with alpha below 128, transparent. Every texture
+ *     column holding one is flagged in the blob's column masks, walls are
+ *     only seen through those columns.
+ *
+ *   asset_packer map MAP OUT.xip [--textures TEXTURES.xip] [--align N] [--pvs 0|1]
+ *     Packs a text or .json map. With --textures every wall is checked to have
+ *     its texture and shaded texture. The potentially visible sets of its open
+ *     tiles (include/pvs.hpp) are baked in, unless --pvs 0 is given.
+ *
+ *   asset_packer archive OUT.xip --texture-set TEXTURES.xip... --level NAME MAP SET... [--align N] [--pvs 0|1]
+ *     Packs a level archive (include/level_archive.hpp). Texture sets are
+ *     taken as packed blobs and numbered in order, every level packs MAP
+ *     and renders with texture set SET. Sections start on N byte boundaries.
+ *
+ *   asset_packer unpack-textures TEXTURES.xip MANIFEST.json PNG_DIR
+ *   asset_packer unpack-map MAPDATA.xip OUT.txt
+ *     Turn existing blobs back into sources.
+ *
+ * Text maps:
+ *   version 100000               (optional)
+ *   player X Y ANGLE_DEGREES     (or: player X Y DIR_X DIR_Y)
+ *   door X Y x|y                 (optional, repeatable) door on the tile at X Y, passed along x or y
+ *   light X Y INTENSITY RADIUS   (optional, repeatable) point light, baked into a lightmap of the wall faces
+ *   ambient LEVEL                (optional) light every face gets, 0..1, default 0.35 once there are lights
+ *   height X Y UNITS             (optional, repeatable) wall height of the tile at X Y, default 1, in 1/16 steps up to 15.9
+ *   tiles
+ *   1 1 1 1
+ *   1 . . 1                      one row per line, '.' or 0 is empty
+ *   1 1 1 1
+ *
+ * JSON maps:
+ *   {"version": 100001, "player": {"x": 8, "y": 8, "angle": 90}, "tiles": [[1, 1, 1], ...]}
+ *   "angle" can be replaced by "dir_x" and "dir_y".
+ *   Doors go in an optional "doors": [{"x": 3, "y": 5, "axis": "y"}, ...] array, lights in
+ *   "lights": [{"x": 4.5, "y": 2.5, "intensity": 1.2, "radius": 8}, ...] with an optional "ambient",
+ *   wall heights in "heights": [{"x": 6, "y": 2, "height": 0.5}, ...].
+ *
+ * Lightmaps: every wall face next to an open tile gets one baked shade from the
+ * ambient level plus each light that reaches it (Lambert term, quadratic falloff
+ * to zero at the radius, walls cast hard shadows), averaged over a few points
+ * along the face. Maps without lights pack no lightmap and render unlit.
+ *
+ * Wall heights: maps where every wall is one unit high pack no heights section,
+ * their columns stop at the first wall.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <numbers>
+#include <string>
+#include <vector>
+
+#include <png.h>
+
+#include "asset_validation.hpp"
+#include "json.hpp"
+#include "level_archive.hpp"
+#include "map_data.hpp"
+#include "mapped_file.hpp"
+#include "pvs_builder.hpp"
+#include "textures.hpp"
+#include "tile_overlay.hpp"
+
+namespace {
+    // RP2350 XIP cache lines are 8 bytes, a 64 texel RGB565 column is 16 of them
+    constexpr uint32_t XIP_CACHE_LINE = 8;
+
+    constexpr uint32_t TEXTURE_VERSION = TextureFileHeader::VERSION;
+    constexpr uint32_t MAP_VERSION = MapFileHeader::VERSION;
+
+    constexpr size_t TEXTURE_TEXELS = TEX_SIZE * TEX_SIZE;
+
+    constexpr double DEFAULT_AMBIENT = 0.35;
+
+    struct Light {
+        double x;
+        double y;
+        double intensity;
+        double radius;
+    };
+
+    struct WallHeight {
+        uint8_t x;
+        uint8_t y;
+        double units;
+    };
+
+    struct SourceMap {
+        uint32_t version = MAP_VERSION;
+        PlayerData player{};
+        uint8_t width = 0;
+        uint8_t height = 0;
+        std::vector<uint8_t> tiles; // column major like MapView
+        std::vector<DoorData> doors;
+        std::vector<Light> lights;
+        double ambient = DEFAULT_AMBIENT;
+        std::vector<uint8_t> lightmap; // already baked, when repacking a blob
+        std::vector<WallHeight> wall_heights;
+        std::vector<uint8_t> heights; // already packed, when repacking a blob
+    };
+
+    uint32_t alignUp(uint32_t value, uint32_t align) {
+        return (value + align - 1) / align * align;
+    }
+
+    Fixed15_16 toFixed(double value) {
+        return Fixed15_16::fromRaw(static_cast<int32_t>(std::lround(value * Fixed15_16::ONE)));
+    }
+
+    void setPlayer(SourceMap& map, double x, double y, double dir_x, double dir_y) {
+        map.player = PlayerData{toFixed(x), toFixed(y), toFixed(dir_x), toFixed(dir_y)};
+    }
+
+    void setPlayerAngle(SourceMap& map, double x, double y, double degrees) {
+        const double rad = degrees * std::numbers::pi / 180.0;
+        setPlayer(map, x, y, std::cos(rad), std::sin(rad));
+    }
+
+    bool writeFile(const char* path, const std::vector<uint8_t>& data) {
+        FILE* f = fopen(path, "wb");
+        if (f == nullptr) return false;
+
+        const bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+        return (fclose(f) == 0) && ok;
+    }
+
+    template <typename T>
+    void put(std::vector<uint8_t>& out, size_t offset, const T& value) {
+        memcpy(out.data() + offset, &value, sizeof(T));
+    }
+
+    // ---- maps ----
+
+    /// @brief Store grid rows (row = y) column major
+    bool setTiles(SourceMap& map, const std::vector<std::vector<int>>& rows) {
+        if (rows.empty() || rows.size() > 255 || rows[0].empty() || rows[0].size() > 255) {
+            fprintf(stderr, "ERROR map must be 1..255 tiles in each direction\n");
+            return false;
+        }
+
+        map.height = static_cast<uint8_t>(rows.size());
+        map.width = static_cast<uint8_t>(rows[0].size());
+        map.tiles.assign(static_cast<size_t>(map.width) * map.height, 0);
+
+        for (size_t y = 0; y < rows.size(); y++) {
+            if (rows[y].size() != map.width) {
+                fprintf(stderr, "ERROR map row %zu has %zu tiles, expected %d\n", y, rows[y].size(), map.width);
+                return false;
+            }
+            for (size_t x = 0; x < rows[y].size(); x++) {
+                if (rows[y][x] < 0 || rows[y][x] > 255) {
+                    fprintf(stderr, "ERROR tile %d at (%zu, %zu) out of range\n", rows[y][x], x, y);
+                    return false;
+                }
+                map.tiles[y + map.height * x] = static_cast<uint8_t>(rows[y][x]);
+            }
+        }
+
+        return true;
+    }
+
+    bool loadTextMap(const char* path, SourceMap& map) {
+        FILE* f = fopen(path, "r");
+        if (f == nullptr) {
+            fprintf(stderr, "ERROR could not open %s\n", path);
+            return false;
+        }
+
+        std::vector<std::vector<int>> rows;
+        bool in_tiles = false;
+        bool has_player = false;
+        char line[1024];
+
+        while (fgets(line, sizeof(line), f) != nullptr) {
+            if (line[0] == '#') continue;
+
+            if (in_tiles) {
+                std::vector<int> row;
+                for (char* token = strtok(line, " \t\r\n"); token != nullptr; token = strtok(nullptr, " \t\r\n")) {
+                    row.push_back(strcmp(token, ".") == 0 ? 0 : atoi(token));
+                }
+                if (!row.empty()) rows.push_back(row);
+                continue;
+            }
+
+            double v[4];
+            double ambient;
+            unsigned version;
+            unsigned door_x, door_y;
+            char door_axis;
+            unsigned height_x, height_y;
+            double units;
+
+            if (sscanf(line, " version %u", &version) == 1) {
+                if (version > MAP_VERSION) {
+                    fprintf(stderr, "ERROR %s: version %u, the packer writes version %u\n", path, version, MAP_VERSION);
+                    fclose(f);
+                    return false;
+                }
+                map.version = version;
+            } else if (sscanf(line, " player %lf %lf %lf %lf", &v[0], &v[1], &v[2], &v[3]) == 4) {
+                setPlayer(map, v[0], v[1], v[2], v[3]);
+                has_player = true;
+            } else if (sscanf(line, " player %lf %lf %lf", &v[0], &v[1], &v[2]) == 3) {
+                setPlayerAngle(map, v[0], v[1], v[2]);
+                has_player = true;
+            } else if (sscanf(line, " door %u %u %c", &door_x, &door_y, &door_axis) == 3) {
+                if (door_x > 255 || door_y > 255 || (door_axis != 'x' && door_axis != 'y')) {
+                    fprintf(stderr, "ERROR %s: bad door line: %s", path, line);
+                    fclose(f);
+                    return false;
+                }
+                map.doors.push_back(DoorData{static_cast<uint8_t>(door_x), static_cast<uint8_t>(door_y), static_cast<uint8_t>(door_axis == 'y'), 0});
+            } else if (sscanf(line, " light %lf %lf %lf %lf", &v[0], &v[1], &v[2], &v[3]) == 4) {
+                map.lights.push_back(Light{v[0], v[1], v[2], v[3]});
+            } else if (sscanf(line, " ambient %lf", &ambient) == 1) {
+                map.ambient = ambient;
+            } else if (sscanf(line, " height %u %u %lf", &height_x, &height_y, &units) == 3) {
+                if (height_x > 255 || height_y > 255) {
+                    fprintf(stderr, "ERROR %s: bad height line: %s", path, line);
+                    fclose(f);
+                    return false;
+                }
+                map.wall_heights.push_back(WallHeight{static_cast<uint8_t>(height_x), static_cast<uint8_t>(height_y), units});
+            } else if (strncmp(line, "tiles", 5) == 0) {
+                in_tiles = true;
+            }
+        }
+
+        fclose(f);
+
+        if (!has_player) {
+            fprintf(stderr, "ERROR %s has no player line\n", path);
+            return false;
+        }
+
+        return setTiles(map, rows);
+    }
+
+    bool loadJsonMap(const char* path, SourceMap& map) {
+        JsonValue root;
+        std::string error;
+        if (!JsonValue::parseFile(path, root, error)) {
+            fprintf(stderr, "ERROR %s: %s\n", path, error.c_str());
+            return false;
+        }
+
+        if (const JsonValue* version = root.find("version"); version && version->isNumber()) {
+            map.version = static_cast<uint32_t>(version->number);
+            if (map.version > MAP_VERSION) {
+                fprintf(stderr, "ERROR %s: version %u, the packer writes version %u\n", path, map.version, MAP_VERSION);
+                return false;
+            }
+        }
+
+        const JsonValue* player = root.find("player");
+        const JsonValue* x = player ? player->find("x") : nullptr;
+        const JsonValue* y = player ? player->find("y") : nullptr;
+        if (!x || !y || !x->isNumber() || !y->isNumber()) {
+            fprintf(stderr, "ERROR %s needs player.x and player.y\n", path);
+            return false;
+        }
+
+        const JsonValue* angle = player->find("angle");
+        const JsonValue* dir_x = player->find("dir_x");
+        const JsonValue* dir_y = player->find("dir_y");
+
+        if (angle && angle->isNumber()) {
+            setPlayerAngle(map, x->number, y->number, angle->number);
+        } else if (dir_x && dir_y && dir_x->isNumber() && dir_y->isNumber()) {
+            setPlayer(map, x->number, y->number, dir_x->number, dir_y->number);
+        } else {
+            fprintf(stderr, "ERROR %s needs player.angle or player.dir_x and player.dir_y\n", path);
+            return false;
+        }
+
+        if (const JsonValue* doors = root.find("doors"); doors && doors->isArray()) {
+            for (const JsonValue& door : doors->array) {
+                const JsonValue* door_x = door.find("x");
+                const JsonValue* door_y = door.find("y");
+                const JsonValue* axis = door.find("axis");
+
+                if (!door_x || !door_y || !axis || !door_x->isNumber() || !door_y->isNumber() || !axis->isString() ||
+                    door_x->number < 0 || door_x->number > 255 || door_y->number < 0 || door_y->number > 255 ||
+                    (axis->string != "x" && axis->string != "y")) {
+                    fprintf(stderr, "ERROR %s: doors need x, y and an axis of \"x\" or \"y\"\n", path);
+                    return false;
+                }
+
+                map.doors.push_back(DoorData{static_cast<uint8_t>(door_x->number), static_cast<uint8_t>(door_y->number),
+                                             static_cast<uint8_t>(axis->string == "y"), 0});
+            }
+        }
+
+        if (const JsonValue* lights = root.find("lights"); lights && lights->isArray()) {
+            for (const JsonValue& light : lights->array) {
+                const JsonValue* light_x = light.find("x");
+                const JsonValue* light_y = light.find("y");
+                const JsonValue* intensity = light.find("intensity");
+                const JsonValue* radius = light.find("radius");
+
+                if (!light_x || !light_y || !intensity || !radius || !light_x->isNumber() || !light_y->isNumber() ||
+                    !intensity->isNumber() || !radius->isNumber()) {
+                    fprintf(stderr, "ERROR %s: lights need x, y, intensity and radius\n", path);
+                    return false;
+                }
+
+                map.lights.push_back(Light{light_x->number, light_y->number, intensity->number, radius->number});
+            }
+        }
+
+        if (const JsonValue* ambient = root.find("ambient"); ambient && ambient->isNumber()) {
+            map.ambient = ambient->number;
+        }
+
+        if (const JsonValue* heights = root.find("heights"); heights && heights->isArray()) {
+            for (const JsonValue& wall : heights->array) {
+                const JsonValue* wall_x = wall.find("x");
+                const JsonValue* wall_y = wall.find("y");
+                const JsonValue* units = wall.find("height");
+
+                if (!wall_x || !wall_y || !units || !wall_x->isNumber() || !wall_y->isNumber() || !units->isNumber() ||
+                    wall_x->number < 0 || wall_x->number > 255 || wall_y->number < 0 || wall_y->number > 255) {
+                    fprintf(stderr, "ERROR %s: heights need x, y and a height\n", path);
+                    return false;
+                }
+
+                map.wall_heights.push_back(WallHeight{static_cast<uint8_t>(wall_x->number), static_cast<uint8_t>(wall_y->number), units->number});
+            }
+        }
+
+        const JsonValue* tiles = root.find("tiles");
+        if (!tiles || !tiles->isArray()) {
+            fprintf(stderr, "ERROR %s needs a tiles array of rows\n", path);
+            return false;
+        }
+
+        std::vector<std::vector<int>> rows;
+        for (const JsonValue& json_row : tiles->array) {
+            std::vector<int>& row = rows.emplace_back();
+            for (const JsonValue& tile : json_row.array) {
+                row.push_back(tile.isNumber() ? static_cast<int>(tile.number) : -1);
+            }
+        }
+
+        return setTiles(map, rows);
+    }
+
+    bool loadXipMap(const char* path, SourceMap& map) {
+        MappedFile file(path);
+        if (!file.valid() || !validateMapBlob(file.data(), file.size(), 256)) {
+            fprintf(stderr, "ERROR invalid map blob: %s\n", path);
+            return false;
+        }
+
+        const MapView view = createMapView(file.data());
+
+        map.version = getMapFileHeader(file.data())->version;
+        map.player = *getPlayerData(file.data());
+        map.width = view.width;
+        map.height = view.height;
+        map.tiles.assign(view.tile_data, view.tile_data + static_cast<size_t>(view.width) * view.height);
+
+        uint32_t door_count;
+        const DoorData* doors = getDoors(door_count, file.data());
+        map.doors.assign(doors, doors + door_count);
+
+        // the lights themselves are not packed, keep what was baked from them
+        if (view.lightmap != nullptr) {
+            map.lightmap.assign(view.lightmap, view.lightmap + static_cast<size_t>(view.width) * view.height * 4);
+        }
+
+        if (view.heights != nullptr) {
+            map.heights.assign(view.heights, view.heights + static_cast<size_t>(view.width) * view.height);
+        }
+
+        return true;
+    }
+
+    bool endsWith(const std::string& s, const char* suffix) {
+        const size_t n = strlen(suffix);
+        return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+    }
+
+    bool loadMap(const char* path, SourceMap& map) {
+        if (endsWith(path, ".json")) return loadJsonMap(path, map);
+        if (endsWith(path, ".xip")) return loadXipMap(path, map);
+        return loadTextMap(path, map);
+    }
+
+    /// @brief Semantic checks the renderer relies on
+    bool checkMap(const SourceMap& map, uint32_t tex_count) {
+        bool ok = true;
+
+        const int px = map.player.pos_x.toInt();
+        const int py = map.player.pos_y.toInt();
+
+        if (map.player.pos_x < 0 || map.player.pos_y < 0 || px >= map.width || py >= map.height) {
+            fprintf(stderr, "ERROR player outside the map\n");
+            ok = false;
+        } else if (map.tiles[py + map.height * px] != 0) {
+            fprintf(stderr, "ERROR player starts inside a wall\n");
+            ok = false;
+        }
+
+        for (uint8_t x = 0; x < map.width; x++) {
+            for (uint8_t y = 0; y < map.height; y++) {
+                const uint8_t tile = map.tiles[y + map.height * x];
+
+                if (tile >= tex_count) {
+                    fprintf(stderr, "ERROR tile %d at (%d, %d) needs textures %d and %d, only %u packed\n", tile, x, y, tile - 1, tile, tex_count);
+                    ok = false;
+                }
+
+                const bool border = x == 0 || y == 0 || x == map.width - 1 || y == map.height - 1;
+                if (border && tile == 0) {
+                    // the DDA stops at the map edge, the column just stays empty
+                    fprintf(stderr, "WARNING map not closed at (%d, %d)\n", x, y);
+                }
+            }
+        }
+
+        for (const DoorData& door : map.doors) {
+            if (door.x >= map.width || door.y >= map.height) {
+                fprintf(stderr, "ERROR door at (%d, %d) outside the map\n", door.x, door.y);
+                ok = false;
+            } else if (map.tiles[door.y + map.height * door.x] == 0) {
+                // the tile under a door is its texture
+                fprintf(stderr, "ERROR door at (%d, %d) has no tile\n", door.x, door.y);
+                ok = false;
+            }
+        }
+
+        if (map.doors.size() > TileOverlay::MAX_DOORS) {
+            fprintf(stderr, "ERROR %zu doors, at most %d are supported\n", map.doors.size(), TileOverlay::MAX_DOORS);
+            ok = false;
+        }
+
+        for (const Light& light : map.lights) {
+            const int lx = static_cast<int>(std::floor(light.x));
+            const int ly = static_cast<int>(std::floor(light.y));
+
+            if (lx < 0 || ly < 0 || lx >= map.width || ly >= map.height || map.tiles[ly + map.height * lx] != 0) {
+                fprintf(stderr, "ERROR light at (%.2f, %.2f) is not on an open tile\n", light.x, light.y);
+                ok = false;
+            } else if (light.intensity <= 0.0 || light.radius <= 0.0) {
+                fprintf(stderr, "ERROR light at (%.2f, %.2f) needs a positive intensity and radius\n", light.x, light.y);
+                ok = false;
+            }
+        }
+
+        if (map.ambient < 0.0 || map.ambient > 1.0) {
+            fprintf(stderr, "ERROR ambient %.2f outside 0..1\n", map.ambient);
+            ok = false;
+        }
+
+        for (const WallHeight& wall : map.wall_heights) {
+            if (wall.x >= map.width || wall.y >= map.height || map.tiles[wall.y + map.height * wall.x] == 0) {
+                fprintf(stderr, "ERROR height at (%d, %d) is not on a wall\n", wall.x, wall.y);
+                ok = false;
+            } else if (std::lround(wall.units * WALL_HEIGHT_ONE) < 1 || std::lround(wall.units * WALL_HEIGHT_ONE) > 255) {
+                fprintf(stderr, "ERROR height %.2f at (%d, %d) outside 1/%d..%.2f\n", wall.units, wall.x, wall.y, WALL_HEIGHT_ONE,
+                        255.0 / WALL_HEIGHT_ONE);
+                ok = false;
+            }
+        }
+
+        return ok;
+    }
+
+    // ---- lightmaps ----
+
+    bool isOpenTile(const SourceMap& map, int x, int y) {
+        return x >= 0 && y >= 0 && x < map.width && y < map.height && map.tiles[y + map.height * x] == 0;
+    }
+
+    /// @brief Grid walk from a point to a light, false if a wall (or the map edge) is in between
+    bool lightReaches(const SourceMap& map, double from_x, double from_y, const Light& light) {
+        const double dir_x = light.x - from_x;
+        const double dir_y = light.y - from_y;
+
+        int map_x = static_cast<int>(std::floor(from_x));
+        int map_y = static_cast<int>(std::floor(from_y));
+        const int end_x = static_cast<int>(std::floor(light.x));
+        const int end_y = static_cast<int>(std::floor(light.y));
+
+        const double inf = std::numeric_limits<double>::infinity();
+        const double delta_x = (dir_x == 0.0) ? inf : std::fabs(1.0 / dir_x);
+        const double delta_y = (dir_y == 0.0) ? inf : std::fabs(1.0 / dir_y);
+        const int step_x = (dir_x < 0.0) ? -1 : 1;
+        const int step_y = (dir_y < 0.0) ? -1 : 1;
+
+        double side_x = (dir_x < 0.0) ? (from_x - map_x) * delta_x : (map_x + 1.0 - from_x) * delta_x;
+        double side_y = (dir_y < 0.0) ? (from_y - map_y) * delta_y : (map_y + 1.0 - from_y) * delta_y;
+
+        while (map_x != end_x || map_y != end_y) {
+            if (!isOpenTile(map, map_x, map_y)) return false;
+
+            // the segment ends at distance 1 along dir, past that the walk is only rounding
+            if (std::min(side_x, side_y) > 1.0) break;
+
+            if (side_x < side_y) {
+                side_x += delta_x;
+                map_x += step_x;
+            } else {
+                side_y += delta_y;
+                map_y += step_y;
+            }
+        }
+
+        return isOpenTile(map, map_x, map_y);
+    }
+
+    /// @brief Bake one shade per face of every tile, see the file comment
+    std::vector<uint8_t> bakeLightmap(const SourceMap& map) {
+        struct FaceGeometry {
+            int out_x, out_y;           // neighbour tile the face looks into
+            double origin_x, origin_y;  // face start relative to the tile
+            double along_x, along_y;    // direction along the face
+        };
+
+        // in TileFace order
+        constexpr FaceGeometry FACES[4] = {
+            {-1, 0, 0.0, 0.0, 0.0, 1.0},
+            {1, 0, 1.0, 0.0, 0.0, 1.0},
+            {0, -1, 0.0, 0.0, 1.0, 0.0},
+            {0, 1, 0.0, 1.0, 1.0, 0.0},
+        };
+        constexpr double SAMPLES[4] = {0.125, 0.375, 0.625, 0.875};
+        constexpr double SURFACE_OFFSET = 1e-3; // sample just off the wall, in the open tile
+
+        std::vector<uint8_t> lightmap(map.tiles.size() * 4, 0);
+
+        for (int x = 0; x < map.width; x++) {
+            for (int y = 0; y < map.height; y++) {
+                if (map.tiles[y + map.height * x] == 0) continue;
+
+                for (uint8_t f = 0; f < 4; f++) {
+                    const FaceGeometry& face = FACES[f];
+                    if (!isOpenTile(map, x + face.out_x, y + face.out_y)) continue;
+
+                    double light = 0.0;
+                    for (double t : SAMPLES) {
+                        const double px = x + face.origin_x + t * face.along_x + face.out_x * SURFACE_OFFSET;
+                        const double py = y + face.origin_y + t * face.along_y + face.out_y * SURFACE_OFFSET;
+
+                        for (const Light& source : map.lights) {
+                            const double dx = source.x - px;
+                            const double dy = source.y - py;
+                            const double dist = std::hypot(dx, dy);
+                            if (dist >= source.radius || dist < 1e-9) continue;
+
+                            const double lambert = (dx * face.out_x + dy * face.out_y) / dist;
+                            if (lambert <= 0.0 || !lightReaches(map, px, py, source)) continue;
+
+                            const double falloff = 1.0 - dist / source.radius;
+                            light += source.intensity * lambert * falloff * falloff;
+                        }
+                    }
+
+                    const double brightness = std::min(1.0, map.ambient + light / std::size(SAMPLES));
+                    const long shade = std::lround((1.0 - brightness) * SHADE_COUNT);
+                    lightmap[(y + map.height * x) * 4 + f] = static_cast<uint8_t>(std::clamp(shade, 0L, SHADE_COUNT - 1L));
+                }
+            }
+        }
+
+        return lightmap;
+    }
+
+    // ---- wall heights ----
+
+    /// @brief One height per tile, empty if every wall stays one unit high
+    std::vector<uint8_t> packHeights(const SourceMap& map) {
+        if (map.wall_heights.empty()) return map.heights;
+
+        std::vector<uint8_t> heights = map.heights;
+        if (heights.empty()) heights.assign(map.tiles.size(), WALL_HEIGHT_ONE);
+
+        for (const WallHeight& wall : map.wall_heights) {
+            heights[wall.y + map.height * wall.x] = static_cast<uint8_t>(std::lround(wall.units * WALL_HEIGHT_ONE));
+        }
+
+        return heights;
+    }
+
+    // ---- visible sets ----
+
+    /// @brief PVS section of the map, built with the doors open and the wall heights it packs
+    std::vector<uint8_t> packPvs(const SourceMap& map) {
+        const auto start = std::chrono::steady_clock::now();
+
+        PvsBuildStats stats;
+        std::vector<uint8_t> section = buildPvs(map.width, map.height, map.tiles, packHeights(map), map.doors, PvsBuildOptions{}, &stats);
+
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        printf("pvs: %u sets, %.1f tiles visible on average, %zu bytes (%zu as bitsets), built in %.1f ms\n", stats.sets,
+               stats.sets ? static_cast<double>(stats.visible_tiles) / stats.sets : 0.0, stats.packed_bytes, stats.raw_bytes, ms);
+
+        return section;
+    }
+
+    std::vector<uint8_t> packMap(const SourceMap& map, uint32_t align, bool pvs) {
+        const uint32_t playerdata_offset = sizeof(MapFileHeader);
+
+        // the tile grid, after the width and height bytes, starts on a cache line
+        const uint32_t mapdata_offset = alignUp(playerdata_offset + sizeof(PlayerData) + 2, align) - 2;
+        const size_t tiles_end = mapdata_offset + 2 + map.tiles.size();
+
+        // door section after the tiles, word aligned for the count
+        const uint32_t doors_offset = map.doors.empty() ? 0 : alignUp(static_cast<uint32_t>(tiles_end), 4);
+        const size_t doors_end = map.doors.empty() ? tiles_end : doors_offset + sizeof(uint32_t) + map.doors.size() * sizeof(DoorData);
+
+        // lightmap last, 4 shades per tile read once per column
+        const std::vector<uint8_t> lightmap = map.lights.empty() ? map.lightmap : bakeLightmap(map);
+        const uint32_t lightmap_offset = lightmap.empty() ? 0 : alignUp(static_cast<uint32_t>(doors_end), 4);
+        const size_t lightmap_end = lightmap.empty() ? doors_end : lightmap_offset + lightmap.size();
+
+        // heights after it, read once per wall a column passes
+        const std::vector<uint8_t> heights = packHeights(map);
+        const uint32_t heights_offset = heights.empty() ? 0 : static_cast<uint32_t>(lightmap_end);
+        const size_t heights_end = lightmap_end + heights.size();
+
+        // visible sets at the end, only read when the player crosses into another tile
+        const std::vector<uint8_t> visible_sets = pvs ? packPvs(map) : std::vector<uint8_t>{};
+        const uint32_t pvs_offset = visible_sets.empty() ? 0 : alignUp(static_cast<uint32_t>(heights_end), 4);
+        const size_t size = visible_sets.empty() ? heights_end : pvs_offset + visible_sets.size();
+
+        std::vector<uint8_t> out(size, 0);
+
+        put(out, 0, MapFileHeader{MapFileHeader::VALID_MAGIC, MAP_VERSION, playerdata_offset, mapdata_offset, doors_offset, lightmap_offset,
+                                  heights_offset, pvs_offset});
+        put(out, playerdata_offset, map.player);
+        out[mapdata_offset] = map.width;
+        out[mapdata_offset + 1] = map.height;
+        memcpy(out.data() + mapdata_offset + 2, map.tiles.data(), map.tiles.size());
+
+        if (!map.doors.empty()) {
+            put(out, doors_offset, static_cast<uint32_t>(map.doors.size()));
+            memcpy(out.data() + doors_offset + sizeof(uint32_t), map.doors.data(), map.doors.size() * sizeof(DoorData));
+        }
+
+        if (!lightmap.empty()) {
+            memcpy(out.data() + lightmap_offset, lightmap.data(), lightmap.size());
+        }
+
+        if (!heights.empty()) {
+            memcpy(out.data() + heights_offset, heights.data(), heights.size());
+        }
+
+        if (!visible_sets.empty()) {
+            memcpy(out.data() + pvs_offset, visible_sets.data(), visible_sets.size());
+        }
+
+        return out;
+    }
+
+    // ---- textures ----
+
+    struct ManifestEntry {
+        uint32_t id;
+        std::string name;
+    };
+
+    /// @param color_key Set to the manifest's transparent colour, -1 if it has none
+    bool loadManifest(const char* path, std::vector<ManifestEntry>& entries, uint32_t& version, int32_t& color_key) {
+        JsonValue root;
+        std::string error;
+        if (!JsonValue::parseFile(path, root, error)) {
+            fprintf(stderr, "ERROR %s: %s\n", path, error.c_str());
+            return false;
+        }
+
+        version = TEXTURE_VERSION;
+        if (const JsonValue* v = root.find("version"); v && v->isNumber()) {
+            version = static_cast<uint32_t>(v->number);
+        }
+        if (version != TEXTURE_VERSION) {
+            fprintf(stderr, "ERROR %s: version %u, the renderer only reads version %u\n", path, version, TEXTURE_VERSION);
+            return false;
+        }
+
+        color_key = -1;
+        if (const JsonValue* key = root.find("color_key"); key && (key->isNumber() || key->isString())) {
+            const unsigned long value = key->isNumber() ? static_cast<unsigned long>(key->number) : strtoul(key->string.c_str(), nullptr, 0);
+            if (value > UINT16_MAX) {
+                fprintf(stderr, "ERROR %s: color_key has to be an RGB565 value\n", path);
+                return false;
+            }
+            // texels are compared as stored, in the panel's byte order
+            color_key = static_cast<int32_t>(panelColor(static_cast<uint16_t>(value)));
+        }
+
+        const JsonValue* textures = root.find("textures");
+        if (!textures || !textures->isArray()) {
+            fprintf(stderr, "ERROR %s has no textures array\n", path);
+            return false;
+        }
+
+        for (const JsonValue& texture : textures->array) {
+            const JsonValue* id = texture.find("id");
+            const JsonValue* name = texture.find("name");
+            if (!id || !name || !id->isNumber() || !name->isString()) {
+                fprintf(stderr, "ERROR %s: every texture needs an id and a name\n", path);
+                return false;
+            }
+            entries.push_back(ManifestEntry{static_cast<uint32_t>(id->number), name->string});
+        }
+
+        // ids index the offset table, they have to be 0..n-1
+        std::sort(entries.begin(), entries.end(), [](const ManifestEntry& a, const ManifestEntry& b) { return a.id < b.id; });
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].id != i) {
+                fprintf(stderr, "ERROR %s: texture ids must run from 0 without gaps, missing %zu\n", path, i);
+                return false;
+            }
+        }
+
+        if (const JsonValue* count = root.find("texture_count"); count && count->isNumber() && count->number != entries.size()) {
+            fprintf(stderr, "ERROR %s: texture_count %d does not match %zu textures\n", path, static_cast<int>(count->number), entries.size());
+            return false;
+        }
+
+        if (entries.empty() || entries.size() > 256) {
+            fprintf(stderr, "ERROR %s: need 1..256 textures\n", path);
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Load a TEX_SIZE square PNG into a column major texture, texels in panel byte order
+     * @param color_key Written for pixels with alpha below 128, -1 to flatten the alpha like any other PNG
+     */
+    bool loadTexturePng(const std::string& path, uint16_t* texels, int32_t color_key) {
+        png_image image;
+        memset(&image, 0, sizeof(image));
+        image.version = PNG_IMAGE_VERSION;
+
+        if (!png_image_begin_read_from_file(&image, path.c_str())) {
+            fprintf(stderr, "ERROR %s: %s\n", path.c_str(), image.message);
+            return false;
+        }
+
+        if (image.width != TEX_SIZE || image.height != TEX_SIZE) {
+            fprintf(stderr, "ERROR %s is %ux%u, textures are %dx%d\n", path.c_str(), image.width, image.height, TEX_SIZE, TEX_SIZE);
+            png_image_free(&image);
+            return false;
+        }
+
+        const bool keyed = color_key >= 0;
+        const uint32_t channels = keyed ? 4 : 3;
+
+        image.format = keyed ? PNG_FORMAT_RGBA : PNG_FORMAT_RGB;
+        std::vector<uint8_t> rgb(PNG_IMAGE_SIZE(image));
+
+        if (!png_image_finish_read(&image, nullptr, rgb.data(), 0, nullptr)) {
+            fprintf(stderr, "ERROR %s: %s\n", path.c_str(), image.message);
+            return false;
+        }
+
+        for (uint32_t x = 0; x < TEX_SIZE; x++) {
+            for (uint32_t y = 0; y < TEX_SIZE; y++) {
+                const uint8_t* p = &rgb[(y * TEX_SIZE + x) * channels];
+                const bool transparent = keyed && p[3] < 128;
+                texels[x * TEX_SIZE + y] = transparent ? static_cast<uint16_t>(color_key) : rgbToTexel(p[0], p[1], p[2]);
+            }
+        }
+
+        return true;
+    }
+
+    /// @brief Write a column major texture as an RGB PNG, the inverse of loadTexturePng()
+    bool writeTexturePng(const std::string& path, const uint16_t* texels) {
+        std::vector<uint8_t> rgb(TEXTURE_TEXELS * 3);
+
+        for (uint32_t x = 0; x < TEX_SIZE; x++) {
+            for (uint32_t y = 0; y < TEX_SIZE; y++) {
+                const TexelRgb c = texelToRgb(texels[x * TEX_SIZE + y]);
+                uint8_t* p = &rgb[(y * TEX_SIZE + x) * 3];
+                p[0] = c.r;
+                p[1] = c.g;
+                p[2] = c.b;
+            }
+        }
+
+        png_image image;
+        memset(&image, 0, sizeof(image));
+        image.version = PNG_IMAGE_VERSION;
+        image.width = TEX_SIZE;
+        image.height = TEX_SIZE;
+        image.format = PNG_FORMAT_RGB;
+
+        if (!png_image_write_to_file(&image, path.c_str(), 0, rgb.data(), 0, nullptr)) {
+            fprintf(stderr, "ERROR %s: %s\n", path.c_str(), image.message);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Visible wall faces per texture in a map
+     * @note x-sides sample texture tile-1, y-sides the shaded texture tile
+     */
+    std::vector<uint32_t> textureUsage(const SourceMap& map, size_t tex_count) {
+        std::vector<uint32_t> usage(tex_count, 0);
+
+        auto empty = [&](int x, int y) {
+            return x >= 0 && y >= 0 && x < map.width && y < map.height && map.tiles[y + map.height * x] == 0;
+        };
+
+        for (int x = 0; x < map.width; x++) {
+            for (int y = 0; y < map.height; y++) {
+                const uint8_t tile = map.tiles[y + map.height * x];
+                if (tile == 0 || tile >= tex_count) continue;
+
+                usage[tile - 1] += empty(x - 1, y) + empty(x + 1, y);
+                usage[tile] += empty(x, y - 1) + empty(x, y + 1);
+            }
+        }
+
+        return usage;
+    }
+
+    /// @brief Descriptor and table if the kernel reproduces every texel, empty otherwise
+    std::vector<uint16_t> tryProcedural(const std::vector<uint16_t>& texels, uint8_t kind, uint8_t shift, const std::vector<uint16_t>& table) {
+        // header words in memory order, kind and shift share the first
+        std::vector<uint16_t> out(sizeof(ProceduralTexture) / sizeof(uint16_t) + table.size());
+        const ProceduralTexture header{kind, shift, static_cast<uint16_t>(table.size())};
+        memcpy(out.data(), &header, sizeof(header));
+        std::copy(table.begin(), table.end(), out.begin() + sizeof(ProceduralTexture) / sizeof(uint16_t));
+
+        const ProceduralTexture* procedural = reinterpret_cast<const ProceduralTexture*>(out.data());
+        for (uint32_t x = 0; x < TEX_SIZE; x++) {
+            for (uint32_t y = 0; y < TEX_SIZE; y++) {
+                if (procedural->texel(x, y) != texels[x * TEX_SIZE + y]) return {};
+            }
+        }
+
+        return out;
+    }
+
+    /**
+     * @brief Find a ProceduralTexture kernel that reproduces a texture exactly, smallest table first
+     * @return Descriptor and table, empty if the texture has to be stored
+     */
+    std::vector<uint16_t> fitProcedural(const std::vector<uint16_t>& texels) {
+        auto at = [&](uint32_t x, uint32_t y) { return texels[x * TEX_SIZE + y]; };
+
+        // checkers of 2^shift texel cells, the two colours are those of the first two cells
+        for (uint8_t shift = 0; shift < TEX_LOG2_SIZE; shift++) {
+            std::vector<uint16_t> out = tryProcedural(texels, ProceduralTexture::CHECKERS, shift, {at(0, 0), at(1u << shift, 0)});
+            if (!out.empty()) return out;
+        }
+
+        // x ^ y patterns, coarsest first, texel (v, 0) has x ^ y = v
+        for (int8_t shift = TEX_LOG2_SIZE - 1; shift >= 0; shift--) {
+            std::vector<uint16_t> table(TEX_SIZE >> shift);
+            for (uint32_t i = 0; i < table.size(); i++) table[i] = at(i << shift, 0);
+
+            std::vector<uint16_t> out = tryProcedural(texels, ProceduralTexture::XOR, shift, table);
+            if (!out.empty()) return out;
+        }
+
+        // ramps, split the bits by the coordinate they follow. Constant bits go with x
+        uint16_t y_bits = 0;
+        for (uint32_t y = 1; y < TEX_SIZE; y++) y_bits |= at(0, y) ^ at(0, 0);
+
+        std::vector<uint16_t> table(2 * TEX_SIZE);
+        for (uint32_t i = 0; i < TEX_SIZE; i++) {
+            table[i] = at(i, 0) & ~y_bits;
+            table[TEX_SIZE + i] = at(0, i) & y_bits;
+        }
+
+        return tryProcedural(texels, ProceduralTexture::RAMPS, 0, table);
+    }
+
+    /**
+     * @brief Lay out the textures in order
+     * @param procedural Pack the textures a kernel reproduces as descriptors after the stored ones
+     * @param procedural_count Set to the number of textures packed as descriptors
+     * @param color_key Transparent texel value, -1 if every texture is opaque
+     * @param masked_count Set to the number of textures with transparent columns
+     */
+    std::vector<uint8_t> packTextures(const std::vector<std::vector<uint16_t>>& textures, const std::vector<uint32_t>& order,
+                                      uint32_t version, uint32_t align, bool procedural, uint32_t& procedural_count,
+                                      int32_t color_key, uint32_t& masked_count) {
+        const uint32_t count = static_cast<uint32_t>(textures.size());
+        const uint32_t texture_bytes = TEXTURE_TEXELS * sizeof(uint16_t);
+        const uint32_t data_offset = alignUp(sizeof(TextureFileHeader) + count * sizeof(uint32_t), align);
+        const uint32_t stride = alignUp(texture_bytes, align);
+
+        // every slot in layout order, stored textures keep whole strides, descriptors follow them
+        std::vector<std::vector<uint16_t>> stored;
+        std::vector<std::vector<uint16_t>> descriptors;
+        std::vector<uint32_t> entries(count);
+        std::vector<uint64_t> masks(count, 0);
+
+        for (uint32_t slot = 0; slot < count; slot++) {
+            const uint32_t id = order[slot];
+            std::vector<uint16_t> texels = textures[id];
+
+            // flagged here so the renderer keeps opaque columns on the single hit path
+            for (uint32_t x = 0; x < TEX_SIZE; x++) {
+                const auto column = texels.begin() + x * TEX_SIZE;
+                if (std::find(column, column + TEX_SIZE, color_key) != column + TEX_SIZE) masks[id] |= 1ULL << x;
+            }
+
+            std::vector<uint16_t> descriptor = procedural ? fitProcedural(texels) : std::vector<uint16_t>{};
+
+            if (descriptor.empty()) {
+                entries[id] = data_offset + static_cast<uint32_t>(stored.size()) * stride;
+                stored.push_back(std::move(texels));
+            } else {
+                entries[id] = TextureFileHeader::PROCEDURAL_OFFSET | static_cast<uint32_t>(descriptors.size());
+                descriptors.push_back(std::move(descriptor));
+            }
+        }
+
+        uint32_t cursor = data_offset + static_cast<uint32_t>(stored.size()) * stride;
+        std::vector<uint32_t> descriptor_offsets;
+        for (const std::vector<uint16_t>& descriptor : descriptors) {
+            descriptor_offsets.push_back(cursor);
+            cursor = alignUp(cursor + static_cast<uint32_t>(descriptor.size() * sizeof(uint16_t)), align);
+        }
+
+        masked_count = static_cast<uint32_t>(std::count_if(masks.begin(), masks.end(), [](uint64_t mask) { return mask != 0; }));
+
+        // no masks at all leaves mask_offset 0, the renderer then never looks past a wall
+        const uint32_t mask_offset = (masked_count > 0) ? alignUp(cursor, alignof(uint64_t)) : 0;
+        if (masked_count > 0) cursor = alignUp(mask_offset + count * static_cast<uint32_t>(sizeof(uint64_t)), align);
+
+        std::vector<uint8_t> out(cursor, 0);
+
+        put(out, 0, TextureFileHeader{TextureFileHeader::VALID_MAGIC, version, count, 0,
+                                      static_cast<uint16_t>((masked_count > 0) ? color_key : 0), 0, mask_offset});
+
+        if (masked_count > 0) memcpy(out.data() + mask_offset, masks.data(), masks.size() * sizeof(uint64_t));
+
+        for (size_t i = 0; i < stored.size(); i++) {
+            memcpy(out.data() + data_offset + i * stride, stored[i].data(), texture_bytes);
+        }
+        for (size_t i = 0; i < descriptors.size(); i++) {
+            memcpy(out.data() + descriptor_offsets[i], descriptors[i].data(), descriptors[i].size() * sizeof(uint16_t));
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t entry = entries[i];
+            if ((entry & TextureFileHeader::PROCEDURAL_OFFSET) != 0) {
+                entry = TextureFileHeader::PROCEDURAL_OFFSET | descriptor_offsets[entry & ~TextureFileHeader::PROCEDURAL_OFFSET];
+            }
+            put(out, sizeof(TextureFileHeader) + i * sizeof(uint32_t), entry);
+        }
+
+        procedural_count = static_cast<uint32_t>(descriptors.size());
+        return out;
+    }
+
+    bool parseAlign(const char* value, uint32_t& align) {
+        align = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        // powers of two only, and at least the uint32 alignment the headers need
+        if (align < 4 || (align & (align - 1)) != 0) {
+            fprintf(stderr, "ERROR --align must be a power of two >= 4\n");
+            return false;
+        }
+        return true;
+    }
+
+    // ---- commands ----
+
+    int packTexturesCommand(int argc, char** argv) {
+        if (argc < 5) return 2;
+
+        const char* manifest_path = argv[2];
+        const std::string png_dir = argv[3];
+        const char* out_path = argv[4];
+        const char* usage_path = nullptr;
+        uint32_t align = XIP_CACHE_LINE;
+        bool procedural = false;
+
+        if ((argc - 5) % 2 != 0) return 2;
+        for (int i = 5; i + 1 < argc; i += 2) {
+            if (strcmp(argv[i], "--usage") == 0) usage_path = argv[i + 1];
+            else if (strcmp(argv[i], "--align") == 0) { if (!parseAlign(argv[i + 1], align)) return 1; }
+            else if (strcmp(argv[i], "--procedural") == 0) procedural = strcmp(argv[i + 1], "0") != 0;
+            else return 2;
+        }
+
+        std::vector<ManifestEntry> entries;
+        uint32_t version;
+        int32_t color_key;
+        if (!loadManifest(manifest_path, entries, version, color_key)) return 1;
+
+        std::vector<std::vector<uint16_t>> textures(entries.size(), std::vector<uint16_t>(TEXTURE_TEXELS));
+        for (const ManifestEntry& entry : entries) {
+            if (!loadTexturePng(png_dir + "/" + entry.name + ".png", textures[entry.id].data(), color_key)) return 1;
+        }
+
+        std::vector<uint32_t> order(entries.size());
+        for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+
+        if (usage_path != nullptr) {
+            SourceMap map;
+            if (!loadMap(usage_path, map)) return 1;
+
+            const std::vector<uint32_t> usage = textureUsage(map, entries.size());
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return usage[a] > usage[b]; });
+
+            printf("layout by usage in %s:\n", usage_path);
+            for (uint32_t id : order) {
+                printf("  %3u faces  %s\n", usage[id], entries[id].name.c_str());
+            }
+        }
+
+        uint32_t procedural_count = 0;
+        uint32_t masked_count = 0;
+        const std::vector<uint8_t> blob = packTextures(textures, order, version, align, procedural, procedural_count, color_key, masked_count);
+
+        if (!validateTextureBlob(blob.data(), blob.size())) {
+            fprintf(stderr, "ERROR packed texture blob failed validation\n");
+            return 1;
+        }
+        if (!writeFile(out_path, blob)) {
+            fprintf(stderr, "ERROR could not write %s\n", out_path);
+            return 1;
+        }
+
+        printf("wrote %s: %zu textures, %u of %zu procedural, %u masked, %zu bytes, %u byte aligned\n", out_path, entries.size(),
+               procedural_count, entries.size(), masked_count, blob.size(), align);
+        return 0;
+    }
+
+    int packMapCommand(int argc, char** argv) {
+        if (argc < 4) return 2;
+
+        const char* in_path = argv[2];
+        const char* out_path = argv[3];
+        const char* textures_path = nullptr;
+        uint32_t align = XIP_CACHE_LINE;
+        bool pvs = true;
+
+        if ((argc - 4) % 2 != 0) return 2;
+        for (int i = 4; i + 1 < argc; i += 2) {
+            if (strcmp(argv[i], "--textures") == 0) textures_path = argv[i + 1];
+            else if (strcmp(argv[i], "--align") == 0) { if (!parseAlign(argv[i + 1], align)) return 1; }
+            else if (strcmp(argv[i], "--pvs") == 0) pvs = strcmp(argv[i + 1], "0") != 0;
+            else return 2;
+        }
+
+        SourceMap map;
+        if (!loadMap(in_path, map)) return 1;
+
+        uint32_t tex_count = 256;
+        if (textures_path != nullptr) {
+            MappedFile textures(textures_path);
+            if (!textures.valid() || !validateTextureBlob(textures.data(), textures.size())) {
+                fprintf(stderr, "ERROR invalid texture blob: %s\n", textures_path);
+                return 1;
+            }
+            tex_count = reinterpret_cast<const TextureFileHeader*>(textures.data())->tex_count;
+        }
+
+        if (!checkMap(map, tex_count)) return 1;
+
+        const std::vector<uint8_t> blob = packMap(map, align, pvs);
+
+        if (!validateMapBlob(blob.data(), blob.size(), tex_count)) {
+            fprintf(stderr, "ERROR packed map blob failed validation\n");
+            return 1;
+        }
+        if (!writeFile(out_path, blob)) {
+            fprintf(stderr, "ERROR could not write %s\n", out_path);
+            return 1;
+        }
+
+        printf("wrote %s: %dx%d tiles, %zu bytes\n", out_path, map.width, map.height, blob.size());
+        return 0;
+    }
+
+    int packArchiveCommand(int argc, char** argv) {
+        if (argc < 3) return 2;
+
+        struct ArchiveLevel {
+            std::string name;
+            const char* map_path;
+            uint32_t texture_set;
+        };
+
+        const char* out_path = argv[2];
+        std::vector<const char*> texture_set_paths;
+        std::vector<ArchiveLevel> levels;
+        uint32_t align = XIP_CACHE_LINE;
+        bool pvs = true;
+
+        for (int i = 3; i < argc; i++) {
+            if (strcmp(argv[i], "--texture-set") == 0 && i + 1 < argc) {
+                texture_set_paths.push_back(argv[++i]);
+            } else if (strcmp(argv[i], "--level") == 0 && i + 3 < argc) {
+                levels.push_back(ArchiveLevel{argv[i + 1], argv[i + 2], static_cast<uint32_t>(strtoul(argv[i + 3], nullptr, 10))});
+                i += 3;
+            } else if (strcmp(argv[i], "--align") == 0 && i + 1 < argc) {
+                if (!parseAlign(argv[++i], align)) return 1;
+            } else if (strcmp(argv[i], "--pvs") == 0 && i + 1 < argc) {
+                pvs = strcmp(argv[++i], "0") != 0;
+            } else {
+                return 2;
+            }
+        }
+
+        if (texture_set_paths.empty() || levels.empty()) return 2;
+
+        // ---- sources ----
+
+        std::vector<std::vector<uint8_t>> texture_sets;
+        for (const char* path : texture_set_paths) {
+            MappedFile file(path);
+            if (!file.valid() || !validateTextureBlob(file.data(), file.size())) {
+                fprintf(stderr, "ERROR invalid texture blob: %s\n", path);
+                return 1;
+            }
+            texture_sets.emplace_back(file.data(), file.data() + file.size());
+        }
+
+        std::vector<std::vector<uint8_t>> maps;
+        for (const ArchiveLevel& level : levels) {
+            if (level.name.empty() || level.name.size() >= LevelEntry::NAME_LENGTH) {
+                fprintf(stderr, "ERROR level name '%s' must be 1..%d characters\n", level.name.c_str(), LevelEntry::NAME_LENGTH - 1);
+                return 1;
+            }
+            if (level.texture_set >= texture_sets.size()) {
+                fprintf(stderr, "ERROR level %s uses texture set %u, only %zu given\n", level.name.c_str(), level.texture_set, texture_sets.size());
+                return 1;
+            }
+
+            SourceMap map;
+            if (!loadMap(level.map_path, map)) return 1;
+
+            const uint32_t tex_count = reinterpret_cast<const TextureFileHeader*>(texture_sets[level.texture_set].data())->tex_count;
+            if (!checkMap(map, tex_count)) return 1;
+
+            maps.push_back(packMap(map, align, pvs));
+        }
+
+        // ---- layout ----
+
+        const uint32_t levels_offset = sizeof(LevelArchiveHeader);
+        const uint32_t texture_sets_offset = levels_offset + levels.size() * sizeof(LevelEntry);
+        uint32_t cursor = alignUp(texture_sets_offset + texture_sets.size() * sizeof(TextureSetEntry), align);
+
+        std::vector<TextureSetEntry> set_entries;
+        for (const std::vector<uint8_t>& set : texture_sets) {
+            set_entries.push_back(TextureSetEntry{cursor, static_cast<uint32_t>(set.size())});
+            cursor = alignUp(cursor + set.size(), align);
+        }
+
+        std::vector<LevelEntry> level_entries;
+        for (size_t i = 0; i < levels.size(); i++) {
+            LevelEntry entry{};
+            strncpy(entry.name, levels[i].name.c_str(), LevelEntry::NAME_LENGTH - 1);
+            entry.map_offset = cursor;
+            entry.map_size = static_cast<uint32_t>(maps[i].size());
+            entry.texture_set = levels[i].texture_set;
+            level_entries.push_back(entry);
+            cursor = alignUp(cursor + maps[i].size(), align);
+        }
+
+        std::vector<uint8_t> out(cursor, 0);
+
+        LevelArchiveHeader header{};
+        header.magic = LevelArchiveHeader::VALID_MAGIC;
+        header.version = 100000;
+        header.level_count = static_cast<uint32_t>(levels.size());
+        header.texture_set_count = static_cast<uint32_t>(texture_sets.size());
+        header.levels_offset = levels_offset;
+        header.texture_sets_offset = texture_sets_offset;
+        put(out, 0, header);
+
+        for (size_t i = 0; i < level_entries.size(); i++) {
+            put(out, levels_offset + i * sizeof(LevelEntry), level_entries[i]);
+            memcpy(out.data() + level_entries[i].map_offset, maps[i].data(), maps[i].size());
+        }
+        for (size_t i = 0; i < set_entries.size(); i++) {
+            put(out, texture_sets_offset + i * sizeof(TextureSetEntry), set_entries[i]);
+            memcpy(out.data() + set_entries[i].offset, texture_sets[i].data(), texture_sets[i].size());
+        }
+
+        if (!validateLevelArchive(out.data(), out.size())) {
+            fprintf(stderr, "ERROR packed archive failed validation\n");
+            return 1;
+        }
+        if (!writeFile(out_path, out)) {
+            fprintf(stderr, "ERROR could not write %s\n", out_path);
+            return 1;
+        }
+
+        printf("wrote %s: %zu levels, %zu texture sets, %zu bytes\n", out_path, levels.size(), texture_sets.size(), out.size());
+        return 0;
+    }
+
+    int unpackTexturesCommand(int argc, char** argv) {
+        if (argc != 5) return 2;
+
+        MappedFile blob(argv[2]);
+        if (!blob.valid() || !validateTextureBlob(blob.data(), blob.size())) {
+            fprintf(stderr, "ERROR invalid texture blob: %s\n", argv[2]);
+            return 1;
+        }
+
+        std::vector<ManifestEntry> entries;
+        uint32_t version;
+        int32_t color_key;
+        if (!loadManifest(argv[3], entries, version, color_key)) return 1;
+
+        const TextureFileHeader* header = reinterpret_cast<const TextureFileHeader*>(blob.data());
+        if (header->tex_count != entries.size()) {
+            fprintf(stderr, "ERROR blob has %u textures, manifest %zu\n", header->tex_count, entries.size());
+            return 1;
+        }
+
+        const uint32_t* offsets = reinterpret_cast<const uint32_t*>(blob.data() + sizeof(TextureFileHeader));
+        std::vector<uint16_t> expanded(TEXTURE_TEXELS);
+        for (const ManifestEntry& entry : entries) {
+            const uint16_t* texels = expanded.data();
+
+            if ((offsets[entry.id] & TextureFileHeader::PROCEDURAL_OFFSET) != 0) {
+                const uint32_t offset = offsets[entry.id] & ~TextureFileHeader::PROCEDURAL_OFFSET;
+                const ProceduralTexture* procedural = reinterpret_cast<const ProceduralTexture*>(blob.data() + offset);
+                for (uint8_t x = 0; x < TEX_SIZE; x++) procedural->generateColumn(x, TEX_LOG2_SIZE, &expanded[x * TEX_SIZE]);
+            } else {
+                texels = reinterpret_cast<const uint16_t*>(blob.data() + offsets[entry.id]);
+            }
+
+            if (!writeTexturePng(std::string(argv[4]) + "/" + entry.name + ".png", texels)) return 1;
+        }
+
+        printf("wrote %zu textures to %s\n", entries.size(), argv[4]);
+        return 0;
+    }
+
+    int unpackMapCommand(int argc, char** argv) {
+        if (argc != 4) return 2;
+
+        SourceMap map;
+        if (!loadXipMap(argv[2], map)) return 1;
+
+        FILE* f = fopen(argv[3], "w");
+        if (f == nullptr) {
+            fprintf(stderr, "ERROR could not write %s\n", argv[3]);
+            return 1;
+        }
+
+        // 6 decimals are well below half a Q15.16 step, so the pose packs back to the same raw values
+        fprintf(f, "version %u\n", map.version);
+        fprintf(f, "player %.6f %.6f %.6f %.6f\n", map.player.pos_x.toRaw() / 65536.0, map.player.pos_y.toRaw() / 65536.0,
+                map.player.dir_x.toRaw() / 65536.0, map.player.dir_y.toRaw() / 65536.0);
+        for (const DoorData& door : map.doors) {
+            fprintf(f, "door %d %d %c\n", door.x, door.y, door.axis ? 'y' : 'x');
+        }
+        if (!map.lightmap.empty()) {
+            fprintf(f, "# the blob has a baked lightmap, its lights are not packed and have to be added back by hand\n");
+        }
+        for (size_t i = 0; i < map.heights.size(); i++) {
+            if (map.tiles[i] == 0 || map.heights[i] == WALL_HEIGHT_ONE) continue;
+            // sixteenths print exactly in 4 decimals
+            fprintf(f, "height %zu %zu %.4f\n", i / map.height, i % map.height, map.heights[i] / static_cast<double>(WALL_HEIGHT_ONE));
+        }
+        fprintf(f, "tiles\n");
+
+        for (uint8_t y = 0; y < map.height; y++) {
+            for (uint8_t x = 0; x < map.width; x++) {
+                const uint8_t tile = map.tiles[y + map.height * x];
+                if (tile == 0) fprintf(f, "%s%2s", x ? " " : "", ".");
+                else fprintf(f, "%s%2d", x ? " " : "", tile);
+            }
+            fprintf(f, "\n");
+        }
+
+        fclose(f);
+        printf("wrote %s\n", argv[3]);
+        return 0;
+    }
+
+    void printUsage() {
+        fprintf(stderr,
+            "usage: asset_packer textures MANIFEST.json PNG_DIR OUT.xip [--usage MAP] [--align N] [--procedural 0|1]\n"
+            "       asset_packer map MAP OUT.xip [--textures TEXTURES.xip] [--align N] [--pvs 0|1]\n"
+            "       asset_packer archive OUT.xip --texture-set TEXTURES.xip... --level NAME MAP SET... [--align N] [--pvs 0|1]\n"
+            "       asset_packer unpack-textures TEXTURES.xip MANIFEST.json PNG_DIR\n"
+            "       asset_packer unpack-map MAPDATA.xip OUT.txt\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    int result = 2;
+
+    if (argc >= 2) {
+        if (strcmp(argv[1], "textures") == 0) result = packTexturesCommand(argc, argv);
+        else if (strcmp(argv[1], "map") == 0) result = packMapCommand(argc, argv);
+        else if (strcmp(argv[1], "archive") == 0) result = packArchiveCommand(argc, argv);
+        else if (strcmp(argv[1], "unpack-textures") == 0) result = unpackTexturesCommand(argc, argv);
+        else if (strcmp(argv[1], "unpack-map") == 0) result = unpackMapCommand(argc, argv);
+    }
+
+    if (result == 2) {
+        printUsage();
+    }
+
+    return result;
+}
@@ -0,0 +1,295 @@
+/**
+ * @file batch_render.cpp
+ * @brief Headless batch renderer for level previews and golden frames.
+ *
+ * Renders every pose in a pose list with the firmware renderer, in parallel on
+ * a work stealing pool. The map and texture blobs are memory mapped read-only
+ * and shared by all workers; each worker only owns one frame and one row buffer.
+ *
+ * Usage:
+ *   batch_render --map mapdata.xip --textures textures.xip --poses poses.txt
+ *                (--atlas out.ppm [--atlas-columns N] | --out-dir DIR) [--threads N]
+ *                [--door-open FRACTION]
+ *
+ * Doors of the map are drawn closed, or opened by FRACTION (0 to 1).
+ *
+ * Pose list: one pose per line, either "pos_x pos_y angle_degrees" or
+ * "pos_x pos_y dir_x dir_y". Blank lines and lines starting with '#' are skipped.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numbers>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "asset_validation.hpp"
+#include "map_data.hpp"
+#include "mapped_file.hpp"
+#include "renderer.hpp"
+#include "textures.hpp"
+#include "tile_overlay.hpp"
+#include "work_stealing_pool.hpp"
+
+namespace {
+    constexpr size_t FRAME_PIXELS = SCREEN_WIDTH * SCREEN_HEIGHT;
+
+    struct Options {
+        const char* map_path = nullptr;
+        const char* textures_path = nullptr;
+        const char* poses_path = nullptr;
+        const char* atlas_path = nullptr;
+        const char* out_dir = nullptr;
+        size_t atlas_columns = 0;
+        size_t threads = 0;
+        double door_open = 0.0;
+    };
+
+    void printUsage() {
+        fprintf(stderr,
+            "usage: batch_render --map FILE --textures FILE --poses FILE\n"
+            "                    (--atlas FILE [--atlas-columns N] | --out-dir DIR) [--threads N]\n"
+            "                    [--door-open FRACTION]\n");
+    }
+
+    bool parseArgs(int argc, char** argv, Options& opts) {
+        for (int i = 1; i < argc; i++) {
+            const char* arg = argv[i];
+            const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+            if (value == nullptr) return false;
+
+            if (strcmp(arg, "--map") == 0) opts.map_path = value;
+            else if (strcmp(arg, "--textures") == 0) opts.textures_path = value;
+            else if (strcmp(arg, "--poses") == 0) opts.poses_path = value;
+            else if (strcmp(arg, "--atlas") == 0) opts.atlas_path = value;
+            else if (strcmp(arg, "--out-dir") == 0) opts.out_dir = value;
+            else if (strcmp(arg, "--atlas-columns") == 0) opts.atlas_columns = strtoul(value, nullptr, 10);
+            else if (strcmp(arg, "--threads") == 0) opts.threads = strtoul(value, nullptr, 10);
+            else if (strcmp(arg, "--door-open") == 0) opts.door_open = strtod(value, nullptr);
+            else return false;
+
+            i++;
+        }
+
+        return opts.map_path && opts.textures_path && opts.poses_path && ((opts.atlas_path != nullptr) != (opts.out_dir != nullptr));
+    }
+
+    bool loadPoses(const char* path, std::vector<PlayerData>& poses) {
+        FILE* f = fopen(path, "r");
+        if (f == nullptr) return false;
+
+        char line[256];
+        while (fgets(line, sizeof(line), f) != nullptr) {
+            if (line[0] == '#') continue;
+
+            double v[4];
+            int n = sscanf(line, "%lf %lf %lf %lf", &v[0], &v[1], &v[2], &v[3]);
+
+            if (n == 3) {
+                double rad = v[2] * std::numbers::pi / 180.0;
+                v[2] = std::cos(rad);
+                v[3] = std::sin(rad);
+            } else if (n != 4) {
+                continue;
+            }
+
+            poses.push_back(PlayerData{
+                Fixed15_16(static_cast<float>(v[0])), Fixed15_16(static_cast<float>(v[1])),
+                Fixed15_16(static_cast<float>(v[2])), Fixed15_16(static_cast<float>(v[3]))
+            });
+        }
+
+        fclose(f);
+        return true;
+    }
+
+    /// @brief Render a whole frame, column major like the column buffers
+    void renderFrame(const MapView& map, const PlayerData& pose, uint16_t* frame) {
+        const Camera camera = Camera::fromPlayer(pose);
+
+        memset(frame, 0, FRAME_PIXELS * sizeof(uint16_t));
+
+        for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+            renderColumn(map, camera, x, &frame[x * SCREEN_HEIGHT]);
+        }
+    }
+
+    /// @brief Convert screen row y of a column major frame (panel byte order RGB565) to RGB888
+    void frameRowToRgb(const uint16_t* frame, uint8_t y, uint8_t* rgb) {
+        for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+            const TexelRgb c = texelToRgb(frame[x * SCREEN_HEIGHT + y]);
+            rgb[x * 3 + 0] = c.r;
+            rgb[x * 3 + 1] = c.g;
+            rgb[x * 3 + 2] = c.b;
+        }
+    }
+
+    bool writeAll(int fd, const void* data, size_t len, off_t offset) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        while (len > 0) {
+            ssize_t written = pwrite(fd, p, len, offset);
+            if (written <= 0) return false;
+            p += written;
+            len -= written;
+            offset += written;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    if (!parseArgs(argc, argv, opts)) {
+        printUsage();
+        return 2;
+    }
+
+    MappedFile textures(opts.textures_path);
+    if (!textures.valid() || !validateTextureBlob(textures.data(), textures.size())) {
+        fprintf(stderr, "ERROR invalid texture blob: %s\n", opts.textures_path);
+        return 1;
+    }
+
+    const uint32_t tex_count = reinterpret_cast<const TextureFileHeader*>(textures.data())->tex_count;
+
+    MappedFile map_file(opts.map_path);
+    if (!map_file.valid() || !validateMapBlob(map_file.data(), map_file.size(), tex_count)) {
+        fprintf(stderr, "ERROR invalid map blob: %s\n", opts.map_path);
+        return 1;
+    }
+
+    std::vector<PlayerData> poses;
+    if (!loadPoses(opts.poses_path, poses) || poses.empty()) {
+        fprintf(stderr, "ERROR no poses loaded from %s\n", opts.poses_path);
+        return 1;
+    }
+
+    TextureManager::setBlob(textures.data(), textures.size());
+    MapView map = createMapView(map_file.data());
+
+    // read-only while rendering, so the workers share it
+    TileOverlay overlay;
+    map.overlay = &overlay;
+    overlay.loadDoors(map_file.data(), map);
+
+    if (opts.door_open > 0.0) {
+        uint32_t door_count;
+        const DoorData* doors = getDoors(door_count, map_file.data());
+        for (uint32_t i = 0; i < door_count; i++) {
+            overlay.toggleDoor(doors[i].x, doors[i].y);
+        }
+        overlay.update(static_cast<uint32_t>(std::fmin(opts.door_open, 1.0) * TileOverlay::DOOR_OPEN_US));
+    }
+
+    WorkStealingPool pool(opts.threads > 0 ? opts.threads : std::thread::hardware_concurrency());
+
+    // ---- output setup ----
+
+    int atlas_fd = -1;
+    size_t atlas_columns = 0;
+    size_t atlas_width = 0;
+    size_t atlas_header_len = 0;
+
+    if (opts.atlas_path != nullptr) {
+        atlas_columns = opts.atlas_columns;
+        if (atlas_columns == 0) {
+            atlas_columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(poses.size()))));
+        }
+        const size_t atlas_rows = (poses.size() + atlas_columns - 1) / atlas_columns;
+        atlas_width = atlas_columns * SCREEN_WIDTH;
+        const size_t atlas_height = atlas_rows * SCREEN_HEIGHT;
+
+        atlas_fd = open(opts.atlas_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (atlas_fd < 0) {
+            fprintf(stderr, "ERROR could not open %s\n", opts.atlas_path);
+            return 1;
+        }
+
+        char header[64];
+        atlas_header_len = static_cast<size_t>(snprintf(header, sizeof(header), "P6\n%zu %zu\n255\n", atlas_width, atlas_height));
+
+        // tiles are written in place, unused tiles stay black
+        if (!writeAll(atlas_fd, header, atlas_header_len, 0) || ftruncate(atlas_fd, atlas_header_len + atlas_width * atlas_height * 3) != 0) {
+            fprintf(stderr, "ERROR could not size %s\n", opts.atlas_path);
+            return 1;
+        }
+    }
+
+    // ---- render ----
+
+    // bounded per worker scratch: one frame and one RGB row
+    std::vector<std::vector<uint16_t>> frames(pool.workerCount(), std::vector<uint16_t>(FRAME_PIXELS));
+    std::vector<std::vector<uint8_t>> rows(pool.workerCount(), std::vector<uint8_t>(SCREEN_WIDTH * 3));
+    std::atomic<size_t> failures{0};
+
+    auto start = std::chrono::steady_clock::now();
+
+    WorkStealingPool::Stats stats = pool.run(poses.size(), [&](size_t worker, size_t job) {
+        uint16_t* frame = frames[worker].data();
+        uint8_t* row = rows[worker].data();
+
+        renderFrame(map, poses[job], frame);
+
+        if (atlas_fd >= 0) {
+            const size_t tile_x = (job % atlas_columns) * SCREEN_WIDTH;
+            const size_t tile_y = (job / atlas_columns) * SCREEN_HEIGHT;
+
+            for (uint8_t y = 0; y < SCREEN_HEIGHT; y++) {
+                frameRowToRgb(frame, y, row);
+                off_t offset = atlas_header_len + ((tile_y + y) * atlas_width + tile_x) * 3;
+                if (!writeAll(atlas_fd, row, SCREEN_WIDTH * 3, offset)) failures++;
+            }
+        } else {
+            std::string path = std::string(opts.out_dir) + "/frame_";
+            char index[16];
+            snprintf(index, sizeof(index), "%05zu.ppm", job);
+            path += index;
+
+            FILE* f = fopen(path.c_str(), "wb");
+            if (f == nullptr) {
+                failures++;
+                return;
+            }
+
+            fprintf(f, "P6\n%d %d\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+            for (uint8_t y = 0; y < SCREEN_HEIGHT; y++) {
+                frameRowToRgb(frame, y, row);
+                fwrite(row, 1, SCREEN_WIDTH * 3, f);
+            }
+            fclose(f);
+        }
+    });
+
+    auto end = std::chrono::steady_clock::now();
+
+    if (atlas_fd >= 0) {
+        close(atlas_fd);
+    }
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+
+    printf("frames:   %zu\n", poses.size());
+    printf("threads:  %zu\n", pool.workerCount());
+    printf("time:     %.3f s\n", seconds);
+    printf("rate:     %.1f frames/s\n", poses.size() / seconds);
+
+    for (size_t w = 0; w < pool.workerCount(); w++) {
+        printf("worker %2zu: %zu frames (%zu stolen)\n", w, stats.jobs_run[w], stats.jobs_stolen[w]);
+    }
+
+    if (failures > 0) {
+        fprintf(stderr, "ERROR %zu writes failed\n", failures.load());
+        return 1;
+    }
+
+    return 0;
+}
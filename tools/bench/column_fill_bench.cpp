@@ -0,0 +1,168 @@
+/**
+ * @file column_fill_bench.cpp
+ * @brief Host microbenchmark for the column fill kernels.
+ *
+ * Checks fillTexturedColumn against the original per-pixel loop for every
+ * line height and for random texture offsets, steps and shades, then times
+ * both, and the kernels of a lit face, across a range of line heights.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <utility>
+
+#include "column_fill.hpp"
+
+namespace {
+    constexpr int16_t SCREEN_HEIGHT = 128;
+    constexpr int ITERATIONS = 200;
+    constexpr int REPEATS = 300;
+    constexpr int RANDOM_COLUMNS = 200000;
+
+    struct ColumnSetup {
+        int16_t draw_start;
+        int16_t draw_end;
+        Fixed15_16 tex_pos;
+        Fixed15_16 step;
+    };
+
+    /// @brief Same setup the render loop does for a given line height
+    ColumnSetup setupColumn(int16_t line_height) {
+        ColumnSetup s;
+
+        s.draw_start = (-line_height >> 1) + (SCREEN_HEIGHT >> 1);
+        if (s.draw_start < 0) s.draw_start = 0;
+
+        s.draw_end = (line_height >> 1) + (SCREEN_HEIGHT >> 1);
+        if (s.draw_end >= SCREEN_HEIGHT) s.draw_end = SCREEN_HEIGHT - 1;
+
+        s.step = TEX_SIZE_FP / Fixed15_16(line_height);
+
+        int16_t wall_top_coord = (SCREEN_HEIGHT - line_height) >> 1;
+        s.tex_pos = (s.draw_start - wall_top_coord) * s.step;
+
+        return s;
+    }
+
+    /// @brief The original per-pixel loop from main()
+    void referenceFill(uint16_t* ray_column, const uint16_t* tex_column,
+                       int16_t draw_start, int16_t draw_end, Fixed15_16 tex_pos, Fixed15_16 step) {
+        for (int16_t y = draw_start; y < draw_end; y++) {
+            int16_t tex_y_coord = tex_pos.toInt() & TEX_MASK;
+
+            tex_pos += step;
+
+            ray_column[y] = tex_column[tex_y_coord];
+        }
+    }
+
+    /// @note The fastest of REPEATS short runs, the host is shared and longer runs pick up its noise
+    template <typename Fn>
+    double timeNsPerColumn(Fn&& fn) {
+        double best = 0;
+
+        for (int r = 0; r < REPEATS; r++) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < ITERATIONS; i++) {
+                fn(i);
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            const double ns = std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+            if (r == 0 || ns < best) best = ns;
+        }
+
+        return best;
+    }
+}
+
+int main() {
+    std::mt19937 rng(1234);
+
+    uint16_t tex[TEX_SIZE];
+    for (auto& t : tex) t = static_cast<uint16_t>(rng());
+
+    // ---- verification ----
+
+    uint32_t mismatches = 0;
+
+    for (int16_t line_height = 1; line_height < 4096; line_height++) {
+        ColumnSetup s = setupColumn(line_height);
+
+        uint16_t expected[SCREEN_HEIGHT] = {0};
+        uint16_t actual[SCREEN_HEIGHT] = {0};
+
+        referenceFill(expected, tex, s.draw_start, s.draw_end, s.tex_pos, s.step);
+        fillTexturedColumn(actual, tex, s.draw_start, s.draw_end, s.tex_pos, s.step);
+
+        if (memcmp(expected, actual, sizeof(expected)) != 0) {
+            printf("MISMATCH line_height=%d\n", line_height);
+            mismatches++;
+        }
+    }
+
+    // the run kernel places texel boundaries by accumulation, so check offsets the render setup never makes
+    std::uniform_int_distribution<int32_t> pick_pos(-(1 << 22), 1 << 22);
+    std::uniform_int_distribution<int32_t> pick_step(128, 2 * Fixed15_16::ONE);
+    std::uniform_int_distribution<int> pick_row(0, SCREEN_HEIGHT);
+    std::uniform_int_distribution<int> pick_shade(0, SHADE_COUNT - 1);
+
+    for (int i = 0; i < RANDOM_COLUMNS; i++) {
+        const Fixed15_16 tex_pos = Fixed15_16::fromRaw(pick_pos(rng));
+        const Fixed15_16 step = Fixed15_16::fromRaw(pick_step(rng));
+        int16_t draw_start = static_cast<int16_t>(pick_row(rng));
+        int16_t draw_end = static_cast<int16_t>(pick_row(rng));
+        if (draw_start > draw_end) std::swap(draw_start, draw_end);
+        const uint8_t shade = static_cast<uint8_t>(pick_shade(rng));
+
+        // the reference samples a darkened copy, the kernels darken each texel they read
+        uint16_t shaded[TEX_SIZE];
+        for (int t = 0; t < TEX_SIZE; t++) shaded[t] = shadeTexel(tex[t], shade);
+
+        uint16_t expected[SCREEN_HEIGHT] = {0};
+        uint16_t actual[SCREEN_HEIGHT] = {0};
+
+        referenceFill(expected, shaded, draw_start, draw_end, tex_pos, step);
+        fillTexturedColumn(actual, tex, draw_start, draw_end, tex_pos, step, shade);
+
+        if (memcmp(expected, actual, sizeof(expected)) != 0) {
+            printf("MISMATCH tex_pos=%d step=%d shade=%d rows %d..%d\n", tex_pos.toRaw(), step.toRaw(), shade, draw_start, draw_end);
+            mismatches++;
+        }
+    }
+
+    printf("verify: %u mismatches\n", mismatches);
+
+    // ---- timing ----
+
+    printf("%12s %14s %14s %8s %14s\n", "line_height", "reference_ns", "kernel_ns", "speedup", "lit_kernel_ns");
+
+    constexpr int16_t LINE_HEIGHTS[] = {16, 32, 64, 80, 96, 128, 160, 192, 256, 384, 512, 1024, 2048};
+
+    for (int16_t line_height : LINE_HEIGHTS) {
+        ColumnSetup s = setupColumn(line_height);
+        uint16_t column[SCREEN_HEIGHT] = {0};
+
+        double ref_ns = timeNsPerColumn([&](int) {
+            referenceFill(column, tex, s.draw_start, s.draw_end, s.tex_pos, s.step);
+            asm volatile("" : : "r"(column) : "memory");
+        });
+
+        double kernel_ns = timeNsPerColumn([&](int) {
+            fillTexturedColumn(column, tex, s.draw_start, s.draw_end, s.tex_pos, s.step);
+            asm volatile("" : : "r"(column) : "memory");
+        });
+
+        // a mid shade, every lit shade takes the same kernels
+        double lit_ns = timeNsPerColumn([&](int) {
+            fillTexturedColumn(column, tex, s.draw_start, s.draw_end, s.tex_pos, s.step, SHADE_COUNT / 2);
+            asm volatile("" : : "r"(column) : "memory");
+        });
+
+        printf("%12d %14.1f %14.1f %7.2fx %14.1f\n", line_height, ref_ns, kernel_ns, ref_ns / kernel_ns, lit_ns);
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+/**
+ * @file entity_bench.cpp
+ * @brief Host benchmark for the entity store and its per-tile spatial hash.
+ *
+ * Spawns thousands of moving entities on a synthetic map and times one
+ * simulation step (integrate and rehash), the collision pass, radius queries
+ * and camera visibility. For the smaller populations the collision pass is
+ * checked against a brute force O(n^2) scan that must find the same pairs,
+ * and rebinding a map bigger than the hash must empty the store.
+ *
+ * Usage: entity_bench [steps]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "entities.hpp"
+#include "renderer.hpp"
+
+namespace {
+    constexpr uint8_t MAP_SIZE = 64;
+    constexpr uint16_t MAX_ENTITIES = 16000;
+
+    using Store = EntityStore<MAX_ENTITIES, MAP_SIZE * MAP_SIZE>;
+
+    /// @brief Closed map with random pillars, column major like the map blob
+    std::vector<uint8_t> makeMap(std::mt19937& rng) {
+        std::vector<uint8_t> tiles(MAP_SIZE * MAP_SIZE, 0);
+        std::uniform_int_distribution<int> chance(0, 99);
+
+        for (uint8_t x = 0; x < MAP_SIZE; x++) {
+            for (uint8_t y = 0; y < MAP_SIZE; y++) {
+                bool border = x == 0 || y == 0 || x == MAP_SIZE - 1 || y == MAP_SIZE - 1;
+                if (border || chance(rng) < 15) {
+                    tiles[y + MAP_SIZE * x] = 1 + (x + y) % 8;
+                }
+            }
+        }
+
+        return tiles;
+    }
+
+    void populate(Store& store, uint16_t count, std::mt19937& rng) {
+        std::uniform_real_distribution<float> pos(1.0f, MAP_SIZE - 1.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::uniform_real_distribution<float> speed(0.5f, 3.0f);
+
+        store.clear();
+        while (store.size() < count) {
+            const Store::Index i = store.spawn(Fixed15_16(pos(rng)), Fixed15_16(pos(rng)), store.size() & 0xFF, 0.2_fp);
+            if (i == Store::NONE) continue;
+
+            const float a = angle(rng);
+            const float s = speed(rng);
+            store.setVelocity(i, Fixed15_16(std::cos(a) * s), Fixed15_16(std::sin(a) * s));
+        }
+    }
+
+    size_t bruteForcePairs(const Store& store) {
+        size_t pairs = 0;
+
+        for (uint16_t a = 0; a < store.size(); a++) {
+            for (uint16_t b = a + 1; b < store.size(); b++) {
+                const int64_t dx = (store.posX()[b] - store.posX()[a]).toRaw();
+                const int64_t dy = (store.posY()[b] - store.posY()[a]).toRaw();
+                const int64_t reach = store.radius()[a].toRaw() + store.radius()[b].toRaw();
+                pairs += dx * dx + dy * dy < reach * reach;
+            }
+        }
+
+        return pairs;
+    }
+
+    size_t hashPairs(const Store& store) {
+        size_t pairs = 0;
+        store.forEachCollision([&](Store::Index, Store::Index) { pairs++; });
+        return pairs;
+    }
+
+    double microsecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv) {
+    const int steps = (argc > 1) ? atoi(argv[1]) : 100;
+
+    std::mt19937 rng(42);
+    std::vector<uint8_t> tiles = makeMap(rng);
+    MapView map(MAP_SIZE, MAP_SIZE, tiles.data());
+
+    static Store store(map);
+    static Store::Index visible[MAX_ENTITIES];
+
+    const PlayerData player{Fixed15_16(32), Fixed15_16(32), Fixed15_16(-1), Fixed15_16(0)};
+    const Camera camera = Camera::fromPlayer(player);
+
+    printf("%-8s %10s %9s %12s %12s %12s %12s %10s\n", "entities", "step_us", "retile%", "collide_us", "brute_us", "pairs", "query_us", "visible_us");
+
+    size_t found = 0;
+
+    for (uint16_t count : {1000, 4000, 16000}) {
+        populate(store, count, rng);
+
+        double step_us = 0.0;
+        double collide_us = 0.0;
+        double query_us = 0.0;
+        double visible_us = 0.0;
+        size_t pairs = 0;
+        store.resetRetiles();
+
+        for (int s = 0; s < steps; s++) {
+            auto start = std::chrono::steady_clock::now();
+            store.integrate(1.0_fp / 30);
+            step_us += microsecondsSince(start);
+
+            pairs = 0;
+            start = std::chrono::steady_clock::now();
+            store.forEachCollision([&](Store::Index, Store::Index) { pairs++; });
+            collide_us += microsecondsSince(start);
+
+            // what an AI tick would ask: who is within 3 tiles of each of 64 actors
+            start = std::chrono::steady_clock::now();
+            for (uint16_t i = 0; i < 64; i++) {
+                store.forEachNear(store.posX()[i], store.posY()[i], Fixed15_16(3), [&](Store::Index) { found++; });
+            }
+            query_us += microsecondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            found += store.collectVisible(camera, visible, MAX_ENTITIES);
+            visible_us += microsecondsSince(start);
+        }
+
+        // the hash must not miss or double count any pair
+        double brute_us = 0.0;
+        if (count <= 4000) {
+            const auto start = std::chrono::steady_clock::now();
+            const size_t expected = bruteForcePairs(store);
+            brute_us = microsecondsSince(start);
+
+            if (expected != pairs) {
+                fprintf(stderr, "FAIL %u entities: hash found %zu pairs, brute force %zu\n", count, pairs, expected);
+                return 1;
+            }
+
+            // swap removes and a rebuild must leave the tile lists consistent
+            for (uint16_t i = 0; i < store.size(); i += 3) store.remove(i);
+            store.mapChanged();
+
+            if (hashPairs(store) != bruteForcePairs(store)) {
+                fprintf(stderr, "FAIL %u entities: pairs differ after remove and rebuild\n", count);
+                return 1;
+            }
+        }
+
+        // a map bigger than the hash empties the store instead of linking past its tile lists
+        if (count == 1000) {
+            map.height = MAP_SIZE + 1;
+            store.mapChanged();
+            map.height = MAP_SIZE;
+
+            if (store.size() != 0) {
+                fprintf(stderr, "FAIL %u entities kept on a map bigger than the hash\n", store.size());
+                return 1;
+            }
+        }
+
+        printf("%-8u %10.2f %8.2f%% %12.2f %12.2f %12zu %12.2f %10.2f\n", count,
+               step_us / steps, 100.0 * store.retiles() / (static_cast<double>(count) * steps),
+               collide_us / steps, brute_us, pairs, query_us / steps, visible_us / steps);
+    }
+
+    return found == 0; // keep the queries from being optimised out
+}
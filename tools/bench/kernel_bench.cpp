@@ -0,0 +1,65 @@
+/**
+ * @file kernel_bench.cpp
+ * @brief Host runner of the per kernel microbenchmarks in bench/, built as the "bench" target.
+ *
+ * The ST7735 driver is compiled against the mock pico-sdk in mock_pico/, so
+ * its command and pixel paths run against MockTransport instead of SPI. Before
+ * timing, checks that one column transfer sends what the panel expects.
+ * Prints the KERNEL lines of kernel_suite.hpp, compare two runs with
+ *   hot_path_report kernels BEFORE.log AFTER.log
+ *
+ * Usage: bench [name prefix]
+ */
+
+#include <chrono>
+#include <cstdio>
+
+#include "kernel_suite.hpp"
+#include "mock_transport.hpp"
+#include "render_config.hpp"
+#include "st7735.hpp"
+
+namespace {
+    // the firmware's wiring, see pico-raycaster.cpp
+    constexpr uint8_t CS_PIN = 17, DC_PIN = 21;
+
+    uint64_t nowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /// @brief A column is one transaction: CASET, RASET and RAMWR with their 8 parameter bytes, then the pixels
+    bool checkColumnTransfer(ST7735& tft) {
+        uint16_t column[DefaultRenderConfig::HEIGHT] = {};
+
+        MockTransport::reset();
+        tft.drawRayColumnn(0, column, DefaultRenderConfig::HEIGHT);
+
+        return MockTransport::transactions() == 1 && MockTransport::commandBytes() == 3 &&
+               MockTransport::dataBytes() == 8 + 2 * DefaultRenderConfig::HEIGHT;
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* filter = (argc > 1) ? argv[1] : nullptr;
+
+    MockTransport::attach(DC_PIN, CS_PIN);
+    ST7735 tft(1, spi0, 18, 19, CS_PIN, DC_PIN, 20, 255);
+    tft.initialize(ST7735::TFT_Type::GREEN_TAB);
+
+    if (!checkColumnTransfer(tft)) {
+        printf("FAIL mock transport: column transfer sent %u commands, %u data bytes\n",
+               MockTransport::commandBytes(), MockTransport::dataBytes());
+        return 1;
+    }
+
+    const BenchPlatform platform{"host", nowNs, nullptr, &tft};
+    const uint16_t count = runKernelSuite(platform, filter);
+
+    if (count == 0) {
+        printf("ERROR no kernel matches %s\n", filter);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,26 @@
+/**
+ * @file spi.h
+ * @brief Host stand-in for the hardware/spi.h calls the ST7735 driver makes, see mock_transport.hpp.
+ */
+
+#ifndef MOCK_HARDWARE_SPI_H
+#define MOCK_HARDWARE_SPI_H
+
+#include "pico/stdlib.h"
+
+struct spi_inst {};
+typedef struct spi_inst spi_inst_t;
+
+inline spi_inst_t mock_spi0;
+#define spi0 (&mock_spi0)
+
+inline unsigned spi_init(spi_inst_t*, unsigned baudrate) {
+    return baudrate;
+}
+
+inline int spi_write_blocking(spi_inst_t*, const uint8_t* src, size_t len) {
+    MockTransport::write(src, len);
+    return static_cast<int>(len);
+}
+
+#endif // MOCK_HARDWARE_SPI_H
@@ -0,0 +1,69 @@
+/**
+ * @file mock_transport.hpp
+ * @brief Host transport behind the mock pico-sdk calls the ST7735 driver makes.
+ *
+ * The driver is compiled unchanged against the headers next to this one.
+ * Its SPI writes and pin changes end up here: bytes are counted as command or
+ * data by the state of the DC pin, and folded into a checksum so the writes
+ * cannot be optimised away and two runs can be compared.
+ */
+
+#ifndef MOCK_TRANSPORT_H
+#define MOCK_TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class MockTransport
+ * @brief Records what the driver sends, one instance for the whole program like the SPI block it stands in for.
+ */
+class MockTransport {
+    public:
+        /// @brief Tell the transport which pins are DC and CS, set before the driver is initialised
+        static void attach(uint8_t dc_pin, uint8_t cs_pin) {
+            dc_pin_ = dc_pin;
+            cs_pin_ = cs_pin;
+            reset();
+        }
+
+        static void reset() {
+            command_bytes_ = data_bytes_ = transactions_ = 0;
+            checksum_ = 0;
+        }
+
+        static void pinWrite(unsigned pin, bool value) {
+            if (pin == dc_pin_) {
+                data_mode_ = value;
+            } else if (pin == cs_pin_ && !value) {
+                transactions_++;
+            }
+        }
+
+        static void write(const uint8_t* src, size_t len) {
+            uint32_t sum = checksum_;
+            for (size_t i = 0; i < len; i++) sum = (sum << 5) + sum + src[i];
+            checksum_ = sum;
+
+            (data_mode_ ? data_bytes_ : command_bytes_) += len;
+        }
+
+        [[nodiscard]] static uint32_t commandBytes() { return command_bytes_; }
+        [[nodiscard]] static uint32_t dataBytes() { return data_bytes_; }
+
+        /// @brief Times CS went low
+        [[nodiscard]] static uint32_t transactions() { return transactions_; }
+        [[nodiscard]] static uint32_t checksum() { return checksum_; }
+
+    private:
+        inline static uint8_t dc_pin_ = 0xFF;
+        inline static uint8_t cs_pin_ = 0xFF;
+        inline static bool data_mode_ = true;
+
+        inline static uint32_t command_bytes_ = 0;
+        inline static uint32_t data_bytes_ = 0;
+        inline static uint32_t transactions_ = 0;
+        inline static uint32_t checksum_ = 0;
+};
+
+#endif // MOCK_TRANSPORT_H
@@ -0,0 +1,29 @@
+/**
+ * @file stdlib.h
+ * @brief Host stand-in for the pico/stdlib.h calls the ST7735 driver makes, see mock_transport.hpp.
+ * @note Only what lib/st7735 uses, pins go to the MockTransport and delays return at once
+ */
+
+#ifndef MOCK_PICO_STDLIB_H
+#define MOCK_PICO_STDLIB_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mock_transport.hpp"
+
+#define GPIO_OUT 1
+
+enum gpio_function { GPIO_FUNC_SPI = 1 };
+
+inline void gpio_init(unsigned) {}
+inline void gpio_set_dir(unsigned, bool) {}
+inline void gpio_set_function(unsigned, gpio_function) {}
+
+inline void gpio_put(unsigned pin, bool value) {
+    MockTransport::pinWrite(pin, value);
+}
+
+inline void sleep_ms(uint32_t) {}
+
+#endif // MOCK_PICO_STDLIB_H
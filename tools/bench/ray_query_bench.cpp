@@ -0,0 +1,150 @@
+/**
+ * @file ray_query_bench.cpp
+ * @brief Host benchmark for the batched ray query API.
+ *
+ * Traces batches of random rays through a synthetic map and reports rays per
+ * second for render style queries, line of sight queries and short range
+ * (max distance) queries. The render query is repeated with a tile overlay
+ * attached: empty, modified only in one corner of the map, and with doors
+ * spread over the whole map, to show what the overlay costs the DDA.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "raycast.hpp"
+#include "tile_overlay.hpp"
+
+namespace {
+    constexpr uint8_t MAP_SIZE = 64;
+    constexpr size_t BATCH_SIZE = 4096;
+    constexpr int BATCHES = 200;
+
+    /// @brief Closed map with random pillars, column major like the map blob
+    std::vector<uint8_t> makeMap(std::mt19937& rng) {
+        std::vector<uint8_t> tiles(MAP_SIZE * MAP_SIZE, 0);
+        std::uniform_int_distribution<int> chance(0, 99);
+
+        for (uint8_t x = 0; x < MAP_SIZE; x++) {
+            for (uint8_t y = 0; y < MAP_SIZE; y++) {
+                bool border = x == 0 || y == 0 || x == MAP_SIZE - 1 || y == MAP_SIZE - 1;
+                if (border || chance(rng) < 15) {
+                    tiles[y + MAP_SIZE * x] = 1 + (x + y) % 8;
+                }
+            }
+        }
+
+        return tiles;
+    }
+
+    std::vector<Ray> makeRays(const MapView& map, std::mt19937& rng) {
+        std::uniform_real_distribution<float> pos(1.0f, MAP_SIZE - 1.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+        std::vector<Ray> rays;
+        rays.reserve(BATCH_SIZE);
+
+        while (rays.size() < BATCH_SIZE) {
+            float x = pos(rng);
+            float y = pos(rng);
+            if (map.getTile(static_cast<uint8_t>(x), static_cast<uint8_t>(y)) != 0) continue;
+
+            float a = angle(rng);
+            rays.push_back(Ray{Fixed15_16(x), Fixed15_16(y), Fixed15_16(std::cos(a)), Fixed15_16(std::sin(a))});
+        }
+
+        return rays;
+    }
+
+    /// @note Reports the fastest batch, the host is shared and the mean drifts between runs
+    void run(const char* name, const MapView& map, const std::vector<Ray>& rays, const RayQueryOptions& options) {
+        std::vector<RayHit> hits(rays.size());
+        size_t traced = 0;
+        size_t hit_count = 0;
+        double best_seconds = 0;
+
+        for (int b = 0; b < BATCHES; b++) {
+            auto start = std::chrono::steady_clock::now();
+            const size_t batch = castRays(map, rays.data(), hits.data(), rays.size(), options);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            traced += batch;
+            if (b == 0 || seconds < best_seconds) best_seconds = seconds;
+        }
+
+        for (const RayHit& hit : hits) {
+            hit_count += hit.tile != 0;
+        }
+
+        printf("%-16s %12.0f rays/s  (%zu rays, %5.1f%% hit)\n", name, traced / BATCHES / best_seconds, traced, 100.0 * hit_count / hits.size());
+    }
+}
+
+int main() {
+    std::mt19937 rng(42);
+
+    std::vector<uint8_t> tiles = makeMap(rng);
+    MapView map(MAP_SIZE, MAP_SIZE, tiles.data());
+
+    std::vector<Ray> rays = makeRays(map, rng);
+
+    RayQueryOptions render;
+    run("render", map, rays, render);
+
+    RayQueryOptions no_tex;
+    no_tex.compute_tex = false;
+    run("hit_only", map, rays, no_tex);
+
+    RayQueryOptions short_range;
+    short_range.compute_tex = false;
+    short_range.max_distance = Fixed15_16(4);
+    run("max_distance_4", map, rays, short_range);
+
+    // the same render query through a tile overlay
+    TileOverlay overlay;
+    MapView overlay_map = map;
+    overlay_map.overlay = &overlay;
+
+    run("overlay_empty", overlay_map, rays, render);
+
+    // a few destroyed walls in one corner, the rest of the map stays on the bitmap fast path
+    for (uint8_t i = 1; i < 4; i++) {
+        overlay.setTile(i, 0, 0);
+    }
+    run("overlay_corner", overlay_map, rays, render);
+
+    // half open doors in place of random walls all over the map
+    overlay.reset();
+    std::uniform_int_distribution<int> cell(1, MAP_SIZE - 2);
+    while (overlay.count() < TileOverlay::MAX_DOORS) {
+        const uint8_t x = cell(rng);
+        const uint8_t y = cell(rng);
+        if (map.getTile(x, y) != 0 && overlay.find(x, y) == nullptr) {
+            overlay.addDoor(x, y, overlay.count() & 1, 1);
+            overlay.toggleDoor(x, y);
+        }
+    }
+    overlay.update(TileOverlay::DOOR_OPEN_US / 2);
+    run("overlay_doors", overlay_map, rays, render);
+
+    // line of sight between random pairs of open points
+    std::vector<Ray> segments = makeRays(map, rng);
+    size_t visible = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int b = 0; b < BATCHES; b++) {
+        for (size_t i = 0; i + 1 < segments.size(); i += 2) {
+            visible += hasLineOfSight(map, segments[i].origin_x, segments[i].origin_y, segments[i + 1].origin_x, segments[i + 1].origin_y);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    size_t queries = BATCHES * (segments.size() / 2);
+    printf("%-16s %12.0f rays/s  (%zu rays, %5.1f%% visible)\n", "line_of_sight", queries / seconds, queries, 100.0 * visible / queries);
+
+    return 0;
+}
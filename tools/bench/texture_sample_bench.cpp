@@ -0,0 +1,186 @@
+/**
+ * @file texture_sample_bench.cpp
+ * @brief Host benchmark for procedural textures against stored texels.
+ *
+ * Expands every procedural texture of a blob into a stored-only copy,
+ * then compares the two: each texture column fetched through
+ * TextureManager::getTextureColumn must match texel for texel, full frames of
+ * the embedded map must render the same pixels, and both are timed. Also
+ * prints how many bytes of the blob each variant needs.
+ * Exits non-zero if the procedural textures differ from their expansion.
+ *
+ * Usage: texture_sample_bench [frames] [TEXTURES.xip]
+ * The blob textures are stored, pass a set packed with
+ * "asset_packer textures ... --procedural 1" (memory mapped) to compare.
+ * Only does anything in tools configured with -DRAYCASTER_PROCEDURAL_TEXTURES=ON,
+ * otherwise the renderer refuses such sets and the bench skips.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "map_data.hpp"
+#include "mapped_file.hpp"
+#include "renderer.hpp"
+#include "textures.hpp"
+
+namespace {
+    constexpr int COLUMN_ITERATIONS = 200;
+
+    /// @brief Copy of the bound blob with every procedural texture expanded into stored texels
+    std::vector<uint8_t> expandTextures() {
+        const TextureFileHeader header = *TextureManager::getHeader();
+        const uint32_t count = header.tex_count;
+
+        const uint32_t data_offset = static_cast<uint32_t>(sizeof(TextureFileHeader) + count * sizeof(uint32_t));
+        std::vector<uint8_t> blob(data_offset + count * TEX_SIZE * TEX_SIZE * sizeof(uint16_t));
+        memcpy(blob.data(), &header, sizeof(header));
+
+        uint16_t scratch[TEX_SIZE];
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t offset = data_offset + i * TEX_SIZE * TEX_SIZE * sizeof(uint16_t);
+            memcpy(blob.data() + sizeof(TextureFileHeader) + i * sizeof(uint32_t), &offset, sizeof(offset));
+
+            uint16_t* dst = reinterpret_cast<uint16_t*>(blob.data() + offset);
+            for (uint8_t x = 0; x < TEX_SIZE; x++) {
+                memcpy(&dst[x * TEX_SIZE], TextureManager::getTextureColumn(i, x, TEX_LOG2_SIZE, scratch), TEX_SIZE * sizeof(uint16_t));
+            }
+        }
+
+        return blob;
+    }
+
+    /// @brief Average ns to fetch and read one column of texture index, summed so nothing is optimised out
+    double columnNs(uint16_t index, uint32_t& sink) {
+        uint16_t scratch[TEX_SIZE];
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < COLUMN_ITERATIONS; i++) {
+            for (uint8_t x = 0; x < TEX_SIZE; x++) {
+                const uint16_t* column = TextureManager::getTextureColumn(index, x, TEX_LOG2_SIZE, scratch);
+                for (uint8_t y = 0; y < TEX_SIZE; y++) sink += column[y];
+            }
+        }
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        return ns / (COLUMN_ITERATIONS * TEX_SIZE);
+    }
+
+    /// @brief Render frames from poses around the map, returns the average frame time in us
+    double renderFrames(const MapView& map, int frames, std::vector<uint16_t>& pixels) {
+        pixels.assign(static_cast<size_t>(frames) * SCREEN_WIDTH * SCREEN_HEIGHT, 0);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            // spin in place at the player start, every wall texture comes by
+            const float a = 6.2831853f * f / frames;
+            const PlayerData player{
+                getPlayerData()->pos_x, getPlayerData()->pos_y,
+                Fixed15_16(std::cos(a)), Fixed15_16(std::sin(a))
+            };
+            const Camera camera = Camera::fromPlayer(player);
+
+            for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+                renderColumn(map, camera, x, &pixels[(static_cast<size_t>(f) * SCREEN_WIDTH + x) * SCREEN_HEIGHT]);
+            }
+        }
+        const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        return us / frames;
+    }
+}
+
+int main(int argc, char** argv) {
+#if !RAYCASTER_PROCEDURAL_TEXTURES
+    printf("SKIP procedural textures are not built in, configure the tools with -DRAYCASTER_PROCEDURAL_TEXTURES=ON\n");
+    return 0;
+#endif
+
+    const int frames = (argc > 1) ? atoi(argv[1]) : 360;
+    const char* textures_path = (argc > 2) ? argv[2] : nullptr;
+
+    MappedFile file;
+    const uint8_t* blob = textures_xip_blob;
+    size_t blob_bytes = static_cast<size_t>(textures_xip_blob_end - textures_xip_blob);
+
+    if (textures_path != nullptr) {
+        file = MappedFile(textures_path);
+        blob = file.data();
+        blob_bytes = file.size();
+        TextureManager::setBlob(blob, blob_bytes);
+    }
+
+    if (blob == nullptr || !TextureManager::isValid() || !isMapDataValid()) {
+        printf("ERROR asset data invalid: %s\n", textures_path ? textures_path : "(linked)");
+        return 1;
+    }
+
+    const MapView map = createMapView();
+    const std::vector<uint8_t> expanded = expandTextures();
+
+    const uint32_t count = TextureManager::getHeader()->tex_count;
+    uint32_t sink = 0;
+    uint32_t procedural_count = 0;
+    int failures = 0;
+
+    static const char* const KIND_NAMES[ProceduralTexture::KIND_COUNT] = {"checkers", "xor", "ramps"};
+
+    printf("%-6s %-9s %10s %12s %10s\n", "index", "kind", "stored_ns", "procedural_ns", "ratio");
+
+    for (uint16_t i = 0; i < count; i++) {
+        const ProceduralTexture* procedural = TextureManager::getProcedural(i);
+        if (procedural == nullptr) continue;
+        procedural_count++;
+
+        TextureManager::setBlob(expanded.data(), expanded.size());
+        const uint16_t* stored = TextureManager::getTextureData(i);
+        const double stored_ns = columnNs(i, sink);
+
+        TextureManager::setBlob(blob, blob_bytes);
+        const double procedural_ns = columnNs(i, sink);
+
+        uint16_t scratch[TEX_SIZE];
+        for (uint8_t x = 0; x < TEX_SIZE; x++) {
+            const uint16_t* column = TextureManager::getTextureColumn(i, x, TEX_LOG2_SIZE, scratch);
+            if (memcmp(column, &stored[x * TEX_SIZE], TEX_SIZE * sizeof(uint16_t)) != 0) {
+                fprintf(stderr, "FAIL texture %u column %u differs from its expansion\n", i, x);
+                failures++;
+                break;
+            }
+        }
+
+        printf("%-6u %-9s %10.1f %12.1f %9.2fx\n", i, KIND_NAMES[procedural->kind], stored_ns, procedural_ns, procedural_ns / stored_ns);
+    }
+
+    // whole frames, the procedural columns against the stored ones
+    std::vector<uint16_t> stored_pixels;
+    std::vector<uint16_t> procedural_pixels;
+
+    TextureManager::setBlob(expanded.data(), expanded.size());
+    const double stored_us = renderFrames(map, frames, stored_pixels);
+
+    TextureManager::setBlob(blob, blob_bytes);
+    const double procedural_us = renderFrames(map, frames, procedural_pixels);
+
+    if (stored_pixels != procedural_pixels) {
+        fprintf(stderr, "FAIL rendered frames differ between stored and procedural textures\n");
+        failures++;
+    }
+
+    printf("procedural textures: %u of %u\n", procedural_count, count);
+    printf("blob bytes:          %zu stored, %zu with procedural (%.1f%%)\n", expanded.size(), blob_bytes,
+           100.0 * blob_bytes / expanded.size());
+    printf("frame_us:            %.1f stored, %.1f with procedural over %d frames\n", stored_us, procedural_us, frames);
+
+    if (failures > 0) {
+        printf("FAIL\n");
+        return 1;
+    }
+
+    printf("PASS\n");
+    return sink == 0; // keep the column reads from being optimised out
+}
@@ -0,0 +1,210 @@
+/**
+ * @file column_cache_check.cpp
+ * @brief Checks the scaled wall column cache and reports its hit rate at several budgets.
+ *
+ * A scripted walk through the embedded map (walking, turning, standing still)
+ * is rendered with plain drawWallColumn() and through a ColumnCache at
+ * several budgets, and with the TemporalRenderer drawing through a cache.
+ * Checked: every cached frame is identical to the plain one, and the LRU
+ * order, budget and clear() behave. Hit rate, bytes of texel reads saved per
+ * frame, evictions and frame times are printed.
+ * Exits non-zero if any check fails.
+ *
+ * Usage: column_cache_check [frames]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numbers>
+#include <vector>
+
+#include "column_cache.hpp"
+#include "map_data.hpp"
+#include "raycast.hpp"
+#include "renderer.hpp"
+#include "temporal.hpp"
+#include "textures.hpp"
+
+namespace {
+    constexpr size_t FRAME_PIXELS = static_cast<size_t>(SCREEN_WIDTH) * SCREEN_HEIGHT;
+    constexpr uint16_t BUDGETS[] = {16, 40, 80, ColumnCache::MAX_ENTRIES};
+
+    int failures = 0;
+
+    void fail(const char* what) {
+        if (failures++ < 10) fprintf(stderr, "FAIL %s\n", what);
+    }
+
+    struct Pose {
+        double x, y, angle;
+    };
+
+    /// @brief Walk, turn and stand still in turns, with simple collision
+    std::vector<Camera> scriptedPath(const MapView& map, const PlayerData& start, int frames) {
+        std::vector<Camera> path;
+        Pose pose{start.pos_x.toFloat(), start.pos_y.toFloat(), std::atan2(start.dir_y.toFloat(), start.dir_x.toFloat())};
+
+        for (int i = 0; i < frames; i++) {
+            double move = 0.0;
+            double turn = 0.0;
+
+            switch ((i / 60) % 4) {
+                case 0: move = 0.05; break;
+                case 1: turn = 2.0; break;
+                case 2: break;
+                case 3: move = 0.03; turn = -1.0; break;
+            }
+
+            pose.angle += turn * std::numbers::pi / 180.0;
+
+            const double lx = pose.x + std::cos(pose.angle) * move * 10.0;
+            const double ly = pose.y + std::sin(pose.angle) * move * 10.0;
+            if (map.getTile(static_cast<uint8_t>(lx), static_cast<uint8_t>(pose.y)) == 0) pose.x += std::cos(pose.angle) * move;
+            if (map.getTile(static_cast<uint8_t>(pose.x), static_cast<uint8_t>(ly)) == 0) pose.y += std::sin(pose.angle) * move;
+
+            const PlayerData player{
+                Fixed15_16(static_cast<float>(pose.x)), Fixed15_16(static_cast<float>(pose.y)),
+                Fixed15_16(static_cast<float>(std::cos(pose.angle))), Fixed15_16(static_cast<float>(std::sin(pose.angle)))
+            };
+            path.push_back(Camera::fromPlayer(player));
+        }
+
+        return path;
+    }
+
+    /// @brief Budget, LRU order and clear() on hand made hits
+    void checkEviction() {
+        static ColumnCache cache;
+        cache.setBudget(2);
+
+        uint16_t column[SCREEN_HEIGHT] = {};
+        auto wall = [](uint8_t tex_x) { return RayHit{1, 0, tex_x, 0, 1, 1, Fixed15_16(2)}; };
+
+        cache.drawWallColumn(wall(1), column);
+        cache.drawWallColumn(wall(2), column);
+        cache.drawWallColumn(wall(1), column);  // hit, 2 is now the oldest
+        cache.drawWallColumn(wall(3), column);  // evicts 2
+        cache.drawWallColumn(wall(1), column);  // hit
+        cache.drawWallColumn(wall(2), column);  // miss, evicts 3
+
+        const ColumnCache::Stats stats = cache.stats();
+        if (stats.lookups != 6 || stats.hits != 2 || stats.evictions != 2) fail("LRU order");
+
+        cache.clear();
+        cache.drawWallColumn(wall(1), column);
+        if (cache.stats().hits != 2) fail("clear() kept a column");
+
+        // a miss draws nothing and is not looked up
+        cache.drawWallColumn(RayHit{}, column);
+        if (cache.stats().lookups != 7) fail("miss looked up");
+
+        cache.setBudget(0);
+        if (cache.budget() != 1) fail("budget not clamped");
+        cache.setBudget(UINT16_MAX);
+        if (cache.budget() != ColumnCache::MAX_ENTRIES) fail("budget not clamped");
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv) {
+    const int frames = (argc > 1) ? atoi(argv[1]) : 960;
+
+    if (!TextureManager::isValid() || !isMapDataValid()) {
+        printf("ERROR embedded asset data invalid\n");
+        return 1;
+    }
+
+    checkEviction();
+
+    const MapView map = createMapView();
+    const std::vector<Camera> path = scriptedPath(map, *getPlayerData(), frames);
+
+    // hits and plain frames once, every budget draws the same hits
+    std::vector<RayHit> hits(path.size() * SCREEN_WIDTH);
+    std::vector<uint16_t> expected(path.size() * FRAME_PIXELS, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < path.size(); f++) {
+        for (uint8_t x = 0; x < SCREEN_WIDTH; x++) hits[f * SCREEN_WIDTH + x] = castRay(map, cameraRay(path[f], x));
+    }
+    const double cast_seconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < path.size(); f++) {
+        for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+            drawWallColumn(hits[f * SCREEN_WIDTH + x], &expected[f * FRAME_PIXELS + x * SCREEN_HEIGHT]);
+        }
+    }
+    const double plain_seconds = secondsSince(start);
+
+    const double n = static_cast<double>(path.size());
+    printf("frames:      %zu, raycasting %.1f us/frame\n", path.size(), 1e6 * cast_seconds / n);
+    printf("%-8s %8s %9s %14s %11s %12s\n", "budget", "bytes", "hit rate", "saved/frame", "evictions", "fill us");
+    printf("%-8s %8s %9s %14s %11s %12.1f\n", "none", "0", "-", "-", "-", 1e6 * plain_seconds / n);
+
+    static ColumnCache cache;
+    std::vector<uint16_t> frame(FRAME_PIXELS);
+
+    for (uint16_t budget : BUDGETS) {
+        cache.setBudget(budget);
+        cache.resetStats();
+
+        double seconds = 0.0;
+        for (size_t f = 0; f < path.size(); f++) {
+            std::fill(frame.begin(), frame.end(), 0);
+
+            start = std::chrono::steady_clock::now();
+            for (uint8_t x = 0; x < SCREEN_WIDTH; x++) cache.drawWallColumn(hits[f * SCREEN_WIDTH + x], &frame[x * SCREEN_HEIGHT]);
+            seconds += secondsSince(start);
+
+            if (!std::equal(frame.begin(), frame.end(), expected.begin() + f * FRAME_PIXELS)) fail("cached frame differs");
+        }
+
+        const ColumnCache::Stats& stats = cache.stats();
+        printf("%-8u %8u %8.1f%% %14.0f %11u %12.1f\n", budget, cache.budgetBytes(), 100.0 * stats.hitRate().toFloat(),
+               stats.bytesSaved() / n, stats.evictions, 1e6 * seconds / n);
+    }
+
+    // the firmware path: interlaced columns through the renderer's cache
+    for (const bool interlaced : {false, true}) {
+        TemporalRenderer plain(map), cached(map);
+        plain.setEnabled(interlaced);
+        cached.setEnabled(interlaced);
+
+        cache.setBudget(ColumnCache::MAX_ENTRIES);
+        cache.resetStats();
+        cached.setColumnCache(&cache);
+
+        std::vector<uint16_t> plain_frame(FRAME_PIXELS);
+        for (const Camera& camera : path) {
+            std::fill(plain_frame.begin(), plain_frame.end(), 0);
+            std::fill(frame.begin(), frame.end(), 0);
+
+            plain.beginFrame(camera);
+            cached.beginFrame(camera);
+            for (uint8_t i = 0; i < SCREEN_WIDTH; i++) {
+                const uint8_t x = plain.columnAt(i);
+                plain.renderColumn(x, &plain_frame[x * SCREEN_HEIGHT]);
+                cached.renderColumn(cached.columnAt(i), &frame[cached.columnAt(i) * SCREEN_HEIGHT]);
+            }
+
+            if (frame != plain_frame) fail("temporal renderer frame differs with the cache");
+        }
+
+        printf("temporal %s: %.1f%% hits\n", interlaced ? "interlaced" : "full", 100.0 * cache.stats().hitRate().toFloat());
+    }
+
+    if (failures > 0) {
+        printf("FAIL: %d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,223 @@
+/**
+ * @file asset_validation.hpp
+ * @brief Bounds checks for texture and map blobs loaded at runtime on the host.
+ *
+ * The firmware trusts its linked blobs, host tools read arbitrary files and
+ * have to check every offset before handing the blob to the renderer.
+ */
+
+#ifndef ASSET_VALIDATION_H
+#define ASSET_VALIDATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "level_archive.hpp"
+#include "map_data.hpp"
+#include "textures.hpp"
+
+/// @brief Known kind with the table it needs, and the table inside the blob
+inline bool validateProceduralTexture(const uint8_t* data, size_t size, uint32_t offset) {
+    if (offset % alignof(ProceduralTexture) != 0 || static_cast<size_t>(offset) + sizeof(ProceduralTexture) > size) return false;
+
+    const ProceduralTexture* procedural = reinterpret_cast<const ProceduralTexture*>(data + offset);
+    if (procedural->kind >= ProceduralTexture::KIND_COUNT) return false;
+    if (procedural->table_size == 0 || procedural->table_size != ProceduralTexture::tableSize(procedural->kind, procedural->shift)) return false;
+
+    return static_cast<size_t>(offset) + sizeof(ProceduralTexture) + procedural->table_size * sizeof(uint16_t) <= size;
+}
+
+/// @brief Header, offset table, column masks and every texture (stored or procedural) lie inside the blob, with no shade levels
+inline bool validateTextureBlob(const uint8_t* data, size_t size) {
+    if (size < sizeof(TextureFileHeader)) return false;
+
+    const TextureFileHeader* header = reinterpret_cast<const TextureFileHeader*>(data);
+    if (header->magic != TextureFileHeader::VALID_MAGIC || header->version != TextureFileHeader::VERSION) return false;
+    if (header->tex_count > 256 || header->shade_levels > 1) return false;
+
+    const uint32_t slots = header->tex_count;
+    if (sizeof(TextureFileHeader) + static_cast<size_t>(slots) * sizeof(uint32_t) > size) return false;
+
+    const uint32_t* offsets = reinterpret_cast<const uint32_t*>(data + sizeof(TextureFileHeader));
+    for (uint32_t i = 0; i < slots; i++) {
+        if ((offsets[i] & TextureFileHeader::PROCEDURAL_OFFSET) != 0) {
+            if (!validateProceduralTexture(data, size, offsets[i] & ~TextureFileHeader::PROCEDURAL_OFFSET)) return false;
+        } else if (static_cast<size_t>(offsets[i]) + TEX_SIZE * TEX_SIZE * sizeof(uint16_t) > size) {
+            return false;
+        }
+    }
+
+    // one column mask per offset table entry
+    if (header->mask_offset != 0) {
+        if (header->mask_offset % alignof(uint64_t) != 0) return false;
+        if (static_cast<size_t>(header->mask_offset) + static_cast<size_t>(slots) * sizeof(uint64_t) > size) return false;
+    }
+
+    return true;
+}
+
+/// @brief A run length encoded bitset at pos lies inside the blob and decodes to exactly bit_bytes bytes
+inline bool validatePvsBits(const uint8_t* data, size_t size, size_t pos, size_t bit_bytes) {
+    for (size_t decoded = 0; decoded < bit_bytes;) {
+        if (pos >= size) return false;
+        if (data[pos++] != 0) {
+            decoded++;
+            continue;
+        }
+
+        if (pos >= size) return false;
+        const uint8_t run = data[pos++];
+        if (run == 0 || run > bit_bytes - decoded) return false;
+        decoded += run;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Every open tile of the map has a visible set inside the blob, see pvs.hpp
+ * @note Wall and face texture lists only name textures the texture set has, and every bitset decodes to exactly one bit per tile
+ */
+inline bool validatePvs(const uint8_t* data, size_t size, uint32_t offset, const MapView& map, uint32_t tex_count) {
+    const size_t tile_count = static_cast<size_t>(map.width) * map.height;
+    const size_t bit_bytes = (tile_count + 7) / 8;
+    if (static_cast<size_t>(offset) + tile_count * sizeof(uint32_t) > size) return false;
+
+    for (size_t tile = 0; tile < tile_count; tile++) {
+        uint32_t entry;
+        memcpy(&entry, data + offset + tile * sizeof(uint32_t), sizeof(entry));
+
+        if (entry == 0) {
+            if (map.tile_data[tile] == 0) return false;
+            continue;
+        }
+
+        size_t pos = static_cast<size_t>(offset) + entry;
+        if (pos + sizeof(uint32_t) >= size) return false;
+
+        // a base set is a plain bitset inside the section, the entry a difference to it
+        uint32_t base;
+        memcpy(&base, data + pos, sizeof(base));
+        pos += sizeof(base);
+        if (base != 0 && !validatePvsBits(data, size, static_cast<size_t>(offset) + base, bit_bytes)) return false;
+
+        const uint8_t texture_count = data[pos++];
+        if (pos + texture_count > size) return false;
+        for (uint8_t i = 0; i < texture_count; i++) {
+            if (data[pos + i] == 0 || data[pos + i] >= tex_count) return false;
+        }
+        pos += texture_count;
+
+        if (pos >= size) return false;
+        const uint8_t face_count = data[pos++];
+        if (pos + face_count > size) return false;
+        for (uint8_t i = 0; i < face_count; i++) {
+            if (data[pos + i] >= tex_count) return false;
+        }
+        pos += face_count;
+
+        if (!validatePvsBits(data, size, pos, bit_bytes)) return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Header, player data and tiles lie inside the blob
+ * @param tex_count Texture count of the blob the map is rendered with, every wall needs its texture and the shaded one after it
+ */
+inline bool validateMapBlob(const uint8_t* data, size_t size, uint32_t tex_count) {
+    if (size < sizeof(MapFileHeader)) return false;
+    if (!isMapDataValid(data)) return false;
+
+    const MapFileHeader* header = getMapFileHeader(data);
+    if (static_cast<size_t>(header->playerdata_offset) + sizeof(PlayerData) > size) return false;
+    if (static_cast<size_t>(header->mapdata_offset) + 2 > size) return false;
+
+    // createMapView() reads the tiles and wall heights, so their bounds come first
+    const size_t tile_count = static_cast<size_t>(data[header->mapdata_offset]) * data[header->mapdata_offset + 1];
+    if (static_cast<size_t>(header->mapdata_offset) + 2 + tile_count > size) return false;
+
+    const bool has_heights = header->hasField(offsetof(MapFileHeader, heights_offset)) && header->heights_offset != 0;
+    if (has_heights && static_cast<size_t>(header->heights_offset) + tile_count > size) return false;
+
+    const MapView map = createMapView(data);
+
+    for (size_t i = 0; i < static_cast<size_t>(map.width) * map.height; i++) {
+        if (map.tile_data[i] >= tex_count) return false;
+    }
+
+    // doors sit on textured tiles inside the map
+    if (header->doors_offset != 0) {
+        if (static_cast<size_t>(header->doors_offset) + sizeof(uint32_t) > size) return false;
+
+        uint32_t door_count;
+        const DoorData* doors = getDoors(door_count, data);
+        if (static_cast<size_t>(header->doors_offset) + sizeof(uint32_t) + door_count * sizeof(DoorData) > size) return false;
+
+        for (uint32_t i = 0; i < door_count; i++) {
+            if (doors[i].x >= map.width || doors[i].y >= map.height || doors[i].axis > 1) return false;
+            if (map.getTile(doors[i].x, doors[i].y) == 0) return false;
+        }
+    }
+
+    // 4 shades per tile, headers from before lightmaps have none
+    if (header->hasField(offsetof(MapFileHeader, lightmap_offset)) && header->lightmap_offset != 0) {
+        const size_t faces = static_cast<size_t>(map.width) * map.height * 4;
+        if (static_cast<size_t>(header->lightmap_offset) + faces > size) return false;
+
+        const uint8_t* lightmap = getLightmap(data);
+        for (size_t i = 0; i < faces; i++) {
+            if (lightmap[i] >= SHADE_COUNT) return false;
+        }
+    }
+
+    // walls cannot be flat
+    if (has_heights) {
+        for (size_t i = 0; i < tile_count; i++) {
+            if (map.tile_data[i] != 0 && map.heights[i] == 0) return false;
+        }
+    }
+
+    // sets from before the face texture lists are not read, see getPvs()
+    if (header->hasField(offsetof(MapFileHeader, pvs_offset)) && header->pvs_offset != 0 &&
+        header->version >= MapFileHeader::PVS_FACES_VERSION) {
+        if (!validatePvs(data, size, header->pvs_offset, map, tex_count)) return false;
+    }
+
+    return true;
+}
+
+/// @brief Directories, every texture set and every level map lie inside the archive and are valid themselves
+inline bool validateLevelArchive(const uint8_t* data, size_t size) {
+    if (size < sizeof(LevelArchiveHeader)) return false;
+
+    const LevelArchiveHeader* header = reinterpret_cast<const LevelArchiveHeader*>(data);
+    if (header->magic != LevelArchiveHeader::VALID_MAGIC) return false;
+    if (header->levels_offset + static_cast<size_t>(header->level_count) * sizeof(LevelEntry) > size) return false;
+    if (header->texture_sets_offset + static_cast<size_t>(header->texture_set_count) * sizeof(TextureSetEntry) > size) return false;
+
+    const TextureSetEntry* texture_sets = reinterpret_cast<const TextureSetEntry*>(data + header->texture_sets_offset);
+    for (uint32_t i = 0; i < header->texture_set_count; i++) {
+        const TextureSetEntry& set = texture_sets[i];
+        if (static_cast<size_t>(set.offset) + set.size > size) return false;
+        if (!validateTextureBlob(data + set.offset, set.size)) return false;
+    }
+
+    const LevelEntry* levels = reinterpret_cast<const LevelEntry*>(data + header->levels_offset);
+    for (uint32_t i = 0; i < header->level_count; i++) {
+        const LevelEntry& level = levels[i];
+        if (level.name[LevelEntry::NAME_LENGTH - 1] != '\0') return false;
+        if (level.texture_set >= header->texture_set_count) return false;
+        if (static_cast<size_t>(level.map_offset) + level.map_size > size) return false;
+
+        const uint8_t* textures = data + texture_sets[level.texture_set].offset;
+        const uint32_t tex_count = reinterpret_cast<const TextureFileHeader*>(textures)->tex_count;
+        if (!validateMapBlob(data + level.map_offset, level.map_size, tex_count)) return false;
+    }
+
+    return true;
+}
+
+#endif // ASSET_VALIDATION_H
@@ -0,0 +1,35 @@
+/**
+ * @file frame_psnr.hpp
+ * @brief PSNR between two rendered frames, for the host tools that compare render paths.
+ */
+
+#ifndef FRAME_PSNR_H
+#define FRAME_PSNR_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "textures.hpp"
+
+/**
+ * @brief PSNR of two frames of panel byte order RGB565 pixels, over the 8 bit R, G and B channels
+ * @return INFINITY for identical frames
+ */
+inline double framePsnr(const uint16_t* a, const uint16_t* b, size_t count) {
+    double sq_error = 0.0;
+
+    for (size_t i = 0; i < count; i++) {
+        const TexelRgb ca = texelToRgb(a[i]);
+        const TexelRgb cb = texelToRgb(b[i]);
+        const int dr = ca.r - cb.r;
+        const int dg = ca.g - cb.g;
+        const int db = ca.b - cb.b;
+        sq_error += dr * dr + dg * dg + db * db;
+    }
+
+    const double mse = sq_error / (count * 3.0);
+    return (mse == 0.0) ? INFINITY : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+#endif // FRAME_PSNR_H
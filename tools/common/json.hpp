@@ -0,0 +1,226 @@
+/**
+ * @file json.hpp
+ * @brief Minimal JSON reader for the asset manifests, no external dependency.
+ */
+
+#ifndef JSON_H
+#define JSON_H
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @class JsonValue
+ * @brief Parsed JSON document node
+ * @note Numbers are kept as double, plenty for manifest ids, versions and coordinates
+ */
+class JsonValue {
+    public:
+        enum class Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+        Type type = Type::NUL;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<JsonValue> array;
+        std::map<std::string, JsonValue> object;
+
+        bool isNumber() const { return type == Type::NUMBER; }
+        bool isString() const { return type == Type::STRING; }
+        bool isArray() const { return type == Type::ARRAY; }
+        bool isObject() const { return type == Type::OBJECT; }
+
+        /// @brief Member of an object, nullptr if missing or not an object
+        const JsonValue* find(const std::string& key) const {
+            if (type != Type::OBJECT) return nullptr;
+            auto it = object.find(key);
+            return (it == object.end()) ? nullptr : &it->second;
+        }
+
+        /**
+         * @brief Parse a whole document
+         * @param[out] error Message with the byte offset on failure
+         * @return false on malformed input or trailing garbage
+         */
+        static bool parse(const std::string& text, JsonValue& out, std::string& error) {
+            Parser parser{text, 0, error};
+            if (!parser.value(out)) return false;
+
+            parser.skipSpace();
+            if (parser.pos != text.size()) return parser.fail("trailing characters");
+            return true;
+        }
+
+        /// @brief Read and parse a file
+        static bool parseFile(const char* path, JsonValue& out, std::string& error) {
+            FILE* f = fopen(path, "rb");
+            if (f == nullptr) {
+                error = std::string("could not open ") + path;
+                return false;
+            }
+
+            std::string text;
+            char buffer[4096];
+            size_t n;
+            while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) text.append(buffer, n);
+            fclose(f);
+
+            return parse(text, out, error);
+        }
+
+    private:
+        struct Parser {
+            const std::string& text;
+            size_t pos;
+            std::string& error;
+
+            bool fail(const char* message) {
+                error = std::string(message) + " at offset " + std::to_string(pos);
+                return false;
+            }
+
+            void skipSpace() {
+                while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos]))) pos++;
+            }
+
+            bool literal(const char* word) {
+                const std::string w(word);
+                if (text.compare(pos, w.size(), w) != 0) return fail("unexpected token");
+                pos += w.size();
+                return true;
+            }
+
+            bool value(JsonValue& out) {
+                skipSpace();
+                if (pos >= text.size()) return fail("unexpected end of input");
+
+                const char c = text[pos];
+
+                if (c == '{') return objectValue(out);
+                if (c == '[') return arrayValue(out);
+                if (c == '"') {
+                    out.type = Type::STRING;
+                    return stringValue(out.string);
+                }
+                if (c == 't') {
+                    out.type = Type::BOOL;
+                    out.boolean = true;
+                    return literal("true");
+                }
+                if (c == 'f') {
+                    out.type = Type::BOOL;
+                    out.boolean = false;
+                    return literal("false");
+                }
+                if (c == 'n') {
+                    out.type = Type::NUL;
+                    return literal("null");
+                }
+
+                // number
+                const char* start = text.c_str() + pos;
+                char* end = nullptr;
+                out.number = strtod(start, &end);
+                if (end == start) return fail("unexpected character");
+
+                out.type = Type::NUMBER;
+                pos += end - start;
+                return true;
+            }
+
+            bool stringValue(std::string& out) {
+                pos++; // opening quote
+
+                while (pos < text.size() && text[pos] != '"') {
+                    char c = text[pos++];
+
+                    if (c == '\\') {
+                        if (pos >= text.size()) break;
+                        c = text[pos++];
+                        switch (c) {
+                            case 'n': c = '\n'; break;
+                            case 't': c = '\t'; break;
+                            case 'r': c = '\r'; break;
+                            case 'b': c = '\b'; break;
+                            case 'f': c = '\f'; break;
+                            case 'u': return fail("unicode escapes are not supported");
+                            default: break; // \" \\ \/
+                        }
+                    }
+
+                    out += c;
+                }
+
+                if (pos >= text.size()) return fail("unterminated string");
+                pos++; // closing quote
+                return true;
+            }
+
+            bool arrayValue(JsonValue& out) {
+                out.type = Type::ARRAY;
+                pos++;
+
+                skipSpace();
+                if (pos < text.size() && text[pos] == ']') {
+                    pos++;
+                    return true;
+                }
+
+                while (true) {
+                    out.array.emplace_back();
+                    if (!value(out.array.back())) return false;
+
+                    skipSpace();
+                    if (pos < text.size() && text[pos] == ',') {
+                        pos++;
+                    } else if (pos < text.size() && text[pos] == ']') {
+                        pos++;
+                        return true;
+                    } else {
+                        return fail("expected ',' or ']'");
+                    }
+                }
+            }
+
+            bool objectValue(JsonValue& out) {
+                out.type = Type::OBJECT;
+                pos++;
+
+                skipSpace();
+                if (pos < text.size() && text[pos] == '}') {
+                    pos++;
+                    return true;
+                }
+
+                while (true) {
+                    skipSpace();
+                    if (pos >= text.size() || text[pos] != '"') return fail("expected key");
+
+                    std::string key;
+                    if (!stringValue(key)) return false;
+
+                    skipSpace();
+                    if (pos >= text.size() || text[pos] != ':') return fail("expected ':'");
+                    pos++;
+
+                    if (!value(out.object[key])) return false;
+
+                    skipSpace();
+                    if (pos < text.size() && text[pos] == ',') {
+                        pos++;
+                    } else if (pos < text.size() && text[pos] == '}') {
+                        pos++;
+                        return true;
+                    } else {
+                        return fail("expected ',' or '}'");
+                    }
+                }
+            }
+        };
+};
+
+#endif // JSON_H
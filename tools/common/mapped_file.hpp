@@ -0,0 +1,77 @@
+/**
+ * @file mapped_file.hpp
+ * @brief Read-only memory mapped file, so host tools can share asset blobs between threads without copying.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @class MappedFile
+ * @brief RAII wrapper around a read-only private mmap of a whole file
+ */
+class MappedFile {
+    private:
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+
+    public:
+        MappedFile() = default;
+
+        /// @note check valid() afterwards, empty or missing files are not mapped
+        explicit MappedFile(const char* path) {
+            int fd = open(path, O_RDONLY);
+            if (fd < 0) return;
+
+            struct stat st;
+            if (fstat(fd, &st) == 0 && st.st_size > 0) {
+                void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (ptr != MAP_FAILED) {
+                    data_ = static_cast<const uint8_t*>(ptr);
+                    size_ = static_cast<size_t>(st.st_size);
+                }
+            }
+
+            // the mapping stays valid after the descriptor is closed
+            close(fd);
+        }
+
+        ~MappedFile() {
+            if (data_ != nullptr) {
+                munmap(const_cast<uint8_t*>(data_), size_);
+            }
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept : data_(other.data_), size_(other.size_) {
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+
+        MappedFile& operator=(MappedFile&& other) noexcept {
+            if (this != &other) {
+                this->~MappedFile();
+                data_ = other.data_;
+                size_ = other.size_;
+                other.data_ = nullptr;
+                other.size_ = 0;
+            }
+            return *this;
+        }
+
+        [[nodiscard]] bool valid() const { return data_ != nullptr; }
+        [[nodiscard]] const uint8_t* data() const { return data_; }
+        [[nodiscard]] size_t size() const { return size_; }
+};
+
+#endif // MAPPED_FILE_H
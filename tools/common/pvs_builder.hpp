@@ -0,0 +1,301 @@
+/**
+ * @file pvs_builder.hpp
+ * @brief Bakes the potentially visible sets of a map (see pvs.hpp) by casting rays from every open tile.
+ *
+ * From a grid of points across each open tile, rays are cast in evenly spaced
+ * directions to the edge of the map. Every tile a ray passes or stops at is
+ * visible from the tile. Rays go through doors (they open) and through walls
+ * lower than the map's tallest, which can show taller ones behind them.
+ * The first open tile of each PVS_BLOCK block is stored whole, the rest of
+ * the block as differences to it where that comes out shorter. Each set also
+ * lists the textures of the faces of its walls, ranked like the walls.
+ */
+
+#ifndef PVS_BUILDER_H
+#define PVS_BUILDER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numbers>
+#include <vector>
+
+#include "map_data.hpp"
+#include "pvs.hpp"
+
+struct PvsBuildOptions {
+    /// @brief Sample points per tile along each axis, the outer ones close to the tile's edges
+    uint8_t points_per_axis = 4;
+
+    /// @brief Ray directions per sample point, 0 for 32 per tile of the longer map side (at least 256)
+    uint16_t directions = 0;
+};
+
+struct PvsBuildStats {
+    uint32_t sets = 0;
+    uint64_t rays = 0;
+    uint64_t visible_tiles = 0; // summed over the sets
+    size_t raw_bytes = 0;       // the whole section with every set as a plain bitset
+    size_t packed_bytes = 0;    // the whole section as built
+};
+
+namespace pvs_builder {
+    /// @brief Zero runs as a zero byte and a count, see pvs.hpp
+    inline void encodeBits(const std::vector<uint8_t>& bits, std::vector<uint8_t>& out) {
+        for (size_t i = 0; i < bits.size();) {
+            if (bits[i] != 0) {
+                out.push_back(bits[i++]);
+                continue;
+            }
+
+            uint8_t run = 0;
+            while (i < bits.size() && bits[i] == 0 && run < UINT8_MAX) {
+                run++;
+                i++;
+            }
+            out.push_back(0);
+            out.push_back(run);
+        }
+    }
+
+    /// @brief Mark every tile the ray passes up to the first wall it cannot see past
+    inline void castVisibility(uint8_t width, uint8_t height, const std::vector<uint8_t>& blocks, double ox, double oy,
+                               double dx, double dy, std::vector<uint8_t>& bits) {
+        int map_x = static_cast<int>(ox);
+        int map_y = static_cast<int>(oy);
+
+        const double delta_x = (dx == 0.0) ? 1e30 : std::fabs(1.0 / dx);
+        const double delta_y = (dy == 0.0) ? 1e30 : std::fabs(1.0 / dy);
+        const int step_x = (dx < 0) ? -1 : 1;
+        const int step_y = (dy < 0) ? -1 : 1;
+        double side_x = (dx < 0) ? (ox - map_x) * delta_x : (map_x + 1.0 - ox) * delta_x;
+        double side_y = (dy < 0) ? (oy - map_y) * delta_y : (map_y + 1.0 - oy) * delta_y;
+
+        while (true) {
+            if (side_x < side_y) {
+                side_x += delta_x;
+                map_x += step_x;
+            } else {
+                side_y += delta_y;
+                map_y += step_y;
+            }
+
+            if (map_x < 0 || map_y < 0 || map_x >= width || map_y >= height) return;
+
+            const size_t tile = static_cast<size_t>(map_y) + static_cast<size_t>(height) * map_x;
+            bits[tile >> 3] |= static_cast<uint8_t>(1 << (tile & 7));
+
+            if (blocks[tile]) return;
+        }
+    }
+
+    /**
+     * @brief Textures of the faces of the visible walls, see PotentiallyVisibleSet::faceTextures()
+     * @param visible_tiles Wall tiles of the set, the most seen first
+     * @param doors Door tile per tile, a face against one counts while the door is shut
+     */
+    inline std::vector<uint8_t> faceTextures(uint8_t width, uint8_t height, const std::vector<uint8_t>& tiles,
+                                             const std::vector<uint8_t>& heights, const std::vector<uint8_t>& doors,
+                                             const std::vector<uint8_t>& bits, const std::vector<uint8_t>& visible_tiles) {
+        constexpr int STEP_X[4] = {-1, 1, 0, 0}; // TileFace order
+        constexpr int STEP_Y[4] = {0, 0, -1, 1};
+
+        auto wallHeight = [&](size_t tile) { return heights.empty() ? WALL_HEIGHT_ONE : heights[tile]; };
+
+        // rank of the most seen wall tile drawing each texture
+        std::vector<uint8_t> tile_rank(256, UINT8_MAX), texture_rank(256, UINT8_MAX);
+        std::vector<uint32_t> faces(256, 0);
+        for (size_t i = visible_tiles.size(); i > 0; i--) tile_rank[visible_tiles[i - 1]] = static_cast<uint8_t>(i - 1);
+
+        for (int x = 0; x < width; x++) {
+            for (int y = 0; y < height; y++) {
+                const size_t tile = static_cast<size_t>(y) + static_cast<size_t>(height) * x;
+                if (tiles[tile] == 0 || ((bits[tile >> 3] >> (tile & 7)) & 1) == 0) continue;
+
+                for (int f = 0; f < 4; f++) {
+                    const int nx = x + STEP_X[f];
+                    const int ny = y + STEP_Y[f];
+                    if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+
+                    // a face against a wall at least as high is never drawn
+                    const size_t neighbour = static_cast<size_t>(ny) + static_cast<size_t>(height) * nx;
+                    if (tiles[neighbour] != 0 && !doors[neighbour] && wallHeight(neighbour) >= wallHeight(tile)) continue;
+
+                    // x faces are side 0 hits, y faces side 1
+                    const uint32_t texture = tiles[tile] - 1 + ((f < 2) ? 0 : 1);
+                    if (texture > UINT8_MAX) continue;
+
+                    faces[texture]++;
+                    texture_rank[texture] = std::min(texture_rank[texture], tile_rank[tiles[tile]]);
+                }
+            }
+        }
+
+        // the textures of the most seen walls first, the ones with more faces first among them
+        std::vector<uint8_t> textures;
+        for (uint32_t t = 0; t <= UINT8_MAX; t++) {
+            if (faces[t] != 0) textures.push_back(static_cast<uint8_t>(t));
+        }
+        std::stable_sort(textures.begin(), textures.end(), [&](uint8_t a, uint8_t b) {
+            return texture_rank[a] != texture_rank[b] ? texture_rank[a] < texture_rank[b] : faces[a] > faces[b];
+        });
+
+        // the count is a byte, all 256 textures of a set only fit without the least seen one
+        if (textures.size() > UINT8_MAX) textures.resize(UINT8_MAX);
+
+        return textures;
+    }
+}
+
+/**
+ * @brief Build the PVS section of a map
+ * @param tiles Column major like MapView
+ * @param heights One per tile in WALL_HEIGHT_ONE units, empty if every wall is one unit high
+ * @return The section, see pvs.hpp
+ */
+inline std::vector<uint8_t> buildPvs(uint8_t width, uint8_t height, const std::vector<uint8_t>& tiles, const std::vector<uint8_t>& heights,
+                                     const std::vector<DoorData>& doors, const PvsBuildOptions& options = PvsBuildOptions{},
+                                     PvsBuildStats* stats = nullptr) {
+    const size_t tile_count = static_cast<size_t>(width) * height;
+    const size_t bit_bytes = (tile_count + 7) / 8;
+
+    // only walls as tall as the tallest hide everything behind them
+    uint8_t max_height = WALL_HEIGHT_ONE;
+    if (!heights.empty()) {
+        max_height = 0;
+        for (size_t i = 0; i < tile_count; i++) {
+            if (tiles[i] != 0) max_height = std::max(max_height, heights[i]);
+        }
+    }
+
+    std::vector<uint8_t> blocks(tile_count);
+    for (size_t i = 0; i < tile_count; i++) {
+        blocks[i] = tiles[i] != 0 && (heights.empty() || heights[i] >= max_height);
+    }
+    std::vector<uint8_t> door_tiles(tile_count, 0);
+    for (const DoorData& door : doors) {
+        blocks[door.y + static_cast<size_t>(height) * door.x] = 0;
+        door_tiles[door.y + static_cast<size_t>(height) * door.x] = 1;
+    }
+
+    const uint8_t points = std::max<uint8_t>(options.points_per_axis, 1);
+    const uint16_t directions = options.directions ? options.directions : std::max(256, 32 * std::max(width, height));
+
+    std::vector<double> dir_x(directions), dir_y(directions);
+    for (uint16_t d = 0; d < directions; d++) {
+        const double angle = 2.0 * std::numbers::pi * d / directions;
+        dir_x[d] = std::cos(angle);
+        dir_y[d] = std::sin(angle);
+    }
+
+    std::vector<uint8_t> section(tile_count * sizeof(uint32_t), 0);
+    std::vector<uint8_t> bits(bit_bytes);
+    std::vector<uint8_t> dilated(bit_bytes);
+    std::vector<uint8_t> difference(bit_bytes);
+    std::vector<uint8_t> whole, against_base;
+    std::vector<uint32_t> tile_faces(256);
+    PvsBuildStats local;
+
+    // base set of every block, where its bitset lies in the section and what it decodes to
+    const size_t blocks_y = (height + PVS_BLOCK - 1) / PVS_BLOCK;
+    std::vector<uint32_t> block_base(((width + PVS_BLOCK - 1) / PVS_BLOCK) * blocks_y, 0);
+    std::vector<std::vector<uint8_t>> block_bits(block_base.size());
+
+    for (uint8_t x = 0; x < width; x++) {
+        for (uint8_t y = 0; y < height; y++) {
+            const size_t tile = y + static_cast<size_t>(height) * x;
+            if (tiles[tile] != 0) continue;
+
+            std::fill(bits.begin(), bits.end(), 0);
+            bits[tile >> 3] |= static_cast<uint8_t>(1 << (tile & 7));
+
+            for (uint8_t px = 0; px < points; px++) {
+                for (uint8_t py = 0; py < points; py++) {
+                    // spread from just inside one edge to just inside the other
+                    const double fx = (points == 1) ? 0.5 : 0.01 + 0.98 * px / (points - 1);
+                    const double fy = (points == 1) ? 0.5 : 0.01 + 0.98 * py / (points - 1);
+
+                    for (uint16_t d = 0; d < directions; d++) {
+                        pvs_builder::castVisibility(width, height, blocks, x + fx, y + fy, dir_x[d], dir_y[d], bits);
+                    }
+                    local.rays += directions;
+                }
+            }
+
+            // rays between the sample points can miss a sliver of wall next to one they hit, add the walls around what was seen
+            dilated = bits;
+            for (int32_t vx = 0; vx < width; vx++) {
+                for (int32_t vy = 0; vy < height; vy++) {
+                    const size_t seen = static_cast<size_t>(vy) + static_cast<size_t>(height) * vx;
+                    if (((bits[seen >> 3] >> (seen & 7)) & 1) == 0) continue;
+
+                    for (int32_t nx = std::max(vx - 1, 0); nx <= std::min(vx + 1, width - 1); nx++) {
+                        for (int32_t ny = std::max(vy - 1, 0); ny <= std::min(vy + 1, height - 1); ny++) {
+                            const size_t t = static_cast<size_t>(ny) + static_cast<size_t>(height) * nx;
+                            if (tiles[t] != 0) dilated[t >> 3] |= static_cast<uint8_t>(1 << (t & 7));
+                        }
+                    }
+                }
+            }
+            bits.swap(dilated);
+
+            // wall tiles seen, the most seen first
+            std::fill(tile_faces.begin(), tile_faces.end(), 0);
+            std::vector<uint8_t> visible_tiles;
+            for (size_t t = 0; t < tile_count; t++) {
+                if (((bits[t >> 3] >> (t & 7)) & 1) == 0) continue;
+                local.visible_tiles++;
+                if (tiles[t] != 0 && tile_faces[tiles[t]]++ == 0) visible_tiles.push_back(tiles[t]);
+            }
+            std::stable_sort(visible_tiles.begin(), visible_tiles.end(),
+                             [&](uint8_t a, uint8_t b) { return tile_faces[a] > tile_faces[b]; });
+            const std::vector<uint8_t> face_textures =
+                pvs_builder::faceTextures(width, height, tiles, heights, door_tiles, bits, visible_tiles);
+
+            const uint32_t entry = static_cast<uint32_t>(section.size());
+            memcpy(section.data() + tile * sizeof(uint32_t), &entry, sizeof(entry));
+
+            const size_t block = y / PVS_BLOCK + blocks_y * (x / PVS_BLOCK);
+            uint32_t base = block_base[block];
+
+            whole.clear();
+            pvs_builder::encodeBits(bits, whole);
+            if (base != 0) {
+                for (size_t i = 0; i < bit_bytes; i++) difference[i] = bits[i] ^ block_bits[block][i];
+                against_base.clear();
+                pvs_builder::encodeBits(difference, against_base);
+                if (against_base.size() >= whole.size()) base = 0;
+            }
+
+            section.resize(section.size() + sizeof(base));
+            memcpy(section.data() + entry, &base, sizeof(base));
+            section.push_back(static_cast<uint8_t>(visible_tiles.size()));
+            section.insert(section.end(), visible_tiles.begin(), visible_tiles.end());
+            section.push_back(static_cast<uint8_t>(face_textures.size()));
+            section.insert(section.end(), face_textures.begin(), face_textures.end());
+
+            if (base != 0) {
+                section.insert(section.end(), against_base.begin(), against_base.end());
+            } else {
+                // the block's first open tile becomes its base
+                if (block_base[block] == 0) {
+                    block_base[block] = static_cast<uint32_t>(section.size());
+                    block_bits[block] = bits;
+                }
+                section.insert(section.end(), whole.begin(), whole.end());
+            }
+
+            local.sets++;
+            local.raw_bytes += sizeof(uint32_t) + 1 + visible_tiles.size() + 1 + face_textures.size() + bit_bytes;
+        }
+    }
+
+    local.raw_bytes += tile_count * sizeof(uint32_t);
+    local.packed_bytes = section.size();
+    if (stats != nullptr) *stats = local;
+
+    return section;
+}
+
+#endif // PVS_BUILDER_H
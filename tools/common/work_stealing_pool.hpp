@@ -0,0 +1,117 @@
+/**
+ * @file work_stealing_pool.hpp
+ * @brief Minimal work stealing thread pool for batches of independent jobs.
+ */
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class WorkStealingPool
+ * @brief Runs jobs [0, count) on a fixed set of workers.
+ *
+ * Jobs are split into contiguous chunks, one deque per worker. Workers pop
+ * from the back of their own deque and, once it is empty, steal from the
+ * front of the others, so uneven job costs still balance out.
+ */
+class WorkStealingPool {
+    private:
+        struct WorkerQueue {
+            std::mutex lock;
+            std::deque<size_t> jobs;
+        };
+
+        size_t worker_count_;
+
+    public:
+        struct Stats {
+            std::vector<size_t> jobs_run;    // per worker
+            std::vector<size_t> jobs_stolen; // per worker
+        };
+
+        explicit WorkStealingPool(size_t worker_count) : worker_count_(worker_count > 0 ? worker_count : 1) {}
+
+        [[nodiscard]] size_t workerCount() const { return worker_count_; }
+
+        /**
+         * @brief Run fn(worker, job) for every job, blocks until all are done
+         * @note fn must be safe to call concurrently for different jobs
+         */
+        template <typename Fn>
+        Stats run(size_t count, Fn&& fn) {
+            std::vector<WorkerQueue> queues(worker_count_);
+
+            for (size_t w = 0; w < worker_count_; w++) {
+                size_t begin = count * w / worker_count_;
+                size_t end = count * (w + 1) / worker_count_;
+                for (size_t job = begin; job < end; job++) {
+                    queues[w].jobs.push_back(job);
+                }
+            }
+
+            std::atomic<size_t> remaining{count};
+
+            Stats stats;
+            stats.jobs_run.assign(worker_count_, 0);
+            stats.jobs_stolen.assign(worker_count_, 0);
+
+            auto worker_main = [&](size_t self) {
+                while (remaining.load(std::memory_order_acquire) > 0) {
+                    size_t job;
+                    bool found = false;
+                    bool stolen = false;
+
+                    {
+                        std::lock_guard<std::mutex> guard(queues[self].lock);
+                        if (!queues[self].jobs.empty()) {
+                            job = queues[self].jobs.back();
+                            queues[self].jobs.pop_back();
+                            found = true;
+                        }
+                    }
+
+                    for (size_t i = 1; !found && i < worker_count_; i++) {
+                        WorkerQueue& victim = queues[(self + i) % worker_count_];
+
+                        std::lock_guard<std::mutex> guard(victim.lock);
+                        if (!victim.jobs.empty()) {
+                            job = victim.jobs.front();
+                            victim.jobs.pop_front();
+                            found = true;
+                            stolen = true;
+                        }
+                    }
+
+                    // everything is claimed, the remaining jobs are in flight elsewhere
+                    if (!found) break;
+
+                    fn(self, job);
+
+                    stats.jobs_run[self]++;
+                    stats.jobs_stolen[self] += stolen;
+                    remaining.fetch_sub(1, std::memory_order_release);
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for (size_t w = 1; w < worker_count_; w++) {
+                threads.emplace_back(worker_main, w);
+            }
+            worker_main(0);
+
+            for (std::thread& t : threads) {
+                t.join();
+            }
+
+            return stats;
+        }
+};
+
+#endif // WORK_STEALING_POOL_H
@@ -0,0 +1,299 @@
+/**
+ * @file flow_field_check.cpp
+ * @brief Checks the incremental flow field against a one shot search and times it.
+ *
+ * On random maps up to the largest the map format allows (255x255) the field
+ * is built with the per frame budget and compared with a plain breadth first
+ * search: every tile has to get the same step count, and following the stored
+ * directions from any reachable tile has to reach the target in exactly that
+ * many legal moves. No update() may use more than its budget, clearing the
+ * back grid included. The check also moves the target in the middle of a
+ * search and opens a wall through a tile overlay, expecting the field to
+ * follow both.
+ * Exits non-zero if any check fails.
+ *
+ * Usage: flow_field_check [maps_per_size] [seed]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "flow_field.hpp"
+#include "tile_overlay.hpp"
+
+namespace {
+    constexpr uint32_t MAX_TILES = 255 * 255;
+    constexpr int TIMING_REPEATS = 5;
+
+    using Field = FlowField<MAX_TILES>;
+
+    struct Timing {
+        double full_us = 0.0;     // whole search in one call
+        double frame_us = 0.0;    // average update() with the default budget
+        double worst_us = 0.0;    // slowest update() with the default budget, each the fastest of TIMING_REPEATS
+        uint32_t frames = 0;      // update() calls until the field was complete
+        double lookup_ns = 0.0;   // one agent step
+    };
+
+    int failures = 0;
+
+    // the field keeps a reference to the view, rebound per map like the firmware rebinds a level
+    MapView bound_map(0, 0, nullptr);
+    Field field(bound_map);
+
+    void fail(const char* what, uint8_t size, int x, int y) {
+        if (failures++ < 10) {
+            fprintf(stderr, "FAIL %ux%u at (%d, %d): %s\n", size, size, x, y, what);
+        }
+    }
+
+    /// @brief Closed map with random pillars, column major like the map blob
+    std::vector<uint8_t> makeMap(uint8_t size, std::mt19937& rng) {
+        std::vector<uint8_t> tiles(size * size, 0);
+        std::uniform_int_distribution<int> chance(0, 99);
+
+        for (int x = 0; x < size; x++) {
+            for (int y = 0; y < size; y++) {
+                bool border = x == 0 || y == 0 || x == size - 1 || y == size - 1;
+                if (border || chance(rng) < 25) {
+                    tiles[y + size * x] = 1 + (x + y) % 8;
+                }
+            }
+        }
+
+        return tiles;
+    }
+
+    bool isOpen(const MapView& map, int x, int y) {
+        if (x < 0 || y < 0 || x >= map.width || y >= map.height) return false;
+        return map.getEffectiveTile(x, y) == 0;
+    }
+
+    /// @brief Move rules of the field: 8 way, no diagonal past a wall
+    bool isLegalMove(const MapView& map, int x, int y, int dx, int dy) {
+        if (!isOpen(map, x + dx, y + dy)) return false;
+        return dx == 0 || dy == 0 || (isOpen(map, x + dx, y) && isOpen(map, x, y + dy));
+    }
+
+    /// @brief One shot breadth first search with the same rules
+    std::vector<uint16_t> referenceDistances(const MapView& map, int tx, int ty) {
+        std::vector<uint16_t> dist(map.width * map.height, Field::UNREACHABLE);
+        std::deque<std::pair<int, int>> queue{{tx, ty}};
+        dist[ty + map.height * tx] = 0;
+
+        while (!queue.empty()) {
+            auto [x, y] = queue.front();
+            queue.pop_front();
+
+            for (int dx = -1; dx <= 1; dx++) {
+                for (int dy = -1; dy <= 1; dy++) {
+                    if ((dx == 0 && dy == 0) || !isLegalMove(map, x, y, dx, dy)) continue;
+
+                    uint16_t& d = dist[(y + dy) + map.height * (x + dx)];
+                    if (d != Field::UNREACHABLE) continue;
+
+                    d = dist[y + map.height * x] + 1;
+                    queue.emplace_back(x + dx, y + dy);
+                }
+            }
+        }
+
+        return dist;
+    }
+
+    /// @brief Run update() until the field swaps, checking the budget on every call
+    /// @param frame_us Time of each update() if not nullptr
+    uint32_t completeSearch(Field& field, uint8_t tx, uint8_t ty, uint16_t budget, std::vector<double>* frame_us = nullptr) {
+        uint32_t frames = 0;
+
+        while (true) {
+            const auto start = std::chrono::steady_clock::now();
+            const bool done = field.update(tx, ty, budget);
+            const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            frames++;
+
+            if (field.lastWork() > budget) fail("update() used more than its budget", 0, tx, ty);
+            if (frame_us != nullptr) frame_us->push_back(us);
+
+            if (done) return frames;
+            if (!field.searching()) {
+                fail("search stopped without completing", 0, tx, ty);
+                return frames;
+            }
+        }
+    }
+
+    void checkField(const MapView& map, const Field& field, int tx, int ty) {
+        const std::vector<uint16_t> expected = referenceDistances(map, tx, ty);
+
+        for (int x = 0; x < map.width; x++) {
+            for (int y = 0; y < map.height; y++) {
+                const uint16_t dist = field.distance(x, y);
+                if (dist != expected[y + map.height * x]) {
+                    fail("distance differs from the reference search", map.width, x, y);
+                    continue;
+                }
+                if (dist == Field::UNREACHABLE) continue;
+
+                // walk the directions, each move has to be legal and take one step off the distance
+                int px = x;
+                int py = y;
+                for (uint16_t steps = dist; steps > 0; steps--) {
+                    const uint8_t dir = field.direction(px, py);
+                    if (dir == Field::NONE || !isLegalMove(map, px, py, Field::DIR_X[dir], Field::DIR_Y[dir])) {
+                        fail("direction leads nowhere or through a wall", map.width, px, py);
+                        break;
+                    }
+                    px += Field::DIR_X[dir];
+                    py += Field::DIR_Y[dir];
+                }
+
+                if (px != tx || py != ty) fail("directions do not end at the target", map.width, x, y);
+            }
+        }
+    }
+
+    std::pair<uint8_t, uint8_t> randomOpenTile(const MapView& map, std::mt19937& rng) {
+        std::uniform_int_distribution<int> cell(1, map.width - 2);
+        while (true) {
+            const uint8_t x = cell(rng);
+            const uint8_t y = cell(rng);
+            if (isOpen(map, x, y)) return {x, y};
+        }
+    }
+
+    Timing checkSize(uint8_t size, int maps, std::mt19937& rng) {
+        Timing timing;
+
+        for (int m = 0; m < maps; m++) {
+            std::vector<uint8_t> tiles = makeMap(size, rng);
+            bound_map = MapView(size, size, tiles.data());
+            field.mapChanged();
+
+            const MapView& map = bound_map;
+            Field& f = field;
+
+            // budgeted search, as the firmware runs it
+            auto [tx, ty] = randomOpenTile(map, rng);
+            timing.frames += completeSearch(f, tx, ty, Field::DEFAULT_BUDGET);
+            checkField(map, f, tx, ty);
+
+            // the same search again a few times, every frame does the same work so its fastest time is its cost
+            std::vector<double> best_us;
+            for (int r = 0; r < TIMING_REPEATS; r++) {
+                std::vector<double> frame_us;
+                f.passabilityChanged();
+                completeSearch(f, tx, ty, Field::DEFAULT_BUDGET, &frame_us);
+                if (r == 0) best_us = frame_us;
+                for (size_t i = 0; i < frame_us.size() && i < best_us.size(); i++) {
+                    if (frame_us[i] < best_us[i]) best_us[i] = frame_us[i];
+                }
+            }
+            for (double us : best_us) {
+                timing.frame_us += us;
+                if (us > timing.worst_us) timing.worst_us = us;
+            }
+
+            // the target moves mid search: the running search starts over for the new tile, agents keep the old grid
+            auto [nx, ny] = randomOpenTile(map, rng);
+            f.update(nx, ny, 64);
+            auto [mx, my] = randomOpenTile(map, rng);
+            completeSearch(f, mx, my, 64);
+            if (f.targetX() != mx || f.targetY() != my) fail("moved target did not restart the search", size, mx, my);
+            checkField(map, f, mx, my);
+
+            // one shot search for the full cost
+            f.passabilityChanged();
+            const auto start = std::chrono::steady_clock::now();
+            f.update(mx, my, UINT16_MAX);
+            timing.full_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+            // agents steering by the field
+            std::vector<std::pair<uint8_t, uint8_t>> agents;
+            for (int a = 0; a < 1024; a++) agents.push_back(randomOpenTile(map, rng));
+
+            size_t moves = 0;
+            const auto agents_start = std::chrono::steady_clock::now();
+            for (int step = 0; step < 16; step++) {
+                for (auto& [ax, ay] : agents) {
+                    const uint8_t dir = f.direction(ax, ay);
+                    if (dir == Field::NONE) continue;
+                    ax += Field::DIR_X[dir];
+                    ay += Field::DIR_Y[dir];
+                    moves++;
+                }
+            }
+            const double agents_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - agents_start).count();
+            timing.lookup_ns += agents_ns / (agents.size() * 16);
+            if (moves == 0) fail("no agent could move", size, mx, my);
+        }
+
+        timing.full_us /= maps;
+        timing.frame_us /= timing.frames;
+        timing.frames /= maps;
+        timing.lookup_ns /= maps;
+        return timing;
+    }
+
+    /// @brief Opening a wall through the overlay has to open a shorter way once the field is told
+    void checkOverlay() {
+        // a wall across the map with a single gap at the bottom
+        constexpr uint8_t size = 32;
+        std::vector<uint8_t> tiles(size * size, 0);
+        for (int x = 0; x < size; x++) {
+            for (int y = 0; y < size; y++) {
+                const bool border = x == 0 || y == 0 || x == size - 1 || y == size - 1;
+                const bool divider = x == size / 2 && y < size - 3;
+                if (border || divider) tiles[y + size * x] = 1;
+            }
+        }
+
+        TileOverlay overlay;
+        bound_map = MapView(size, size, tiles.data());
+        bound_map.overlay = &overlay;
+        field.mapChanged();
+
+        const MapView& map = bound_map;
+        completeSearch(field, 4, 4, Field::DEFAULT_BUDGET);
+        const uint16_t around = field.distance(size - 5, 4);
+
+        overlay.setTile(size / 2, 4, 0);
+        field.passabilityChanged();
+
+        // agents keep the old grid until the new search completes
+        field.update(4, 4, 1);
+        if (field.distance(size - 5, 4) != around) fail("grid changed before the search completed", size, size - 5, 4);
+
+        completeSearch(field, 4, 4, Field::DEFAULT_BUDGET);
+        checkField(map, field, 4, 4);
+        if (field.distance(size - 5, 4) >= around) fail("opened wall did not shorten the path", size, size - 5, 4);
+    }
+}
+
+int main(int argc, char** argv) {
+    const int maps = (argc > 1) ? atoi(argv[1]) : 4;
+    const unsigned seed = (argc > 2) ? static_cast<unsigned>(atoi(argv[2])) : 1234u;
+
+    std::mt19937 rng(seed);
+
+    printf("%-8s %10s %8s %10s %10s %10s\n", "map", "full_us", "frames", "frame_us", "worst_us", "lookup_ns");
+
+    for (uint8_t size : {32, 64, 128, 255}) {
+        const Timing t = checkSize(size, maps, rng);
+        printf("%3ux%-4u %10.1f %8u %10.2f %10.2f %10.2f\n", size, size, t.full_us, t.frames, t.frame_us, t.worst_us, t.lookup_ns);
+    }
+
+    checkOverlay();
+
+    if (failures > 0) {
+        printf("FAIL: %d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("PASS (budget %u tiles per update)\n", Field::DEFAULT_BUDGET);
+    return 0;
+}
@@ -0,0 +1,396 @@
+/**
+ * @file hot_path_report.cpp
+ * @brief Reports what the SRAM hot path build option relocates and what it buys.
+ *
+ * Usage:
+ *   hot_path_report map pico-raycaster.elf.map [baseline.elf.map]
+ *     Lists every function linked into SRAM through .time_critical sections,
+ *     grouped by object file, and the SRAM (.data + .bss) and flash (.text)
+ *     footprint. With a baseline map (built with the option off) the cost of
+ *     the option is printed as a difference.
+ *
+ *   hot_path_report bench log...
+ *     Averages the "BENCH ..." lines printed by a PICO_RAYCASTER_BENCHMARK
+ *     firmware per configuration and compares SRAM against XIP frame times.
+ *
+ *   hot_path_report kernels before.log after.log
+ *     Compares the "KERNEL ..." lines of two kernel suite runs (the host bench
+ *     tool or the pico-raycaster-bench firmware) kernel by kernel, in cycles
+ *     where both logs have them, otherwise in nanoseconds.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cxxabi.h>
+
+namespace {
+    // RP2350 main SRAM, SRAM0-9 including the scratch banks
+    constexpr uint64_t SRAM_BASE = 0x20000000;
+    constexpr uint64_t SRAM_END = 0x20082000;
+
+    struct Symbol {
+        uint64_t address;
+        std::string name;
+    };
+
+    struct InputSection {
+        std::string name;
+        std::string object;
+        uint64_t address;
+        uint64_t size;
+        std::vector<Symbol> symbols;
+    };
+
+    struct LinkMap {
+        std::vector<InputSection> sections;
+        std::map<std::string, uint64_t> output_sizes; // output section name -> size
+    };
+
+    bool parseHex(const std::string& token, uint64_t& value) {
+        if (token.size() < 3 || token[0] != '0' || token[1] != 'x') return false;
+
+        char* end = nullptr;
+        value = strtoull(token.c_str() + 2, &end, 16);
+        return *end == '\0';
+    }
+
+    std::vector<std::string> split(const std::string& line) {
+        std::vector<std::string> tokens;
+        std::istringstream stream(line);
+        std::string token;
+        while (stream >> token) tokens.push_back(token);
+        return tokens;
+    }
+
+    std::string demangle(const std::string& name) {
+        int status = 0;
+        std::unique_ptr<char, decltype(&free)> demangled(abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status), &free);
+        return (status == 0 && demangled) ? std::string(demangled.get()) : name;
+    }
+
+    std::string baseName(const std::string& path) {
+        const size_t slash = path.find_last_of('/');
+        return (slash == std::string::npos) ? path : path.substr(slash + 1);
+    }
+
+    /**
+     * @brief Parse the memory map part of a GNU ld map file
+     * @note Long section names are printed on their own line, the address, size and object follow on the next one
+     */
+    bool loadLinkMap(const char* path, LinkMap& link_map) {
+        FILE* f = fopen(path, "r");
+        if (f == nullptr) return false;
+
+        bool in_memory_map = false;
+        std::string pending_name;   // section name waiting for its address line
+        bool pending_output = false;
+        InputSection* current = nullptr;
+
+        char buffer[1024];
+        while (fgets(buffer, sizeof(buffer), f) != nullptr) {
+            const std::string line(buffer);
+
+            if (!in_memory_map) {
+                in_memory_map = line.rfind("Linker script and memory map", 0) == 0;
+                continue;
+            }
+
+            std::vector<std::string> tokens = split(line);
+            if (tokens.empty()) continue;
+
+            const bool output_line = line[0] == '.';
+            const bool input_line = line.size() > 1 && line[0] == ' ' && line[1] == '.';
+
+            if (output_line || input_line) {
+                pending_name = tokens[0];
+                pending_output = output_line;
+                tokens.erase(tokens.begin());
+                current = nullptr;
+
+                if (tokens.empty()) continue;
+            } else if (pending_name.empty()) {
+                // symbol inside the current input section: "0xADDRESS name"
+                uint64_t address;
+                if (current != nullptr && tokens.size() == 2 && parseHex(tokens[0], address)) {
+                    current->symbols.push_back(Symbol{address, tokens[1]});
+                }
+                continue;
+            }
+
+            uint64_t address, size;
+            if (tokens.size() < 2 || !parseHex(tokens[0], address) || !parseHex(tokens[1], size)) {
+                pending_name.clear();
+                continue;
+            }
+
+            if (pending_output) {
+                link_map.output_sizes[pending_name] += size;
+            } else if (size > 0 && tokens.size() >= 3) {
+                link_map.sections.push_back(InputSection{pending_name, tokens[2], address, size, {}});
+                current = &link_map.sections.back();
+            }
+
+            pending_name.clear();
+        }
+
+        fclose(f);
+
+        return in_memory_map;
+    }
+
+    bool isRelocatedCode(const InputSection& section) {
+        return section.name.rfind(".time_critical", 0) == 0 && section.address >= SRAM_BASE && section.address < SRAM_END;
+    }
+
+    uint64_t outputSize(const LinkMap& link_map, const char* name) {
+        auto it = link_map.output_sizes.find(name);
+        return (it == link_map.output_sizes.end()) ? 0 : it->second;
+    }
+
+    int reportMap(const char* path, const char* baseline_path) {
+        LinkMap link_map;
+        if (!loadLinkMap(path, link_map)) {
+            fprintf(stderr, "ERROR could not read link map %s\n", path);
+            return 1;
+        }
+
+        // group relocated sections by object file
+        std::map<std::string, std::vector<const InputSection*>> by_object;
+        uint64_t relocated_bytes = 0;
+
+        for (const InputSection& section : link_map.sections) {
+            if (!isRelocatedCode(section)) continue;
+
+            by_object[baseName(section.object)].push_back(&section);
+            relocated_bytes += section.size;
+        }
+
+        printf("relocated to SRAM:\n");
+
+        for (const auto& [object, sections] : by_object) {
+            uint64_t object_bytes = 0;
+            for (const InputSection* section : sections) object_bytes += section->size;
+
+            printf("  %-40s %6llu bytes\n", object.c_str(), static_cast<unsigned long long>(object_bytes));
+
+            for (const InputSection* section : sections) {
+                // symbol sizes from the distance to the next symbol, the last one runs to the section end
+                for (size_t i = 0; i < section->symbols.size(); i++) {
+                    const uint64_t end = (i + 1 < section->symbols.size()) ? section->symbols[i + 1].address : section->address + section->size;
+                    printf("    %6llu  %s\n", static_cast<unsigned long long>(end - section->symbols[i].address), demangle(section->symbols[i].name).c_str());
+                }
+            }
+        }
+
+        if (by_object.empty()) {
+            printf("  nothing, was the firmware built with PICO_RAYCASTER_SRAM_HOT_PATH=ON?\n");
+        }
+
+        const uint64_t sram = outputSize(link_map, ".data") + outputSize(link_map, ".bss");
+        const uint64_t flash = outputSize(link_map, ".text");
+
+        printf("relocated code:  %llu bytes\n", static_cast<unsigned long long>(relocated_bytes));
+        printf("sram .data+.bss: %llu bytes\n", static_cast<unsigned long long>(sram));
+        printf("flash .text:     %llu bytes\n", static_cast<unsigned long long>(flash));
+
+        if (baseline_path != nullptr) {
+            LinkMap baseline;
+            if (!loadLinkMap(baseline_path, baseline)) {
+                fprintf(stderr, "ERROR could not read link map %s\n", baseline_path);
+                return 1;
+            }
+
+            const uint64_t baseline_sram = outputSize(baseline, ".data") + outputSize(baseline, ".bss");
+            const uint64_t baseline_flash = outputSize(baseline, ".text");
+
+            printf("sram cost vs baseline:  %+lld bytes\n", static_cast<long long>(sram) - static_cast<long long>(baseline_sram));
+            printf("flash .text vs baseline: %+lld bytes\n", static_cast<long long>(flash) - static_cast<long long>(baseline_flash));
+        }
+
+        return 0;
+    }
+
+    // ---- benchmark logs ----
+
+    struct BenchTotals {
+        int laps = 0;
+        double mean_us = 0.0;
+        double render_us = 0.0;
+        double gfx_us = 0.0;
+        long min_us = 0;
+        long max_us = 0;
+    };
+
+    /// @brief Parse "BENCH key=value ..." (or any other tag) into a key value map
+    std::map<std::string, std::string> parseBenchLine(const char* line, const char* tag = "BENCH") {
+        std::map<std::string, std::string> fields;
+
+        for (const std::string& token : split(line + strlen(tag))) {
+            const size_t eq = token.find('=');
+            if (eq != std::string::npos) fields[token.substr(0, eq)] = token.substr(eq + 1);
+        }
+
+        return fields;
+    }
+
+    int reportBench(int log_count, char** log_paths) {
+        // keyed by temporal mode, then hot path placement
+        std::map<std::string, std::map<std::string, BenchTotals>> results;
+
+        for (int i = 0; i < log_count; i++) {
+            FILE* f = fopen(log_paths[i], "r");
+            if (f == nullptr) {
+                fprintf(stderr, "ERROR could not open %s\n", log_paths[i]);
+                return 1;
+            }
+
+            char line[512];
+            while (fgets(line, sizeof(line), f) != nullptr) {
+                const char* bench = strstr(line, "BENCH ");
+                if (bench == nullptr) continue;
+
+                auto fields = parseBenchLine(bench);
+                if (!fields.count("hot_path") || !fields.count("mean_us")) continue;
+
+                BenchTotals& totals = results[fields["temporal"]][fields["hot_path"]];
+                const long min_us = atol(fields["min_us"].c_str());
+                const long max_us = atol(fields["max_us"].c_str());
+
+                totals.mean_us += atof(fields["mean_us"].c_str());
+                totals.render_us += atof(fields["render_us"].c_str());
+                totals.gfx_us += atof(fields["gfx_us"].c_str());
+                totals.min_us = (totals.laps == 0 || min_us < totals.min_us) ? min_us : totals.min_us;
+                totals.max_us = (max_us > totals.max_us) ? max_us : totals.max_us;
+                totals.laps++;
+            }
+
+            fclose(f);
+        }
+
+        if (results.empty()) {
+            fprintf(stderr, "ERROR no BENCH lines found\n");
+            return 1;
+        }
+
+        printf("%-9s %-5s %5s %10s %10s %10s %8s %8s\n", "temporal", "code", "laps", "frame_us", "render_us", "gfx_us", "min_us", "max_us");
+
+        for (auto& [temporal, placements] : results) {
+            for (auto& [hot_path, totals] : placements) {
+                printf("%-9s %-5s %5d %10.0f %10.0f %10.0f %8ld %8ld\n", temporal.c_str(), hot_path.c_str(), totals.laps,
+                       totals.mean_us / totals.laps, totals.render_us / totals.laps, totals.gfx_us / totals.laps, totals.min_us, totals.max_us);
+            }
+
+            if (placements.count("xip") && placements.count("sram")) {
+                const BenchTotals& xip = placements["xip"];
+                const BenchTotals& sram = placements["sram"];
+
+                const double xip_frame = xip.mean_us / xip.laps;
+                const double sram_frame = sram.mean_us / sram.laps;
+                const double xip_render = xip.render_us / xip.laps;
+                const double sram_render = sram.render_us / sram.laps;
+
+                printf("temporal=%s: sram frame time %.1f%% of xip, render %.1f%% of xip\n", temporal.c_str(),
+                       100.0 * sram_frame / xip_frame, 100.0 * sram_render / xip_render);
+            }
+        }
+
+        return 0;
+    }
+
+    // ---- kernel suite logs ----
+
+    struct KernelResult {
+        std::string unit;
+        double ns_per_op = 0.0;
+        double cycles_per_op = -1.0; // none in host logs
+    };
+
+    /// @brief Fastest result per kernel name, a log can hold several runs of the suite
+    bool readKernels(const char* path, std::map<std::string, KernelResult>& kernels) {
+        FILE* f = fopen(path, "r");
+        if (f == nullptr) {
+            fprintf(stderr, "ERROR could not open %s\n", path);
+            return false;
+        }
+
+        char line[512];
+        while (fgets(line, sizeof(line), f) != nullptr) {
+            const char* kernel = strstr(line, "KERNEL ");
+            if (kernel == nullptr) continue;
+
+            auto fields = parseBenchLine(kernel, "KERNEL");
+            if (!fields.count("name") || !fields.count("ns_per_op")) continue;
+
+            KernelResult result;
+            result.unit = fields["unit"];
+            result.ns_per_op = atof(fields["ns_per_op"].c_str());
+            if (fields.count("cycles_per_op")) result.cycles_per_op = atof(fields["cycles_per_op"].c_str());
+
+            auto it = kernels.find(fields["name"]);
+            if (it == kernels.end() || result.ns_per_op < it->second.ns_per_op) kernels[fields["name"]] = result;
+        }
+
+        fclose(f);
+        return true;
+    }
+
+    int reportKernels(const char* before_path, const char* after_path) {
+        std::map<std::string, KernelResult> before, after;
+        if (!readKernels(before_path, before) || !readKernels(after_path, after)) return 1;
+
+        if (before.empty() || after.empty()) {
+            fprintf(stderr, "ERROR no KERNEL lines found\n");
+            return 1;
+        }
+
+        printf("%-20s %-8s %12s %12s %8s\n", "kernel", "unit", "before", "after", "change");
+
+        for (auto& [name, new_result] : after) {
+            auto it = before.find(name);
+            if (it == before.end()) {
+                printf("%-20s %-8s %12s %12.2f %8s\n", name.c_str(), new_result.unit.c_str(), "-", new_result.ns_per_op, "new");
+                continue;
+            }
+
+            const KernelResult& old_result = it->second;
+            const bool cycles = old_result.cycles_per_op >= 0.0 && new_result.cycles_per_op >= 0.0;
+            const double old_value = cycles ? old_result.cycles_per_op : old_result.ns_per_op;
+            const double new_value = cycles ? new_result.cycles_per_op : new_result.ns_per_op;
+
+            printf("%-20s %-8s %10.2f%-2s %10.2f%-2s %+7.1f%%\n", name.c_str(), new_result.unit.c_str(), old_value, cycles ? "cy" : "ns",
+                   new_value, cycles ? "cy" : "ns", (old_value > 0.0) ? 100.0 * (new_value - old_value) / old_value : 0.0);
+        }
+
+        for (auto& [name, old_result] : before) {
+            if (!after.count(name)) printf("%-20s %-8s %12.2f %12s %8s\n", name.c_str(), old_result.unit.c_str(), old_result.ns_per_op, "-", "gone");
+        }
+
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && strcmp(argv[1], "map") == 0) {
+        return reportMap(argv[2], (argc > 3) ? argv[3] : nullptr);
+    }
+    if (argc >= 3 && strcmp(argv[1], "bench") == 0) {
+        return reportBench(argc - 2, argv + 2);
+    }
+    if (argc == 4 && strcmp(argv[1], "kernels") == 0) {
+        return reportKernels(argv[2], argv[3]);
+    }
+
+    fprintf(stderr,
+        "usage: hot_path_report map FILE.elf.map [BASELINE.elf.map]\n"
+        "       hot_path_report bench LOG...\n"
+        "       hot_path_report kernels BEFORE.log AFTER.log\n");
+    return 2;
+}
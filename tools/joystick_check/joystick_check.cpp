@@ -0,0 +1,251 @@
+/**
+ * @file joystick_check.cpp
+ * @brief Host mock of the ADC round robin FIFO, driving the joystick filter the firmware runs in its interrupt.
+ *
+ * A mock ADC converts the two axes alternately like the free running round
+ * robin, with noise, an off centre rest position and optional failed
+ * conversions, and hands every FIFO word to JoystickSampler::pushSample().
+ * Checked: nothing but 0 comes out at rest or before calibration, full travel
+ * reaches exactly -1 and 1 on either side of an off centre rest, a step settles
+ * within a few milliseconds, a slow sweep gives a monotonic output, failed
+ * conversions and a resync after a lost word never swap the axes. Also times
+ * pushSample() and latest().
+ * Exits non-zero if any check fails.
+ *
+ * Usage: joystick_check [seed]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "joystick.hpp"
+
+namespace {
+    // the firmware wiring, y is on the lower ADC input so the round robin starts with it
+    constexpr JoystickSampler::Axis FIRST_AXIS = JoystickSampler::Y;
+
+    // conversions per millisecond, both axes, see AdcJoystick::SAMPLE_RATE_HZ
+    constexpr int WORDS_PER_MS = 2;
+
+    int failures = 0;
+
+    void fail(const char* what) {
+        if (failures++ < 10) fprintf(stderr, "FAIL %s\n", what);
+    }
+
+    /// @brief Raw stick position in ADC counts at a given conversion
+    using Stick = std::function<void(int word, int& x, int& y)>;
+
+    /**
+     * @class MockAdc
+     * @brief Free running round robin conversions of two inputs into a FIFO
+     */
+    class MockAdc {
+        public:
+            MockAdc(JoystickSampler& sampler, unsigned seed, int noise) : sampler_(sampler), rng_(seed), noise_(-noise, noise) {}
+
+            /// @brief Every n-th conversion fails, 0 for none
+            void setErrorEvery(int n) { error_every_ = n; }
+
+            /// @brief Convert count words, the sampler sees each one like the interrupt handler does
+            void run(int count, const Stick& stick) {
+                for (int i = 0; i < count; i++, word_++) {
+                    int x, y;
+                    stick(word_, x, y);
+
+                    const bool is_x = (next_axis_ == JoystickSampler::X);
+                    next_axis_ = is_x ? JoystickSampler::Y : JoystickSampler::X;
+
+                    int raw = (is_x ? x : y) + noise_(rng_);
+                    if (raw < 0) raw = 0;
+                    if (raw > JoystickSampler::ADC_MAX) raw = JoystickSampler::ADC_MAX;
+
+                    uint16_t fifo_word = static_cast<uint16_t>(raw);
+                    if (error_every_ > 0 && word_ % error_every_ == error_every_ - 1) fifo_word |= JoystickSampler::ERROR_BIT;
+
+                    sampler_.pushSample(fifo_word);
+                }
+            }
+
+            /// @brief A conversion lost to a FIFO overflow, the next word belongs to the other axis
+            void dropWord() {
+                next_axis_ = (next_axis_ == JoystickSampler::X) ? JoystickSampler::Y : JoystickSampler::X;
+                word_++;
+            }
+
+            /// @brief What the overflow handler does: restart the round robin on the first input
+            void resync() {
+                next_axis_ = FIRST_AXIS;
+                sampler_.resync();
+            }
+
+        private:
+            JoystickSampler& sampler_;
+            std::mt19937 rng_;
+            std::uniform_int_distribution<int> noise_;
+            JoystickSampler::Axis next_axis_ = FIRST_AXIS;
+            int error_every_ = 0;
+            int word_ = 0;
+    };
+
+    Stick hold(int x, int y) {
+        return [x, y](int, int& sx, int& sy) { sx = x; sy = y; };
+    }
+
+    void calibrate(JoystickSampler& sampler, MockAdc& adc, int rest_x, int rest_y) {
+        sampler.reset();
+        adc.resync();
+        adc.run(2 * JoystickSampler::CALIBRATION_SAMPLES, hold(rest_x, rest_y));
+        if (!sampler.calibrated()) fail("not calibrated after CALIBRATION_SAMPLES per axis");
+    }
+
+    void checkRest(unsigned seed) {
+        JoystickSampler sampler(FIRST_AXIS);
+        MockAdc adc(sampler, seed, 60);
+
+        adc.run(2 * JoystickSampler::CALIBRATION_SAMPLES - 2, hold(4095, 0));
+        if (sampler.latest().x != 0 || sampler.latest().y != 0) fail("output before calibration");
+
+        calibrate(sampler, adc, 1980, 2110);
+        for (int i = 0; i < 20000; i++) {
+            adc.run(1, hold(1980, 2110));
+            if (sampler.latest().x != 0 || sampler.latest().y != 0) {
+                fail("noise at rest got past the deadzone");
+                break;
+            }
+        }
+    }
+
+    void checkFullTravel(unsigned seed) {
+        JoystickSampler sampler(FIRST_AXIS);
+        MockAdc adc(sampler, seed, 20);
+
+        // off centre rest, each side still has to reach full scale
+        calibrate(sampler, adc, 1800, 2300);
+
+        adc.run(200, hold(JoystickSampler::ADC_MAX, 0));
+        if (sampler.latest().x != 1 || sampler.latest().y != -1) fail("full travel does not reach (1, -1)");
+
+        adc.run(200, hold(0, JoystickSampler::ADC_MAX));
+        if (sampler.latest().x != -1 || sampler.latest().y != 1) fail("full travel does not reach (-1, 1)");
+
+        // half way past the deadzone on the short side
+        constexpr int dead = JoystickSampler::DEADZONE;
+        constexpr int span = 1800 - dead - JoystickSampler::EDGE_ZONE;
+        adc.run(200, hold(1800 - dead - span / 2, 2300));
+        const Fixed15_16 half = sampler.latest().x;
+        if (half > -0.45_fp || half < -0.55_fp) fail("half travel is not about -0.5");
+    }
+
+    /// @brief Milliseconds until a full push on x reads above 0.9
+    int stepResponse(unsigned seed) {
+        JoystickSampler sampler(FIRST_AXIS);
+        MockAdc adc(sampler, seed, 20);
+        calibrate(sampler, adc, 2048, 2048);
+
+        for (int ms = 1; ms <= 100; ms++) {
+            adc.run(WORDS_PER_MS, hold(JoystickSampler::ADC_MAX, 2048));
+            if (sampler.latest().x > 0.9_fp) return ms;
+        }
+
+        fail("step never settled");
+        return 100;
+    }
+
+    void checkSweep(unsigned seed) {
+        JoystickSampler sampler(FIRST_AXIS);
+        MockAdc adc(sampler, seed, 0);
+        calibrate(sampler, adc, 2048, 2048);
+
+        // x from one end to the other over 4 seconds, y stays put
+        Fixed15_16 last(-1);
+        for (int raw = 0; raw <= JoystickSampler::ADC_MAX; raw++) {
+            adc.run(2, hold(raw, 2048));
+
+            const JoystickState state = sampler.latest();
+            if (raw > 64 && state.x < last) {
+                fail("sweep output not monotonic");
+                break;
+            }
+            if (state.y != 0) {
+                fail("sweeping x moved y");
+                break;
+            }
+            last = state.x;
+        }
+    }
+
+    void checkErrorsAndResync(unsigned seed) {
+        JoystickSampler sampler(FIRST_AXIS);
+        MockAdc adc(sampler, seed, 20);
+        calibrate(sampler, adc, 2048, 2048);
+
+        // x pushed, y at rest, with failed conversions of both axes mixed in
+        adc.setErrorEvery(7);
+        adc.run(2000, hold(JoystickSampler::ADC_MAX, 2048));
+        if (sampler.latest().x != 1 || sampler.latest().y != 0) fail("failed conversions swapped or moved the axes");
+        if (sampler.errorCount() == 0) fail("failed conversions were not counted");
+        adc.setErrorEvery(0);
+
+        // a lost word swaps the axes until the handler resyncs
+        adc.dropWord();
+        adc.run(200, hold(JoystickSampler::ADC_MAX, 2048));
+        if (sampler.latest().y == 0) fail("a lost word did not swap the axes, the mock is wrong");
+
+        adc.resync();
+        adc.run(200, hold(JoystickSampler::ADC_MAX, 2048));
+        if (sampler.latest().x != 1 || sampler.latest().y != 0) fail("resync did not realign the axes");
+    }
+
+    void timing(unsigned seed, double& push_ns, double& read_ns) {
+        constexpr int WORDS = 1 << 22;
+
+        JoystickSampler sampler(FIRST_AXIS);
+        MockAdc adc(sampler, seed, 20);
+        calibrate(sampler, adc, 2048, 2048);
+
+        std::vector<uint16_t> words(WORDS);
+        std::mt19937 rng(seed);
+        for (uint16_t& w : words) w = static_cast<uint16_t>(rng() & JoystickSampler::ADC_MAX);
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint16_t w : words) sampler.pushSample(w);
+        push_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / WORDS;
+
+        int64_t sum = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < WORDS; i++) sum += sampler.latest().x.toRaw();
+        read_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / WORDS;
+
+        if (sum == INT64_MIN) fail("unreachable, keeps the reads");
+    }
+}
+
+int main(int argc, char** argv) {
+    const unsigned seed = (argc > 1) ? static_cast<unsigned>(atoi(argv[1])) : 1234u;
+
+    checkRest(seed);
+    checkFullTravel(seed);
+    const int settle_ms = stepResponse(seed);
+    checkSweep(seed);
+    checkErrorsAndResync(seed);
+
+    double push_ns, read_ns;
+    timing(seed, push_ns, read_ns);
+
+    printf("step settles in:  %d ms at %d Hz per axis\n", settle_ms, WORDS_PER_MS * 1000 / 2);
+    printf("pushSample:       %.1f ns\n", push_ns);
+    printf("latest:           %.1f ns\n", read_ns);
+
+    if (failures > 0) {
+        printf("FAIL: %d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file level_switch.cpp
+ * @brief Times switching between the levels of a level archive.
+ *
+ * Cycles through every level of the archive, doing what the firmware does on
+ * a switch (bind the level, rebuild the minimap, drop the temporal history)
+ * and rendering one frame afterwards. Reports the time of each step per level.
+ *
+ * Usage: level_switch [levels.xip] [cycles]
+ * Without an archive path the linked assets/levels.xip is used, otherwise
+ * the file is memory mapped.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "asset_validation.hpp"
+#include "hud.hpp"
+#include "level_archive.hpp"
+#include "mapped_file.hpp"
+#include "renderer.hpp"
+#include "temporal.hpp"
+
+namespace {
+    struct StepTimes {
+        double total = 0.0;
+        double worst = 0.0;
+
+        void add(double us) {
+            total += us;
+            if (us > worst) worst = us;
+        }
+    };
+
+    struct LevelTimes {
+        StepTimes bind;
+        StepTimes hud;
+        StepTimes first_frame;
+    };
+
+    double microsecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /// @brief A copy of the archive with level 0's map or texture set magic broken must not bind
+    bool refusesCorruptLevel(const uint8_t* data, size_t size, bool corrupt_map) {
+        std::vector<uint8_t> copy(data, data + size);
+        const LevelArchive archive(copy.data());
+        const Level level = archive.getLevel(0);
+
+        const uint8_t* blob = corrupt_map ? level.map_blob : level.texture_blob;
+        copy[static_cast<size_t>(blob - copy.data())] ^= 0xFF; // first magic byte
+
+        const uint8_t* bound = reinterpret_cast<const uint8_t*>(TextureManager::getHeader());
+        MapView map(0, 0, nullptr);
+        const bool refused = !archive.getLevel(0).isValid() && !bindLevel(archive.getLevel(0), map);
+
+        return refused && reinterpret_cast<const uint8_t*>(TextureManager::getHeader()) == bound && map.tile_data == nullptr;
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* archive_path = (argc > 1) ? argv[1] : nullptr;
+    const int cycles = (argc > 2) ? atoi(argv[2]) : 200;
+
+    MappedFile file;
+    const uint8_t* data = levels_xip_blob;
+    size_t size = static_cast<size_t>(levels_xip_blob_end - levels_xip_blob);
+
+    if (archive_path != nullptr) {
+        file = MappedFile(archive_path);
+        data = file.data();
+        size = file.size();
+    }
+
+    if (data == nullptr || !validateLevelArchive(data, size)) {
+        fprintf(stderr, "ERROR invalid level archive: %s\n", archive_path ? archive_path : "(linked)");
+        return 1;
+    }
+
+    const LevelArchive archive(data);
+    const uint32_t level_count = archive.levelCount();
+
+    // the renderer state lives across switches like it does in the firmware
+    if (!refusesCorruptLevel(data, size, true) || !refusesCorruptLevel(data, size, false)) {
+        fprintf(stderr, "ERROR a level with a corrupt map or texture set was bound\n");
+        return 1;
+    }
+
+    MapView map(0, 0, nullptr);
+    for (uint32_t i = 0; i < level_count; i++) {
+        if (!archive.getLevel(i).isValid()) {
+            fprintf(stderr, "ERROR level %u (%s) has an invalid map or texture set\n", i, archive.getLevel(i).name);
+            return 1;
+        }
+    }
+
+    bindLevel(archive.getLevel(0), map);
+    PlayerData player = *getPlayerData(archive.getLevel(0).map_blob);
+
+    HudOverlay hud(map, SCREEN_WIDTH);
+    TemporalRenderer temporal(map);
+    temporal.setEnabled(true);
+
+    static uint16_t frame[SCREEN_WIDTH * SCREEN_HEIGHT];
+    std::vector<LevelTimes> times(level_count);
+
+    for (int cycle = 0; cycle < cycles; cycle++) {
+        for (uint32_t i = 0; i < level_count; i++) {
+            const Level level = archive.getLevel(i);
+
+            auto start = std::chrono::steady_clock::now();
+            bindLevel(level, map);
+            player = *getPlayerData(level.map_blob);
+            temporal.invalidate();
+            times[i].bind.add(microsecondsSince(start));
+
+            start = std::chrono::steady_clock::now();
+            hud.mapChanged();
+            hud.update(player, 0, 0);
+            hud.flush();
+            times[i].hud.add(microsecondsSince(start));
+
+            start = std::chrono::steady_clock::now();
+            temporal.beginFrame(Camera::fromPlayer(player));
+            for (uint8_t c = 0; c < SCREEN_WIDTH; c++) {
+                const uint8_t x = temporal.columnAt(c);
+                uint16_t* column = &frame[x * SCREEN_HEIGHT];
+                temporal.renderColumn(x, column);
+                hud.composite(x, column);
+            }
+            times[i].first_frame.add(microsecondsSince(start));
+        }
+    }
+
+    printf("archive:  %s, %zu bytes, %u levels\n", archive_path ? archive_path : "(linked)", size, level_count);
+    printf("cycles:   %d\n", cycles);
+    printf("%-20s %8s %8s %8s %8s %10s %10s\n", "level", "size", "bind_us", "worst", "hud_us", "worst", "frame_us");
+
+    for (uint32_t i = 0; i < level_count; i++) {
+        const Level level = archive.getLevel(i);
+        const MapView view = createMapView(level.map_blob);
+
+        printf("%-20s %3dx%-4d %8.2f %8.2f %8.2f %10.2f %10.2f\n", level.name, view.width, view.height,
+               times[i].bind.total / cycles, times[i].bind.worst,
+               times[i].hud.total / cycles, times[i].hud.worst,
+               times[i].first_frame.total / cycles);
+    }
+
+    return 0;
+}
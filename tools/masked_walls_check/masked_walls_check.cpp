@@ -0,0 +1,308 @@
+/**
+ * @file masked_walls_check.cpp
+ * @brief Checks walls seen through masked (colour keyed) texture columns and times them against opaque ones.
+ *
+ * The embedded texture set is copied with a grate punched into the textures
+ * of the inner wall tile the walk sees most, and once more with a grate in every
+ * texture, so rays pass more walls than MAX_MASKED_LAYERS. A scripted walk
+ * through the embedded map is rendered with renderColumn() and the
+ * TemporalRenderer (through a column cache), and compared with a per pixel
+ * reference that walks the ray and composites the walls back to front.
+ * Checked: frames are identical, the column masks
+ * flag exactly the columns with key texels, opaque columns of masked
+ * textures stay on the single hit path, no column draws more than
+ * MAX_MASKED_LAYERS walls, and the opaque sets have no masks.
+ * Exits non-zero if any check fails.
+ *
+ * Usage: masked_walls_check [frames]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numbers>
+#include <vector>
+
+#include "column_cache.hpp"
+#include "map_data.hpp"
+#include "raycast.hpp"
+#include "renderer.hpp"
+#include "temporal.hpp"
+#include "textures.hpp"
+
+namespace {
+    constexpr size_t FRAME_PIXELS = static_cast<size_t>(SCREEN_WIDTH) * SCREEN_HEIGHT;
+    constexpr uint16_t COLOR_KEY = panelColor(0xF81F); // magenta
+
+    int failures = 0;
+
+    void fail(const char* what) {
+        if (failures++ < 10) fprintf(stderr, "FAIL %s\n", what);
+    }
+
+    /// @brief Walk, turn and strafe through the map with simple collision
+    std::vector<Camera> scriptedPath(const MapView& map, const PlayerData& start, int frames) {
+        std::vector<Camera> path;
+        double x = start.pos_x.toFloat(), y = start.pos_y.toFloat();
+        double angle = std::atan2(start.dir_y.toFloat(), start.dir_x.toFloat());
+
+        for (int i = 0; i < frames; i++) {
+            double move = 0.0, turn = 0.0;
+            switch ((i / 60) % 3) {
+                case 0: move = 0.05; break;
+                case 1: turn = 3.0; break;
+                case 2: move = 0.04; turn = -1.5; break;
+            }
+
+            angle += turn * std::numbers::pi / 180.0;
+            const double lx = x + std::cos(angle) * move * 10.0;
+            const double ly = y + std::sin(angle) * move * 10.0;
+            if (map.getTile(static_cast<uint8_t>(lx), static_cast<uint8_t>(y)) == 0) x += std::cos(angle) * move;
+            if (map.getTile(static_cast<uint8_t>(x), static_cast<uint8_t>(ly)) == 0) y += std::sin(angle) * move;
+
+            const PlayerData player{Fixed15_16(static_cast<float>(x)), Fixed15_16(static_cast<float>(y)),
+                                    Fixed15_16(static_cast<float>(std::cos(angle))), Fixed15_16(static_cast<float>(std::sin(angle)))};
+            path.push_back(Camera::fromPlayer(player));
+        }
+
+        return path;
+    }
+
+    /// @brief Wall tile the walk sees most off the map's border, the outer walls keep the rays inside
+    uint8_t mostSeenInnerTile(const MapView& map, const std::vector<Camera>& path) {
+        uint32_t counts[256] = {};
+        for (const Camera& camera : path) {
+            for (uint16_t x = 0; x < SCREEN_WIDTH; x++) {
+                const RayHit hit = castRay(map, cameraRay(camera, static_cast<uint8_t>(x)));
+                const bool border = hit.map_x <= 0 || hit.map_y <= 0 || hit.map_x + 1 >= map.width || hit.map_y + 1 >= map.height;
+                if (!border) counts[hit.tile]++;
+            }
+        }
+        counts[0] = 0;
+
+        return static_cast<uint8_t>(std::max_element(counts, counts + 256) - counts);
+    }
+
+    /**
+     * @brief Copy of the bound blob with every texture stored, a grate punched into a tile's textures and column masks
+     * @param tile Wall tile whose textures get the grate, 0 for every texture, -1 for an opaque copy without masks
+     */
+    std::vector<uint8_t> storedTextures(int16_t tile) {
+        TextureFileHeader header = *TextureManager::getHeader();
+        const uint32_t count = header.tex_count;
+
+        const uint32_t data_offset = static_cast<uint32_t>(sizeof(TextureFileHeader) + count * sizeof(uint32_t));
+        const uint32_t mask_offset = data_offset + count * TEX_SIZE * TEX_SIZE * sizeof(uint16_t);
+        std::vector<uint8_t> blob(mask_offset + count * sizeof(uint64_t));
+
+        header.color_key = COLOR_KEY;
+        header.mask_offset = (tile >= 0) ? mask_offset : 0;
+        memcpy(blob.data(), &header, sizeof(header));
+
+        uint16_t scratch[TEX_SIZE];
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t offset = data_offset + i * TEX_SIZE * TEX_SIZE * sizeof(uint16_t);
+            memcpy(blob.data() + sizeof(TextureFileHeader) + i * sizeof(uint32_t), &offset, sizeof(offset));
+
+            const uint32_t id = i;
+            const bool grate = tile == 0 || (tile > 0 && (id + 1 == static_cast<uint32_t>(tile) || id == static_cast<uint32_t>(tile)));
+
+            uint16_t* dst = reinterpret_cast<uint16_t*>(blob.data() + offset);
+            uint64_t mask = 0;
+
+            for (uint8_t x = 0; x < TEX_SIZE; x++) {
+                memcpy(&dst[x * TEX_SIZE], TextureManager::getTextureColumn(i, x, TEX_LOG2_SIZE, scratch), TEX_SIZE * sizeof(uint16_t));
+
+                // vertical bars every 16 columns stay opaque, the columns between them get holes
+                for (uint8_t y = 0; y < TEX_SIZE; y++) {
+                    if (grate && (x & 15) >= 4 && (y & 15) >= 4) dst[x * TEX_SIZE + y] = COLOR_KEY;
+                    if (dst[x * TEX_SIZE + y] == COLOR_KEY) mask |= 1ULL << x;
+                }
+            }
+
+            memcpy(blob.data() + mask_offset + i * sizeof(uint64_t), &mask, sizeof(mask));
+        }
+
+        return blob;
+    }
+
+    /// @brief A masked blob is refused with another format version or with its masks cut off
+    void checkHeaderValidation(std::vector<uint8_t> blob) {
+        if (!TextureManager::isValid(blob.data(), blob.size())) fail("masked texture set is not valid");
+        if (TextureManager::isValid(blob.data(), blob.size() - 1)) fail("texture set with truncated masks is valid");
+
+        TextureFileHeader header;
+        memcpy(&header, blob.data(), sizeof(header));
+        header.version = TextureFileHeader::VERSION - 1;
+        memcpy(blob.data(), &header, sizeof(header));
+        if (TextureManager::isValid(blob.data(), blob.size())) fail("texture set of an older version is valid");
+    }
+
+    /// @brief The bound masks flag exactly the columns holding the key
+    void checkMasks() {
+        const uint32_t count = TextureManager::getHeader()->tex_count;
+        uint16_t scratch[TEX_SIZE];
+
+        for (uint32_t i = 0; i < count; i++) {
+            for (uint8_t x = 0; x < TEX_SIZE; x++) {
+                const uint16_t* column = TextureManager::getTextureColumn(static_cast<uint16_t>(i), x, TEX_LOG2_SIZE, scratch);
+                const bool keyed = std::find(column, column + TEX_SIZE, COLOR_KEY) != column + TEX_SIZE;
+
+                if (TextureManager::isColumnMasked(static_cast<uint16_t>(i), x) != keyed) fail("column mask differs from the texels");
+            }
+        }
+    }
+
+    /// @brief Rows of a wall the fill kernels draw, leaving key texels, stepped one pixel at a time
+    void compositeWall(const RayHit& hit, uint16_t* column) {
+        uint16_t scratch[TEX_SIZE];
+        const uint16_t* tex_column = TextureManager::getTextureColumn(DefaultColumnRenderer::wallTexture(hit), hit.tex_x, TEX_LOG2_SIZE, scratch);
+
+        const int16_t line_height = lineHeight(hit.distance);
+        int16_t draw_start, draw_end;
+        DefaultColumnRenderer::wallRows(line_height, draw_start, draw_end);
+
+        const Fixed15_16 step = TEX_SIZE_FP / Fixed15_16(line_height);
+        const int16_t wall_top = (SCREEN_HEIGHT - line_height) >> 1;
+        int32_t pos = ((draw_start - wall_top) * step).toRaw();
+
+        for (int16_t y = draw_start; y < draw_end; y++) {
+            const uint16_t texel = tex_column[(pos >> 16) & TEX_MASK];
+            if (texel != COLOR_KEY) column[y] = texel;
+            pos += step.toRaw();
+        }
+    }
+
+    /**
+     * @brief Reference column, every wall up to the first opaque column or the layer limit, farthest first
+     * @return Walls drawn
+     */
+    uint8_t referenceColumn(const MapView& map, const Ray& ray, uint16_t* column) {
+        RayWalk walk(map, ray);
+        std::vector<RayHit> hits;
+
+        for (RayHit hit = walk.next(); hit.tile != 0 && hits.size() < MAX_MASKED_LAYERS; hit = walk.next()) {
+            hits.push_back(hit);
+
+            uint16_t scratch[TEX_SIZE];
+            const uint16_t* tex_column = TextureManager::getTextureColumn(DefaultColumnRenderer::wallTexture(hit), hit.tex_x, TEX_LOG2_SIZE, scratch);
+            if (std::find(tex_column, tex_column + TEX_SIZE, COLOR_KEY) == tex_column + TEX_SIZE) break;
+        }
+
+        for (auto it = hits.rbegin(); it != hits.rend(); ++it) compositeWall(*it, column);
+
+        return static_cast<uint8_t>(hits.size());
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /// @brief Every renderer against the reference with the bound blob, returns renderColumn() us per frame
+    double checkFrames(const char* name, const MapView& map, const std::vector<Camera>& path) {
+        std::vector<uint16_t> expected(FRAME_PIXELS), frame(FRAME_PIXELS);
+        uint32_t histogram[MAX_MASKED_LAYERS + 1] = {};
+        uint64_t single_hit_columns = 0;
+
+        TemporalRenderer temporal(map);
+        static ColumnCache cache;
+        cache.clear();
+        temporal.setColumnCache(&cache);
+
+        for (const Camera& camera : path) {
+            std::fill(expected.begin(), expected.end(), 0);
+            for (uint16_t x = 0; x < SCREEN_WIDTH; x++) {
+                const Ray ray = cameraRay(camera, static_cast<uint8_t>(x));
+                const uint8_t layers = referenceColumn(map, ray, &expected[x * SCREEN_HEIGHT]);
+                histogram[layers]++;
+
+                // the single hit path is what opaque columns of a masked texture take
+                uint8_t drawn;
+                uint16_t column[SCREEN_HEIGHT] = {};
+                renderMaskedLayers(map, ray, column, drawn);
+                if (drawn != layers) fail("walls drawn differ from the reference");
+
+                const RayHit hit = castRay(map, ray);
+                const bool single_hit = !DefaultColumnRenderer::isMasked(hit);
+                single_hit_columns += hit.tile != 0 && single_hit;
+                if (single_hit && layers != (hit.tile != 0)) fail("opaque column looked past its wall");
+            }
+
+            std::fill(frame.begin(), frame.end(), 0);
+            for (uint16_t x = 0; x < SCREEN_WIDTH; x++) renderColumn(map, camera, static_cast<uint8_t>(x), &frame[x * SCREEN_HEIGHT]);
+            if (frame != expected) fail("renderColumn frame differs from the reference");
+
+            std::fill(frame.begin(), frame.end(), 0);
+            temporal.beginFrame(camera);
+            for (uint16_t i = 0; i < SCREEN_WIDTH; i++) {
+                const uint8_t x = temporal.columnAt(static_cast<uint8_t>(i));
+                temporal.renderColumn(x, &frame[x * SCREEN_HEIGHT]);
+            }
+            if (frame != expected) fail("temporal renderer frame differs from the reference");
+        }
+
+        // timed once the textures are warm
+        const auto start = std::chrono::steady_clock::now();
+        for (const Camera& camera : path) {
+            for (uint16_t x = 0; x < SCREEN_WIDTH; x++) renderColumn(map, camera, static_cast<uint8_t>(x), &frame[x * SCREEN_HEIGHT]);
+        }
+        const double seconds = secondsSince(start);
+
+        const double columns = static_cast<double>(path.size()) * SCREEN_WIDTH;
+        printf("%-8s %5.1f%% single hit, walls per column:", name, 100.0 * single_hit_columns / columns);
+        for (uint8_t layers = 0; layers <= MAX_MASKED_LAYERS; layers++) printf(" %u:%.1f%%", layers, 100.0 * histogram[layers] / columns);
+        printf("\n");
+
+        return 1e6 * seconds / static_cast<double>(path.size());
+    }
+}
+
+int main(int argc, char** argv) {
+    const int frames = (argc > 1) ? atoi(argv[1]) : 240;
+    const size_t linked_size = static_cast<size_t>(textures_xip_blob_end - textures_xip_blob);
+
+    TextureManager::setBlob(textures_xip_blob, linked_size);
+    if (!TextureManager::isValid() || !isMapDataValid()) {
+        printf("ERROR embedded asset data invalid\n");
+        return 1;
+    }
+    if (TextureManager::hasMasks()) fail("embedded texture set has masks");
+
+    const MapView map = createMapView();
+    const std::vector<Camera> path = scriptedPath(map, *getPlayerData(), frames);
+    const uint8_t tile = mostSeenInnerTile(map, path);
+
+    const std::vector<uint8_t> opaque = storedTextures(-1);
+    const std::vector<uint8_t> grate = storedTextures(tile);
+    const std::vector<uint8_t> every = storedTextures(0);
+    checkHeaderValidation(every);
+
+    // the same stored textures for all three, procedural columns would skew the timing
+    TextureManager::setBlob(opaque.data(), opaque.size());
+    if (TextureManager::hasMasks()) fail("opaque texture set has masks");
+    const double opaque_us = checkFrames("opaque", map, path);
+
+    TextureManager::setBlob(grate.data(), grate.size());
+    checkMasks();
+    const double grate_us = checkFrames("grate", map, path);
+
+    TextureManager::setBlob(every.data(), every.size());
+    checkMasks();
+    const double every_us = checkFrames("every", map, path);
+
+    TextureManager::setBlob(textures_xip_blob, linked_size);
+
+    printf("grate on tile %u, renderColumn %.1f us/frame opaque, %.1f grate, %.1f every wall masked (limit %u walls)\n",
+           tile, opaque_us, grate_us, every_us, MAX_MASKED_LAYERS);
+
+    if (failures > 0) {
+        printf("FAIL: %d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
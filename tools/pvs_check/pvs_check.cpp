@@ -0,0 +1,555 @@
+/**
+ * @file pvs_check.cpp
+ * @brief Checks the potentially visible sets baked by the asset packer, and what building and using them costs.
+ *
+ * Sets are built for the embedded map (doors and wall heights as packed) and
+ * for a synthetic 64x64 map of rooms, packed into a map blob by hand and bound
+ * with createMapView(). Checked: every wall castRay() hits and every wall a
+ * RayWalk passes before a full height wall, from random poses, is in the set
+ * of the pose's tile, as is every tile with a line of sight to it; culling
+ * entities with the set finds exactly what culling without it finds; every
+ * texture a wall is drawn with is among the set's face textures, which match
+ * a scan of the map; and the validator rejects broken sections. Build time, section size, the cost of
+ * decoding a set on a tile crossing, isVisible() lookups and entity culling
+ * with and without the set, and the face texture scan the baked lists replace
+ * are printed.
+ * Exits non-zero if any check fails.
+ *
+ * Usage: pvs_check [pose_count] [seed]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "asset_validation.hpp"
+#include "entities.hpp"
+#include "map_data.hpp"
+#include "pvs.hpp"
+#include "pvs_builder.hpp"
+#include "raycast.hpp"
+#include "renderer.hpp"
+#include "textures.hpp"
+
+namespace {
+    constexpr uint8_t ROOMS_SIZE = 64;
+    constexpr uint8_t ROOM_SIZE = 8;
+    constexpr uint16_t ENTITY_COUNT = 4000;
+
+    using Store = EntityStore<ENTITY_COUNT, ROOMS_SIZE * ROOMS_SIZE>;
+
+    int failures = 0;
+
+    void fail(const char* what) {
+        if (failures++ < 10) fprintf(stderr, "FAIL %s\n", what);
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /// @brief Closed map of ROOM_SIZE rooms, each wall between two rooms has one doorway, column major like the map blob
+    std::vector<uint8_t> makeRooms(std::mt19937& rng) {
+        std::vector<uint8_t> tiles(ROOMS_SIZE * ROOMS_SIZE, 0);
+        std::uniform_int_distribution<int> gap(1, ROOM_SIZE - 2);
+
+        for (uint8_t x = 0; x < ROOMS_SIZE; x++) {
+            for (uint8_t y = 0; y < ROOMS_SIZE; y++) {
+                const bool border = x == ROOMS_SIZE - 1 || y == ROOMS_SIZE - 1;
+                if (border || x % ROOM_SIZE == 0 || y % ROOM_SIZE == 0) {
+                    tiles[y + ROOMS_SIZE * x] = 1 + (x / ROOM_SIZE + y / ROOM_SIZE) % 8;
+                }
+            }
+        }
+
+        // a doorway in the wall right of and below every room
+        for (uint8_t rx = 0; rx + ROOM_SIZE < ROOMS_SIZE; rx += ROOM_SIZE) {
+            for (uint8_t ry = 0; ry + ROOM_SIZE < ROOMS_SIZE; ry += ROOM_SIZE) {
+                tiles[(ry + gap(rng)) + ROOMS_SIZE * (rx + ROOM_SIZE)] = 0;
+                tiles[(ry + ROOM_SIZE) + ROOMS_SIZE * (rx + gap(rng))] = 0;
+            }
+        }
+
+        return tiles;
+    }
+
+    struct SourceMap {
+        uint8_t width;
+        uint8_t height;
+        std::vector<uint8_t> tiles;
+        std::vector<uint8_t> heights;
+        std::vector<DoorData> doors;
+        PlayerData player;
+    };
+
+    template <typename T>
+    void append(std::vector<uint8_t>& out, const T* data, size_t count) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        out.insert(out.end(), bytes, bytes + count * sizeof(T));
+    }
+
+    void align(std::vector<uint8_t>& out, size_t alignment) {
+        out.resize((out.size() + alignment - 1) / alignment * alignment, 0);
+    }
+
+    /// @brief Map blob with doors, wall heights and a PVS section, laid out like the asset packer lays it out
+    std::vector<uint8_t> packMap(const SourceMap& map, const std::vector<uint8_t>& pvs) {
+        std::vector<uint8_t> blob(sizeof(MapFileHeader), 0);
+        MapFileHeader header{MapFileHeader::VALID_MAGIC, MapFileHeader::VERSION, 0, 0, 0, 0, 0, 0};
+
+        header.playerdata_offset = static_cast<uint32_t>(blob.size());
+        append(blob, &map.player, 1);
+
+        header.mapdata_offset = static_cast<uint32_t>(blob.size());
+        blob.push_back(map.width);
+        blob.push_back(map.height);
+        append(blob, map.tiles.data(), map.tiles.size());
+
+        if (!map.doors.empty()) {
+            align(blob, 4);
+            header.doors_offset = static_cast<uint32_t>(blob.size());
+            const uint32_t count = static_cast<uint32_t>(map.doors.size());
+            append(blob, &count, 1);
+            append(blob, map.doors.data(), map.doors.size());
+        }
+
+        if (!map.heights.empty()) {
+            header.heights_offset = static_cast<uint32_t>(blob.size());
+            append(blob, map.heights.data(), map.heights.size());
+        }
+
+        align(blob, 4);
+        header.pvs_offset = static_cast<uint32_t>(blob.size());
+        append(blob, pvs.data(), pvs.size());
+
+        memcpy(blob.data(), &header, sizeof(header));
+        return blob;
+    }
+
+    std::vector<uint8_t> build(const SourceMap& map, const char* name) {
+        PvsBuildStats stats;
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<uint8_t> section = buildPvs(map.width, map.height, map.tiles, map.heights, map.doors, PvsBuildOptions{}, &stats);
+        const double seconds = secondsSince(start);
+
+        printf("%-9s %2ux%-2u  %4u sets  %6.1f visible  %7zu bytes  %7zu plain  %7.1f ms build\n", name, map.width, map.height,
+               stats.sets, stats.sets ? static_cast<double>(stats.visible_tiles) / stats.sets : 0.0, stats.packed_bytes,
+               stats.raw_bytes, 1e3 * seconds);
+
+        return section;
+    }
+
+    /// @brief Open tile picked at random and a pose inside it
+    PlayerData randomPose(const MapView& map, std::mt19937& rng) {
+        std::uniform_int_distribution<int> tile_x(0, map.width - 1);
+        std::uniform_int_distribution<int> tile_y(0, map.height - 1);
+        std::uniform_real_distribution<float> offset(0.02f, 0.98f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+        int tx, ty;
+        do {
+            tx = tile_x(rng);
+            ty = tile_y(rng);
+        } while (map.getTile(tx, ty) != 0);
+
+        const float a = angle(rng);
+        return PlayerData{Fixed15_16(tx + offset(rng)), Fixed15_16(ty + offset(rng)), Fixed15_16(std::cos(a)), Fixed15_16(std::sin(a))};
+    }
+
+    /// @brief Everything the renderer and a line of sight can reach from random poses lies in the pose's set
+    void checkConservative(const MapView& map, int pose_count, std::mt19937& rng, const char* name) {
+        PotentiallyVisibleSet pvs(map);
+        std::uniform_int_distribution<int> tile_x(0, map.width - 1);
+        std::uniform_int_distribution<int> tile_y(0, map.height - 1);
+        std::uniform_real_distribution<float> offset(0.0f, 1.0f);
+
+        uint32_t missed_hits = 0, missed_sight = 0;
+
+        for (int p = 0; p < pose_count; p++) {
+            const PlayerData pose = randomPose(map, rng);
+            pvs.update(pose.pos_x.toInt(), pose.pos_y.toInt());
+            if (!pvs.active()) {
+                fail("open tile without a set");
+                return;
+            }
+
+            const Camera camera = Camera::fromPlayer(pose);
+            for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+                const Ray ray = cameraRay(camera, x);
+
+                // walls behind lower ones show above them, up to the first full height wall
+                RayWalk walk(map, ray);
+                for (RayHit hit = walk.next(); hit.tile != 0; hit = walk.next()) {
+                    missed_hits += !pvs.isVisible(hit.map_x, hit.map_y);
+                    if (map.getWallHeight(hit.map_x, hit.map_y) >= map.max_height) break;
+                }
+
+                const RayHit hit = castRay(map, ray);
+                missed_hits += hit.tile != 0 && !pvs.isVisible(hit.map_x, hit.map_y);
+            }
+
+            for (int t = 0; t < 200; t++) {
+                const Fixed15_16 tx = Fixed15_16(tile_x(rng) + offset(rng));
+                const Fixed15_16 ty = Fixed15_16(tile_y(rng) + offset(rng));
+                if (hasLineOfSight(map, pose.pos_x, pose.pos_y, tx, ty)) missed_sight += !pvs.isVisible(tx.toInt(), ty.toInt());
+            }
+        }
+
+        if (missed_hits != 0 || missed_sight != 0) {
+            fprintf(stderr, "%s: %u wall hits and %u lines of sight outside the set\n", name, missed_hits, missed_sight);
+            fail("set is not conservative");
+        }
+    }
+
+    /**
+     * @brief Every texture a drawn wall uses is among the set's face textures, and how much of the
+     * drawing the ones that fit in SRAM cover
+     */
+    void checkFaceTextures(const MapView& map, int pose_count, std::mt19937& rng, const char* name) {
+        PotentiallyVisibleSet pvs(map);
+        uint16_t textures[UINT8_MAX];
+
+        uint32_t missed = 0, columns = 0, covered = 0;
+        double visible_tiles = 0.0, face_textures = 0.0;
+
+        for (int p = 0; p < pose_count; p++) {
+            const PlayerData pose = randomPose(map, rng);
+            pvs.update(pose.pos_x.toInt(), pose.pos_y.toInt());
+
+            const uint8_t count = pvs.faceTextures(textures, UINT8_MAX);
+            face_textures += count;
+            for (uint16_t t = 0; t < static_cast<uint32_t>(map.width) * map.height; t++) visible_tiles += pvs.isTileVisible(t);
+
+            const uint16_t* const resident_end = textures + std::min<uint8_t>(count, TextureManager::SRAM_TEXTURE_SLOTS);
+            const Camera camera = Camera::fromPlayer(pose);
+            for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+                const RayHit hit = castRay(map, cameraRay(camera, x));
+                if (hit.tile == 0) continue;
+
+                const uint16_t texture = DefaultColumnRenderer::wallTexture(hit);
+                missed += std::find(textures, textures + count, texture) == textures + count;
+                covered += std::find(static_cast<const uint16_t*>(textures), resident_end, texture) != resident_end;
+                columns++;
+            }
+        }
+
+        printf("%s: %.1f of %u tiles visible on average, %.1f face textures, the %u in SRAM draw %.1f%% of columns\n",
+               name, visible_tiles / pose_count, static_cast<uint32_t>(map.width) * map.height, face_textures / pose_count,
+               TextureManager::SRAM_TEXTURE_SLOTS, 100.0 * covered / columns);
+
+        if (missed != 0) {
+            fprintf(stderr, "%s: %u drawn columns use a texture outside the face textures\n", name, missed);
+            fail("face textures are not conservative");
+        }
+    }
+
+    /// @brief Face textures by scanning every tile of the map, what faceTextures() did at runtime before the lists were baked
+    uint8_t scanFaceTextures(const MapView& map, const std::vector<DoorData>& doors, const PotentiallyVisibleSet& pvs,
+                             uint16_t* textures) {
+        uint16_t faces[UINT8_MAX + 1] = {};
+        uint8_t tile_rank[UINT8_MAX + 1];
+        uint8_t texture_rank[UINT8_MAX + 1];
+        memset(tile_rank, UINT8_MAX, sizeof(tile_rank));
+        memset(texture_rank, UINT8_MAX, sizeof(texture_rank));
+        for (uint8_t i = pvs.textureCount(); i > 0; i--) tile_rank[pvs.textures()[i - 1]] = i - 1;
+
+        auto isDoor = [&](int x, int y) {
+            return std::any_of(doors.begin(), doors.end(), [&](const DoorData& door) { return door.x == x && door.y == y; });
+        };
+
+        constexpr int STEP_X[4] = {-1, 1, 0, 0}; // TileFace order
+        constexpr int STEP_Y[4] = {0, 0, -1, 1};
+
+        for (uint8_t x = 0; x < map.width; x++) {
+            for (uint8_t y = 0; y < map.height; y++) {
+                const uint8_t tile = map.getTileUnchecked(x, y);
+                if (tile == 0 || !pvs.isTileVisible(static_cast<uint16_t>(y + map.height * x))) continue;
+
+                for (int f = 0; f < 4; f++) {
+                    const int nx = x + STEP_X[f];
+                    const int ny = y + STEP_Y[f];
+                    if (nx < 0 || ny < 0 || nx >= map.width || ny >= map.height) continue;
+
+                    const uint8_t neighbour = map.getTileUnchecked(static_cast<uint8_t>(nx), static_cast<uint8_t>(ny));
+                    if (neighbour != 0 && !isDoor(nx, ny) &&
+                        map.getWallHeight(static_cast<uint8_t>(nx), static_cast<uint8_t>(ny)) >= map.getWallHeight(x, y)) continue;
+
+                    const uint32_t texture = tile - 1 + ((f < 2) ? 0 : 1);
+                    if (texture > UINT8_MAX) continue;
+
+                    faces[texture]++;
+                    texture_rank[texture] = std::min(texture_rank[texture], tile_rank[tile]);
+                }
+            }
+        }
+
+        uint8_t count = 0;
+        while (count < UINT8_MAX) {
+            uint16_t best = 0;
+            for (uint16_t t = 1; t <= UINT8_MAX; t++) {
+                if (faces[t] == 0) continue;
+                if (faces[best] == 0 || texture_rank[t] < texture_rank[best] ||
+                    (texture_rank[t] == texture_rank[best] && faces[t] > faces[best])) best = t;
+            }
+            if (faces[best] == 0) break;
+
+            textures[count++] = best;
+            faces[best] = 0;
+        }
+
+        return count;
+    }
+
+    /**
+     * @brief The baked face textures of every set are what a scan of the map finds, and what each costs on a tile crossing
+     * @note Also prints what a tile crossing copies into SRAM, all of it at once before the copy was spread over columns
+     */
+    void checkBakedFaces(const MapView& map, const std::vector<DoorData>& doors, const char* name) {
+        PotentiallyVisibleSet pvs(map);
+        uint16_t baked[UINT8_MAX], scanned[UINT8_MAX];
+
+        double scan_seconds = 0.0, baked_seconds = 0.0, worst_scan = 0.0, worst_baked = 0.0;
+        uint32_t sets = 0, mismatches = 0;
+
+        for (uint8_t x = 0; x < map.width; x++) {
+            for (uint8_t y = 0; y < map.height; y++) {
+                if (map.getTile(x, y) != 0) continue;
+                pvs.update(x, y);
+
+                auto start = std::chrono::steady_clock::now();
+                const uint8_t count = pvs.faceTextures(baked, UINT8_MAX);
+                const double baked_time = secondsSince(start);
+
+                start = std::chrono::steady_clock::now();
+                const uint8_t expected = scanFaceTextures(map, doors, pvs, scanned);
+                const double scan_time = secondsSince(start);
+
+                mismatches += count != expected || !std::equal(baked, baked + count, scanned);
+                baked_seconds += baked_time;
+                scan_seconds += scan_time;
+                worst_baked = std::max(worst_baked, baked_time);
+                worst_scan = std::max(worst_scan, scan_time);
+                sets++;
+            }
+        }
+
+        const uint32_t texture_bytes = TEX_SIZE * TEX_SIZE * sizeof(uint16_t);
+        printf("%-9s face textures on a tile crossing: scan %.2f us (worst %.2f), baked %.3f us (worst %.3f); "
+               "prefetch copies %u bytes per column instead of up to %u at once\n",
+               name, 1e6 * scan_seconds / sets, 1e6 * worst_scan, 1e6 * baked_seconds / sets, 1e6 * worst_baked,
+               TextureManager::PREFETCH_STEP_BYTES, TextureManager::SRAM_TEXTURE_SLOTS * texture_bytes);
+
+        if (mismatches != 0) {
+            fprintf(stderr, "%s: %u of %u sets list other face textures than a scan of the map finds\n", name, mismatches, sets);
+            fail("baked face textures differ from the scan");
+        }
+    }
+
+    /// @brief Decoding a set on a tile crossing and looking tiles up in it
+    void timeLookups(const MapView& map, std::mt19937& rng, const char* name) {
+        PotentiallyVisibleSet pvs(map);
+
+        std::vector<uint16_t> open;
+        for (uint8_t x = 0; x < map.width; x++) {
+            for (uint8_t y = 0; y < map.height; y++) {
+                if (map.getTile(x, y) == 0) open.push_back(static_cast<uint16_t>(y + map.height * x));
+            }
+        }
+
+        constexpr int ROUNDS = 20;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < ROUNDS; r++) {
+            std::shuffle(open.begin(), open.end(), rng);
+            for (uint16_t tile : open) pvs.update(tile / map.height, tile % map.height);
+        }
+        const double update_us = 1e6 * secondsSince(start) / (static_cast<double>(ROUNDS) * open.size());
+
+        std::vector<int16_t> queries(1 << 16);
+        std::uniform_int_distribution<int> tile_x(0, map.width - 1);
+        std::uniform_int_distribution<int> tile_y(0, map.height - 1);
+        for (size_t i = 0; i < queries.size(); i += 2) {
+            queries[i] = static_cast<int16_t>(tile_x(rng));
+            queries[i + 1] = static_cast<int16_t>(tile_y(rng));
+        }
+
+        uint32_t visible = 0;
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < ROUNDS; r++) {
+            for (size_t i = 0; i < queries.size(); i += 2) visible += pvs.isVisible(queries[i], queries[i + 1]);
+        }
+        const double lookup_ns = 1e9 * secondsSince(start) / (ROUNDS * queries.size() / 2.0);
+
+        printf("%-9s update on a tile crossing %.2f us, isVisible %.2f ns (%u visible)\n", name, update_us, lookup_ns, visible);
+    }
+
+    /// @brief Culling entities with the set finds what culling without it finds, in less time
+    void checkEntities(const MapView& map, int pose_count, std::mt19937& rng) {
+        static Store store(map);
+        static Store::Index with_pvs[ENTITY_COUNT], without_pvs[ENTITY_COUNT];
+
+        std::uniform_real_distribution<float> pos(1.0f, ROOMS_SIZE - 1.0f);
+        store.clear();
+        while (store.size() < ENTITY_COUNT) {
+            store.spawn(Fixed15_16(pos(rng)), Fixed15_16(pos(rng)), store.size() & 0xFF, 0.2_fp);
+        }
+
+        PotentiallyVisibleSet pvs(map);
+        double with_seconds = 0.0, without_seconds = 0.0;
+        uint64_t found = 0;
+
+        for (int p = 0; p < pose_count; p++) {
+            const PlayerData pose = randomPose(map, rng);
+            const Camera camera = Camera::fromPlayer(pose);
+            pvs.update(pose.pos_x.toInt(), pose.pos_y.toInt());
+
+            auto start = std::chrono::steady_clock::now();
+            const uint16_t count = store.collectVisible(camera, without_pvs, ENTITY_COUNT);
+            without_seconds += secondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            const uint16_t culled = store.collectVisible(camera, with_pvs, ENTITY_COUNT, Fixed15_16(64), &pvs);
+            with_seconds += secondsSince(start);
+
+            if (count != culled || !std::equal(without_pvs, without_pvs + count, with_pvs)) fail("set culled a visible entity");
+            found += count;
+        }
+
+        printf("entities  %u on the rooms map, %.1f visible: collectVisible %.1f us without the set, %.1f us with it\n", ENTITY_COUNT,
+               static_cast<double>(found) / pose_count, 1e6 * without_seconds / pose_count, 1e6 * with_seconds / pose_count);
+    }
+
+    /// @brief The blob is accepted and bound, broken sections are not
+    bool checkBlob(std::vector<uint8_t>& blob, uint32_t tex_count, const char* name) {
+        if (!validateMapBlob(blob.data(), blob.size(), tex_count)) {
+            fprintf(stderr, "%s: ", name);
+            fail("packed map rejected");
+            return false;
+        }
+        if (createMapView(blob.data()).pvs == nullptr) fail("visible sets not bound");
+
+        const MapFileHeader* header = getMapFileHeader(blob.data());
+        const uint32_t section = header->pvs_offset;
+        const MapView map = createMapView(blob.data());
+
+        if (validateMapBlob(blob.data(), blob.size() - 1, tex_count)) fail("truncated section accepted");
+
+        // a layout newer than this build reads
+        uint32_t version = MapFileHeader::VERSION + 1;
+        memcpy(blob.data() + offsetof(MapFileHeader, version), &version, sizeof(version));
+        if (isMapDataValid(blob.data())) fail("newer map version accepted");
+        version = MapFileHeader::VERSION;
+        memcpy(blob.data() + offsetof(MapFileHeader, version), &version, sizeof(version));
+
+        // the first open tile's set: its base and its first texture
+        uint32_t entry = 0;
+        for (size_t t = 0; entry == 0; t++) memcpy(&entry, blob.data() + section + t * sizeof(uint32_t), sizeof(entry));
+
+        uint8_t* base = blob.data() + section + entry;
+        const uint32_t valid_base = 0;
+        uint32_t bad_base = static_cast<uint32_t>(blob.size());
+        memcpy(base, &bad_base, sizeof(bad_base));
+        if (validateMapBlob(blob.data(), blob.size(), tex_count)) fail("base outside the section accepted");
+        memcpy(base, &valid_base, sizeof(valid_base));
+
+        uint8_t* texture = base + sizeof(uint32_t) + 1;
+        if (base[sizeof(uint32_t)] != 0) {
+            const uint8_t tile = *texture;
+            *texture = 0;
+            if (validateMapBlob(blob.data(), blob.size(), tex_count)) fail("texture of an open tile accepted");
+            *texture = tile;
+        }
+
+        // an open tile without a set
+        for (size_t t = 0; t < static_cast<size_t>(map.width) * map.height; t++) {
+            if (map.tile_data[t] != 0) continue;
+
+            uint8_t* slot = blob.data() + section + t * sizeof(uint32_t);
+            uint32_t saved;
+            memcpy(&saved, slot, sizeof(saved));
+            memset(slot, 0, sizeof(saved));
+            if (validateMapBlob(blob.data(), blob.size(), tex_count)) fail("open tile without a set accepted");
+            memcpy(slot, &saved, sizeof(saved));
+            break;
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    const int pose_count = (argc > 1) ? atoi(argv[1]) : 200;
+    const unsigned seed = (argc > 2) ? static_cast<unsigned>(atoi(argv[2])) : 1234u;
+
+    if (!TextureManager::isValid() || !isMapDataValid()) {
+        printf("ERROR embedded asset data invalid\n");
+        return 1;
+    }
+
+    std::mt19937 rng(seed);
+    const uint32_t tex_count = TextureManager::getHeader()->tex_count;
+
+    // the embedded map with what it packs, the set is rebuilt here so an older blob without one works too
+    const MapView embedded = createMapView();
+    const size_t embedded_tiles = static_cast<size_t>(embedded.width) * embedded.height;
+
+    SourceMap level{embedded.width, embedded.height, {embedded.tile_data, embedded.tile_data + embedded_tiles}, {}, {}, *getPlayerData()};
+    if (embedded.heights != nullptr) level.heights.assign(embedded.heights, embedded.heights + embedded_tiles);
+
+    uint32_t door_count;
+    const DoorData* doors = getDoors(door_count);
+    level.doors.assign(doors, doors + door_count);
+
+    SourceMap rooms{ROOMS_SIZE, ROOMS_SIZE, makeRooms(rng), {}, {}, {}};
+    rooms.player = PlayerData{Fixed15_16(4), Fixed15_16(4), Fixed15_16(1), Fixed15_16(0)};
+
+    // the rooms again with walls of every height, low ones show what is behind them
+    SourceMap towers = rooms;
+    const uint8_t tower_heights[] = {8, 32, 32, 32};
+    std::uniform_int_distribution<size_t> pick_height(0, sizeof(tower_heights) - 1);
+    towers.heights.resize(towers.tiles.size());
+    for (uint8_t& h : towers.heights) h = tower_heights[pick_height(rng)];
+
+    std::vector<uint8_t> level_blob = packMap(level, build(level, "embedded"));
+    std::vector<uint8_t> rooms_blob = packMap(rooms, build(rooms, "rooms"));
+    std::vector<uint8_t> towers_blob = packMap(towers, build(towers, "towers"));
+
+    if (!checkBlob(level_blob, tex_count, "embedded") || !checkBlob(rooms_blob, tex_count, "rooms") ||
+        !checkBlob(towers_blob, tex_count, "towers")) {
+        printf("FAIL: %d checks failed\n", failures);
+        return 1;
+    }
+
+    const MapView level_map = createMapView(level_blob.data());
+    const MapView rooms_map = createMapView(rooms_blob.data());
+    const MapView towers_map = createMapView(towers_blob.data());
+
+    checkConservative(level_map, pose_count, rng, "embedded");
+    checkConservative(rooms_map, pose_count, rng, "rooms");
+    checkConservative(towers_map, pose_count, rng, "towers");
+
+    // the linked map as packed, with its lightmap
+    checkFaceTextures(embedded, pose_count, rng, "embedded");
+
+    checkBakedFaces(level_map, level.doors, "embedded");
+    checkBakedFaces(rooms_map, rooms.doors, "rooms");
+    checkBakedFaces(towers_map, towers.doors, "towers");
+
+    timeLookups(level_map, rng, "embedded");
+    timeLookups(rooms_map, rng, "rooms");
+
+    checkEntities(rooms_map, pose_count, rng);
+
+    if (failures > 0) {
+        printf("FAIL: %d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
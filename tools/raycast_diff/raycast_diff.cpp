@@ -0,0 +1,160 @@
+/**
+ * @file raycast_diff.cpp
+ * @brief Differential check of the fixed-point renderer against the double precision reference.
+ *
+ * Renders the embedded map from many random poses with both renderers and
+ * reports per-column hit mismatches, line height error and frame PSNR.
+ * Exits non-zero if any metric is outside its threshold.
+ *
+ * Usage: raycast_diff [pose_count] [seed]
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "frame_psnr.hpp"
+#include "map_data.hpp"
+#include "renderer.hpp"
+#include "reference_renderer.hpp"
+#include "textures.hpp"
+
+namespace {
+    // thresholds, fast paths have to stay within these
+    // the plain Q15.16 pipeline gives ~0.008% hit mismatches, ~0.003px mean line height error
+    // and ~32.6 dB mean / ~24.4 dB worst PSNR over 5000 poses, most of it texel rounding on close walls
+    constexpr double MAX_HIT_MISMATCH_RATE = 0.0005;    // fraction of columns
+    constexpr double MAX_MEAN_LINE_HEIGHT_ERROR = 0.05; // pixels
+    constexpr double MIN_MEAN_PSNR = 30.0;  // dB
+    constexpr double MIN_WORST_PSNR = 20.0; // dB
+}
+
+int main(int argc, char** argv) {
+    const int pose_count = (argc > 1) ? std::atoi(argv[1]) : 5000;
+    const unsigned seed = (argc > 2) ? static_cast<unsigned>(std::atoi(argv[2])) : 1;
+
+    if (!TextureManager::isValid() || !isMapDataValid()) {
+        printf("ERROR embedded asset data invalid\n");
+        return 1;
+    }
+
+    const MapView map = createMapView();
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> offset(0.05f, 0.95f);
+    std::uniform_int_distribution<int> tile_x(0, map.width - 1);
+    std::uniform_int_distribution<int> tile_y(0, map.height - 1);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+    uint64_t columns = 0;
+    uint64_t hit_mismatches = 0;
+    uint64_t side_mismatches = 0;
+    uint64_t tex_x_mismatches = 0;
+    double line_height_error_sum = 0.0;
+    int max_line_height_error = 0;
+
+    double psnr_sum = 0.0;
+    int finite_psnr_frames = 0;
+    int exact_frames = 0;
+    double worst_psnr = INFINITY;
+    Camera worst_camera{};
+
+    static uint16_t frame[SCREEN_WIDTH * SCREEN_HEIGHT];
+    static uint16_t reference_frame[SCREEN_WIDTH * SCREEN_HEIGHT];
+
+    for (int pose = 0; pose < pose_count; pose++) {
+        // random pose inside an open tile
+        int tx, ty;
+        do {
+            tx = tile_x(rng);
+            ty = tile_y(rng);
+        } while (map.getTile(tx, ty) != 0);
+
+        const float a = angle(rng);
+
+        PlayerData player{
+            Fixed15_16(tx + offset(rng)), Fixed15_16(ty + offset(rng)),
+            Fixed15_16(std::cos(a)), Fixed15_16(std::sin(a))
+        };
+
+        const Camera camera = Camera::fromPlayer(player);
+        const ReferenceCamera reference_camera = ReferenceCamera::fromCamera(camera);
+
+        for (auto& p : frame) p = 0;
+        for (auto& p : reference_frame) p = 0;
+
+        for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+            uint16_t* column = &frame[x * SCREEN_HEIGHT];
+            uint16_t* reference_column = &reference_frame[x * SCREEN_HEIGHT];
+
+            const RayHit hit = renderColumn(map, camera, x, column);
+            const ReferenceHit ref = referenceRenderColumn(map, reference_camera, x, reference_column);
+
+            columns++;
+
+            if (hit.tile != ref.tile || hit.map_x != ref.map_x || hit.map_y != ref.map_y) {
+                hit_mismatches++;
+                continue;
+            }
+
+            side_mismatches += hit.side != ref.side;
+            tex_x_mismatches += hit.tex_x != ref.tex_x;
+
+            const int line_height_error = std::abs(lineHeight(hit.distance) - ref.line_height);
+            line_height_error_sum += line_height_error;
+            if (line_height_error > max_line_height_error) max_line_height_error = line_height_error;
+        }
+
+        const double psnr = framePsnr(frame, reference_frame, SCREEN_WIDTH * SCREEN_HEIGHT);
+
+        if (std::isinf(psnr)) {
+            exact_frames++;
+        } else {
+            psnr_sum += psnr;
+            finite_psnr_frames++;
+        }
+
+        if (psnr < worst_psnr) {
+            worst_psnr = psnr;
+            worst_camera = camera;
+        }
+    }
+
+    const uint64_t matched_columns = columns - hit_mismatches;
+    const double hit_mismatch_rate = static_cast<double>(hit_mismatches) / columns;
+    const double mean_line_height_error = (matched_columns > 0) ? line_height_error_sum / matched_columns : 0.0;
+    const double mean_psnr = (finite_psnr_frames > 0) ? psnr_sum / finite_psnr_frames : INFINITY;
+
+    printf("poses:                  %d (seed %u)\n", pose_count, seed);
+    printf("columns:                %llu\n", static_cast<unsigned long long>(columns));
+    printf("hit mismatches:         %llu (%.4f%%)\n", static_cast<unsigned long long>(hit_mismatches), 100.0 * hit_mismatch_rate);
+    printf("side mismatches:        %llu\n", static_cast<unsigned long long>(side_mismatches));
+    printf("tex_x mismatches:       %llu\n", static_cast<unsigned long long>(tex_x_mismatches));
+    printf("line height error:      mean %.4f px, max %d px\n", mean_line_height_error, max_line_height_error);
+    printf("psnr:                   mean %.2f dB over %d inexact frames, %d exact frames\n", mean_psnr, finite_psnr_frames, exact_frames);
+    printf("worst psnr:             %.2f dB at pos (%.4f, %.4f) dir (%.4f, %.4f)\n", worst_psnr,
+           worst_camera.pos_x.toFloat(), worst_camera.pos_y.toFloat(), worst_camera.dir_x.toFloat(), worst_camera.dir_y.toFloat());
+
+    bool pass = true;
+
+    if (hit_mismatch_rate > MAX_HIT_MISMATCH_RATE) {
+        printf("FAIL hit mismatch rate above %.4f%%\n", 100.0 * MAX_HIT_MISMATCH_RATE);
+        pass = false;
+    }
+    if (mean_line_height_error > MAX_MEAN_LINE_HEIGHT_ERROR) {
+        printf("FAIL mean line height error above %.2f px\n", MAX_MEAN_LINE_HEIGHT_ERROR);
+        pass = false;
+    }
+    if (mean_psnr < MIN_MEAN_PSNR) {
+        printf("FAIL mean psnr below %.1f dB\n", MIN_MEAN_PSNR);
+        pass = false;
+    }
+    if (worst_psnr < MIN_WORST_PSNR) {
+        printf("FAIL worst psnr below %.1f dB\n", MIN_WORST_PSNR);
+        pass = false;
+    }
+
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file reference_renderer.cpp
+ */
+
+#include "reference_renderer.hpp"
+
+#include <cmath>
+#include <limits>
+
+#include "textures.hpp"
+
+ReferenceCamera ReferenceCamera::fromCamera(const Camera& camera) {
+    return ReferenceCamera{
+        camera.pos_x.toRaw() / 65536.0, camera.pos_y.toRaw() / 65536.0,
+        camera.dir_x.toRaw() / 65536.0, camera.dir_y.toRaw() / 65536.0,
+        camera.plane_x.toRaw() / 65536.0, camera.plane_y.toRaw() / 65536.0
+    };
+}
+
+ReferenceHit referenceRenderColumn(const MapView& map, const ReferenceCamera& camera, uint8_t x, uint16_t* column) {
+    ReferenceHit result{};
+
+    const double camera_x = 2.0 * x / SCREEN_WIDTH - 1.0;
+    const double ray_dir_x = camera.dir_x + camera.plane_x * camera_x;
+    const double ray_dir_y = camera.dir_y + camera.plane_y * camera_x;
+
+    int map_x = static_cast<int>(std::floor(camera.pos_x));
+    int map_y = static_cast<int>(std::floor(camera.pos_y));
+
+    const double inf = std::numeric_limits<double>::infinity();
+    const double delta_dist_x = (ray_dir_x == 0.0) ? inf : std::fabs(1.0 / ray_dir_x);
+    const double delta_dist_y = (ray_dir_y == 0.0) ? inf : std::fabs(1.0 / ray_dir_y);
+
+    const int step_x = (ray_dir_x < 0.0) ? -1 : 1;
+    const int step_y = (ray_dir_y < 0.0) ? -1 : 1;
+
+    double side_dist_x = (ray_dir_x < 0.0) ? (camera.pos_x - map_x) * delta_dist_x : (map_x + 1.0 - camera.pos_x) * delta_dist_x;
+    double side_dist_y = (ray_dir_y < 0.0) ? (camera.pos_y - map_y) * delta_dist_y : (map_y + 1.0 - camera.pos_y) * delta_dist_y;
+
+    double dist = 0.0;
+    uint8_t side = 0;
+    uint8_t tile = 0;
+
+    while (tile == 0) {
+        if (side_dist_x < side_dist_y) {
+            dist = side_dist_x;
+            side_dist_x += delta_dist_x;
+            map_x += step_x;
+            side = 0;
+        } else {
+            dist = side_dist_y;
+            side_dist_y += delta_dist_y;
+            map_y += step_y;
+            side = 1;
+        }
+
+        if (map_x < 0 || map_y < 0 || map_x >= map.width || map_y >= map.height) {
+            return result;
+        }
+
+        tile = map.getTileUnchecked(static_cast<uint8_t>(map_x), static_cast<uint8_t>(map_y));
+    }
+
+    double wall_x = (side == 0) ? camera.pos_y + dist * ray_dir_y : camera.pos_x + dist * ray_dir_x;
+    wall_x -= std::floor(wall_x);
+
+    int tex_x = static_cast<int>(wall_x * TEX_SIZE);
+    if ((side == 0 && ray_dir_x > 0.0) || (side == 1 && ray_dir_y < 0.0)) {
+        tex_x = TEX_SIZE - tex_x - 1;
+    }
+
+    const double exact_height = SCREEN_HEIGHT / dist;
+    const int16_t line_height = (exact_height >= INT16_MAX) ? INT16_MAX : static_cast<int16_t>(exact_height);
+
+    result.tile = tile;
+    result.side = side;
+    result.map_x = static_cast<int16_t>(map_x);
+    result.map_y = static_cast<int16_t>(map_y);
+    result.tex_x = static_cast<uint8_t>(tex_x);
+    result.line_height = line_height;
+    result.distance = dist;
+
+    // same draw range convention as renderColumn
+    int draw_start = (-line_height >> 1) + (SCREEN_HEIGHT >> 1);
+    if (draw_start < 0) draw_start = 0;
+
+    int draw_end = (line_height >> 1) + (SCREEN_HEIGHT >> 1);
+    if (draw_end >= SCREEN_HEIGHT) draw_end = SCREEN_HEIGHT - 1;
+
+    const int wall_top = (SCREEN_HEIGHT - line_height) >> 1;
+    const double step = static_cast<double>(TEX_SIZE) / line_height;
+
+    // baked light, the face on the ray's side of the tile
+    const TileFace face = (side == 0) ? ((ray_dir_x < 0.0) ? TileFace::X_MAX : TileFace::X_MIN)
+                                      : ((ray_dir_y < 0.0) ? TileFace::Y_MAX : TileFace::Y_MIN);
+    const uint8_t shade = map.getShade(map_x, map_y, face);
+
+    uint16_t scratch[TEX_SIZE];
+    const uint16_t* tex_column = TextureManager::getTextureColumn(side == 1 ? tile : tile - 1, tex_x, TEX_LOG2_SIZE, scratch);
+
+    for (int y = draw_start; y < draw_end; y++) {
+        int tex_y = static_cast<int>(std::floor((y - wall_top) * step)) & TEX_MASK;
+        column[y] = (shade != 0) ? shadeTexel(tex_column[tex_y], shade) : tex_column[tex_y];
+    }
+
+    return result;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file reference_renderer.hpp
+ * @brief Double precision reference raycaster for checking the fixed-point renderer.
+ *
+ * Follows the same rasterisation conventions as renderColumn (integer line
+ * height, same draw range, same texture mirroring) so that any difference
+ * comes from the fixed-point arithmetic, not from a different projection.
+ */
+
+#ifndef REFERENCE_RENDERER_H
+#define REFERENCE_RENDERER_H
+
+#include <cstdint>
+
+#include "map_data.hpp"
+#include "renderer.hpp"
+
+struct ReferenceCamera {
+    double pos_x, pos_y;
+    double dir_x, dir_y;
+    double plane_x, plane_y;
+
+    /// @brief Exact conversion of a fixed-point camera
+    static ReferenceCamera fromCamera(const Camera& camera);
+};
+
+struct ReferenceHit {
+    uint8_t tile;   // 0 if the ray missed
+    uint8_t side;
+    int16_t map_x;
+    int16_t map_y;
+    uint8_t tex_x;
+    int16_t line_height;
+    double distance;
+};
+
+/**
+ * @brief Raycast and texture a single screen column in double precision
+ * @param column Output buffer of SCREEN_HEIGHT pixels, rows outside the wall are left untouched
+ */
+ReferenceHit referenceRenderColumn(const MapView& map, const ReferenceCamera& camera, uint8_t x, uint16_t* column);
+
+#endif // REFERENCE_RENDERER_H
@@ -0,0 +1,317 @@
+/**
+ * @file render_config_check.cpp
+ * @brief Instantiates the column renderer for several RenderConfigs and checks each one.
+ *
+ * Every configuration renders the embedded map from the same random poses.
+ * Per column the hit has to match a plain castRay of the configuration's
+ * camera ray, and only the rows of the projected wall span may be written.
+ * Across configurations the RGB888 instance has to produce the RGB565 one's
+ * pixels converted, and the 32x32 texture instance (rendering a downsampled
+ * copy of the texture blob) has to hit the same texture columns at half
+ * resolution. The RGB888 conversion has to keep the grey stone brick texture
+ * grey. Frame times per configuration are printed as well.
+ * Exits non-zero if any check fails.
+ *
+ * Usage: render_config_check [pose_count] [seed]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "map_data.hpp"
+#include "renderer.hpp"
+#include "textures.hpp"
+
+namespace {
+    using SmallConfig = RenderConfig<96, 64>;
+    using PortraitConfig = RenderConfig<128, 160>;
+    using VgaConfig = RenderConfig<320, 240>;
+    using VgaRgb888Config = RenderConfig<320, 240, TEX_LOG2_SIZE, uint32_t>;
+    using LowTexConfig = RenderConfig<160, 128, 5>;
+
+    // buffers and column indices are sized by the configuration
+    static_assert(sizeof(ColumnRenderer<DefaultRenderConfig>::Column) == 128 * sizeof(uint16_t));
+    static_assert(sizeof(ColumnRenderer<VgaRgb888Config>::Column) == 240 * sizeof(uint32_t));
+    static_assert(std::is_same_v<DefaultRenderConfig::column_index_t, uint8_t>);
+    static_assert(std::is_same_v<VgaConfig::column_index_t, uint16_t>);
+    static_assert(LowTexConfig::TEX_SIZE == 32 && LowTexConfig::TEX_MASK == 31);
+
+    // texels are big endian RGB565, a grey stone brick texel has to come out grey and red has to stay red
+    static_assert(fromRgb565<uint32_t>(0xA210) == 0x101410);
+    static_assert(fromRgb565<uint32_t>(panelColor(0xF800)) == 0xFF0000);
+    static_assert(fromRgb565<uint32_t>(panelColor(0x07E0)) == 0x00FF00);
+    static_assert(fromRgb565<uint32_t>(panelColor(0x001F)) == 0x0000FF);
+
+    // rows no renderer writes, every pixel of it outside the wall span has to keep it
+    constexpr uint32_t SENTINEL = 0xDEAD;
+
+    /// @brief One rendered frame, column major, with the hit of every column
+    template <class Config>
+    struct Frame {
+        std::vector<typename Config::pixel_t> pixels = std::vector<typename Config::pixel_t>(Config::WIDTH * Config::HEIGHT);
+        std::vector<RayHit> hits = std::vector<RayHit>(Config::WIDTH);
+    };
+
+    struct ConfigStats {
+        uint64_t columns = 0;
+        uint64_t hit_mismatches = 0;
+        uint64_t span_errors = 0;
+        uint64_t height_errors = 0;
+        double seconds = 0.0;
+        int frames = 0;
+    };
+
+    template <class Config>
+    void renderFrame(const MapView& map, const PlayerData& player, Frame<Config>& frame, ConfigStats& stats) {
+        using Renderer = ColumnRenderer<Config>;
+
+        const Camera camera = Camera::fromPlayer<Config>(player);
+
+        for (auto& p : frame.pixels) p = static_cast<typename Config::pixel_t>(SENTINEL);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (uint16_t x = 0; x < Config::WIDTH; x++) {
+            frame.hits[x] = Renderer::renderColumn(map, camera, static_cast<typename Config::column_index_t>(x), &frame.pixels[x * Config::HEIGHT]);
+        }
+        stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats.frames++;
+    }
+
+    /// @brief Per column checks of one frame against castRay and the projection
+    template <class Config>
+    void checkFrame(const MapView& map, const PlayerData& player, const Frame<Config>& frame, ConfigStats& stats) {
+        using Renderer = ColumnRenderer<Config>;
+
+        const Camera camera = Camera::fromPlayer<Config>(player);
+
+        RayQueryOptions options;
+        options.tex_log2_size = Config::TEX_LOG2_SIZE;
+
+        for (uint16_t x = 0; x < Config::WIDTH; x++) {
+            const RayHit& hit = frame.hits[x];
+            const RayHit expected = castRay(map, Renderer::cameraRay(camera, static_cast<typename Config::column_index_t>(x)), options);
+
+            stats.columns++;
+
+            if (hit.tile != expected.tile || hit.side != expected.side || hit.map_x != expected.map_x ||
+                hit.map_y != expected.map_y || hit.tex_x != expected.tex_x || hit.distance != expected.distance) {
+                stats.hit_mismatches++;
+                continue;
+            }
+            if (hit.tile == 0) continue;
+
+            // projected height within a pixel of the exact one
+            const int16_t line_height = Renderer::lineHeight(hit.distance);
+            const double exact_height = Config::HEIGHT / (hit.distance.toRaw() / 65536.0);
+            if (exact_height < INT16_MAX && std::fabs(line_height - exact_height) > 1.0) {
+                stats.height_errors++;
+            }
+
+            int draw_start = (-line_height >> 1) + (Config::HEIGHT >> 1);
+            if (draw_start < 0) draw_start = 0;
+            int draw_end = (line_height >> 1) + (Config::HEIGHT >> 1);
+            if (draw_end >= Config::HEIGHT) draw_end = Config::HEIGHT - 1;
+
+            const typename Config::pixel_t* column = &frame.pixels[x * Config::HEIGHT];
+            for (int y = 0; y < Config::HEIGHT; y++) {
+                const bool untouched = column[y] == static_cast<typename Config::pixel_t>(SENTINEL);
+                const bool in_span = y >= draw_start && y < draw_end;
+
+                // textures may legitimately contain the sentinel, only writes outside the span are errors
+                if (!in_span && !untouched) {
+                    stats.span_errors++;
+                    break;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Texture blob with every texture of the bound one downsampled to 32x32
+     * @note Procedural textures are copied as they are, their kernels sample every other texel at 32x32 themselves
+     */
+    std::vector<uint8_t> downsampleTextures() {
+        const uint32_t count = TextureManager::getHeader()->tex_count;
+        constexpr uint32_t HALF = TEX_SIZE / 2;
+
+        const uint32_t data_offset = static_cast<uint32_t>(sizeof(TextureFileHeader) + count * sizeof(uint32_t));
+        std::vector<uint8_t> blob(data_offset + count * HALF * HALF * sizeof(uint16_t));
+
+        TextureFileHeader header = *TextureManager::getHeader();
+        memcpy(blob.data(), &header, sizeof(header));
+
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t offset = data_offset + i * HALF * HALF * sizeof(uint16_t);
+            uint32_t entry = offset;
+
+            const uint16_t* src = TextureManager::getTextureData(static_cast<uint16_t>(i));
+            const ProceduralTexture* procedural = TextureManager::getProcedural(static_cast<uint16_t>(i));
+
+            if (procedural != nullptr) {
+                // a descriptor is far smaller than a 32x32 texture, it fits in the slot
+                memcpy(blob.data() + offset, procedural, sizeof(ProceduralTexture) + procedural->table_size * sizeof(uint16_t));
+                entry |= TextureFileHeader::PROCEDURAL_OFFSET;
+            } else {
+                uint16_t* dst = reinterpret_cast<uint16_t*>(blob.data() + offset);
+
+                // column major like the packed textures
+                for (uint32_t x = 0; x < HALF; x++) {
+                    for (uint32_t y = 0; y < HALF; y++) {
+                        dst[x * HALF + y] = src[(x * 2) * TEX_SIZE + y * 2];
+                    }
+                }
+            }
+
+            memcpy(blob.data() + sizeof(TextureFileHeader) + i * sizeof(uint32_t), &entry, sizeof(entry));
+        }
+
+        return blob;
+    }
+
+    // tex_stone_bricks in assets/textures.json, a grey texture
+    constexpr uint16_t STONE_BRICKS_TEXTURE = 8;
+
+    /// @brief Largest difference of red or blue from green over every texel of a texture, small for grey ones
+    int channelSpread(uint16_t texIndex) {
+        uint16_t scratch[TEX_SIZE];
+        int spread = 0;
+
+        for (uint8_t x = 0; x < TEX_SIZE; x++) {
+            const uint16_t* column = TextureManager::getTextureColumn(texIndex, x, TEX_LOG2_SIZE, scratch);
+            for (uint8_t y = 0; y < TEX_SIZE; y++) {
+                const uint32_t pixel = fromRgb565<uint32_t>(column[y]);
+                const int r = static_cast<int>(pixel >> 16), g = static_cast<int>((pixel >> 8) & 0xFF), b = static_cast<int>(pixel & 0xFF);
+                spread = std::max({spread, std::abs(r - g), std::abs(b - g)});
+            }
+        }
+
+        return spread;
+    }
+
+    bool report(const char* name, const ConfigStats& stats, uint16_t width, uint16_t height) {
+        const bool ok = stats.hit_mismatches == 0 && stats.span_errors == 0 && stats.height_errors == 0;
+
+        printf("%-20s %4dx%-4d %8llu %8llu %8llu %8llu %10.1f  %s\n", name, width, height,
+               static_cast<unsigned long long>(stats.columns), static_cast<unsigned long long>(stats.hit_mismatches),
+               static_cast<unsigned long long>(stats.span_errors), static_cast<unsigned long long>(stats.height_errors),
+               1e6 * stats.seconds / stats.frames, ok ? "ok" : "FAIL");
+
+        return ok;
+    }
+}
+
+int main(int argc, char** argv) {
+    const int pose_count = (argc > 1) ? std::atoi(argv[1]) : 200;
+    const unsigned seed = (argc > 2) ? static_cast<unsigned>(std::atoi(argv[2])) : 1;
+
+    if (!TextureManager::isValid() || !isMapDataValid()) {
+        printf("ERROR embedded asset data invalid\n");
+        return 1;
+    }
+
+    const MapView map = createMapView();
+    const uint8_t* linked_textures = textures_xip_blob;
+    const size_t linked_size = static_cast<size_t>(textures_xip_blob_end - textures_xip_blob);
+    const std::vector<uint8_t> low_textures = downsampleTextures();
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> offset(0.05f, 0.95f);
+    std::uniform_int_distribution<int> tile_x(0, map.width - 1);
+    std::uniform_int_distribution<int> tile_y(0, map.height - 1);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+    Frame<DefaultRenderConfig> default_frame;
+    Frame<SmallConfig> small_frame;
+    Frame<PortraitConfig> portrait_frame;
+    Frame<VgaConfig> vga_frame;
+    Frame<VgaRgb888Config> rgb888_frame;
+    Frame<LowTexConfig> low_tex_frame;
+
+    ConfigStats default_stats, small_stats, portrait_stats, vga_stats, rgb888_stats, low_tex_stats;
+
+    uint64_t rgb888_mismatches = 0;
+    uint64_t low_tex_mismatches = 0;
+
+    for (int pose = 0; pose < pose_count; pose++) {
+        // random pose inside an open tile
+        int tx, ty;
+        do {
+            tx = tile_x(rng);
+            ty = tile_y(rng);
+        } while (map.getTile(tx, ty) != 0);
+
+        const float a = angle(rng);
+
+        const PlayerData player{
+            Fixed15_16(tx + offset(rng)), Fixed15_16(ty + offset(rng)),
+            Fixed15_16(std::cos(a)), Fixed15_16(std::sin(a))
+        };
+
+        TextureManager::setBlob(linked_textures, linked_size);
+
+        renderFrame(map, player, default_frame, default_stats);
+        checkFrame(map, player, default_frame, default_stats);
+
+        renderFrame(map, player, small_frame, small_stats);
+        checkFrame(map, player, small_frame, small_stats);
+
+        renderFrame(map, player, portrait_frame, portrait_stats);
+        checkFrame(map, player, portrait_frame, portrait_stats);
+
+        renderFrame(map, player, vga_frame, vga_stats);
+        checkFrame(map, player, vga_frame, vga_stats);
+
+        renderFrame(map, player, rgb888_frame, rgb888_stats);
+        checkFrame(map, player, rgb888_frame, rgb888_stats);
+
+        // the pixel type only changes how texels are stored
+        for (size_t i = 0; i < vga_frame.pixels.size(); i++) {
+            if (vga_frame.pixels[i] == SENTINEL) continue;
+            rgb888_mismatches += rgb888_frame.pixels[i] != fromRgb565<uint32_t>(vga_frame.pixels[i]);
+        }
+
+        TextureManager::setBlob(low_textures.data(), low_textures.size());
+
+        renderFrame(map, player, low_tex_frame, low_tex_stats);
+        checkFrame(map, player, low_tex_frame, low_tex_stats);
+
+        // same walls, texture columns at half the resolution
+        for (uint16_t x = 0; x < DefaultRenderConfig::WIDTH; x++) {
+            const RayHit& full = default_frame.hits[x];
+            const RayHit& low = low_tex_frame.hits[x];
+            low_tex_mismatches += full.tile != low.tile || full.distance != low.distance || (full.tex_x >> 1) != low.tex_x;
+        }
+    }
+
+    TextureManager::setBlob(linked_textures, linked_size);
+
+    printf("poses: %d (seed %u)\n", pose_count, seed);
+    printf("%-20s %9s %8s %8s %8s %8s %10s\n", "config", "size", "columns", "hit_err", "span_err", "h_err", "frame_us");
+
+    bool ok = true;
+    ok &= report("st7735 (default)", default_stats, DefaultRenderConfig::WIDTH, DefaultRenderConfig::HEIGHT);
+    ok &= report("small", small_stats, SmallConfig::WIDTH, SmallConfig::HEIGHT);
+    ok &= report("portrait", portrait_stats, PortraitConfig::WIDTH, PortraitConfig::HEIGHT);
+    ok &= report("vga", vga_stats, VgaConfig::WIDTH, VgaConfig::HEIGHT);
+    ok &= report("vga rgb888", rgb888_stats, VgaRgb888Config::WIDTH, VgaRgb888Config::HEIGHT);
+    ok &= report("32x32 textures", low_tex_stats, LowTexConfig::WIDTH, LowTexConfig::HEIGHT);
+
+    printf("rgb888 vs rgb565 pixel mismatches:   %llu\n", static_cast<unsigned long long>(rgb888_mismatches));
+    printf("32x32 vs 64x64 texture hit mismatches: %llu\n", static_cast<unsigned long long>(low_tex_mismatches));
+
+    // a byte order mix up turns the grey stone into magenta, far more than 16 apart
+    const int stone_spread = channelSpread(STONE_BRICKS_TEXTURE);
+    printf("stone bricks rgb888 channel spread:  %d\n", stone_spread);
+
+    ok &= rgb888_mismatches == 0 && low_tex_mismatches == 0 && stone_spread <= 16;
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
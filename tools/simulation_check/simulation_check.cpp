@@ -0,0 +1,201 @@
+/**
+ * @file simulation_check.cpp
+ * @brief Checks the fixed timestep simulation against frame rate changes and times a tick.
+ *
+ * The player walks and turns through the embedded map with a scripted stick
+ * while frames take random times. Every run over the same wall clock time has
+ * to run the same ticks and end in exactly the same pose as a run at a steady
+ * frame rate. Also checked: a stalled frame runs at most SIM_MAX_TICKS and keeps
+ * the tick phase, alpha stays in [0, 1), the interpolated camera starts at the
+ * previous pose and turns the short way across the wrap, the turn rate follows
+ * the stick deflection, and the player never ends up inside a wall.
+ * Exits non-zero if any check fails.
+ *
+ * Usage: simulation_check [seconds] [seed]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "map_data.hpp"
+#include "simulation.hpp"
+
+namespace {
+    int failures = 0;
+
+    void fail(const char* what) {
+        if (failures++ < 10) fprintf(stderr, "FAIL %s\n", what);
+    }
+
+    /// @brief Scripted stick over simulated time: walk, turn, back up, turn the other way
+    JoystickState scriptedStick(uint32_t tick) {
+        switch ((tick / 90) % 4) {
+            case 0: return JoystickState{Fixed15_16(0), Fixed15_16(-1)};
+            case 1: return JoystickState{Fixed15_16(1), Fixed15_16(-1)};
+            case 2: return JoystickState{Fixed15_16(0), Fixed15_16(1)};
+            default: return JoystickState{-0.8_fp, Fixed15_16(0)};
+        }
+    }
+
+    struct Run {
+        PlayerState player;
+        uint32_t ticks = 0;
+        bool in_wall = false;
+    };
+
+    /// @brief Simulate total_us of wall clock time in frames of the given durations
+    template <typename FrameUs>
+    Run simulate(const MapView& map, uint32_t total_us, FrameUs&& frame_us) {
+        Run run{PlayerState::fromPose(*getPlayerData())};
+        FixedTimestep sim;
+        PlayerState previous = run.player;
+
+        uint32_t elapsed = 0;
+        while (elapsed < total_us) {
+            uint32_t frame = frame_us();
+            if (elapsed + frame > total_us) frame = total_us - elapsed;
+            elapsed += frame;
+
+            // the stick is read per frame on the device, script it per tick here so runs are comparable
+            sim.advance(frame, [&]() {
+                previous = run.player;
+                stepPlayer(run.player, map, scriptedStick(run.ticks++));
+                run.in_wall |= map.getEffectiveTile(run.player.pos_x.toInt(), run.player.pos_y.toInt()) != 0;
+            });
+
+            const Fixed15_16 alpha = sim.alpha();
+            if (alpha < 0 || alpha >= 1) fail("alpha outside [0, 1)");
+        }
+
+        return run;
+    }
+
+    bool samePose(const PlayerState& a, const PlayerState& b) {
+        return a.pos_x == b.pos_x && a.pos_y == b.pos_y && a.heading == b.heading;
+    }
+
+    void checkStall() {
+        FixedTimestep sim;
+        int ticks = 0;
+
+        sim.advance(SIM_TICK_US / 3, [&]() { ticks++; });
+        const Fixed15_16 phase = sim.alpha();
+
+        // a one second hitch, far more than SIM_MAX_TICKS ticks
+        const uint8_t ran = sim.advance(1000000 - (1000000 % SIM_TICK_US), [&]() { ticks++; });
+        if (ran != SIM_MAX_TICKS || ticks != SIM_MAX_TICKS) fail("stalled frame did not stop at SIM_MAX_TICKS");
+        if (sim.alpha() != phase) fail("stalled frame lost the tick phase");
+        if (sim.droppedUs() == 0) fail("dropped time not reported");
+    }
+
+    void checkInterpolation(const MapView& map) {
+        PlayerState previous = PlayerState::fromPose(*getPlayerData());
+        PlayerState current = previous;
+        stepPlayer(current, map, JoystickState{Fixed15_16(1), Fixed15_16(-1)});
+
+        const Camera start = interpolateCamera(previous, current, Fixed15_16(0));
+        const Camera expected = Camera::fromPlayer(previous.pose());
+        if (start.pos_x != expected.pos_x || start.pos_y != expected.pos_y || start.dir_x != expected.dir_x ||
+            start.plane_y != expected.plane_y) {
+            fail("alpha 0 is not the previous pose");
+        }
+
+        const Camera half = interpolateCamera(previous, current, 0.5_fp);
+        const PlayerData previous_pose = previous.pose();
+        const PlayerData current_pose = current.pose();
+        const bool between = (half.pos_x - previous_pose.pos_x) * (current_pose.pos_x - half.pos_x) >= 0 &&
+                             (half.dir_x - previous_pose.dir_x) * (current_pose.dir_x - half.dir_x) >= 0;
+        if (!between) fail("alpha 0.5 is not between the poses");
+
+        // a turn across heading 0 blends through 0, not the long way round through 180 degrees
+        const PlayerState before{previous.pos_x, previous.pos_y, static_cast<angle16_t>(-SIM_MAX_TURN)};
+        const PlayerState after{previous.pos_x, previous.pos_y, SIM_MAX_TURN};
+        if (interpolateCamera(before, after, 0.5_fp).dir_x != 1) fail("interpolation turned the long way round");
+    }
+
+    void checkTurnRate(const MapView& map) {
+        const PlayerState start = PlayerState::fromPose(*getPlayerData());
+
+        // heading change over one tick for a stick deflection, in binary angle steps
+        auto turned = [&](Fixed15_16 x) {
+            PlayerState player = start;
+            stepPlayer(player, map, JoystickState{x, Fixed15_16(0)});
+            return static_cast<int16_t>(player.heading - start.heading);
+        };
+
+        if (turned(Fixed15_16(0)) != 0) fail("turned with the stick at rest");
+        if (turned(Fixed15_16(1)) != SIM_MAX_TURN || turned(Fixed15_16(-1)) != -SIM_MAX_TURN) fail("full deflection is not SIM_MAX_TURN");
+
+        const int16_t quarter = turned(0.25_fp);
+        if (quarter < SIM_MAX_TURN / 4 - 1 || quarter > SIM_MAX_TURN / 4 + 1) fail("quarter deflection is not a quarter of the rate");
+        if (turned(-0.25_fp) != -quarter) fail("turning is not symmetric");
+
+        // small deflections still turn, below the old on/off threshold
+        if (turned(0.1_fp) <= 0) fail("a light push did not turn");
+    }
+}
+
+int main(int argc, char** argv) {
+    const int seconds = (argc > 1) ? atoi(argv[1]) : 60;
+    const unsigned seed = (argc > 2) ? static_cast<unsigned>(atoi(argv[2])) : 1234u;
+
+    if (!isMapDataValid()) {
+        printf("ERROR embedded map data invalid\n");
+        return 1;
+    }
+
+    const MapView map = createMapView();
+    const uint32_t total_us = static_cast<uint32_t>(seconds) * 1000000;
+
+    std::mt19937 rng(seed);
+
+    // 60 fps, jittery 20-45 fps like the device with interlacing toggled, and slow frames with hitches
+    const Run steady = simulate(map, total_us, []() { return 16667u; });
+    std::uniform_int_distribution<uint32_t> jitter(22000, 50000);
+    const Run jittery = simulate(map, total_us, [&]() { return jitter(rng); });
+    std::uniform_int_distribution<uint32_t> slow(60000, 110000);
+    const Run slowed = simulate(map, total_us, [&]() { return slow(rng); });
+
+    if (steady.ticks != total_us / SIM_TICK_US) fail("steady run did not run one tick per SIM_TICK_US");
+    if (jittery.ticks != steady.ticks || slowed.ticks != steady.ticks) fail("frame times changed the tick count");
+    if (!samePose(steady.player, jittery.player) || !samePose(steady.player, slowed.player)) fail("frame times changed the final pose");
+    if (steady.in_wall || jittery.in_wall || slowed.in_wall) fail("player walked into a wall");
+    if (samePose(steady.player, PlayerState::fromPose(*getPlayerData()))) fail("scripted stick never moved the player");
+
+    checkStall();
+    checkInterpolation(map);
+    checkTurnRate(map);
+
+    // cost of one tick and one camera snapshot
+    constexpr int REPEATS = 1 << 20;
+    PlayerState player = PlayerState::fromPose(*getPlayerData());
+    PlayerState previous = player;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < REPEATS; i++) {
+        previous = player;
+        stepPlayer(player, map, scriptedStick(static_cast<uint32_t>(i)));
+    }
+    const double tick_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / REPEATS;
+
+    Fixed15_16 sink(0);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < REPEATS; i++) {
+        sink += interpolateCamera(previous, player, Fixed15_16::fromRaw(i & 0xFFFF)).plane_x;
+    }
+    const double camera_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / REPEATS;
+
+    printf("simulated:   %d s, %u ticks of %u us\n", seconds, steady.ticks, SIM_TICK_US);
+    printf("tick:        %.1f ns\n", tick_ns);
+    printf("camera:      %.1f ns (%d)\n", camera_ns, sink.toInt() & 1);
+
+    if (failures > 0) {
+        printf("FAIL: %d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
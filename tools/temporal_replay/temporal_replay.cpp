@@ -0,0 +1,184 @@
+/**
+ * @file temporal_replay.cpp
+ * @brief Replays a camera path with interlaced temporal rendering on and off.
+ *
+ * Reports rays cast per frame, frame time and the PSNR of the temporal frames
+ * against fully raycast frames of the same pose.
+ *
+ * Usage: temporal_replay [poses.txt]
+ * Without a pose file a scripted walk through the embedded map is replayed.
+ * Pose file format matches batch_render: "pos_x pos_y angle_degrees" per line.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <numbers>
+#include <vector>
+
+#include "frame_psnr.hpp"
+#include "map_data.hpp"
+#include "renderer.hpp"
+#include "temporal.hpp"
+
+namespace {
+    constexpr size_t FRAME_PIXELS = SCREEN_WIDTH * SCREEN_HEIGHT;
+    constexpr int SCRIPTED_FRAMES = 1200;
+
+    struct Pose {
+        double x, y, angle;
+    };
+
+    PlayerData toPlayer(const Pose& pose) {
+        return PlayerData{
+            Fixed15_16(static_cast<float>(pose.x)), Fixed15_16(static_cast<float>(pose.y)),
+            Fixed15_16(static_cast<float>(std::cos(pose.angle))), Fixed15_16(static_cast<float>(std::sin(pose.angle)))
+        };
+    }
+
+    /// @brief Walk, turn and strafe through the map with simple collision, like a player would
+    std::vector<Pose> scriptedPath(const MapView& map, const PlayerData& start) {
+        std::vector<Pose> path;
+
+        Pose pose{start.pos_x.toFloat(), start.pos_y.toFloat(), std::atan2(start.dir_y.toFloat(), start.dir_x.toFloat())};
+
+        for (int i = 0; i < SCRIPTED_FRAMES; i++) {
+            const int phase = (i / 90) % 4;
+            double move = 0.0;
+            double turn = 0.0;
+
+            switch (phase) {
+                case 0: move = 0.05; break;
+                case 1: turn = 2.0; break;
+                case 2: move = 0.05; turn = -1.0; break;
+                case 3: move = -0.05; turn = 0.5; break;
+            }
+
+            pose.angle += turn * std::numbers::pi / 180.0;
+
+            const double nx = pose.x + std::cos(pose.angle) * move;
+            const double ny = pose.y + std::sin(pose.angle) * move;
+            const double lx = pose.x + std::cos(pose.angle) * move * 10.0;
+            const double ly = pose.y + std::sin(pose.angle) * move * 10.0;
+
+            if (map.getTile(static_cast<uint8_t>(lx), static_cast<uint8_t>(pose.y)) == 0) pose.x = nx;
+            if (map.getTile(static_cast<uint8_t>(pose.x), static_cast<uint8_t>(ly)) == 0) pose.y = ny;
+
+            path.push_back(pose);
+        }
+
+        return path;
+    }
+
+    bool loadPoses(const char* path, std::vector<Pose>& poses) {
+        FILE* f = fopen(path, "r");
+        if (f == nullptr) return false;
+
+        char line[256];
+        while (fgets(line, sizeof(line), f) != nullptr) {
+            Pose p;
+            if (line[0] != '#' && sscanf(line, "%lf %lf %lf", &p.x, &p.y, &p.angle) == 3) {
+                p.angle *= std::numbers::pi / 180.0;
+                poses.push_back(p);
+            }
+        }
+
+        fclose(f);
+        return true;
+    }
+
+    struct ReplayResult {
+        uint64_t rays_cast = 0;
+        uint64_t reprojected = 0;
+        double seconds = 0.0;
+    };
+
+    /// @brief Render every pose through a TemporalRenderer, optionally keeping the frames
+    ReplayResult replay(const MapView& map, const std::vector<Pose>& poses, bool enabled, std::vector<uint16_t>* frames) {
+        TemporalRenderer temporal(map);
+        temporal.setEnabled(enabled);
+
+        ReplayResult result;
+        static uint16_t frame[FRAME_PIXELS];
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t f = 0; f < poses.size(); f++) {
+            temporal.beginFrame(Camera::fromPlayer(toPlayer(poses[f])));
+            memset(frame, 0, sizeof(frame));
+
+            for (uint8_t i = 0; i < SCREEN_WIDTH; i++) {
+                const uint8_t x = temporal.columnAt(i);
+                temporal.renderColumn(x, &frame[x * SCREEN_HEIGHT]);
+            }
+
+            result.rays_cast += temporal.frameStats().rays_cast;
+            result.reprojected += temporal.frameStats().reprojected;
+
+            if (frames != nullptr) {
+                memcpy(&(*frames)[f * FRAME_PIXELS], frame, sizeof(frame));
+            }
+        }
+
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (!isMapDataValid()) {
+        printf("ERROR embedded map data invalid\n");
+        return 1;
+    }
+
+    const MapView map = createMapView();
+
+    std::vector<Pose> poses;
+    if (argc > 1) {
+        if (!loadPoses(argv[1], poses) || poses.empty()) {
+            printf("ERROR no poses loaded from %s\n", argv[1]);
+            return 1;
+        }
+    } else {
+        poses = scriptedPath(map, *getPlayerData());
+    }
+
+    // timing runs without keeping frames, then a run of each to compare images
+    const ReplayResult full = replay(map, poses, false, nullptr);
+    const ReplayResult interlaced = replay(map, poses, true, nullptr);
+
+    std::vector<uint16_t> full_frames(poses.size() * FRAME_PIXELS);
+    std::vector<uint16_t> interlaced_frames(poses.size() * FRAME_PIXELS);
+    replay(map, poses, false, &full_frames);
+    replay(map, poses, true, &interlaced_frames);
+
+    double psnr_sum = 0.0;
+    double worst_psnr = INFINITY;
+    size_t exact_frames = 0;
+
+    for (size_t f = 0; f < poses.size(); f++) {
+        const double psnr = framePsnr(&full_frames[f * FRAME_PIXELS], &interlaced_frames[f * FRAME_PIXELS], FRAME_PIXELS);
+        if (std::isinf(psnr)) {
+            exact_frames++;
+            continue;
+        }
+        psnr_sum += psnr;
+        if (psnr < worst_psnr) worst_psnr = psnr;
+    }
+
+    const size_t inexact = poses.size() - exact_frames;
+    const double n = static_cast<double>(poses.size());
+
+    printf("frames:              %zu\n", poses.size());
+    printf("full:                %.1f rays/frame, %.1f us/frame\n", full.rays_cast / n, 1e6 * full.seconds / n);
+    printf("temporal:            %.1f rays/frame, %.1f reprojected/frame, %.1f us/frame\n",
+           interlaced.rays_cast / n, interlaced.reprojected / n, 1e6 * interlaced.seconds / n);
+    printf("dda work saved:      %.1f%%\n", 100.0 * (1.0 - static_cast<double>(interlaced.rays_cast) / full.rays_cast));
+    printf("exact frames:        %zu / %zu\n", exact_frames, poses.size());
+    if (inexact > 0) {
+        printf("psnr vs full:        mean %.2f dB, worst %.2f dB over %zu inexact frames\n", psnr_sum / inexact, worst_psnr, inexact);
+    }
+
+    return 0;
+}
@@ -0,0 +1,196 @@
+/**
+ * @file trig_check.cpp
+ * @brief Error bounds of the binary angle sine and cosine against std::sin, and their lookup cost.
+ *
+ * Every one of the 65536 binary angles is compared with the double precision
+ * sine and cosine. Checked: the error stays within MAX_ERROR_STEPS raw Q16
+ * steps, the axes come out exactly 0 and 1, sine is odd and monotonic over the
+ * quarter wave, sin^2 + cos^2 stays at 1, atan2Bam() inverts the direction and
+ * degreesToBam() rounds. The integer degree sinfp() table is measured the
+ * same way for comparison, as is the drift of rotating a direction vector
+ * by 2 degrees per step like the player used to. The timings store every
+ * result to a volatile so nothing is folded away, and say whether the table
+ * beats sinfp() and std::sin on this machine.
+ * Exits non-zero if any check fails.
+ *
+ * Usage: trig_check [seed]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include "fp_math.hpp"
+
+namespace {
+    // linear interpolation over 256 segments is off by less than one step, the table and the blend round once each
+    constexpr double MAX_ERROR_STEPS = 2.0;
+
+    int failures = 0;
+
+    void fail(const char* what) {
+        if (failures++ < 10) fprintf(stderr, "FAIL %s\n", what);
+    }
+
+    double radians(angle16_t a) {
+        return a * (2.0 * std::numbers::pi / 0x10000);
+    }
+
+    /// @brief Error in raw Q16 steps
+    double stepsOff(Fixed15_16 value, double exact) {
+        return std::fabs(value.toRaw() - exact * Fixed15_16::ONE);
+    }
+
+    struct Errors {
+        double sin_max = 0;
+        double cos_max = 0;
+        double sin_mean = 0;
+        double length_max = 0;
+    };
+
+    Errors checkAllAngles() {
+        Errors errors;
+
+        for (uint32_t i = 0; i < 0x10000; i++) {
+            const angle16_t a = static_cast<angle16_t>(i);
+            const Fixed15_16 s = sinBam(a);
+            const Fixed15_16 c = cosBam(a);
+
+            const double sin_err = stepsOff(s, std::sin(radians(a)));
+            const double cos_err = stepsOff(c, std::cos(radians(a)));
+            errors.sin_max = std::fmax(errors.sin_max, sin_err);
+            errors.cos_max = std::fmax(errors.cos_max, cos_err);
+            errors.sin_mean += sin_err / 0x10000;
+
+            const double fs = s.toRaw() / 65536.0, fc = c.toRaw() / 65536.0;
+            errors.length_max = std::fmax(errors.length_max, std::fabs(std::sqrt(fs * fs + fc * fc) - 1.0) * Fixed15_16::ONE);
+
+            if (sinBam(static_cast<angle16_t>(-a)) != -s) fail("sine is not odd");
+            if (i > 0 && i <= BAM_QUARTER && s < sinBam(static_cast<angle16_t>(a - 1))) fail("sine not monotonic over the quarter wave");
+        }
+
+        if (errors.sin_max > MAX_ERROR_STEPS || errors.cos_max > MAX_ERROR_STEPS) fail("error above MAX_ERROR_STEPS");
+        if (errors.length_max > 2 * MAX_ERROR_STEPS) fail("sin^2 + cos^2 strays from 1");
+
+        return errors;
+    }
+
+    void checkExactPoints() {
+        if (sinBam(0) != 0 || sinBam(BAM_QUARTER) != 1 || sinBam(BAM_HALF) != 0 || sinBam(BAM_HALF + BAM_QUARTER) != -1) {
+            fail("sine is not exact on the axes");
+        }
+        if (cosBam(0) != 1 || cosBam(BAM_QUARTER) != 0 || cosBam(BAM_HALF) != -1) fail("cosine is not exact on the axes");
+
+        if (degreesToBam(90) != BAM_QUARTER || degreesToBam(-90) != static_cast<angle16_t>(-BAM_QUARTER) || degreesToBam(360) != 0) {
+            fail("degreesToBam is off on the axes");
+        }
+        if (degreesToBam(2) != 364 || degreesToBam(-2) != static_cast<angle16_t>(-364)) fail("degreesToBam does not round");
+    }
+
+    /// @brief Largest distance in steps between an angle and atan2Bam of its direction
+    int checkAtan2() {
+        int worst = 0;
+
+        for (uint32_t i = 0; i < 0x10000; i++) {
+            const angle16_t a = static_cast<angle16_t>(i);
+            const int off = std::abs(static_cast<int16_t>(atan2Bam(sinBam(a), cosBam(a)) - a));
+            if (off > worst) worst = off;
+        }
+
+        // the map file's axis aligned start directions have to come back exactly
+        if (atan2Bam(Fixed15_16(0), Fixed15_16(-1)) != BAM_HALF || atan2Bam(Fixed15_16(1), Fixed15_16(0)) != BAM_QUARTER) {
+            fail("atan2Bam is not exact on the axes");
+        }
+        if (worst > 4) fail("atan2Bam does not invert the direction");
+
+        return worst;
+    }
+
+    /// @brief Largest error of the integer degree table, in steps
+    double sinfpError() {
+        double worst = 0;
+        for (int16_t d = -360; d <= 360; d++) {
+            worst = std::fmax(worst, stepsOff(sinfp(d), std::sin(d * std::numbers::pi / 180.0)));
+        }
+        return worst;
+    }
+
+    /// @brief Length of a unit vector after steps incremental 2 degree rotations with sinfp/cosfp
+    double incrementalDrift(int steps) {
+        constexpr Fixed15_16 rosin = sinfp(2);
+        constexpr Fixed15_16 rocos = cosfp(2);
+
+        Fixed15_16 x(1), y(0);
+        for (int i = 0; i < steps; i++) {
+            const Fixed15_16 old_x = x;
+            x = old_x * rocos - y * rosin;
+            y = old_x * rosin + y * rocos;
+        }
+
+        return std::hypot(x.toFloat(), y.toFloat());
+    }
+
+    /// @brief Stored on every call so no lookup can be folded away, vectorised or hoisted out of the rounds
+    volatile uint32_t sink = 0;
+
+    /// @brief Nanoseconds per call of lookup over the angles
+    template <typename Lookup>
+    double timeLookup(const std::vector<angle16_t>& angles, Lookup&& lookup) {
+        constexpr int ROUNDS = 64;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < ROUNDS; r++) {
+            for (angle16_t a : angles) sink = static_cast<uint32_t>(lookup(a));
+        }
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        return ns / (static_cast<double>(ROUNDS) * angles.size());
+    }
+}
+
+int main(int argc, char** argv) {
+    const unsigned seed = (argc > 1) ? static_cast<unsigned>(atoi(argv[1])) : 1234u;
+
+    const Errors errors = checkAllAngles();
+    checkExactPoints();
+    const int atan2_steps = checkAtan2();
+
+    // random angles so the branches and table reads do not follow a pattern
+    std::vector<angle16_t> angles(1 << 16);
+    std::mt19937 rng(seed);
+    for (angle16_t& a : angles) a = static_cast<angle16_t>(rng());
+
+    const double bam_ns = timeLookup(angles, [](angle16_t a) { return sinBam(a).toRaw() + cosBam(a).toRaw(); });
+    const double degree_ns = timeLookup(angles, [](angle16_t a) {
+        const int16_t d = static_cast<int16_t>(a % 360);
+        return sinfp(d).toRaw() + cosfp(d).toRaw();
+    });
+    const double float_ns = timeLookup(angles, [](angle16_t a) {
+        const float rad = a * (2.0f * std::numbers::pi_v<float> / 0x10000);
+        return static_cast<int32_t>((std::sin(rad) + std::cos(rad)) * Fixed15_16::ONE);
+    });
+
+    printf("sinBam error:      max %.2f, mean %.2f steps of 1/65536\n", errors.sin_max, errors.sin_mean);
+    printf("cosBam error:      max %.2f steps\n", errors.cos_max);
+    printf("unit length error: max %.2f steps\n", errors.length_max);
+    printf("atan2Bam:          within %d of 65536 per turn\n", atan2_steps);
+    printf("sinfp error:       max %.2f steps at whole degrees\n", sinfpError());
+    printf("2 degree rotation: length %.4f after 10000 steps\n", incrementalDrift(10000));
+    printf("sinBam + cosBam:   %.2f ns\n", bam_ns);
+    printf("sinfp + cosfp:     %.2f ns\n", degree_ns);
+    printf("std::sin + cos:    %.2f ns\n", float_ns);
+    printf("sinBam table:      %s than sinfp (%.2fx), %s than std::sin (%.2fx)\n", bam_ns < degree_ns ? "faster" : "slower",
+           degree_ns / bam_ns, bam_ns < float_ns ? "faster" : "slower", float_ns / bam_ns);
+
+    if (failures > 0) {
+        printf("FAIL: %d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file vec2_check.cpp
+ * @brief Checks the fused Fixed15_16 vector kernels against exact products and the separate ones they replace.
+ *
+ * Random operands, and operands made to round badly, go through mulAdd /
+ * mulSub, dot, cross and rotated. Checked: the fused result is always the
+ * exact 128 bit sum rounded to the nearest step and never further from it than
+ * separately truncated products, mulAcc and scaledAdd are bit identical to acc + a * b
+ * so camera rays do not change, and the kernels evaluate at compile time.
+ * Also prints the drift of a vector rotated step by step, mostly down to the
+ * rounded cos / sin of the step rather than the products, and times both forms.
+ * Exits non-zero if any check fails.
+ *
+ * Usage: vec2_check [seed]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "fp_math.hpp"
+#include "renderer.hpp"
+#include "vec2.hpp"
+
+namespace {
+    int failures = 0;
+
+    void fail(const char* what) {
+        if (failures++ < 10) fprintf(stderr, "FAIL %s\n", what);
+    }
+
+    // compile time use, eg. building a table of directions
+    constexpr Vec2fp EAST{Fixed15_16(1), Fixed15_16(0)};
+    static_assert(EAST.rotated(cosBam(BAM_QUARTER), sinBam(BAM_QUARTER)) == Vec2fp{Fixed15_16(0), Fixed15_16(1)});
+    static_assert(EAST.perpendicular().cross(EAST) == -1);
+    static_assert(Vec2fp{2.5_fp, -1.5_fp}.dot(Vec2fp{2.0_fp, 4.0_fp}) == -1);
+    static_assert(EAST.lerp(-EAST, 0.5_fp) == Vec2fp{});
+
+    /// @brief The separately truncated forms the kernels replace
+    Fixed15_16 separateMulAdd(Fixed15_16 a, Fixed15_16 b, Fixed15_16 c, Fixed15_16 d) { return a * b + c * d; }
+    Fixed15_16 separateMulSub(Fixed15_16 a, Fixed15_16 b, Fixed15_16 c, Fixed15_16 d) { return a * b - c * d; }
+
+    /// @brief Exact a * b + sign * c * d in raw Q32.32 units
+    __int128 exact(Fixed15_16 a, Fixed15_16 b, Fixed15_16 c, Fixed15_16 d, int sign) {
+        return static_cast<__int128>(a.toRaw()) * b.toRaw() + sign * static_cast<__int128>(c.toRaw()) * d.toRaw();
+    }
+
+    /// @brief Nearest step, halves round up
+    __int128 roundShift(__int128 v) {
+        v += 32768;
+        return (v >= 0) ? v / 65536 : -((-v + 65535) / 65536);
+    }
+
+    struct Counts {
+        uint64_t pairs = 0;
+        uint64_t fused_closer = 0;
+    };
+
+    /// @brief Operands in the range the renderer uses, directions and offsets of a few tiles
+    Fixed15_16 operand(std::mt19937& rng) {
+        return Fixed15_16::fromRaw(static_cast<int32_t>(rng() % (64 << 16)) - (32 << 16));
+    }
+
+    void checkPair(Fixed15_16 a, Fixed15_16 b, Fixed15_16 c, Fixed15_16 d, Counts& counts) {
+        for (int sign : {1, -1}) {
+            const Fixed15_16 fused = (sign > 0) ? mulAdd(a, b, c, d) : mulSub(a, b, c, d);
+            const Fixed15_16 separate = (sign > 0) ? separateMulAdd(a, b, c, d) : separateMulSub(a, b, c, d);
+
+            const __int128 sum = exact(a, b, c, d, sign);
+            if (fused.toRaw() != roundShift(sum)) fail("fused result is not the exact sum rounded");
+
+            // the nearest step can only be as close or closer than whatever step the separate products land on
+            const __int128 fused_err = sum - (static_cast<__int128>(fused.toRaw()) << 16);
+            const __int128 separate_err = sum - (static_cast<__int128>(separate.toRaw()) << 16);
+            const auto magnitude = [](__int128 v) { return v < 0 ? -v : v; };
+            if (magnitude(fused_err) > magnitude(separate_err)) fail("fused result further from exact than separate products");
+
+            counts.pairs++;
+            if (fused != separate) counts.fused_closer++;
+        }
+
+        if (mulAcc(a, c, d) != a + c * d) fail("mulAcc differs from acc + a * b");
+    }
+
+    Counts checkRandom(unsigned seed) {
+        std::mt19937 rng(seed);
+        Counts counts;
+
+        for (int i = 0; i < 1000000; i++) {
+            checkPair(operand(rng), operand(rng), operand(rng), operand(rng), counts);
+        }
+
+        // fractions just below a step on both products, where truncating twice loses the most
+        for (int i = 0; i < 1000; i++) {
+            const Fixed15_16 a = Fixed15_16::fromRaw(0x8000 + static_cast<int32_t>(rng() % 64));
+            const Fixed15_16 b = Fixed15_16::fromRaw(0x1FFFF - static_cast<int32_t>(rng() % 64));
+            checkPair(a, b, b, a, counts);
+            checkPair(-a, b, b, -a, counts);
+        }
+
+        return counts;
+    }
+
+    /// @brief Camera rays through the kernels are bit identical to the separate form the renderer used
+    void checkCameraRays(unsigned seed) {
+        std::mt19937 rng(seed);
+
+        for (int i = 0; i < 2000; i++) {
+            const angle16_t heading = static_cast<angle16_t>(rng());
+            const PlayerData player{operand(rng), operand(rng), cosBam(heading), sinBam(heading)};
+            const Camera camera = Camera::fromPlayer(player);
+
+            if (camera.plane_x != -player.dir_y * FOV_SCALE || camera.plane_y != player.dir_x * FOV_SCALE) {
+                fail("camera plane changed");
+            }
+
+            for (uint16_t x = 0; x < SCREEN_WIDTH; x++) {
+                const Ray ray = cameraRay(camera, static_cast<uint8_t>(x));
+                const Fixed15_16 camera_x = (2 * Fixed15_16(x) / Fixed15_16(SCREEN_WIDTH)) - 1;
+
+                if (ray.dir_x != camera.dir_x + camera.plane_x * camera_x || ray.dir_y != camera.dir_y + camera.plane_y * camera_x) {
+                    fail("camera ray changed");
+                    return;
+                }
+            }
+        }
+    }
+
+    /// @brief Length of a unit vector after steps rotations by 2 degrees
+    template <typename Rotate>
+    double drift(int steps, Rotate&& rotate) {
+        Vec2fp v{Fixed15_16(1), Fixed15_16(0)};
+        for (int i = 0; i < steps; i++) v = rotate(v);
+        return std::hypot(v.x.toFloat(), v.y.toFloat());
+    }
+
+    template <typename Kernel>
+    double timeKernel(const std::vector<Fixed15_16>& values, Kernel&& kernel, int32_t& sink) {
+        constexpr int ROUNDS = 64;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < ROUNDS; r++) {
+            for (size_t i = 0; i + 3 < values.size(); i += 4) {
+                sink += kernel(values[i], values[i + 1], values[i + 2], values[i + 3]).toRaw();
+            }
+        }
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        return ns / (ROUNDS * static_cast<double>(values.size() / 4));
+    }
+}
+
+int main(int argc, char** argv) {
+    const unsigned seed = (argc > 1) ? static_cast<unsigned>(atoi(argv[1])) : 1234u;
+
+    const Counts counts = checkRandom(seed);
+    checkCameraRays(seed);
+
+    const Fixed15_16 c = cosBam(degreesToBam(2));
+    const Fixed15_16 s = sinBam(degreesToBam(2));
+    const double fused_length = drift(10000, [&](Vec2fp v) { return v.rotated(c, s); });
+    const double separate_length = drift(10000, [&](Vec2fp v) {
+        return Vec2fp{separateMulSub(v.x, c, v.y, s), separateMulAdd(v.x, s, v.y, c)};
+    });
+
+    std::vector<Fixed15_16> values(1 << 16);
+    std::mt19937 rng(seed);
+    for (Fixed15_16& v : values) v = operand(rng);
+
+    int32_t sink = 0;
+    const double fused_ns = timeKernel(values, [](Fixed15_16 a, Fixed15_16 b, Fixed15_16 c, Fixed15_16 d) { return mulAdd(a, b, c, d); }, sink);
+    const double separate_ns = timeKernel(values, separateMulAdd, sink);
+
+    printf("pairs checked:     %llu, fused closer to exact in %.1f%%, never further\n",
+           static_cast<unsigned long long>(counts.pairs), 100.0 * counts.fused_closer / counts.pairs);
+    printf("2 degree rotation: length %.4f fused, %.4f separate after 10000 steps\n", fused_length, separate_length);
+    printf("mulAdd:            %.2f ns fused, %.2f ns separate (%d)\n", fused_ns, separate_ns, sink & 1);
+
+    if (failures > 0) {
+        printf("FAIL: %d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,279 @@
+/**
+ * @file wall_heights_check.cpp
+ * @brief Checks the layered column renderer for maps with wall heights, and what it costs.
+ *
+ * The embedded map is rendered from random poses three ways: without wall
+ * heights, with a heights section of unit walls, and with random heights on
+ * its walls. Checked: unit heights draw exactly the pixels and hits of the
+ * plain renderer, the early stop of renderWallLayers() draws exactly what
+ * walking every wall of the column to the map edge draws, the first step of a
+ * RayWalk is castRay() and later steps never come nearer, and the
+ * TemporalRenderer counts the layers without reprojecting. A packed header with
+ * a heights section is validated and bound by createMapView(), while headers
+ * from before it keep their lightmap and render with unit walls.
+ * Average layers per column and frame times are printed.
+ * Exits non-zero if any check fails.
+ *
+ * Usage: wall_heights_check [pose_count] [seed]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "asset_validation.hpp"
+#include "map_data.hpp"
+#include "raycast.hpp"
+#include "renderer.hpp"
+#include "temporal.hpp"
+#include "textures.hpp"
+
+namespace {
+    // a mix of walls below the eye, around it and far above it
+    constexpr uint8_t RANDOM_HEIGHTS[] = {4, 8, 12, 16, 16, 24, 40, 64};
+
+    constexpr size_t FRAME_PIXELS = static_cast<size_t>(SCREEN_WIDTH) * SCREEN_HEIGHT;
+
+    int failures = 0;
+
+    void fail(const char* what) {
+        if (failures++ < 10) fprintf(stderr, "FAIL %s\n", what);
+    }
+
+    bool sameHit(const RayHit& a, const RayHit& b) {
+        return a.tile == b.tile && a.side == b.side && a.map_x == b.map_x && a.map_y == b.map_y &&
+               a.tex_x == b.tex_x && a.shade == b.shade && a.distance == b.distance;
+    }
+
+    /// @brief View on the map with a heights array bound the way createMapView() binds a packed one
+    MapView withHeights(const MapView& map, const std::vector<uint8_t>& heights) {
+        MapView view = map;
+        view.heights = heights.data();
+        view.max_height = 0;
+        for (size_t i = 0; i < heights.size(); i++) {
+            if (map.tile_data[i] != 0 && heights[i] > view.max_height) view.max_height = heights[i];
+        }
+        return view;
+    }
+
+    /// @brief renderWallLayers() without the early stop, every wall up to the map edge is drawn into the span
+    RayHit renderEveryWall(const MapView& map, const Ray& ray, uint16_t* column, uint32_t& walls) {
+        RayWalk walk(map, ray);
+        ColumnSpan span = DefaultColumnRenderer::openSpan();
+
+        const RayHit nearest = walk.next();
+        for (RayHit hit = nearest; hit.tile != 0; hit = walk.next()) {
+            DefaultColumnRenderer::drawWallSpan(hit, map.getWallHeight(hit.map_x, hit.map_y), column, span);
+            walls++;
+        }
+
+        return nearest;
+    }
+
+    /// @brief The first step of a walk is castRay(), later ones go on from the hit
+    void checkWalk(const MapView& map, const Ray& ray) {
+        RayWalk walk(map, ray);
+
+        const RayHit first = walk.next();
+        if (!sameHit(first, castRay(map, ray))) {
+            fail("first step of a RayWalk differs from castRay");
+            return;
+        }
+
+        Fixed15_16 last = first.distance;
+        for (RayHit hit = walk.next(); hit.tile != 0; hit = walk.next()) {
+            if (hit.distance < last) {
+                fail("RayWalk came nearer");
+                return;
+            }
+            last = hit.distance;
+        }
+
+        if (walk.next().tile != 0) fail("RayWalk went on after its miss");
+    }
+
+    template <typename T>
+    void put(std::vector<uint8_t>& out, size_t offset, const T& value) {
+        memcpy(out.data() + offset, &value, sizeof(T));
+    }
+
+    /**
+     * @brief Pack the map by hand with heights and an older header without them
+     * @note Both carry a lightmap, the older header has to keep it
+     */
+    void checkHeader(const MapView& map, const std::vector<uint8_t>& heights, uint32_t tex_count) {
+        const size_t tiles = static_cast<size_t>(map.width) * map.height;
+        const std::vector<uint8_t> lightmap(tiles * 4, 1);
+
+        for (const bool old_header : {false, true}) {
+            // the older header is a FIRST_VERSION one ending before heights_offset, its player data starts there
+            const uint32_t version = old_header ? MapFileHeader::FIRST_VERSION : MapFileHeader::VERSION;
+            const uint32_t playerdata_offset = old_header ? offsetof(MapFileHeader, heights_offset) : sizeof(MapFileHeader);
+            const uint32_t mapdata_offset = playerdata_offset + sizeof(PlayerData);
+            const uint32_t lightmap_offset = static_cast<uint32_t>((mapdata_offset + 2 + tiles + 3) / 4 * 4);
+            const uint32_t heights_offset = static_cast<uint32_t>(lightmap_offset + lightmap.size());
+
+            std::vector<uint8_t> blob(heights_offset + (old_header ? 0 : heights.size()));
+            const MapFileHeader header{MapFileHeader::VALID_MAGIC, version, playerdata_offset, mapdata_offset, 0, lightmap_offset, heights_offset, 0};
+            memcpy(blob.data(), &header, playerdata_offset);
+            put(blob, playerdata_offset, *getPlayerData());
+            blob[mapdata_offset] = map.width;
+            blob[mapdata_offset + 1] = map.height;
+            memcpy(blob.data() + mapdata_offset + 2, map.tile_data, tiles);
+            memcpy(blob.data() + lightmap_offset, lightmap.data(), lightmap.size());
+
+            if (old_header) {
+                if (!validateMapBlob(blob.data(), blob.size(), tex_count)) fail("older header rejected");
+
+                const MapView view = createMapView(blob.data());
+                if (view.heights != nullptr || view.max_height != WALL_HEIGHT_ONE) fail("older header bound wall heights");
+                if (view.lightmap == nullptr) fail("older header lost its lightmap");
+                continue;
+            }
+
+            memcpy(blob.data() + heights_offset, heights.data(), heights.size());
+            if (!validateMapBlob(blob.data(), blob.size(), tex_count)) fail("header with wall heights rejected");
+
+            const MapView view = createMapView(blob.data());
+            if (view.heights == nullptr || view.max_height != withHeights(map, heights).max_height) fail("wall heights not bound");
+            if (view.lightmap == nullptr) fail("lightmap lost next to wall heights");
+
+            // cut short inside the section, and with a flat wall
+            if (validateMapBlob(blob.data(), blob.size() - 1, tex_count)) fail("truncated heights section accepted");
+
+            for (size_t i = 0; i < tiles; i++) {
+                if (map.tile_data[i] == 0) continue;
+                blob[heights_offset + i] = 0;
+                if (validateMapBlob(blob.data(), blob.size(), tex_count)) fail("flat wall accepted");
+                break;
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    const int pose_count = (argc > 1) ? atoi(argv[1]) : 300;
+    const unsigned seed = (argc > 2) ? static_cast<unsigned>(atoi(argv[2])) : 1234u;
+
+    if (!TextureManager::isValid() || !isMapDataValid()) {
+        printf("ERROR embedded asset data invalid\n");
+        return 1;
+    }
+
+    const MapView plain = createMapView();
+    const size_t tiles = static_cast<size_t>(plain.width) * plain.height;
+
+    std::mt19937 rng(seed);
+
+    const std::vector<uint8_t> unit_heights(tiles, WALL_HEIGHT_ONE);
+    std::vector<uint8_t> random_heights(tiles, WALL_HEIGHT_ONE);
+    std::uniform_int_distribution<size_t> pick_height(0, sizeof(RANDOM_HEIGHTS) - 1);
+    for (uint8_t& h : random_heights) h = RANDOM_HEIGHTS[pick_height(rng)];
+
+    const MapView unit = withHeights(plain, unit_heights);
+    const MapView varied = withHeights(plain, random_heights);
+
+    checkHeader(plain, random_heights, TextureManager::getHeader()->tex_count);
+
+    std::uniform_real_distribution<float> offset(0.05f, 0.95f);
+    std::uniform_int_distribution<int> tile_x(0, plain.width - 1);
+    std::uniform_int_distribution<int> tile_y(0, plain.height - 1);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+    std::vector<uint16_t> expected(FRAME_PIXELS), layered(FRAME_PIXELS), every_wall(FRAME_PIXELS);
+
+    uint64_t columns = 0, layers = 0, walls_to_edge = 0;
+    double plain_seconds = 0.0, layered_seconds = 0.0;
+
+    TemporalRenderer temporal(varied);
+    temporal.setEnabled(true);
+    uint64_t temporal_layers = 0, temporal_columns = 0;
+
+    for (int pose = 0; pose < pose_count; pose++) {
+        // random pose inside an open tile
+        int tx, ty;
+        do {
+            tx = tile_x(rng);
+            ty = tile_y(rng);
+        } while (plain.getTile(tx, ty) != 0);
+
+        const float a = angle(rng);
+
+        const PlayerData player{
+            Fixed15_16(tx + offset(rng)), Fixed15_16(ty + offset(rng)),
+            Fixed15_16(std::cos(a)), Fixed15_16(std::sin(a))
+        };
+        const Camera camera = Camera::fromPlayer(player);
+
+        // unit walls: one layer per column, the same frame as without heights
+        std::fill(expected.begin(), expected.end(), 0);
+        std::fill(layered.begin(), layered.end(), 0);
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+            renderColumn(plain, camera, x, &expected[x * SCREEN_HEIGHT]);
+        }
+        plain_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+            const RayHit hit = renderColumn(unit, camera, x, &layered[x * SCREEN_HEIGHT]);
+            if (!sameHit(hit, castRay(plain, cameraRay(camera, x)))) fail("unit heights changed the hit");
+        }
+        if (layered != expected) fail("unit heights changed the frame");
+
+        // random walls: the early stop draws what walking to the map edge draws
+        std::fill(layered.begin(), layered.end(), 0);
+        std::fill(every_wall.begin(), every_wall.end(), 0);
+
+        start = std::chrono::steady_clock::now();
+        for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+            uint8_t column_layers;
+            renderWallLayers(varied, cameraRay(camera, x), &layered[x * SCREEN_HEIGHT], column_layers);
+            layers += column_layers;
+        }
+        layered_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        uint32_t walls = 0;
+        for (uint8_t x = 0; x < SCREEN_WIDTH; x++) {
+            const Ray ray = cameraRay(camera, x);
+            renderEveryWall(varied, ray, &every_wall[x * SCREEN_HEIGHT], walls);
+            checkWalk(varied, ray);
+        }
+        walls_to_edge += walls;
+        columns += SCREEN_WIDTH;
+
+        if (layered != every_wall) fail("early stop changed the frame");
+
+        // the temporal renderer walks every column of a map with heights
+        temporal.beginFrame(camera);
+        for (uint8_t i = 0; i < SCREEN_WIDTH; i++) {
+            const uint8_t x = temporal.columnAt(i);
+            temporal.renderColumn(x, &layered[x * SCREEN_HEIGHT]);
+        }
+        if (temporal.frameStats().reprojected != 0) fail("columns with wall heights reprojected");
+        temporal_layers += temporal.frameStats().layers;
+        temporal_columns += temporal.frameStats().rays_cast;
+    }
+
+    if (temporal_layers != layers) fail("temporal renderer counted other layers");
+    if (temporal_columns != columns) fail("temporal renderer skipped columns");
+
+    const double n = pose_count;
+    printf("layers per column:   %.2f drawn, %.2f walls to the map edge\n", static_cast<double>(layers) / columns,
+           static_cast<double>(walls_to_edge) / columns);
+    printf("plain frame:         %.1f us\n", 1e6 * plain_seconds / n);
+    printf("layered frame:       %.1f us\n", 1e6 * layered_seconds / n);
+
+    if (failures > 0) {
+        printf("FAIL: %d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}